@@ -0,0 +1,186 @@
+#ifndef CONTROL_LAW_H
+#define CONTROL_LAW_H
+
+#include <stdint.h>
+#include "FixedPoint.h"
+
+// =========================================================
+// Compile-time control law policies
+// =========================================================
+// ControlLaw<Policy> turns one axis' filtered distance and closure rate
+// into a servo pulse. The policy is a template parameter, so only the law
+// main.cpp selects (CONTROL_LAW) is instantiated; the others never reach
+// the binary, and the policy's correction() inlines into update().
+//
+// A policy returns a correction in microseconds away from neutral, towards
+// correctUs (negative means the other way). ControlLaw applies the
+// direction and clamps to the servo's [minUs, maxUs].
+//
+//   BangBangHold     full correction while rate > rateThreshold, held for
+//                    holdMs after the last trigger (the original loop logic)
+//   Proportional     kp * (targetCm - dist)
+//   ProportionalDerivative
+//                    kp * (targetCm - dist) + kd * rate
+//   TimeToCollision  full correction while closing with dist / rate below
+//                    tauSec, held for holdMs
+//   TauProportional  correction ramps from none at tau = tauSec to full at
+//                    tau = tauFullSec, where tau = dist / rate is the time
+//                    to contact
+//
+// Templated over the number type like SignalPath.h.
+
+template <typename T>
+struct AxisConfig {
+  int neutralUs;
+  int correctUs;           // Full correction (away from the wall / ground)
+  int minUs;
+  int maxUs;
+  T rateThreshold;         // cm/s, BangBangHold trigger
+  uint32_t holdMs;         // BangBangHold / TimeToCollision hold time
+  T targetCm;              // Proportional / PD set-point
+  T kp;                    // us per cm below the set-point
+  T kd;                    // us per cm/s of closure rate
+  T tauSec;                // TimeToCollision trigger, TauProportional onset
+  T tauFullSec;            // TauProportional full correction
+};
+
+template <typename T>
+T fullCorrection(const AxisConfig<T> &c) {
+  return T(c.correctUs > c.neutralUs ? c.correctUs - c.neutralUs : c.neutralUs - c.correctUs);
+}
+
+// Keeps a triggered correction for holdMs after the last trigger
+class HoldTimer {
+  private:
+    bool active;
+    uint32_t activatedMs;
+
+  public:
+    HoldTimer() : active(false), activatedMs(0) {}
+
+    bool update(bool trigger, uint32_t nowMs, uint32_t holdMs) {
+      if (trigger) {
+        activatedMs = nowMs;
+        active = true;
+      } else if (active && (nowMs - activatedMs < holdMs)) {
+        // Holding
+      } else {
+        active = false;
+      }
+      return active;
+    }
+};
+
+template <typename T>
+class BangBangHold {
+  private:
+    HoldTimer hold;
+
+  public:
+    typedef T Value;
+
+    T correction(const AxisConfig<T> &c, T, T rate, uint32_t nowMs) {
+      bool on = hold.update(rate > c.rateThreshold, nowMs, c.holdMs);
+      return on ? fullCorrection(c) : T(0);
+    }
+};
+
+template <typename T>
+class Proportional {
+  public:
+    typedef T Value;
+
+    T correction(const AxisConfig<T> &c, T dist, T, uint32_t) {
+      return c.kp * (c.targetCm - dist);
+    }
+};
+
+template <typename T>
+class ProportionalDerivative {
+  public:
+    typedef T Value;
+
+    T correction(const AxisConfig<T> &c, T dist, T rate, uint32_t) {
+      return c.kp * (c.targetCm - dist) + c.kd * rate;
+    }
+};
+
+template <typename T>
+class TimeToCollision {
+  private:
+    HoldTimer hold;
+
+  public:
+    typedef T Value;
+
+    // dist / rate < tauSec, without the division
+    T correction(const AxisConfig<T> &c, T dist, T rate, uint32_t nowMs) {
+      bool closing = rate > T(0) && dist < c.tauSec * rate;
+      bool on = hold.update(closing, nowMs, c.holdMs);
+      return on ? fullCorrection(c) : T(0);
+    }
+};
+
+template <typename T>
+class TauProportional {
+  public:
+    typedef T Value;
+
+    // full * (tauSec - tau) / (tauSec - tauFullSec), clamped to [0, full],
+    // rearranged with both sides times rate so the only division is by a
+    // larger denominator (never overflows Q16)
+    T correction(const AxisConfig<T> &c, T dist, T rate, uint32_t) {
+      if (!(rate > T(0))) return T(0);
+      T num = c.tauSec * rate - dist;
+      if (!(num > T(0))) return T(0);
+      T den = (c.tauSec - c.tauFullSec) * rate;
+      if (num >= den) return fullCorrection(c);
+      return fullCorrection(c) * (num / den);
+    }
+};
+
+template <class Policy>
+class ControlLaw {
+  public:
+    typedef typename Policy::Value Value;
+
+  private:
+    AxisConfig<Value> cfg;
+    Policy policy;
+
+  public:
+    ControlLaw(const AxisConfig<Value> &config) : cfg(config) {}
+
+    // Correction for this tick, in whole us towards correctUs (for
+    // ServoMap::command(), which applies the rest of update())
+    int offset(Value dist, Value rate, uint32_t nowMs) {
+      return toInt(policy.correction(cfg, dist, rate, nowMs));
+    }
+
+    // Servo pulse (us) for this tick
+    int update(Value dist, Value rate, uint32_t nowMs) {
+      int offset = this->offset(dist, rate, nowMs);
+      int us = cfg.correctUs > cfg.neutralUs ? cfg.neutralUs + offset : cfg.neutralUs - offset;
+      return us < cfg.minUs ? cfg.minUs : (us > cfg.maxUs ? cfg.maxUs : us);
+    }
+
+    const AxisConfig<Value>& config() const { return cfg; }
+};
+
+// =========================================================
+// Law selection: LawPolicy<CONTROL_LAW, real_t>::type
+// =========================================================
+const int LAW_BANG_BANG_HOLD    = 0;
+const int LAW_PROPORTIONAL      = 1;
+const int LAW_PD                = 2;
+const int LAW_TIME_TO_COLLISION = 3;
+const int LAW_TAU               = 4;
+
+template <int Law, typename T> struct LawPolicy;
+template <typename T> struct LawPolicy<LAW_BANG_BANG_HOLD, T>    { typedef BangBangHold<T> type; };
+template <typename T> struct LawPolicy<LAW_PROPORTIONAL, T>      { typedef Proportional<T> type; };
+template <typename T> struct LawPolicy<LAW_PD, T>                { typedef ProportionalDerivative<T> type; };
+template <typename T> struct LawPolicy<LAW_TIME_TO_COLLISION, T> { typedef TimeToCollision<T> type; };
+template <typename T> struct LawPolicy<LAW_TAU, T>               { typedef TauProportional<T> type; };
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef CONTROL_SCHEDULER_H
+#define CONTROL_SCHEDULER_H
+
+#include <stdint.h>
+
+// =========================================================
+// Timer-released control task with jitter statistics
+// =========================================================
+// A hardware timer interrupt calls release() once per period; loop() calls
+// begin() on every pass and runs the control step when it returns true.
+// Release instants come from the timer, not from when the previous pass
+// happened to finish, so a slow iteration delays one cycle instead of
+// shifting every later one (the old millis() gate drifted by the overshoot
+// each time).
+//
+// For every cycle it records the period since the previous cycle start
+// (as jitter against the nominal period), the start latency after its
+// release, and the busy time between begin() and end(). A release that
+// arrives while the previous one is still waiting is an overrun: the
+// missed cycles are counted and skipped, never run back to back.
+//
+// Handoff is lock-free like EchoCapture: the ISR writes releasedId and
+// releasedAtUs, loop() writes everything else. Nothing here touches
+// Arduino APIs, so the host tests drive it from a simulated clock.
+
+struct ControlStats {
+  uint32_t cycles;
+  uint32_t overruns;           // Releases skipped because a cycle was late
+  int32_t  minJitterUs;        // Period - nominal, over all cycles
+  int32_t  maxJitterUs;
+  int64_t  sumJitterUs;
+  uint32_t maxLatencyUs;       // Release to begin()
+  uint32_t sumLatencyUs;
+  uint32_t maxBusyUs;          // begin() to end()
+};
+
+class ControlScheduler {
+  private:
+    uint32_t periodUs;
+
+    volatile uint32_t releasedId;
+    volatile uint32_t releasedAtUs;
+
+    uint32_t consumedId;
+    uint32_t lastStartUs;
+    bool started;
+    ControlStats stats;
+
+  public:
+    ControlScheduler(uint32_t period) {
+      periodUs = period;
+      releasedId = 0;
+      releasedAtUs = 0;
+      consumedId = 0;
+      lastStartUs = 0;
+      started = false;
+      resetStats();
+    }
+
+    // ISR: the period timer fired at `nowUs`.
+    void release(uint32_t nowUs) {
+      releasedAtUs = nowUs;
+      releasedId = releasedId + 1;
+    }
+
+    // loop(): true when a cycle is due; starts it at `nowUs`.
+    bool begin(uint32_t nowUs) {
+      uint32_t id;
+      uint32_t atUs;
+      do {                                 // Re-read if the ISR fired in between
+        id = releasedId;
+        atUs = releasedAtUs;
+      } while (id != releasedId);
+
+      if (id == consumedId) return false;
+      stats.overruns += id - consumedId - 1;
+      consumedId = id;
+
+      if (started) {
+        uint32_t latency = nowUs - atUs;
+        if (latency > stats.maxLatencyUs) stats.maxLatencyUs = latency;
+        stats.sumLatencyUs += latency;
+
+        int32_t jitter = (int32_t)(nowUs - lastStartUs - periodUs);
+        if (stats.cycles == 0 || jitter < stats.minJitterUs) stats.minJitterUs = jitter;
+        if (stats.cycles == 0 || jitter > stats.maxJitterUs) stats.maxJitterUs = jitter;
+        stats.sumJitterUs += jitter;
+        stats.cycles++;
+      }
+      started = true;
+      lastStartUs = nowUs;
+      return true;
+    }
+
+    // loop(): the cycle started by begin() finished at `nowUs`.
+    void end(uint32_t nowUs) {
+      uint32_t busy = nowUs - lastStartUs;
+      if (busy > stats.maxBusyUs) stats.maxBusyUs = busy;
+    }
+
+    // Forgets past cycles; the next begin() only sets the period reference.
+    void resetStats() {
+      stats.cycles = 0;
+      stats.overruns = 0;
+      stats.minJitterUs = 0;
+      stats.maxJitterUs = 0;
+      stats.sumJitterUs = 0;
+      stats.maxLatencyUs = 0;
+      stats.sumLatencyUs = 0;
+      stats.maxBusyUs = 0;
+      started = false;
+    }
+
+    const ControlStats& timingStats() const { return stats; }
+
+    float meanJitterUs() const {
+      return stats.cycles ? (float)stats.sumJitterUs / stats.cycles : 0.0;
+    }
+
+    float meanLatencyUs() const {
+      return stats.cycles ? (float)stats.sumLatencyUs / stats.cycles : 0.0;
+    }
+
+    uint32_t period() const { return periodUs; }
+
+    // Time left until the next release is due (0 once it is), for work that
+    // must not hold up the next cycle
+    uint32_t usUntilNext(uint32_t nowUs) const {
+      uint32_t since = nowUs - releasedAtUs;
+      return since < periodUs ? periodUs - since : 0;
+    }
+};
+
+#endif
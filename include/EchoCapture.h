@@ -0,0 +1,118 @@
+#ifndef ECHO_CAPTURE_H
+#define ECHO_CAPTURE_H
+
+#include <stdint.h>
+
+// =========================================================
+// Interrupt-driven HC-SR04 echo capture
+// =========================================================
+// Replaces the blocking pulseIn() read. The loop arms a channel and fires
+// the trigger pulse, the echo pin's CHANGE interrupt timestamps both edges
+// with micros(), and the finished pulse width is handed back to loop().
+//
+// Handoff is lock-free: every field has exactly one writer.
+//   loop() writes  armedId, armedAtUs, consumedId
+//   ISR    writes  riseId, riseAtUs, widthUs, fallAtUs, doneId
+// A result is valid when doneId == armedId. The ISR stores the width before
+// doneId, and on the in-order M0+ a volatile 32-bit store is atomic, so
+// loop() never sees a half-written sample. Nothing here touches Arduino
+// APIs, so the same code runs in the host tests with a simulated clock.
+
+struct EchoSample {
+  uint32_t widthUs;    // Echo pulse width, 0 when the ping timed out
+  uint32_t stampUs;    // micros() of the falling edge (or of the timeout)
+  uint32_t armedUs;    // micros() of the arm() before the trigger
+};
+
+// When the range was measured: the echo mid-point, i.e. when the burst hit
+// the target. The falling edge is width/2 later, and a fixed trigger time
+// would carry the loop's scheduling jitter.
+inline uint32_t echoMidpointUs(const EchoSample &sample) {
+  return sample.stampUs - sample.widthUs / 2;
+}
+
+class EchoCapture {
+  private:
+    uint32_t timeoutUs;
+
+    volatile uint32_t armedId;
+    volatile uint32_t armedAtUs;
+    volatile uint32_t consumedId;
+
+    volatile uint32_t riseId;
+    volatile uint32_t riseAtUs;
+    volatile uint32_t widthUs;
+    volatile uint32_t fallAtUs;
+    volatile uint32_t doneId;
+
+  public:
+    EchoCapture(uint32_t timeout) {
+      timeoutUs = timeout;
+      armedId = 0;
+      armedAtUs = 0;
+      consumedId = 0;
+      riseId = 0;
+      riseAtUs = 0;
+      widthUs = 0;
+      fallAtUs = 0;
+      doneId = 0;
+    }
+
+    // loop(): call immediately before the trigger pulse.
+    void arm(uint32_t nowUs) {
+      armedAtUs = nowUs;
+      armedId = armedId + 1;
+    }
+
+    // ISR: echo pin changed to `level` at `nowUs`.
+    void onEdge(bool level, uint32_t nowUs) {
+      uint32_t id = armedId;
+      if (doneId == id) return;          // Nothing in flight
+
+      if (level) {
+        riseAtUs = nowUs;
+        riseId = id;
+      } else if (riseId == id) {
+        widthUs = nowUs - riseAtUs;
+        fallAtUs = nowUs;
+        doneId = id;                     // Publish last
+      }
+      // A falling edge without a matching rise belongs to an older ping
+      // whose echo line was still high when we re-armed; ignore it.
+    }
+
+    // loop(): true while a ping is armed and neither answered nor timed out.
+    bool pending(uint32_t nowUs) const {
+      uint32_t id = armedId;
+      if (consumedId == id || doneId == id) return false;
+      return (nowUs - armedAtUs) < timeoutUs;
+    }
+
+    // loop(): hands over the result of the armed ping exactly once.
+    // Returns false while the ping is still in flight.
+    bool fetch(uint32_t nowUs, EchoSample &out) {
+      uint32_t id = armedId;
+      if (consumedId == id) return false;
+
+      if (doneId == id) {
+        out.widthUs = widthUs;
+        out.stampUs = fallAtUs;
+      } else if ((nowUs - armedAtUs) >= timeoutUs) {
+        out.widthUs = 0;
+        out.stampUs = nowUs;
+      } else {
+        return false;
+      }
+
+      out.armedUs = armedAtUs;
+      consumedId = id;
+      return true;
+    }
+
+    // loop(): listen window for the next arm(); the ISR never reads it.
+    void setTimeout(uint32_t timeout) { timeoutUs = timeout; }
+
+    uint32_t timeout() const { return timeoutUs; }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+
+// =========================================================
+// Q16.16 fixed-point number
+// =========================================================
+// The SAMD21's Cortex-M0+ has no FPU, so every float add/mul/div in the
+// sensor -> rate -> servo path is a soft-float library call. Q16 keeps the
+// same operators on a 32-bit integer (16 fractional bits, range +-32767,
+// resolution 1.5e-5) so the templated stages in SignalPath.h compile for
+// either type. Literal constants convert at compile time.
+//
+// Products and quotients go through a 64-bit intermediate; Q16 * int and
+// Q16 / int stay 32-bit. Conversions to int truncate toward zero, matching
+// a float -> int cast. Integers outside the range and quotients that
+// overflow it (including division by zero) saturate at +-32767.99998
+// instead of wrapping; 0 / 0 is 0.
+
+class Q16 {
+  private:
+    int32_t raw;
+
+    struct RawTag {};
+    constexpr Q16(int32_t r, RawTag) : raw(r) {}
+
+    static constexpr int32_t roundToRaw(double v) {
+      return (int32_t)(v * 65536.0 + (v >= 0 ? 0.5 : -0.5));
+    }
+
+    static constexpr int32_t saturate(int64_t r) {
+      return r > INT32_MAX ? INT32_MAX : (r < INT32_MIN ? INT32_MIN : (int32_t)r);
+    }
+    static constexpr int32_t fromInteger(long long v) {
+      return v > 32767 ? INT32_MAX : (v < -32768 ? INT32_MIN : (int32_t)(v * 65536));
+    }
+    static constexpr int32_t fromUnsigned(unsigned long long v) {
+      return v > 32767u ? INT32_MAX : (int32_t)(v * 65536u);
+    }
+    // n / d; d == 0 pins to the end of the range n points at
+    static constexpr int32_t byZero(int64_t n) {
+      return n > 0 ? INT32_MAX : (n < 0 ? INT32_MIN : 0);
+    }
+    static constexpr int32_t divide(int64_t n, int32_t d) {
+      return d != 0 ? saturate(n / d) : byZero(n);
+    }
+    static constexpr int32_t divide32(int32_t n, int d) {
+      return d != 0 ? (d == -1 ? saturate(-(int64_t)n) : n / d) : byZero(n);
+    }
+
+  public:
+    constexpr Q16() : raw(0) {}
+    constexpr Q16(int v) : raw(fromInteger(v)) {}
+    constexpr Q16(unsigned int v) : raw(fromUnsigned(v)) {}
+    constexpr Q16(long v) : raw(fromInteger(v)) {}
+    constexpr Q16(unsigned long v) : raw(fromUnsigned(v)) {}
+    constexpr Q16(float v) : raw(roundToRaw(v)) {}
+    constexpr Q16(double v) : raw(roundToRaw(v)) {}
+
+    static constexpr Q16 fromRaw(int32_t r) { return Q16(r, RawTag()); }
+    constexpr int32_t rawValue() const { return raw; }
+
+    // Arithmetic
+    friend constexpr Q16 operator+(Q16 a, Q16 b) { return fromRaw(a.raw + b.raw); }
+    friend constexpr Q16 operator-(Q16 a, Q16 b) { return fromRaw(a.raw - b.raw); }
+    constexpr Q16 operator-() const { return fromRaw(-raw); }
+
+    friend constexpr Q16 operator*(Q16 a, Q16 b) {
+      return fromRaw((int32_t)(((int64_t)a.raw * b.raw) >> 16));
+    }
+    friend constexpr Q16 operator*(Q16 a, int b) { return fromRaw(a.raw * b); }
+    friend constexpr Q16 operator*(int a, Q16 b) { return fromRaw(a * b.raw); }
+    // Without these a double operand would silently truncate to the int overload
+    friend constexpr Q16 operator*(Q16 a, double b) { return a * Q16(b); }
+    friend constexpr Q16 operator*(double a, Q16 b) { return Q16(a) * b; }
+
+    friend constexpr Q16 operator/(Q16 a, Q16 b) {
+      return fromRaw(divide((int64_t)a.raw * 65536, b.raw));
+    }
+    friend constexpr Q16 operator/(Q16 a, int b) { return fromRaw(divide32(a.raw, b)); }
+    friend constexpr Q16 operator/(Q16 a, double b) { return a / Q16(b); }
+
+    Q16& operator+=(Q16 b) { raw += b.raw; return *this; }
+    Q16& operator-=(Q16 b) { raw -= b.raw; return *this; }
+
+    // Comparison
+    friend constexpr bool operator==(Q16 a, Q16 b) { return a.raw == b.raw; }
+    friend constexpr bool operator!=(Q16 a, Q16 b) { return a.raw != b.raw; }
+    friend constexpr bool operator<(Q16 a, Q16 b)  { return a.raw < b.raw; }
+    friend constexpr bool operator>(Q16 a, Q16 b)  { return a.raw > b.raw; }
+    friend constexpr bool operator<=(Q16 a, Q16 b) { return a.raw <= b.raw; }
+    friend constexpr bool operator>=(Q16 a, Q16 b) { return a.raw >= b.raw; }
+};
+
+// Conversions shared by both number types, so templated code can say
+// toInt(x) / toFloat(x) without caring which one it was built with.
+inline int toInt(Q16 v) {
+  int32_t r = v.rawValue();
+  return r >= 0 ? (int)(r >> 16) : -(int)((-r) >> 16);
+}
+inline int toInt(float v)  { return (int)v; }
+inline int toInt(double v) { return (int)v; }
+
+inline float toFloat(Q16 v)   { return v.rawValue() / 65536.0f; }
+inline float toFloat(float v) { return v; }
+
+#endif
@@ -0,0 +1,312 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "Telemetry.h"
+
+// =========================================================
+// Flight recorder: RAM during flight, NVM rows after landing
+// =========================================================
+// The glider usually flies untethered, so the serial telemetry goes
+// nowhere. The recorder keeps each control tick's TelemetrySample as a
+// 24-byte record in a RAM image of one flash slot. Nothing touches flash in
+// flight. After landing, or when the image is full, step() commits the
+// image one NVM operation at a time: a row erase, or a page write.
+//
+// On the SAMD21 the CPU stalls on every flash fetch while the NVM
+// controller is busy, about 6ms for a row erase and 2.5ms for a page write.
+// Interrupts stall too. step() is therefore given the time left before the
+// next control release and only starts an operation whose worst case fits.
+// The commit spreads over the gaps between ticks and never delays one.
+//
+// Slot layout (SLOT_ROWS rows): page 0 is the header, then the records.
+// The header is written last, so a commit cut short by power loss leaves
+// no valid flight. New flights go to the slot after the newest one, so the
+// oldest is overwritten first.
+//
+// Flash access goes through a Hw class: Samd21Flash below on the board, or
+// the flash emulator in test/test_flight_recorder_host.cpp on the host.
+
+const uint32_t RECORDER_MAGIC = 0x31544C46;   // "FLT1"
+const int RECORDER_RECORD_BYTES = 24;
+
+struct RecorderHeader {
+  uint32_t magic;
+  uint32_t flight;           // Counts up across slots
+  uint16_t records;
+  uint16_t truncated;        // 1 if the image filled before landing
+  uint16_t checksum;         // Fletcher-16 of the records
+  uint16_t recordBytes;
+};
+
+// Record, little-endian: time since launch in ms (u16), then the
+// TelemetrySample fields in frame order, raw echoes included, flags, one
+// spare byte
+inline void packRecord(const TelemetrySample &s, uint8_t *p) {
+  putU16(p, s.timeMs > 0xFFFF ? 0xFFFF : (uint16_t)s.timeMs);
+  putU16(p + 2, (uint16_t)s.rightMm);
+  putU16(p + 4, (uint16_t)s.heightMm);
+  putU16(p + 6, (uint16_t)s.rateRightMmS);
+  putU16(p + 8, (uint16_t)s.rateHeightMmS);
+  putU16(p + 10, s.rudderUs);
+  putU16(p + 12, s.elevatorUs);
+  putU16(p + 14, s.rightEchoUs);
+  putU16(p + 16, s.rightEchoAtUs);
+  putU16(p + 18, s.heightEchoUs);
+  putU16(p + 20, s.heightEchoAtUs);
+  p[22] = s.flags;
+  p[23] = 0xFF;
+}
+
+inline void unpackRecord(const uint8_t *p, TelemetrySample &s) {
+  s.timeMs = getU16(p);
+  s.rightMm = (int16_t)getU16(p + 2);
+  s.heightMm = (int16_t)getU16(p + 4);
+  s.rateRightMmS = (int16_t)getU16(p + 6);
+  s.rateHeightMmS = (int16_t)getU16(p + 8);
+  s.rudderUs = getU16(p + 10);
+  s.elevatorUs = getU16(p + 12);
+  s.rightEchoUs = getU16(p + 14);
+  s.rightEchoAtUs = getU16(p + 16);
+  s.heightEchoUs = getU16(p + 18);
+  s.heightEchoAtUs = getU16(p + 20);
+  s.flags = p[22];
+}
+
+template <class Flash, int RECORDS>
+class FlightRecorder {
+  public:
+    static const uint32_t PAGE = Flash::PAGE_BYTES;
+    static const uint32_t ROW = Flash::ROW_BYTES;
+    static const uint32_t SLOT_ROWS = (PAGE + RECORDS * RECORDER_RECORD_BYTES + ROW - 1) / ROW;
+    static const uint32_t SLOT_BYTES = SLOT_ROWS * ROW;
+    static const int CAPACITY = RECORDS;
+
+    enum State { IDLE, RECORDING, COMMITTING, ERASING };
+
+  private:
+    Flash &flash;
+    uint32_t base;
+    int slots;
+
+    uint32_t image[SLOT_BYTES / 4];      // Slot image: header page + records
+    uint16_t count;
+    bool full;
+    State state;
+
+    int slot;                            // Being committed or erased
+    uint32_t op;                         // Next operation within it
+    uint32_t newestFlight;
+    int newestSlot;
+
+    uint8_t *bytes() { return (uint8_t *)image; }
+    uint32_t slotAddr(int s) const { return base + (uint32_t)s * SLOT_BYTES; }
+
+    // Commit order per row: erase, then its pages; the header page (row 0,
+    // page 0) is skipped and written after everything else
+    static const uint32_t PAGES_PER_ROW = ROW / PAGE;
+    static const uint32_t OPS_PER_ROW = 1 + PAGES_PER_ROW;
+    static const uint32_t COMMIT_OPS = SLOT_ROWS * OPS_PER_ROW + 1;   // Then the header
+
+    uint32_t opCostUs(uint32_t n) const {
+      if (n == COMMIT_OPS - 1) return Flash::WRITE_US;
+      if (n == 1) return 0;                        // Header page, deferred
+      return (n % OPS_PER_ROW == 0) ? Flash::ERASE_US : Flash::WRITE_US;
+    }
+
+    void runOp(uint32_t n) {
+      uint32_t addr = slotAddr(slot);
+      if (n == COMMIT_OPS - 1) {
+        flash.writePage(addr, image);
+        return;
+      }
+      uint32_t row = n / OPS_PER_ROW;
+      uint32_t k = n % OPS_PER_ROW;
+      if (k == 0) {
+        flash.eraseRow(addr + row * ROW);
+      } else {
+        uint32_t offset = row * ROW + (k - 1) * PAGE;
+        if (offset != 0) flash.writePage(addr + offset, image + offset / 4);
+      }
+    }
+
+  public:
+    // `slotCount` slots of SLOT_BYTES from `baseAddr` (row aligned)
+    FlightRecorder(Flash &f, uint32_t baseAddr, int slotCount)
+      : flash(f), base(baseAddr), slots(slotCount) {
+      count = 0;
+      full = false;
+      state = IDLE;
+      slot = 0;
+      op = 0;
+      newestFlight = 0;
+      newestSlot = -1;
+    }
+
+    // Finds the newest stored flight (reads only)
+    void begin() {
+      newestFlight = 0;
+      newestSlot = -1;
+      for (int s = 0; s < slots; s++) {
+        RecorderHeader h;
+        if (readHeader(s, h) && (newestSlot < 0 || h.flight > newestFlight)) {
+          newestFlight = h.flight;
+          newestSlot = s;
+        }
+      }
+    }
+
+    // Launch: start a fresh image (ignored while a commit is running)
+    void start() {
+      if (state != IDLE) return;
+      count = 0;
+      full = false;
+      state = RECORDING;
+    }
+
+    // Control tick, RAM only. Filling the image ends the recording.
+    void record(const TelemetrySample &s) {
+      if (state != RECORDING) return;
+      packRecord(s, bytes() + PAGE + count * RECORDER_RECORD_BYTES);
+      if (++count == RECORDS) {
+        full = true;
+        finish();
+      }
+    }
+
+    // Landing: seal the image and queue the commit
+    void finish() {
+      if (state != RECORDING) return;
+      uint8_t *b = bytes();
+      memset(b + PAGE + count * RECORDER_RECORD_BYTES, 0xFF,
+             SLOT_BYTES - PAGE - count * RECORDER_RECORD_BYTES);
+      memset(b, 0xFF, PAGE);
+      RecorderHeader h;
+      h.magic = RECORDER_MAGIC;
+      h.flight = newestFlight + 1;
+      h.records = count;
+      h.truncated = full;
+      h.checksum = telemetryChecksum(b + PAGE, count * RECORDER_RECORD_BYTES);
+      h.recordBytes = RECORDER_RECORD_BYTES;
+      memcpy(b, &h, sizeof(h));
+
+      slot = newestSlot < 0 ? 0 : (newestSlot + 1) % slots;
+      op = 0;
+      state = COMMITTING;
+    }
+
+    // Queue an erase of every slot (not while recording)
+    void eraseAll() {
+      if (state == RECORDING) return;
+      slot = 0;
+      op = 0;
+      state = ERASING;
+    }
+
+    // One flash operation, if one is pending and its worst case fits in
+    // `usAvailable`. Returns true if it ran one.
+    bool step(uint32_t usAvailable) {
+      if (state == COMMITTING) {
+        if (opCostUs(op) > usAvailable) return false;
+        runOp(op);
+        if (++op == COMMIT_OPS) {
+          newestFlight++;
+          newestSlot = slot;
+          state = IDLE;
+        }
+        return true;
+      }
+      if (state == ERASING) {
+        if (Flash::ERASE_US > usAvailable) return false;
+        flash.eraseRow(base + op * ROW);
+        if (++op == (uint32_t)slots * SLOT_ROWS) {
+          newestSlot = -1;
+          state = IDLE;
+        }
+        return true;
+      }
+      return false;
+    }
+
+    State status() const { return state; }
+    int recorded() const { return count; }
+    int slotCount() const { return slots; }
+    int newest() const { return newestSlot; }
+    // Commit operations left (0 when idle)
+    uint32_t pendingOps() const { return state == COMMITTING ? COMMIT_OPS - op : 0; }
+
+    // Stored flight in slot `s`; false if erased or half written
+    bool readHeader(int s, RecorderHeader &h) const {
+      flash.read(slotAddr(s), &h, sizeof(h));
+      return h.magic == RECORDER_MAGIC && h.records <= RECORDS &&
+             h.recordBytes == RECORDER_RECORD_BYTES;
+    }
+
+    void readRecord(int s, int i, TelemetrySample &out) const {
+      uint8_t p[RECORDER_RECORD_BYTES];
+      flash.read(slotAddr(s) + PAGE + i * RECORDER_RECORD_BYTES, p, RECORDER_RECORD_BYTES);
+      unpackRecord(p, out);
+    }
+
+    // Recomputes the stored records' checksum against the header
+    bool verify(int s) const {
+      RecorderHeader h;
+      if (!readHeader(s, h)) return false;
+      uint16_t a = 0, b = 0;
+      for (int i = 0; i < h.records * RECORDER_RECORD_BYTES; i++) {
+        uint8_t v;
+        flash.read(slotAddr(s) + PAGE + i, &v, 1);
+        a = (a + v) % 255;
+        b = (b + a) % 255;
+      }
+      return h.checksum == (uint16_t)((b << 8) | a);
+    }
+};
+
+#if defined(ARDUINO_ARCH_SAMD)
+// SAMD21 NVM controller, manual page writes. The CPU (and every interrupt)
+// waits while a command runs; ERASE_US and WRITE_US are the datasheet
+// worst cases.
+class Samd21Flash {
+  private:
+    static void waitReady() {
+      while (!NVMCTRL->INTFLAG.bit.READY);
+    }
+
+    static void command(uint32_t cmd) {
+      NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | cmd;
+      waitReady();
+    }
+
+  public:
+    static const uint32_t PAGE_BYTES = 64;
+    static const uint32_t ROW_BYTES = 256;
+    static const uint32_t ERASE_US = 6000;
+    static const uint32_t WRITE_US = 2500;
+
+    void begin() {
+      NVMCTRL->CTRLB.bit.MANW = 1;
+    }
+
+    void eraseRow(uint32_t addr) {
+      NVMCTRL->STATUS.reg |= NVMCTRL_STATUS_MASK;
+      NVMCTRL->ADDR.reg = addr / 2;
+      command(NVMCTRL_CTRLA_CMD_ER);
+    }
+
+    void writePage(uint32_t addr, const uint32_t *words) {
+      command(NVMCTRL_CTRLA_CMD_PBC);
+      volatile uint32_t *dst = (volatile uint32_t *)(uintptr_t)addr;
+      for (uint32_t i = 0; i < PAGE_BYTES / 4; i++) dst[i] = words[i];
+      NVMCTRL->ADDR.reg = addr / 2;
+      command(NVMCTRL_CTRLA_CMD_WP);
+    }
+
+    void read(uint32_t addr, void *out, uint32_t len) const {
+      memcpy(out, (const void *)(uintptr_t)addr, len);
+    }
+};
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef HAL_H
+#define HAL_H
+
+// =========================================================
+// Hardware abstraction for src/main.cpp
+// =========================================================
+// The sketch reaches the board only through these, so the flight code
+// builds both for the board and as a Linux program:
+//   Clock   halMicros(), halMillis()            free-running, wrap at 32 bits
+//           halDelayUs(us), halDelayMs(ms)      busy-wait
+//   Sonar   halSonarPins(trig, echo)            trigger out, echo in
+//           halEchoInterrupt(echo, isr)         isr on both echo edges
+//           halTriggerWrite(trig, high)         drive the trigger pin
+//           halEchoRead(echo)                   echo level (isr, busy check)
+//   Servo   HalServo                            attach(pin), writeMicroseconds(us)
+//   Log     halLog                              Serial's begin / print / println /
+//                                               write / available / read /
+//                                               availableForWrite / operator bool
+//
+// Backends:
+//   Arduino (HalArduino.h)  the Arduino core calls, one to one: SAMD21
+//                           flight board and any other Arduino board
+//   Linux   (HalLinux.h)    a virtual µs clock; echo pulses from a range
+//                           or echo callback, servo writes to a callback, the log to
+//                           a FILE*. The driver moves the clock between
+//                           loop() calls (tools/host, tools/replay).
+// Board-only peripherals (TCC0 servo output, the TC3 control timer, NVM)
+// stay behind ARDUINO_ARCH_SAMD in the sketch, as before.
+
+#if defined(ARDUINO)
+#include "HalArduino.h"
+#else
+#include "HalLinux.h"
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef HAL_ARDUINO_H
+#define HAL_ARDUINO_H
+
+// =========================================================
+// HAL backend: the Arduino core (SAMD21 flight board)
+// =========================================================
+// Each call is the Arduino call it replaces and inlines to it, so the board
+// build does exactly what it did before the HAL (see Hal.h).
+
+#include <Arduino.h>
+#include <Servo.h>
+
+inline uint32_t halMicros() { return micros(); }
+inline uint32_t halMillis() { return millis(); }
+inline void halDelayUs(uint32_t us) { delayMicroseconds(us); }
+inline void halDelayMs(uint32_t ms) { delay(ms); }
+
+inline void halSonarPins(int trigPin, int echoPin) {
+  pinMode(trigPin, OUTPUT);
+  pinMode(echoPin, INPUT);
+}
+
+inline void halEchoInterrupt(int echoPin, void (*isr)()) {
+  attachInterrupt(digitalPinToInterrupt(echoPin), isr, CHANGE);
+}
+
+inline void halTriggerWrite(int trigPin, bool high) { digitalWrite(trigPin, high ? HIGH : LOW); }
+inline int halEchoRead(int echoPin) { return digitalRead(echoPin); }
+
+typedef Servo HalServo;
+
+// The board's Serial (native USB on the SAMD21), whatever its class
+typedef decltype(Serial) HalLogPort;
+static HalLogPort &halLog = Serial;
+
+#endif
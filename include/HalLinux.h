@@ -0,0 +1,324 @@
+#ifndef HAL_LINUX_H
+#define HAL_LINUX_H
+
+// =========================================================
+// HAL backend: Linux, on a virtual clock
+// =========================================================
+// For running the sketch off the board (see Hal.h). Nothing happens on its
+// own: the driver moves the clock between loop() calls, e.g. with
+// halLinuxRun(), and the hardware follows it:
+//   - halMicros() / halMillis() read the virtual µs clock; the delays
+//     advance it.
+//   - A falling edge on a trigger pin asks the driver's range callback what
+//     the sonar sees at that moment and schedules an echo pulse as wide as
+//     that range, or asks the echo callback, if set, for the pulse's edges
+//     outright (a recorded echo). With no echo the line goes high for
+//     missHoldUs, as an HC-SR04's does, or stays low if that is 0. The edges
+//     call the echo interrupt handler at their exact times, whenever the
+//     clock moves past them.
+//   - Servo writes go to the driver's callback with the time of the write.
+//   - halLog output goes to logOut (dropped if NULL); input comes from logIn.
+// With skipIdle set (during setup()), each halMicros() call jumps the
+// clock to the next pending edge, so setup()'s busy-wait for an echo takes
+// a few iterations instead of thousands.
+//
+// A run leaves the sketch's globals and this HAL's state behind, so each
+// run goes in a child process of its own (halLinuxPowerCycle()).
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <string>
+#include <type_traits>
+
+// Arduino's constrain(), which the sketch uses
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+const int HAL_LINUX_PINS = 32;
+const int HAL_LINUX_EDGES = 16;
+const uint32_t HAL_LINUX_MISS_HOLD_US = 38000;   // HC-SR04 echo line after a miss
+
+struct HalLinuxEdge {
+  uint64_t atUs;
+  int pin;
+  int level;
+};
+
+// Range in cm the sonar on `trigPin` sees at `nowUs`; <= 0 for no echo
+typedef float (*HalRangeFn)(void *ctx, int trigPin, uint64_t nowUs);
+// Echo edges for the trigger on `trigPin` that fell at `nowUs`, both after
+// it; false for no echo
+typedef bool (*HalEchoFn)(void *ctx, int trigPin, uint64_t nowUs, uint64_t &riseUs, uint64_t &fallUs);
+typedef void (*HalServoFn)(void *ctx, int pin, int us, uint64_t atUs);
+
+struct HalLinuxState {
+  uint64_t nowUs;
+  bool inIsr;
+  bool skipIdle;
+  int level[HAL_LINUX_PINS];
+  void (*isr[HAL_LINUX_PINS])();
+  int echoPin[HAL_LINUX_PINS];       // Trigger pin -> echo pin + 1 (0: not a trigger)
+
+  HalLinuxEdge edges[HAL_LINUX_EDGES];   // Pending, unsorted
+  int edgeCount;
+
+  HalRangeFn range;
+  HalEchoFn echo;                    // Takes precedence over range
+  HalServoFn servo;
+  void *ctx;
+  uint32_t burstUs;                  // Trigger to echo rise
+  float usPerCm;                     // Echo width per cm of range
+  float maxRangeCm;                  // Farther gives no echo
+  uint32_t missHoldUs;               // Echo line high after no echo (0: stays low)
+
+  FILE *logOut;
+  const char *logIn;
+};
+
+inline HalLinuxState &halLinux() {
+  static HalLinuxState state;
+  return state;
+}
+
+inline uint64_t halLinuxNextEdgeUs() {
+  HalLinuxState &s = halLinux();
+  uint64_t next = UINT64_MAX;
+  for (int i = 0; i < s.edgeCount; i++) {
+    if (s.edges[i].atUs < next) next = s.edges[i].atUs;
+  }
+  return next;
+}
+
+// Moves the clock to `t`, running every edge up to it in time order
+inline void halLinuxAdvanceTo(uint64_t t) {
+  HalLinuxState &s = halLinux();
+  while (s.edgeCount > 0) {
+    int first = 0;
+    for (int i = 1; i < s.edgeCount; i++) {
+      if (s.edges[i].atUs < s.edges[first].atUs) first = i;
+    }
+    if (s.edges[first].atUs > t) break;
+    HalLinuxEdge e = s.edges[first];
+    s.edges[first] = s.edges[--s.edgeCount];
+    if (e.atUs > s.nowUs) s.nowUs = e.atUs;
+    s.level[e.pin] = e.level;
+    if (s.isr[e.pin]) {
+      s.inIsr = true;
+      s.isr[e.pin]();
+      s.inIsr = false;
+    }
+  }
+  if (t > s.nowUs) s.nowUs = t;
+}
+
+inline void halLinuxSchedule(uint64_t atUs, int pin, int level) {
+  HalLinuxState &s = halLinux();
+  if (s.edgeCount < HAL_LINUX_EDGES) {
+    HalLinuxEdge e = { atUs, pin, level };
+    s.edges[s.edgeCount++] = e;
+  }
+}
+
+// Calls loop() until `endUs`. Whenever nextDue(now) (the sketch's next task
+// release) is still ahead, the clock jumps to it or to the next echo edge,
+// whichever comes first: nothing would run in between on the board either.
+template <class NextDue>
+void halLinuxRun(uint64_t endUs, void (*loopFn)(), NextDue nextDue) {
+  HalLinuxState &s = halLinux();
+  while (s.nowUs < endUs) {
+    uint32_t now32 = (uint32_t)s.nowUs;
+    uint64_t due = s.nowUs + (uint32_t)(nextDue(now32) - now32);
+    if (due <= s.nowUs) {
+      loopFn();
+      continue;
+    }
+    uint64_t edge = halLinuxNextEdgeUs();
+    uint64_t next = due < edge ? due : edge;
+    halLinuxAdvanceTo(next < endUs ? next : endUs);
+  }
+}
+
+// ---------------------------------------------------------
+// Power cycle
+// ---------------------------------------------------------
+// Runs fn(ctx, out) in a forked child: a fresh board, as long as the
+// driver never runs the sketch in its own process. Whatever fn leaves in
+// the globals dies with the child, heap included. `out` comes back through
+// a pipe; stdio is flushed on both sides of the fork so output isn't
+// duplicated or lost. False if the child couldn't be started or didn't
+// exit cleanly.
+inline bool halLinuxPowerCycle(void (*fn)(void *ctx, std::string &out), void *ctx, std::string &out) {
+  int fds[2];
+  fflush(NULL);
+  if (pipe(fds) != 0) return false;
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    std::string result;
+    fn(ctx, result);
+    fflush(NULL);
+    const char *p = result.data();
+    size_t left = result.size();
+    while (left > 0) {
+      ssize_t n = write(fds[1], p, left);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) _exit(1);
+      p += n;
+      left -= (size_t)n;
+    }
+    _exit(0);
+  }
+
+  close(fds[1]);
+  out.clear();
+  char buf[4096];
+  for (;;) {
+    ssize_t n = read(fds[0], buf, sizeof(buf));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    out.append(buf, (size_t)n);
+  }
+  close(fds[0]);
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) return false;
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// ---------------------------------------------------------
+// HAL calls
+// ---------------------------------------------------------
+inline uint32_t halMicros() {
+  HalLinuxState &s = halLinux();
+  if (s.skipIdle && !s.inIsr) {
+    uint64_t next = halLinuxNextEdgeUs();
+    halLinuxAdvanceTo(next != UINT64_MAX ? next : s.nowUs + 10);
+  }
+  return (uint32_t)s.nowUs;
+}
+
+inline uint32_t halMillis() {
+  return (uint32_t)(halLinux().nowUs / 1000);
+}
+
+inline void halDelayUs(uint32_t us) {
+  halLinuxAdvanceTo(halLinux().nowUs + us);
+}
+
+inline void halDelayMs(uint32_t ms) {
+  halLinuxAdvanceTo(halLinux().nowUs + (uint64_t)ms * 1000);
+}
+
+inline void halSonarPins(int trigPin, int echoPin) {
+  halLinux().echoPin[trigPin] = echoPin + 1;
+}
+
+inline void halEchoInterrupt(int echoPin, void (*isr)()) {
+  halLinux().isr[echoPin] = isr;
+}
+
+inline void halTriggerWrite(int trigPin, bool high) {
+  HalLinuxState &s = halLinux();
+  bool fell = s.level[trigPin] && !high;
+  s.level[trigPin] = high ? 1 : 0;
+  if (!fell || !s.echoPin[trigPin] || (!s.range && !s.echo)) return;
+
+  int echo = s.echoPin[trigPin] - 1;
+  uint64_t rise = s.nowUs + s.burstUs, fall = 0;
+  bool heard;
+  if (s.echo) {
+    heard = s.echo(s.ctx, trigPin, s.nowUs, rise, fall) && rise > s.nowUs && fall > rise;
+    if (!heard) rise = s.nowUs + s.burstUs;
+  } else {
+    float cm = s.range(s.ctx, trigPin, s.nowUs);
+    heard = cm > 0 && cm <= s.maxRangeCm;
+    if (heard) fall = rise + (uint64_t)(cm * s.usPerCm + 0.5f);
+  }
+  if (!heard && !s.missHoldUs) return;
+  halLinuxSchedule(rise, echo, 1);
+  halLinuxSchedule(heard ? fall : rise + s.missHoldUs, echo, 0);
+}
+
+inline int halEchoRead(int echoPin) {
+  return halLinux().level[echoPin];
+}
+
+class HalServo {
+  private:
+    int pin;
+
+  public:
+    HalServo() : pin(-1) {}
+
+    void attach(int p) { pin = p; }
+
+    void writeMicroseconds(int us) {
+      HalLinuxState &s = halLinux();
+      if (s.servo) s.servo(s.ctx, pin, us, s.nowUs);
+    }
+};
+
+// Serial's print API on a FILE*, formatted the way the Arduino core does
+class HalLinuxLog {
+  private:
+    static FILE *out() { return halLinux().logOut; }
+
+    template <class T>
+    static typename std::enable_if<std::is_integral<T>::value>::type put(T v, int) {
+      if (std::is_signed<T>::value) fprintf(out(), "%lld", (long long)v);
+      else                          fprintf(out(), "%llu", (unsigned long long)v);
+    }
+    template <class T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type put(T v, int digits) {
+      fprintf(out(), "%.*f", digits, (double)v);
+    }
+    static void put(char c, int) { fputc(c, out()); }
+    static void put(const char *str, int) { fputs(str, out()); }
+
+  public:
+    void begin(long) {}
+    operator bool() const { return out() != NULL; }
+
+    template <class T> void print(T v, int digits = 2) {
+      if (out()) put(v, digits);
+    }
+    template <class T> void println(T v, int digits = 2) {
+      if (out()) {
+        put(v, digits);
+        fputs("\r\n", out());
+      }
+    }
+    void println() {
+      if (out()) fputs("\r\n", out());
+    }
+
+    int available() { return halLinux().logIn && *halLinux().logIn ? 1 : 0; }
+    int read() { return available() ? *halLinux().logIn++ : -1; }
+    int availableForWrite() { return 4096; }
+    size_t write(uint8_t b) {
+      if (out()) fputc(b, out());
+      return 1;
+    }
+    size_t write(const uint8_t *data, size_t len) {
+      if (out()) fwrite(data, 1, len, out());
+      return len;
+    }
+};
+
+typedef HalLinuxLog HalLogPort;
+static HalLinuxLog halLog;
+
+#endif
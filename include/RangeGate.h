@@ -0,0 +1,89 @@
+#ifndef RANGE_GATE_H
+#define RANGE_GATE_H
+
+#include <stdint.h>
+
+// =========================================================
+// Adaptive sonar listen window ("range gate")
+// =========================================================
+// Sizes each ping's listening window from where the target should be:
+// the last filtered distance, plus how far it can move at the current rate
+// over horizonSec, plus a margin. Echoes that land later are treated as
+// misses, which also throws away far-field multipath returns. After
+// lostAfter consecutive misses the gate opens to maxUs until the target is
+// reacquired.
+
+const float SONAR_US_PER_CM = 58.0;      // Round trip, matches SPEED_OF_SOUND_DIVISOR
+
+class RangeGate {
+  private:
+    float marginCm;
+    float horizonSec;
+    uint32_t burstUs;                    // Trigger to echo-line rise
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t baselineUs;                 // Fixed window we are saving against
+    int lostAfter;
+    int missStreak;
+    bool acquired;
+
+    uint32_t windows;
+    uint32_t savedUs;
+
+  public:
+    RangeGate(float margin, float horizon, uint32_t burst, uint32_t minWindow, uint32_t maxWindow,
+              uint32_t baseline, int lostAfterMisses) {
+      marginCm = margin;
+      horizonSec = horizon;
+      burstUs = burst;
+      minUs = minWindow;
+      maxUs = maxWindow;
+      baselineUs = baseline;
+      lostAfter = lostAfterMisses;
+      missStreak = 0;
+      acquired = false;
+      resetStats();
+    }
+
+    // Feed whether this tick produced a valid range.
+    void record(bool hit) {
+      if (hit) {
+        missStreak = 0;
+        acquired = true;
+      } else if (++missStreak >= lostAfter) {
+        acquired = false;
+      }
+    }
+
+    // Listen window in microseconds (measured from the trigger) for the
+    // next pings, given the filtered distance and rate (either sign).
+    uint32_t windowUs(float distCm, float rateCmS) {
+      uint32_t window = maxUs;
+
+      if (acquired) {
+        float travelCm = (rateCmS < 0 ? -rateCmS : rateCmS) * horizonSec;
+        float reachCm = distCm + travelCm + marginCm;
+        float us = reachCm * SONAR_US_PER_CM + burstUs;
+        if (us < minUs) window = minUs;
+        else if (us < maxUs) window = (uint32_t)us;
+      }
+
+      windows++;
+      if (window < baselineUs) savedUs += baselineUs - window;
+      return window;
+    }
+
+    bool tracking() const { return acquired; }
+
+    void resetStats() {
+      windows = 0;
+      savedUs = 0;
+    }
+
+    // Mean listening time saved per window against the fixed baseline
+    uint32_t meanSavedUs() const {
+      return windows ? savedUs / windows : 0;
+    }
+};
+
+#endif
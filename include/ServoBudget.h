@@ -0,0 +1,121 @@
+#ifndef SERVO_BUDGET_H
+#define SERVO_BUDGET_H
+
+#include <stdint.h>
+
+// =========================================================
+// Per-servo activity budget setting the write granularity
+// =========================================================
+// The fixed 300us deadband kept the servos from chattering, but it also
+// dropped every correction smaller than 300us, cold servo or not. Here each
+// servo keeps a heat estimate instead: every microsecond of travel written
+// adds one unit, holding off neutral adds holdPermille/1000 per us per tick
+// (the motor pushes against the air load), and it cools by coolPermille/1000
+// of itself each tick. The granularity, the change a new command must
+// exceed before it is written, rises linearly from minStepUs when cold to
+// maxStepUs at limitUs of heat. Small fast corrections pass while the
+// budget allows, and a servo that has been busy is throttled back to the old
+// deadband.
+//
+// The pulse starts at neutral, which setup() writes, so the first command
+// is compared against what the servo actually holds.
+//
+// Integer only; heat is kept in thousandths of a microsecond of travel.
+
+struct ServoBudgetConfig {
+  int minStepUs;             // Granularity with a cold servo
+  int maxStepUs;             // Granularity at or above limitUs of heat
+  int32_t limitUs;           // Heat (us of travel) at which the budget is spent
+  int holdPermille;          // Heat per tick per us of deflection, x1000
+  int coolPermille;          // Share of the heat shed per tick, x1000
+};
+
+// Per flight (reset at launch)
+struct ServoBudgetStats {
+  uint32_t ticks;
+  uint32_t writes;           // Ticks that changed the pulse
+  uint32_t suppressed;       // Changes held back by the granularity
+  uint32_t movedUs;          // Travel written
+  uint32_t deflectedTicks;   // Ticks spent off neutral
+  uint32_t deflectionUsTicks;// Sum of |pulse - neutral| over ticks
+  int32_t  peakHeatUs;
+  int      peakStepUs;       // Coarsest granularity reached
+};
+
+class ServoBudget {
+  private:
+    ServoBudgetConfig cfg;
+    int neutral;
+    int pulse;
+    int32_t heatMilli;
+    bool changed;
+    ServoBudgetStats stats;
+
+    static int absInt(int v) { return v < 0 ? -v : v; }
+
+  public:
+    ServoBudget(const ServoBudgetConfig &c, int neutralUs) : cfg(c), neutral(neutralUs) {
+      pulse = neutralUs;
+      heatMilli = 0;
+      changed = false;
+      resetStats();
+    }
+
+    // Change a command must exceed to be written now
+    int stepUs() const {
+      int32_t heat = heatUs();
+      if (heat >= cfg.limitUs) return cfg.maxStepUs;
+      return cfg.minStepUs + (int)((int32_t)(cfg.maxStepUs - cfg.minStepUs) * heat / cfg.limitUs);
+    }
+
+    // Once per control tick: the pulse to send for `commandUs`, which is
+    // the last one sent unless the change clears the granularity
+    int update(int commandUs) {
+      int step = stepUs();
+      int delta = absInt(commandUs - pulse);
+      changed = delta > step;
+      if (changed) {
+        pulse = commandUs;
+        heatMilli += (int32_t)delta * 1000;
+        stats.writes++;
+        stats.movedUs += delta;
+      } else if (delta > 0) {
+        stats.suppressed++;
+      }
+
+      int deflection = absInt(pulse - neutral);
+      heatMilli += (int32_t)deflection * cfg.holdPermille;
+      heatMilli -= heatMilli / 1000 * cfg.coolPermille;
+      // Past twice the limit the granularity is already at its maximum;
+      // the cap only keeps the arithmetic in range
+      if (heatMilli > cfg.limitUs * 2000) heatMilli = cfg.limitUs * 2000;
+
+      stats.ticks++;
+      if (deflection > 0) stats.deflectedTicks++;
+      stats.deflectionUsTicks += deflection;
+      if (heatUs() > stats.peakHeatUs) stats.peakHeatUs = heatUs();
+      if (step > stats.peakStepUs) stats.peakStepUs = step;
+      return pulse;
+    }
+
+    // Whether the last update() changed the pulse
+    bool moved() const { return changed; }
+    int pulseUs() const { return pulse; }
+    int32_t heatUs() const { return heatMilli / 1000; }
+    // Heat as a share of the limit, 0-1000 (more when over it)
+    int32_t heatPermille() const { return heatMilli / cfg.limitUs; }
+
+    const ServoBudgetStats& budgetStats() const { return stats; }
+    void resetStats() {
+      stats.ticks = 0;
+      stats.writes = 0;
+      stats.suppressed = 0;
+      stats.movedUs = 0;
+      stats.deflectedTicks = 0;
+      stats.deflectionUsTicks = 0;
+      stats.peakHeatUs = heatUs();
+      stats.peakStepUs = stepUs();
+    }
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef SERVO_MODEL_H
+#define SERVO_MODEL_H
+
+#include <stdint.h>
+#include "FixedPoint.h"
+
+// =========================================================
+// Servo horn response model and lead compensation
+// =========================================================
+// A micro servo doesn't follow its pulse width at once. Nothing moves for a
+// dead time (the next PWM frame plus the servo's own electronics). Then the
+// horn slews at a fixed top speed, and finally closes the last part of the
+// gap exponentially with time constant tauSec. ServoResponse models that in
+// SUB_STEPS Euler steps per control tick, cheap enough for Q16.
+//
+// ServoLead uses the model to send the command early. It predicts where the
+// horn will be when this tick's command starts to act, then overdrives by
+// leadGain times the remaining gap. It also adds ffGain times the part of
+// the target the output smoothing hasn't passed on yet. Both are clamped to
+// the servo limits. A step to full deflection is already clamped, so there
+// the gain comes from dropping the smoothing lag. On release the lead
+// drives the horn back through neutral's far side and shortens the tail.
+//
+// fitServoStep() recovers the three parameters from one step of
+// test/servo_test_battery.cpp with the horn's feedback pot on an analog pin.
+
+template <typename T>
+struct ServoParams {
+  T deadSec;               // Command to first movement
+  T slewUsPerSec;          // Top horn speed, in pulse-width microseconds
+  T tauSec;                // Exponential approach near the target
+};
+
+template <typename T>
+class ServoResponse {
+  public:
+    static const int SUB_STEPS = 10;
+
+  private:
+    T pos;
+    T applied;             // Command the horn is following
+    T pending;             // Latest command, still inside its dead time
+    T gain;                // h / tau per sub-step
+    T maxMove;             // slew * h per sub-step
+    int deadSteps;         // Sub-steps before a new command takes over
+
+    void subStep(T command) {
+      T move = (command - pos) * gain;
+      if (move > maxMove) move = maxMove;
+      else if (move < -maxMove) move = -maxMove;
+      pos += move;
+    }
+
+  public:
+    // `tickSec` is the control period; the dead time must be below it
+    ServoResponse(const ServoParams<T> &p, T tickSec, int startUs) {
+      T h = tickSec / SUB_STEPS;
+      gain = h / p.tauSec;
+      if (gain > T(1)) gain = T(1);
+      maxMove = p.slewUsPerSec * h;
+      deadSteps = toInt(p.deadSec / h + T(0.5));
+      if (deadSteps > SUB_STEPS) deadSteps = SUB_STEPS;
+      reset(startUs);
+    }
+
+    void reset(int us) {
+      pos = T(us);
+      applied = T(us);
+      pending = T(us);
+    }
+
+    // One control tick with `commandUs` written at its start
+    void step(int commandUs) {
+      pending = T(commandUs);
+      for (int i = 0; i < SUB_STEPS; i++) {
+        if (i == deadSteps) applied = pending;
+        subStep(applied);
+      }
+      applied = pending;
+    }
+
+    // Horn position when a command written now starts to act
+    T predictAtTakeover() const {
+      ServoResponse ahead = *this;
+      for (int i = 0; i < deadSteps; i++) ahead.subStep(applied);
+      return ahead.pos;
+    }
+
+    T position() const { return pos; }
+};
+
+template <typename T>
+class ServoLead {
+  private:
+    ServoResponse<T> model;
+    T leadGain;
+    T ffGain;
+    int minUs;
+    int maxUs;
+
+  public:
+    ServoLead(const ServoParams<T> &p, T tickSec, int neutralUs, int lo, int hi, T lead, T ff)
+      : model(p, tickSec, neutralUs), leadGain(lead), ffGain(ff), minUs(lo), maxUs(hi) {}
+
+    // Command for this tick: `reference` is the smoothed pulse, `target`
+    // the control law's unsmoothed one
+    int command(int reference, int target) const {
+      T ref = T(reference);
+      T u = ref + leadGain * (ref - model.predictAtTakeover()) + ffGain * T(target - reference);
+      int us = toInt(u);
+      return us < minUs ? minUs : (us > maxUs ? maxUs : us);
+    }
+
+    // What actually went to the servo this tick (after the deadband)
+    void advance(int writtenUs) { model.step(writtenUs); }
+
+    void reset(int us) { model.reset(us); }
+    T predictedPosition() const { return model.position(); }
+};
+
+// ---------------------------------------------------------
+// Identification from one step of the servo_test_battery sweep
+// ---------------------------------------------------------
+// `pos` holds horn positions (already mapped from the feedback ADC to
+// pulse-width microseconds with the two settled ends), one per `sampleSec`,
+// starting at the instant the step was written from `fromUs` to `toUs`.
+// Slew: straight-line slope between 20% and 60% of the step. Dead time:
+// where that line starts. Tau: time for the remaining gap to fall from 10%
+// to 10%/e (the tail is exponential once the gap is under slew * tau).
+
+// Time (s) the step first reaches `fraction` of the way, or -1
+inline float stepCrossing(const float *pos, int n, float sampleSec, float fromUs, float span,
+                          float fraction) {
+  for (int i = 0; i < n; i++) {
+    float f = (pos[i] - fromUs) / span;
+    if (f >= fraction) {
+      if (i == 0) return 0.0;
+      float f0 = (pos[i - 1] - fromUs) / span;
+      return (i - 1 + (fraction - f0) / (f - f0)) * sampleSec;
+    }
+  }
+  return -1.0;
+}
+
+inline bool fitServoStep(const float *pos, int n, float sampleSec, float fromUs, float toUs,
+                         ServoParams<float> &out) {
+  float span = toUs - fromUs;
+  if (span == 0) return false;
+  float t20 = stepCrossing(pos, n, sampleSec, fromUs, span, 0.20);
+  float t60 = stepCrossing(pos, n, sampleSec, fromUs, span, 0.60);
+  float tTail = stepCrossing(pos, n, sampleSec, fromUs, span, 0.90);
+  float tTau = stepCrossing(pos, n, sampleSec, fromUs, span, 1.0 - 0.10 / 2.718282);
+  if (t20 < 0 || t60 <= t20 || tTail < 0 || tTau <= tTail) return false;
+
+  float travel = span > 0 ? span : -span;
+  out.slewUsPerSec = 0.40f * travel / (t60 - t20);
+  out.deadSec = t20 - 0.20f * travel / out.slewUsPerSec;
+  if (out.deadSec < 0) out.deadSec = 0;
+  out.tauSec = tTau - tTail;
+  return true;
+}
+
+#endif
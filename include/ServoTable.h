@@ -0,0 +1,92 @@
+#ifndef SERVO_TABLE_H
+#define SERVO_TABLE_H
+
+#include <stdint.h>
+
+// =========================================================
+// Compile-time servo command and smoothing tables
+// =========================================================
+// Once a control law's correction is rounded to whole microseconds, the
+// rest of the output path is a pure function of small integers: direction,
+// calibration limits, then the output EMA. A control tick does integer
+// arithmetic for the first and one index and clamp into a compile-time table
+// for the second, instead of the branches and the soft-float EMA (the M0+
+// has no FPU).
+//
+//   ServoMap<Neutral, Correct, Min, Max>::command(offsetUs)
+//       Pulse for a correction of offsetUs towards Correct (negative goes
+//       the other way), clamped to [Min, Max]. Same as ControlLaw::update().
+//       One add and a clamp: a table of every offset (about 7 KB of flash
+//       for both axes) would save nothing over that.
+//   ServoSmoothing<Permille, Span>::apply(target, prev)
+//       prev + floor((target - prev) * Permille / 1000), i.e. smoothServo()
+//       in exact arithmetic. For |target - prev| <= Span. The table
+//       (constexpr, so it sits in flash) replaces a multiply and a floor
+//       division.
+//
+// smoothServo() in float truncates a result 1us low where the EMA lands
+// exactly on an integer; test/test_servo_table_host.cpp checks that this is
+// the only difference.
+//
+// C++11 constexpr can't loop, so the table is one pack expansion over an
+// index list (built in log N template depth).
+
+template <int... I> struct IndexList {};
+
+template <class A, class B> struct ConcatIndices;
+template <int... A, int... B>
+struct ConcatIndices<IndexList<A...>, IndexList<B...> > {
+  typedef IndexList<A..., ((int)sizeof...(A) + B)...> type;
+};
+
+template <int N>
+struct MakeIndexList {
+  typedef typename ConcatIndices<typename MakeIndexList<N / 2>::type,
+                                 typename MakeIndexList<N - N / 2>::type>::type type;
+};
+template <> struct MakeIndexList<0> { typedef IndexList<> type; };
+template <> struct MakeIndexList<1> { typedef IndexList<0> type; };
+
+// Gen::at(i) for every i in the list
+template <class Gen, class Indices> struct Table;
+template <class Gen, int... I>
+struct Table<Gen, IndexList<I...> > {
+  static constexpr int16_t values[sizeof...(I)] = { Gen::at(I)... };
+};
+template <class Gen, int... I>
+constexpr int16_t Table<Gen, IndexList<I...> >::values[sizeof...(I)];
+
+template <int Neutral, int Correct, int Min, int Max>
+struct ServoMap {
+  static constexpr int clampUs(int us) {
+    return us < Min ? Min : (us > Max ? Max : us);
+  }
+
+  static constexpr int command(int offsetUs) {
+    return clampUs(Correct > Neutral ? Neutral + offsetUs : Neutral - offsetUs);
+  }
+};
+
+template <int Permille, int Span>
+struct ServoSmoothing {
+  static constexpr int SIZE = 2 * Span + 1;
+
+  static constexpr int floorDiv(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+  }
+
+  static constexpr int16_t at(int i) {
+    return floorDiv((i - Span) * Permille, 1000);
+  }
+
+  typedef Table<ServoSmoothing, typename MakeIndexList<SIZE>::type> Steps;
+
+  static int apply(int target, int prev) {
+    int i = target - prev + Span;
+    if (i < 0) i = 0;
+    else if (i >= SIZE) i = SIZE - 1;
+    return prev + Steps::values[i];
+  }
+};
+
+#endif
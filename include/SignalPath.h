@@ -0,0 +1,86 @@
+#ifndef SIGNAL_PATH_H
+#define SIGNAL_PATH_H
+
+#include "FixedPoint.h"
+
+// =========================================================
+// Sensor -> rate -> servo stages
+// =========================================================
+// Each stage is a template over the number type, so main.cpp builds them
+// with float or Q16 (USE_FIXED_POINT) and the host tests can run both side
+// by side. The float instantiations do exactly the arithmetic the loop has
+// always done, including the double-precision (1.0 - alpha) blend terms.
+
+template <typename T>
+T absValue(T v) {
+  return v < 0 ? -v : v;
+}
+
+template <typename T>
+T lowPass(T raw, T prevSmoothed, T alpha) {
+  return (alpha * raw) + ((1.0 - alpha) * prevSmoothed);
+}
+
+// Timeout hold, spike rejection, then low-pass filter
+template <typename T>
+T filterDistance(T raw, T prevSmoothed, T alpha, T maxJump, T noReading) {
+  if (raw == noReading) return prevSmoothed;
+  if (absValue(raw - prevSmoothed) > maxJump) return prevSmoothed;
+  return lowPass(raw, prevSmoothed, alpha);
+}
+
+// Positive when closing on the wall / ground; 0 over a zero interval
+template <typename T>
+T closureRate(T current, T previous, T dt) {
+  if (!(dt > 0)) return 0.0;
+  return - (current - previous) / dt;
+}
+
+// Microseconds -> seconds, split so Q16 (integer part below 32768) can
+// take intervals longer than 32 ms. Q16 resolves 15 us: shorter nonzero
+// intervals round up to one step rather than down to 0.
+template <typename T>
+T microsToSeconds(uint32_t us) {
+  T s = (T(int(us / 1000)) + T(int(us % 1000)) / 1000) / 1000;
+  if (us > 0 && !(s > 0)) s = T(1) / 65536;
+  return s;
+}
+
+template <typename T>
+int smoothServo(int target, int prev, T alpha) {
+  return toInt((alpha * target) + ((1.0 - alpha) * prev));
+}
+
+// =========================================================
+// CLASS: Rolling Average (To smooth Rate of Change)
+// =========================================================
+template <typename T, int N>
+class RollingAverage {
+  private:
+    T history[N];
+    int index;
+    T sum;
+    bool filled;
+
+  public:
+    RollingAverage() {
+      index = 0;
+      sum = 0.0;
+      filled = false;
+      for (int i = 0; i < N; i++) history[i] = 0.0;
+    }
+
+    T add(T val) {
+      sum -= history[index];
+      history[index] = val;
+      sum += history[index];
+      index++;
+      if (index >= N) {
+        index = 0;
+        filled = true;
+      }
+      return filled ? (sum / N) : (sum / index);
+    }
+};
+
+#endif
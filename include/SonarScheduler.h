@@ -0,0 +1,197 @@
+#ifndef SONAR_SCHEDULER_H
+#define SONAR_SCHEDULER_H
+
+#include <stdint.h>
+#include "EchoCapture.h"
+
+// =========================================================
+// Interleaved dual-sonar ping scheduler
+// =========================================================
+// Fires the two HC-SR04 channels alternately, one every slotUs, instead of
+// waiting out a full timeout on each in turn. A channel listens from its
+// ping until its echo returns or listenUs runs out.
+//
+// A burst keeps echoing around the corridor for horizonUs after it leaves
+// the transducer, and the other sensor can't tell it from its own echo.
+// So an echo that arrives (its falling edge) less than horizonUs after the
+// other channel's last burst is dropped and counted as crosstalk. With the
+// slot at least horizonUs that only happens when a ping goes out late or a
+// window runs past the other channel's next ping; a shorter slot trades
+// range for crosstalk drops.
+//
+// An HC-SR04 that hears nothing holds its echo line high for ~38 ms (longer
+// on some clones) and ignores triggers until it drops. The trigger callback
+// reports such a busy sensor; that slot is skipped and counted, so the
+// miss costs one ping rather than the next one too.
+//
+// Each ping's listening window can be narrowed with setListenWindow() (see
+// RangeGate.h). It takes effect from the next ping of that channel and also
+// becomes the capture timeout, so a late echo is simply a miss.
+//
+// update() is called from loop() as often as possible; it never blocks.
+
+const int SONAR_CHANNELS = 2;
+
+// Fires `channel`'s trigger; false, without firing, while its echo line is
+// still high from the last ping
+typedef bool (*PingTrigger)(int channel);
+
+struct SonarStats {
+  uint32_t pings;
+  uint32_t valid;
+  uint32_t timeouts;
+  uint32_t crosstalkDrops;
+  uint32_t busySkips;        // Slots skipped with the echo line still high
+};
+
+class SonarScheduler {
+  private:
+    EchoCapture* capture[SONAR_CHANNELS];
+    PingTrigger trigger;
+    uint32_t slotUs;
+    uint32_t horizonUs;
+    uint32_t listenUs[SONAR_CHANNELS];      // Window of the ping in flight
+    uint32_t nextListenUs[SONAR_CHANNELS];  // Window for the next ping
+
+    uint32_t nextFireUs;
+    int nextChannel;
+    bool running;
+    uint32_t lastFireUs[SONAR_CHANNELS];
+    bool fired[SONAR_CHANNELS];
+
+    // Newest accepted sample per channel, waiting for take()
+    EchoSample latest[SONAR_CHANNELS];
+    bool fresh[SONAR_CHANNELS];
+
+    SonarStats stats[SONAR_CHANNELS];
+    uint32_t statsStartUs;
+
+    // Could `ch`'s echo, heard at `echoUs`, be the other channel's burst?
+    // Samples are collected before the next ping fires, so the other
+    // channel's last burst is never later than the echo.
+    bool isCrosstalk(int ch, uint32_t echoUs) const {
+      int other = 1 - ch;
+      if (!fired[other]) return false;
+      return (echoUs - lastFireUs[other]) < horizonUs;
+    }
+
+    void collect(uint32_t nowUs) {
+      for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+        EchoSample sample;
+        if (!capture[ch]->fetch(nowUs, sample)) continue;
+
+        // An echo collected after its window closed is still a miss
+        if (sample.widthUs == 0 || (sample.stampUs - lastFireUs[ch]) > listenUs[ch]) {
+          stats[ch].timeouts++;
+        } else if (isCrosstalk(ch, sample.stampUs)) {
+          stats[ch].crosstalkDrops++;
+        } else {
+          stats[ch].valid++;
+          latest[ch] = sample;
+          fresh[ch] = true;
+        }
+      }
+    }
+
+  public:
+    SonarScheduler(EchoCapture &channelA, EchoCapture &channelB, PingTrigger fire, uint32_t slot, uint32_t listen,
+                   uint32_t horizon) {
+      capture[0] = &channelA;
+      capture[1] = &channelB;
+      trigger = fire;
+      slotUs = slot;
+      horizonUs = horizon;
+      nextFireUs = 0;
+      nextChannel = 0;
+      running = false;
+      for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+        lastFireUs[ch] = 0;
+        fired[ch] = false;
+        listenUs[ch] = listen;
+        nextListenUs[ch] = listen;
+        latest[ch].widthUs = 0;
+        latest[ch].stampUs = 0;
+        latest[ch].armedUs = 0;
+        fresh[ch] = false;
+      }
+      resetStats(0);
+    }
+
+    void start(uint32_t nowUs) {
+      nextFireUs = nowUs;
+      nextChannel = 0;
+      running = true;
+      resetStats(nowUs);
+    }
+
+    void update(uint32_t nowUs) {
+      collect(nowUs);
+
+      if (!running || (int32_t)(nowUs - nextFireUs) < 0) return;
+
+      int ch = nextChannel;
+      nextChannel = 1 - ch;
+      if (trigger(ch)) {
+        listenUs[ch] = nextListenUs[ch];
+        capture[ch]->setTimeout(listenUs[ch]);
+        lastFireUs[ch] = nowUs;
+        fired[ch] = true;
+        stats[ch].pings++;
+      } else {
+        stats[ch].busySkips++;
+      }
+
+      nextFireUs += slotUs;
+      // If loop() stalled past a whole slot, restart the pattern from now
+      // instead of firing a burst of catch-up pings.
+      if ((int32_t)(nowUs - nextFireUs) >= 0) nextFireUs = nowUs + slotUs;
+    }
+
+    void setListenWindow(int ch, uint32_t windowUs) {
+      nextListenUs[ch] = windowUs;
+    }
+
+    uint32_t listenWindow(int ch) const { return listenUs[ch]; }
+
+    // How long the CPU may stall from now (a flash operation holds off the
+    // echo interrupts too) without delaying an echo edge: 0 while either
+    // channel is still listening, else the time to the next ping
+    uint32_t quietUs(uint32_t nowUs) const {
+      for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+        if (capture[ch]->pending(nowUs)) return 0;
+      }
+      if (!running) return UINT32_MAX;
+      int32_t ahead = (int32_t)(nextFireUs - nowUs);
+      return ahead > 0 ? (uint32_t)ahead : 0;
+    }
+
+    // Hands over the newest accepted sample once; false if none since last take.
+    bool take(int ch, EchoSample &out) {
+      if (!fresh[ch]) return false;
+      out = latest[ch];
+      fresh[ch] = false;
+      return true;
+    }
+
+    void resetStats(uint32_t nowUs) {
+      for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+        stats[ch].pings = 0;
+        stats[ch].valid = 0;
+        stats[ch].timeouts = 0;
+        stats[ch].crosstalkDrops = 0;
+        stats[ch].busySkips = 0;
+      }
+      statsStartUs = nowUs;
+    }
+
+    const SonarStats& channelStats(int ch) const { return stats[ch]; }
+
+    // Accepted samples per second since the last resetStats()
+    float effectiveHz(int ch, uint32_t nowUs) const {
+      uint32_t elapsedUs = nowUs - statsStartUs;
+      if (elapsedUs == 0) return 0.0;
+      return stats[ch].valid * 1000000.0 / elapsedUs;
+    }
+};
+
+#endif
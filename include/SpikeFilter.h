@@ -0,0 +1,116 @@
+#ifndef SPIKE_FILTER_H
+#define SPIKE_FILTER_H
+
+// =========================================================
+// Streaming median / Hampel spike filter
+// =========================================================
+// Keeps the last N samples twice: in arrival order (to know which one
+// leaves) and sorted (insertion/removal shifts at most N-1 entries, no
+// copying or re-sorting). The median is then sorted[N/2], and the median
+// absolute deviation is found with one merge-walk outward from the median,
+// so an update costs O(N) with N a small compile-time constant.
+//
+// Hampel: a sample further than k * 1.4826 * MAD from the median, clamped
+// to [minDev, maxDev], is replaced by the median. The clamp keeps clean,
+// identical readings from flagging noise and stops a window holding several
+// outliers from inflating the MAD until everything passes. Inliers pass
+// through untouched, so unlike a plain median there is no added lag on clean
+// data, and because outliers still enter the window a real step is accepted
+// after N/2 ticks (the old MAX_DIST_JUMP_CM check never accepts it).
+// Templated over the number type like SignalPath.h.
+
+template <typename T, int N>
+class HampelFilter {
+  private:
+    T window[N];       // Arrival order, ring buffer
+    T sorted[N];
+    int count;
+    int head;
+    T scale;           // k * 1.4826 (MAD -> standard deviation)
+    T minDev;
+    T maxDev;
+
+    void removeSorted(T v) {
+      int i = 0;
+      while (i < count - 1 && !(sorted[i] == v)) i++;
+      for (; i < count - 1; i++) sorted[i] = sorted[i + 1];
+      count--;
+    }
+
+    void insertSorted(T v) {
+      int i = count;
+      while (i > 0 && v < sorted[i - 1]) {
+        sorted[i] = sorted[i - 1];
+        i--;
+      }
+      sorted[i] = v;
+      count++;
+    }
+
+  public:
+    HampelFilter(T k, T minDeviation, T maxDeviation) {
+      static_assert(N % 2 == 1, "HampelFilter window must be odd");
+      scale = k * 1.4826;
+      minDev = minDeviation;
+      maxDev = maxDeviation;
+      reset();
+    }
+
+    void reset() {
+      count = 0;
+      head = 0;
+    }
+
+    // Adds a sample to the window; returns the new median.
+    T push(T x) {
+      if (count == N) removeSorted(window[head]);
+      insertSorted(x);
+      window[head] = x;
+      head = (head + 1) % N;
+      return median();
+    }
+
+    T median() const {
+      return sorted[count / 2];
+    }
+
+    // Median absolute deviation of the current window
+    T mad() const {
+      int m = count / 2;
+      T med = sorted[m];
+      int left = m - 1;
+      int right = m + 1;
+      T dev = 0.0;
+      for (int rank = 0; rank < count / 2; rank++) {
+        if (left < 0) {
+          dev = sorted[right++] - med;
+        } else if (right >= count) {
+          dev = med - sorted[left--];
+        } else {
+          T dl = med - sorted[left];
+          T dr = sorted[right] - med;
+          if (dl <= dr) { dev = dl; left--; }
+          else          { dev = dr; right++; }
+        }
+      }
+      return dev;
+    }
+
+    // Returns x, or the window median if x is an outlier.
+    T filter(T x) {
+      T med = push(x);
+      if (count < 3) return x;
+
+      T limit = scale * mad();
+      if (limit < minDev) limit = minDev;
+      if (limit > maxDev) limit = maxDev;
+
+      T dev = x - med;
+      if (dev < 0) dev = -dev;
+      return dev > limit ? med : x;
+    }
+
+    int size() const { return count; }
+};
+
+#endif
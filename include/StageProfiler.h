@@ -0,0 +1,203 @@
+#ifndef STAGE_PROFILER_H
+#define STAGE_PROFILER_H
+
+#include <stdint.h>
+
+// =========================================================
+// Per-stage latency histograms
+// =========================================================
+// The executor's 'x' stats give one run time per task. This splits the hot
+// path into stages (sonar service, filtering, rates, control law, servo
+// command, servo write, logging) and keeps, for each, the sample count,
+// min / mean / max and a histogram over fixed µs buckets.
+//
+// Markers:
+//   StageScope<P> s(profiler, STAGE);  times the enclosing scope
+//   StageLap<P> laps(profiler);        then laps.lap(STAGE) times the code
+//                                      since the previous lap, for steps
+//                                      that share locals in one function
+//
+// StageProfiler<Clock, STAGES, false> has no members and empty inline
+// methods, so with the profiler switched off the markers compile to
+// nothing and the histograms take no RAM.
+//
+// Clocks give a free-running 32-bit tick count and TICKS_PER_US:
+//   SAMD21    core cycles from SysTick and the millis() count (the M0+
+//             has no DWT cycle counter)
+//   Arduino   micros()
+//   host      std::chrono::steady_clock in ns
+// The cost of reading the clock is measured by calibrate() and taken off
+// every sample.
+
+const int PROFILE_BUCKETS = 12;
+// Upper bucket edges in µs; the last bucket holds everything from 5ms up
+const uint16_t PROFILE_BUCKET_US[PROFILE_BUCKETS - 1] = {
+  2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000
+};
+
+struct StageHistogram {
+  uint32_t count;
+  uint32_t minTicks;
+  uint32_t maxTicks;
+  uint64_t totalTicks;
+  uint32_t buckets[PROFILE_BUCKETS];
+};
+
+template <class Clock, int STAGES, bool Enabled = true>
+class StageProfiler {
+  private:
+    StageHistogram hist[STAGES];
+    uint32_t edges[PROFILE_BUCKETS - 1];   // PROFILE_BUCKET_US in ticks
+    uint32_t overhead;
+
+  public:
+    static const bool ENABLED = true;
+    static const uint32_t TICKS_PER_US = Clock::TICKS_PER_US;
+
+    StageProfiler() : overhead(0) {
+      for (int i = 0; i < PROFILE_BUCKETS - 1; i++) edges[i] = PROFILE_BUCKET_US[i] * TICKS_PER_US;
+      resetStats();
+    }
+
+    static uint32_t now() { return Clock::now(); }
+
+    // Cheapest of a few back-to-back clock reads: the part of every sample
+    // that is the marker itself
+    void calibrate() {
+      uint32_t best = 0xFFFFFFFF;
+      for (int i = 0; i < 16; i++) {
+        uint32_t start = Clock::now();
+        uint32_t ticks = Clock::now() - start;
+        if (ticks < best) best = ticks;
+      }
+      overhead = best;
+    }
+
+    void record(int stage, uint32_t ticks) {
+      ticks = ticks > overhead ? ticks - overhead : 0;
+      StageHistogram &h = hist[stage];
+      h.count++;
+      h.totalTicks += ticks;
+      if (ticks < h.minTicks) h.minTicks = ticks;
+      if (ticks > h.maxTicks) h.maxTicks = ticks;
+      int b = 0;
+      while (b < PROFILE_BUCKETS - 1 && ticks >= edges[b]) b++;
+      h.buckets[b]++;
+    }
+
+    void resetStats() {
+      for (int s = 0; s < STAGES; s++) {
+        StageHistogram &h = hist[s];
+        h.count = 0;
+        h.minTicks = 0xFFFFFFFF;
+        h.maxTicks = 0;
+        h.totalTicks = 0;
+        for (int b = 0; b < PROFILE_BUCKETS; b++) h.buckets[b] = 0;
+      }
+    }
+
+    const StageHistogram &stageStats(int stage) const { return hist[stage]; }
+    uint32_t overheadTicks() const { return overhead; }
+
+    static float toUs(uint64_t ticks) { return (float)ticks / TICKS_PER_US; }
+    float meanUs(int stage) const {
+      return hist[stage].count ? toUs(hist[stage].totalTicks) / hist[stage].count : 0.0f;
+    }
+};
+
+// Switched off: nothing stored, nothing timed
+template <class Clock, int STAGES>
+class StageProfiler<Clock, STAGES, false> {
+  public:
+    static const bool ENABLED = false;
+    static const uint32_t TICKS_PER_US = Clock::TICKS_PER_US;
+
+    static uint32_t now() { return 0; }
+    void calibrate() {}
+    void record(int, uint32_t) {}
+    void resetStats() {}
+    const StageHistogram &stageStats(int) const {
+      static const StageHistogram none = StageHistogram();
+      return none;
+    }
+    uint32_t overheadTicks() const { return 0; }
+    static float toUs(uint64_t) { return 0.0f; }
+    float meanUs(int) const { return 0.0f; }
+};
+
+template <class Profiler>
+class StageScope {
+  private:
+    Profiler &profiler;
+    int stage;
+    uint32_t start;
+
+  public:
+    StageScope(Profiler &p, int s) : profiler(p), stage(s), start(Profiler::now()) {}
+    ~StageScope() { profiler.record(stage, Profiler::now() - start); }
+};
+
+template <class Profiler>
+class StageLap {
+  private:
+    Profiler &profiler;
+    uint32_t last;
+
+  public:
+    explicit StageLap(Profiler &p) : profiler(p), last(Profiler::now()) {}
+
+    void lap(int stage) {
+      uint32_t t = Profiler::now();
+      profiler.record(stage, t - last);
+      last = t;
+    }
+};
+
+// ---------------------------------------------------------
+// Clocks
+// ---------------------------------------------------------
+#if defined(ARDUINO_ARCH_SAMD)
+// Core cycles: the millis() count times the SysTick period plus how far
+// SysTick (counting down, reloading every 1ms) has got. A tick that has
+// wrapped but not been serviced yet is pending in ICSR; counted here the
+// same way micros() counts it. Wraps every 89s at 48MHz; differences are
+// fine across it.
+class Samd21CycleClock {
+  public:
+    static const uint32_t TICKS_PER_US = F_CPU / 1000000;
+
+    static uint32_t now() {
+      uint32_t period = SysTick->LOAD + 1;
+      uint32_t ms, val;
+      bool pending;
+      do {
+        ms = millis();
+        val = SysTick->VAL;
+        pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+      } while (ms != millis());
+      if (pending && val > period / 2) ms++;
+      return ms * period + (period - 1 - val);
+    }
+};
+typedef Samd21CycleClock ProfileClock;
+#elif defined(ARDUINO)
+class MicrosClock {
+  public:
+    static const uint32_t TICKS_PER_US = 1;
+    static uint32_t now() { return micros(); }
+};
+typedef MicrosClock ProfileClock;
+#else
+#include <chrono>
+class HostClock {
+  public:
+    static const uint32_t TICKS_PER_US = 1000;
+    static uint32_t now() {
+      return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+typedef HostClock ProfileClock;
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef STATE_ESTIMATOR_H
+#define STATE_ESTIMATOR_H
+
+// =========================================================
+// Alpha-beta (constant-velocity) range tracker
+// =========================================================
+// Tracks distance and its rate together instead of low-pass filtering the
+// distance, differencing the lagged result and then averaging three rates.
+// Each tick predicts forward with the current rate and corrects both states
+// from the residual:
+//     dist += vel * dt
+//     dist += alpha * residual
+//     vel  += beta * residual / dt
+// A sample with dt == 0 (same instant as the last) corrects the distance
+// only: there is no interval to take a rate over.
+// A missed ping (noReading) only predicts, so the rate keeps its value
+// instead of reading zero and then spiking when the echo comes back. After
+// maxCoast misses in a row the rate is zeroed and the distance holds.
+// correct()/miss()/predict() take each sample's own interval (timestamped
+// echoes); step() is the same thing on a fixed tick.
+// Templated over the number type like SignalPath.h.
+
+template <typename T>
+class AlphaBetaTracker {
+  private:
+    T alpha;
+    T beta;
+    T dist;          // cm
+    T vel;           // cm/s, positive when the range is opening
+    int misses;
+    int maxCoast;
+
+  public:
+    AlphaBetaTracker(T a, T b, int maxCoastTicks) {
+      alpha = a;
+      beta = b;
+      maxCoast = maxCoastTicks;
+      reset(0.0);
+    }
+
+    void reset(T distance) {
+      dist = distance;
+      vel = 0.0;
+      misses = 0;
+    }
+
+    // Folds in a measurement taken dt seconds after the current estimate;
+    // returns distance.
+    T correct(T measured, T dt) {
+      dist = dist + vel * dt;
+      misses = 0;
+
+      T residual = measured - dist;
+      dist = dist + alpha * residual;
+      if (dt > 0) vel = vel + (beta * residual) / dt;
+      return dist;
+    }
+
+    // A ping with no usable echo. The estimate stays anchored at the last
+    // measurement; use predict() for the distance now.
+    void miss() {
+      if (++misses >= maxCoast) vel = 0.0;
+    }
+
+    // Distance dt seconds after the last measurement
+    T predict(T dt) const { return dist + vel * dt; }
+
+    // Fixed-interval ticks: advances by dt seconds and folds in one
+    // measurement (or just predicts on noReading); returns distance.
+    T step(T measured, T dt, T noReading) {
+      if (measured == noReading) {
+        dist = predict(dt);
+        miss();
+        return dist;
+      }
+      return correct(measured, dt);
+    }
+
+    T distance() const { return dist; }
+
+    // Positive when closing on the wall / ground, like closureRate()
+    T closureRate() const { return -vel; }
+
+    bool coasting() const { return misses > 0; }
+};
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef TASK_EXECUTOR_H
+#define TASK_EXECUTOR_H
+
+#include <stdint.h>
+
+// =========================================================
+// Static multi-rate cooperative task executor
+// =========================================================
+// Runs a fixed table of tasks from loop(), one task per poll(). Each task is
+// released either by its own period (periodUs, drift-free: releases step by
+// the period, not from when the task last ran) or by an external event
+// (released() returning true, e.g. a timer ISR flag). Of the released tasks
+// the lowest priority number runs first; tasks never preempt each other.
+// Tasks with neither a period nor a release hook are background work and
+// only run when nothing else is waiting, i.e. in leftover slack.
+//
+// Per task it counts runs, skipped releases (a new release landed before
+// the previous one ran; the task then runs once, for the newest, never in
+// a catch-up burst) and deadline misses (finished later than deadlineUs
+// after its release, deadlineUs = 0 meaning the period), and keeps the worst
+// start latency and run time. Everything is statically sized by the table; the
+// clock is passed in so the host tests run on a virtual one.
+
+typedef void (*TaskFn)(uint32_t nowUs);
+typedef bool (*ReleaseFn)(uint32_t nowUs);
+typedef uint32_t (*ClockFn)();
+
+struct Task {
+  const char* name;
+  TaskFn run;
+  uint32_t periodUs;       // Self-released every periodUs, or 0
+  ReleaseFn released;      // ...or released when this returns true (may be NULL)
+  uint32_t deadlineUs;     // From release to finish; 0 = periodUs (none if background)
+  uint8_t priority;        // 0 runs first
+};
+
+struct TaskStats {
+  uint32_t runs;
+  uint32_t skipped;        // Releases that landed while the last was still waiting
+  uint32_t deadlineMisses;
+  uint32_t maxLatencyUs;   // Release to start
+  uint32_t maxRunUs;
+  uint32_t totalRunUs;
+};
+
+template <int N>
+class TaskExecutor {
+  private:
+    const Task* table;
+    ClockFn clock;
+
+    uint32_t nextReleaseUs[N];
+    uint32_t releaseAtUs[N];
+    bool pending[N];
+    TaskStats stats[N];
+
+    static bool isBackground(const Task &t) {
+      return t.periodUs == 0 && t.released == 0;
+    }
+
+    uint32_t deadlineOf(const Task &t) const {
+      return t.deadlineUs ? t.deadlineUs : t.periodUs;
+    }
+
+    void execute(int i, uint32_t nowUs) {
+      const Task &t = table[i];
+      t.run(nowUs);
+      uint32_t endUs = clock();
+
+      uint32_t runUs = endUs - nowUs;
+      TaskStats &st = stats[i];
+      st.runs++;
+      st.totalRunUs += runUs;
+      if (runUs > st.maxRunUs) st.maxRunUs = runUs;
+
+      if (!isBackground(t)) {
+        uint32_t latency = nowUs - releaseAtUs[i];
+        if (latency > st.maxLatencyUs) st.maxLatencyUs = latency;
+        uint32_t deadline = deadlineOf(t);
+        if (deadline && endUs - releaseAtUs[i] > deadline) st.deadlineMisses++;
+      }
+    }
+
+  public:
+    TaskExecutor(const Task (&tasks)[N], ClockFn clockFn) {
+      table = tasks;
+      clock = clockFn;
+      start(0);
+    }
+
+    // First periodic releases at `nowUs`; clears the statistics.
+    void start(uint32_t nowUs) {
+      for (int i = 0; i < N; i++) {
+        nextReleaseUs[i] = nowUs;
+        releaseAtUs[i] = nowUs;
+        pending[i] = false;
+      }
+      resetStats();
+    }
+
+    // Runs the most urgent released task, or else one pass of the background
+    // tasks. Returns true if a released (non-background) task ran.
+    bool poll() {
+      uint32_t nowUs = clock();
+      int pick = -1;
+
+      for (int i = 0; i < N; i++) {
+        const Task &t = table[i];
+        if (t.periodUs) {
+          while ((int32_t)(nowUs - nextReleaseUs[i]) >= 0) {
+            if (pending[i]) stats[i].skipped++;   // Run once, for the newest
+            pending[i] = true;
+            releaseAtUs[i] = nextReleaseUs[i];
+            nextReleaseUs[i] += t.periodUs;
+          }
+        } else if (t.released && !pending[i] && t.released(nowUs)) {
+          pending[i] = true;
+          releaseAtUs[i] = nowUs;
+        }
+        if (pending[i] && (pick < 0 || t.priority < table[pick].priority)) pick = i;
+      }
+
+      if (pick >= 0) {
+        pending[pick] = false;
+        execute(pick, nowUs);
+        return true;
+      }
+
+      for (int i = 0; i < N; i++) {
+        if (isBackground(table[i])) execute(i, clock());
+      }
+      return false;
+    }
+
+    // Earliest time a periodic task is waiting to run (`nowUs` if one
+    // already is), so a simulated clock can skip the idle time in between.
+    // Release hooks and background tasks are not counted.
+    uint32_t nextDueUs(uint32_t nowUs) const {
+      uint32_t wait = 0xFFFFFFFF;
+      for (int i = 0; i < N; i++) {
+        if (!table[i].periodUs) continue;
+        if (pending[i]) return nowUs;
+        int32_t until = (int32_t)(nextReleaseUs[i] - nowUs);
+        if (until <= 0) return nowUs;
+        if ((uint32_t)until < wait) wait = until;
+      }
+      return nowUs + wait;
+    }
+
+    void resetStats() {
+      for (int i = 0; i < N; i++) {
+        stats[i].runs = 0;
+        stats[i].skipped = 0;
+        stats[i].deadlineMisses = 0;
+        stats[i].maxLatencyUs = 0;
+        stats[i].maxRunUs = 0;
+        stats[i].totalRunUs = 0;
+      }
+    }
+
+    int size() const { return N; }
+    const Task& task(int i) const { return table[i]; }
+    const TaskStats& taskStats(int i) const { return stats[i]; }
+};
+
+#endif
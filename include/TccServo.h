@@ -0,0 +1,115 @@
+#ifndef TCC_SERVO_H
+#define TCC_SERVO_H
+
+#include <stdint.h>
+
+// =========================================================
+// Two servo outputs on TCC0 compare channels, latched together
+// =========================================================
+// The Servo library times every channel from one TC4 interrupt, one pulse
+// after another in the 20ms frame. Each writeMicroseconds() takes effect
+// whenever that channel's slot next comes round, so the two surfaces move
+// in different frames and at no fixed time relative to the control tick.
+//
+// TccServo instead runs the pulses in hardware. TCC0 is in normal PWM, so
+// every output goes high at the start of each frame and low at its compare
+// value. write() puts both widths in the compare buffers (CCBx) with the
+// update locked (CTRLB.LUPD), then unlocks. Both buffers then copy into
+// CCx at the same counter overflow: the two surfaces always change in the
+// same frame, and at most one frame after write(). The frame length is a
+// parameter: 20000us for analog servos, down to about 2500us for digital
+// servos that accept a higher rate.
+//
+// Register access goes through a Hw class: Tcc0Hw below on the board, or
+// the counter model in test/test_tcc_servo_host.cpp on the host.
+//
+//   Channel 0: PA04 (Xiao D1), TCC0/WO[0], CC0
+//   Channel 1: PA10 (Xiao D2), TCC0/WO[2], CC2
+
+template <class Hw>
+class TccServo {
+  private:
+    Hw &hw;
+    uint32_t frame;
+
+  public:
+    static const uint32_t COUNTS_PER_US = 3;     // 48MHz GCLK0 / 16
+
+    TccServo(Hw &h) : hw(h), frame(0) {}
+
+    // Starts the frame with both outputs at their initial widths
+    void begin(uint32_t frameUs, int us0, int us1) {
+      frame = frameUs;
+      hw.configure(frameUs * COUNTS_PER_US - 1, us0 * COUNTS_PER_US, us1 * COUNTS_PER_US);
+    }
+
+    // Both widths, applied from the next frame start on
+    void write(int us0, int us1) {
+      hw.lockUpdate();
+      hw.setBuffered(0, us0 * COUNTS_PER_US);
+      hw.setBuffered(1, us1 * COUNTS_PER_US);
+      hw.unlockUpdate();
+    }
+
+    uint32_t frameUs() const { return frame; }
+};
+
+#if defined(ARDUINO_ARCH_SAMD)
+// TCC0 on the SAMD21 (the core's init() already clocks it on the APBC bus).
+// Shares GCLK0 with TCC1; TC3 (control timer) and TC4 (Servo) are untouched.
+class Tcc0Hw {
+  private:
+    static void sync(uint32_t mask) {
+      while (TCC0->SYNCBUSY.reg & mask);
+    }
+
+  public:
+    void configure(uint32_t period, uint32_t cc0, uint32_t cc1) {
+      GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TCC0_TCC1);
+      while (GCLK->STATUS.bit.SYNCBUSY);
+
+      TCC0->CTRLA.reg &= ~TCC_CTRLA_ENABLE;
+      sync(TCC_SYNCBUSY_ENABLE);
+      TCC0->CTRLA.reg = TCC_CTRLA_PRESCALER_DIV16 | TCC_CTRLA_PRESCSYNC_PRESC;
+      TCC0->WAVE.reg = TCC_WAVE_WAVEGEN_NPWM;
+      sync(TCC_SYNCBUSY_WAVE);
+      TCC0->PER.reg = period;
+      sync(TCC_SYNCBUSY_PER);
+      TCC0->CC[0].reg = cc0;
+      sync(TCC_SYNCBUSY_CC0);
+      TCC0->CC[2].reg = cc1;
+      sync(TCC_SYNCBUSY_CC2);
+
+      // Hand the pins from GPIO to the timer: PA04 function E, PA10 function F
+      PORT->Group[0].PINCFG[4].reg |= PORT_PINCFG_PMUXEN;
+      PORT->Group[0].PMUX[4 >> 1].reg = (PORT->Group[0].PMUX[4 >> 1].reg & 0xF0) | PORT_PMUX_PMUXE_E;
+      PORT->Group[0].PINCFG[10].reg |= PORT_PINCFG_PMUXEN;
+      PORT->Group[0].PMUX[10 >> 1].reg = (PORT->Group[0].PMUX[10 >> 1].reg & 0xF0) | PORT_PMUX_PMUXE_F;
+
+      TCC0->CTRLA.reg |= TCC_CTRLA_ENABLE;
+      sync(TCC_SYNCBUSY_ENABLE);
+    }
+
+    void lockUpdate() {
+      TCC0->CTRLBSET.reg = TCC_CTRLBSET_LUPD;
+      sync(TCC_SYNCBUSY_CTRLB);
+    }
+
+    void unlockUpdate() {
+      TCC0->CTRLBCLR.reg = TCC_CTRLBCLR_LUPD;
+      sync(TCC_SYNCBUSY_CTRLB);
+    }
+
+    void setBuffered(int channel, uint32_t counts) {
+      if (channel == 0) {
+        TCC0->CCB[0].reg = counts;
+        sync(TCC_SYNCBUSY_CCB0);
+      } else {
+        TCC0->CCB[2].reg = counts;
+        sync(TCC_SYNCBUSY_CCB2);
+      }
+    }
+};
+#endif
+
+#endif
@@ -0,0 +1,293 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "FixedPoint.h"
+
+// =========================================================
+// Binary telemetry frames and a lock-free SPSC byte ring
+// =========================================================
+// logTelemetry() costs a dozen Serial.print calls with soft-float
+// formatting, about 80 bytes of text per line, so it only ran at 5Hz. Here
+// the control task encodes one fixed 30-byte frame per tick (integers only)
+// into a RAM ring, and the telemetry task drains the ring to the serial
+// port in whatever slack the higher-priority tasks leave. The control tick
+// never waits on the port. When the ring is full the record is dropped and
+// counted; the next frame that fits carries TELEM_DROPPED.
+//
+// Frame, little-endian:
+//   0  0xA5 0x5A           sync
+//   2  seq                 +1 per frame pushed (gaps show drops)
+//   3  flags               TELEM_*
+//   4  timeMs   u32        since launch, 0 on the ground
+//   8  rightMm  i16        filtered distances
+//  10  heightMm i16
+//  12  rateRightMmS  i16   closure rates
+//  14  rateHeightMmS i16
+//  16  rudderUs u16        pulses written to the servos
+//  18  elevatorUs u16
+//  20  rightEchoUs u16     raw echo the tick consumed: width, 0 for none
+//  22  rightEchoAtUs u16   and its falling edge after the trigger
+//  24  heightEchoUs u16
+//  26  heightEchoAtUs u16
+//  28  Fletcher-16 of bytes 2-27
+//
+// The raw echoes are what tools/replay feeds back to src/main.cpp: the
+// filtered fields alone can't reproduce the control decisions exactly.
+//
+// Text printed on the same port (serial command replies) falls between
+// frames; TelemetryParser skips it by resyncing on the sync bytes and the
+// checksum. tools/telemetry_decode.cpp turns a capture back into CSV.
+
+const int TELEMETRY_FRAME_BYTES = 30;
+const uint8_t TELEMETRY_SYNC0 = 0xA5;
+const uint8_t TELEMETRY_SYNC1 = 0x5A;
+
+const uint8_t TELEM_FLIGHT        = 0x01;   // Launch detected
+const uint8_t TELEM_RIGHT_VALID   = 0x02;   // Right sonar gave a sample this tick
+const uint8_t TELEM_HEIGHT_VALID  = 0x04;
+const uint8_t TELEM_RUDDER_WRITE  = 0x08;   // Rudder pulse changed this tick
+const uint8_t TELEM_ELEVATOR_WRITE = 0x10;
+const uint8_t TELEM_DROPPED       = 0x20;   // Frames were lost before this one
+const uint8_t TELEM_SENSOR_TEST   = 0x80;   // A reading of setup()'s sensor test, not a tick
+
+struct TelemetrySample {
+  uint32_t timeMs;
+  int16_t  rightMm;
+  int16_t  heightMm;
+  int16_t  rateRightMmS;
+  int16_t  rateHeightMmS;
+  uint16_t rudderUs;
+  uint16_t elevatorUs;
+  uint16_t rightEchoUs;
+  uint16_t rightEchoAtUs;
+  uint16_t heightEchoUs;
+  uint16_t heightEchoAtUs;
+  uint8_t  flags;
+};
+
+inline uint16_t telemetryChecksum(const uint8_t *data, int len) {
+  uint16_t a = 0, b = 0;
+  for (int i = 0; i < len; i++) {
+    a = (a + data[i]) % 255;
+    b = (b + a) % 255;
+  }
+  return (uint16_t)((b << 8) | a);
+}
+
+// Saturating conversion of a value in cm (or cm/s) to a 16-bit mm field,
+// truncated like toInt(); float or Q16
+template <typename T>
+inline int16_t toTelemetryMm(T cm) {
+  if (cm > T(3276)) return 32767;
+  if (cm < T(-3276)) return -32768;
+  return (int16_t)toInt(cm * 10);
+}
+
+inline void putU16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+inline uint16_t getU16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline void encodeTelemetry(const TelemetrySample &s, uint8_t seq, uint8_t *out) {
+  out[0] = TELEMETRY_SYNC0;
+  out[1] = TELEMETRY_SYNC1;
+  out[2] = seq;
+  out[3] = s.flags;
+  putU16(out + 4, (uint16_t)s.timeMs);
+  putU16(out + 6, (uint16_t)(s.timeMs >> 16));
+  putU16(out + 8, (uint16_t)s.rightMm);
+  putU16(out + 10, (uint16_t)s.heightMm);
+  putU16(out + 12, (uint16_t)s.rateRightMmS);
+  putU16(out + 14, (uint16_t)s.rateHeightMmS);
+  putU16(out + 16, s.rudderUs);
+  putU16(out + 18, s.elevatorUs);
+  putU16(out + 20, s.rightEchoUs);
+  putU16(out + 22, s.rightEchoAtUs);
+  putU16(out + 24, s.heightEchoUs);
+  putU16(out + 26, s.heightEchoAtUs);
+  putU16(out + 28, telemetryChecksum(out + 2, TELEMETRY_FRAME_BYTES - 4));
+}
+
+// False if the sync bytes or the checksum don't match
+inline bool decodeTelemetry(const uint8_t *in, TelemetrySample &s, uint8_t &seq) {
+  if (in[0] != TELEMETRY_SYNC0 || in[1] != TELEMETRY_SYNC1) return false;
+  if (getU16(in + 28) != telemetryChecksum(in + 2, TELEMETRY_FRAME_BYTES - 4)) return false;
+  seq = in[2];
+  s.flags = in[3];
+  s.timeMs = (uint32_t)getU16(in + 4) | ((uint32_t)getU16(in + 6) << 16);
+  s.rightMm = (int16_t)getU16(in + 8);
+  s.heightMm = (int16_t)getU16(in + 10);
+  s.rateRightMmS = (int16_t)getU16(in + 12);
+  s.rateHeightMmS = (int16_t)getU16(in + 14);
+  s.rudderUs = getU16(in + 16);
+  s.elevatorUs = getU16(in + 18);
+  s.rightEchoUs = getU16(in + 20);
+  s.rightEchoAtUs = getU16(in + 22);
+  s.heightEchoUs = getU16(in + 24);
+  s.heightEchoAtUs = getU16(in + 26);
+  return true;
+}
+
+// ---------------------------------------------------------
+// Single-producer single-consumer byte ring
+// ---------------------------------------------------------
+// Handoff as in EchoCapture: the producer only writes head, the consumer
+// only writes tail, both free-running 32-bit counters (volatile, atomic on
+// the M0+). The producer copies the bytes in before it moves head, so the
+// consumer never reads a half-written frame; the drain could equally run
+// from an interrupt.
+template <int N>
+class SpscRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+  private:
+    uint8_t buf[N];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+
+  public:
+    SpscRing() : head(0), tail(0) {}
+
+    uint32_t used() const { return head - tail; }
+    uint32_t space() const { return N - used(); }
+
+    // Producer: all `len` bytes or none
+    bool push(const uint8_t *data, uint32_t len) {
+      uint32_t h = head;
+      if (N - (h - tail) < len) return false;
+      for (uint32_t i = 0; i < len; i++) buf[(h + i) & (N - 1)] = data[i];
+      head = h + len;
+      return true;
+    }
+
+    // Consumer: the oldest unread bytes, as far as they run without wrapping
+    uint32_t peek(const uint8_t *&data) const {
+      uint32_t t = tail;
+      uint32_t avail = head - t;
+      uint32_t toEnd = N - (t & (N - 1));
+      data = buf + (t & (N - 1));
+      return avail < toEnd ? avail : toEnd;
+    }
+
+    void consume(uint32_t len) { tail = tail + len; }
+};
+
+// The fixed frame above as a TelemetryLog codec. A codec numbers its
+// frames, encodes one sample into at most MAX_BYTES and returns the length,
+// and hears about frames that did not fit in the ring (TelemetryDelta.h
+// restarts from a keyframe).
+class FixedFrameCodec {
+  private:
+    uint8_t seq;
+
+  public:
+    static const int MAX_BYTES = TELEMETRY_FRAME_BYTES;
+
+    FixedFrameCodec() : seq(0) {}
+
+    int encode(const TelemetrySample &s, uint8_t *out) {
+      encodeTelemetry(s, seq++, out);
+      return TELEMETRY_FRAME_BYTES;
+    }
+
+    void dropped() {}
+};
+
+// Producer side: frames samples into the ring and flags the first frame
+// after a drop
+template <int N, class Codec = FixedFrameCodec>
+class TelemetryLog {
+  private:
+    SpscRing<N> ring;
+    Codec codec;
+    bool lost;
+    uint32_t pushed;
+    uint32_t dropped;
+
+  public:
+    TelemetryLog() : lost(false), pushed(0), dropped(0) {}
+
+    bool push(TelemetrySample s) {
+      uint8_t frame[Codec::MAX_BYTES];
+      if (lost) s.flags |= TELEM_DROPPED;
+      int len = codec.encode(s, frame);
+      if (!ring.push(frame, len)) {
+        codec.dropped();
+        lost = true;
+        dropped++;
+        return false;
+      }
+      lost = false;
+      pushed++;
+      return true;
+    }
+
+    // Consumer: hands at most `maxBytes` to write(data, len), which returns
+    // how many it took. Returns the bytes drained.
+    template <typename Sink>
+    uint32_t drain(Sink &sink, uint32_t maxBytes) {
+      uint32_t total = 0;
+      while (total < maxBytes) {
+        const uint8_t *data;
+        uint32_t len = ring.peek(data);
+        if (len == 0) break;
+        if (len > maxBytes - total) len = maxBytes - total;
+        uint32_t took = sink.write(data, len);
+        ring.consume(took);
+        total += took;
+        if (took < len) break;
+      }
+      return total;
+    }
+
+    uint32_t framesPushed() const { return pushed; }
+    uint32_t framesDropped() const { return dropped; }
+    uint32_t bytesQueued() const { return ring.used(); }
+};
+
+// ---------------------------------------------------------
+// Stream decoder (host tools and tests)
+// ---------------------------------------------------------
+class TelemetryParser {
+  private:
+    uint8_t buf[TELEMETRY_FRAME_BYTES];
+    int len;
+    uint32_t skipped;
+
+    // Drop the first byte and everything up to the next sync candidate
+    void resync() {
+      int start = 1;
+      while (start < len && buf[start] != TELEMETRY_SYNC0) start++;
+      skipped += start;
+      for (int i = start; i < len; i++) buf[i - start] = buf[i];
+      len -= start;
+    }
+
+  public:
+    TelemetryParser() : len(0), skipped(0) {}
+
+    // True when `byte` completes a valid frame, decoded into s / seq
+    bool feed(uint8_t byte, TelemetrySample &s, uint8_t &seq) {
+      buf[len++] = byte;
+      for (;;) {
+        if (len >= 1 && buf[0] != TELEMETRY_SYNC0) { resync(); continue; }
+        if (len >= 2 && buf[1] != TELEMETRY_SYNC1) { resync(); continue; }
+        if (len < TELEMETRY_FRAME_BYTES) return false;
+        if (decodeTelemetry(buf, s, seq)) {
+          len = 0;
+          return true;
+        }
+        resync();
+      }
+    }
+
+    // Bytes thrown away while looking for frames
+    uint32_t bytesSkipped() const { return skipped; }
+};
+
+#endif
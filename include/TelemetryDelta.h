@@ -0,0 +1,242 @@
+#ifndef TELEMETRY_DELTA_H
+#define TELEMETRY_DELTA_H
+
+#include <stdint.h>
+#include "Telemetry.h"
+
+// =========================================================
+// Delta / zigzag-varint telemetry frames
+// =========================================================
+// From one 20Hz tick to the next the logged fields move by a few mm or
+// µs, but the fixed frame spends 2-4 bytes on each of them every time.
+// Here a frame carries each channel's change since the previous frame as a
+// zigzag varint: one byte for changes within ±63, two within ±8191.
+// Every TELEMETRY_KEYFRAME_EVERY frames, and after any frame the ring
+// dropped, a keyframe carries the absolute values instead. A decoder that
+// joins mid-stream or loses a frame picks up again at the next keyframe.
+//
+// Frame:
+//   0  0xA5 0x5D           sync (0x5A is the fixed frame)
+//   2  len                 bytes from seq to the end of the payload
+//   3  seq                 +1 per frame encoded
+//   4  flags               TELEM_*, plus TELEM_KEYFRAME
+//   5  payload             keyframe: timeMs, then each channel (zigzag)
+//                          delta: time step, then each channel's change
+//   n  CRC-16/CCITT of bytes 2..n-1, little-endian
+//
+// Channels, in order: rightMm, heightMm, rateRightMmS, rateHeightMmS,
+// rudderUs, elevatorUs, then the raw echoes (rightEchoUs, rightEchoAtUs,
+// heightEchoUs, heightEchoAtUs). A new channel is one more line in toChannels() /
+// fromChannels(); the frame length follows the payload.
+
+const uint8_t TELEMETRY_DELTA_SYNC1 = 0x5D;
+const uint8_t TELEM_KEYFRAME = 0x40;          // Absolute values, not changes
+const int TELEMETRY_KEYFRAME_EVERY = 20;      // 1s at 20Hz
+const int TELEMETRY_CHANNELS = 10;
+const int TELEMETRY_DELTA_HEADER = 5;
+const int TELEMETRY_DELTA_MAX_BYTES = TELEMETRY_DELTA_HEADER + 5 + TELEMETRY_CHANNELS * 5 + 2;
+
+// CRC-16/CCITT (poly 0x1021, init 0xFFFF), a nibble at a time from a
+// 16-entry table: 32 bytes of flash instead of 512
+inline uint16_t telemetryCrc16(const uint8_t *data, int len) {
+  static const uint16_t NIBBLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+  };
+  uint16_t crc = 0xFFFF;
+  for (int i = 0; i < len; i++) {
+    crc = (uint16_t)((crc << 4) ^ NIBBLE[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ NIBBLE[(crc >> 12) ^ (data[i] & 0x0F)]);
+  }
+  return crc;
+}
+
+inline uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// 7 bits per byte, low first, high bit set on all but the last
+inline int putVarint(uint8_t *p, uint32_t v) {
+  int n = 0;
+  while (v >= 0x80) {
+    p[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+// Bytes read, or 0 if the varint runs past `end` or beyond 5 bytes
+inline int getVarint(const uint8_t *p, const uint8_t *end, uint32_t &v) {
+  v = 0;
+  for (int n = 0; n < 5 && p + n < end; n++) {
+    v |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+    if (!(p[n] & 0x80)) return n + 1;
+  }
+  return 0;
+}
+
+inline void toChannels(const TelemetrySample &s, int32_t *ch) {
+  ch[0] = s.rightMm;
+  ch[1] = s.heightMm;
+  ch[2] = s.rateRightMmS;
+  ch[3] = s.rateHeightMmS;
+  ch[4] = s.rudderUs;
+  ch[5] = s.elevatorUs;
+  ch[6] = s.rightEchoUs;
+  ch[7] = s.rightEchoAtUs;
+  ch[8] = s.heightEchoUs;
+  ch[9] = s.heightEchoAtUs;
+}
+
+inline void fromChannels(const int32_t *ch, TelemetrySample &s) {
+  s.rightMm = (int16_t)ch[0];
+  s.heightMm = (int16_t)ch[1];
+  s.rateRightMmS = (int16_t)ch[2];
+  s.rateHeightMmS = (int16_t)ch[3];
+  s.rudderUs = (uint16_t)ch[4];
+  s.elevatorUs = (uint16_t)ch[5];
+  s.rightEchoUs = (uint16_t)ch[6];
+  s.rightEchoAtUs = (uint16_t)ch[7];
+  s.heightEchoUs = (uint16_t)ch[8];
+  s.heightEchoAtUs = (uint16_t)ch[9];
+}
+
+// TelemetryLog codec (Telemetry.h); integers only, about a dozen shifts
+// and stores per channel
+class DeltaFrameCodec {
+  private:
+    uint8_t seq;
+    int sinceKey;                      // Frames since the last keyframe, or -1: send one
+    uint32_t lastTimeMs;
+    int32_t last[TELEMETRY_CHANNELS];
+
+  public:
+    static const int MAX_BYTES = TELEMETRY_DELTA_MAX_BYTES;
+
+    DeltaFrameCodec() : seq(0), sinceKey(-1), lastTimeMs(0) {}
+
+    int encode(const TelemetrySample &s, uint8_t *out) {
+      int32_t ch[TELEMETRY_CHANNELS];
+      toChannels(s, ch);
+      bool key = sinceKey < 0 || sinceKey + 1 >= TELEMETRY_KEYFRAME_EVERY;
+
+      int n = TELEMETRY_DELTA_HEADER;
+      n += putVarint(out + n, key ? s.timeMs : s.timeMs - lastTimeMs);
+      for (int i = 0; i < TELEMETRY_CHANNELS; i++) {
+        n += putVarint(out + n, zigzag(key ? ch[i] : ch[i] - last[i]));
+        last[i] = ch[i];
+      }
+      lastTimeMs = s.timeMs;
+      sinceKey = key ? 0 : sinceKey + 1;
+
+      out[0] = TELEMETRY_SYNC0;
+      out[1] = TELEMETRY_DELTA_SYNC1;
+      out[2] = (uint8_t)(n - 3);
+      out[3] = seq++;
+      out[4] = (uint8_t)(s.flags | (key ? TELEM_KEYFRAME : 0));
+      putU16(out + n, telemetryCrc16(out + 2, n - 2));
+      return n + 2;
+    }
+
+    // The frame just encoded never reached the port, so the next one
+    // can't be a change from it
+    void dropped() { sinceKey = -1; }
+};
+
+// ---------------------------------------------------------
+// Stream decoder (host tools and tests)
+// ---------------------------------------------------------
+// Resyncs like TelemetryParser. A delta frame is only applied on top of
+// the frame with the previous sequence number; otherwise it is counted in
+// framesUnusable() and the decoder waits for the next keyframe.
+class DeltaParser {
+  private:
+    uint8_t buf[TELEMETRY_DELTA_MAX_BYTES];
+    int len;
+    uint32_t skipped;
+    uint32_t unusable;
+
+    bool haveRef;
+    uint8_t lastSeq;
+    uint32_t lastTimeMs;
+    int32_t last[TELEMETRY_CHANNELS];
+
+    void resync() {
+      int start = 1;
+      while (start < len && buf[start] != TELEMETRY_SYNC0) start++;
+      skipped += start;
+      for (int i = start; i < len; i++) buf[i - start] = buf[i];
+      len -= start;
+    }
+
+    // Payload of a CRC-checked frame into s; false if it doesn't parse
+    bool apply(TelemetrySample &s, uint8_t &seq) {
+      const uint8_t *p = buf + TELEMETRY_DELTA_HEADER;
+      const uint8_t *end = buf + 3 + buf[2];
+      bool key = (buf[4] & TELEM_KEYFRAME) != 0;
+      uint32_t v;
+      int n = getVarint(p, end, v);
+      if (n == 0) return false;
+      p += n;
+      uint32_t timeMs = key ? v : lastTimeMs + v;
+      int32_t ch[TELEMETRY_CHANNELS];
+      for (int i = 0; i < TELEMETRY_CHANNELS; i++) {
+        n = getVarint(p, end, v);
+        if (n == 0) return false;
+        p += n;
+        ch[i] = key ? unzigzag(v) : last[i] + unzigzag(v);
+      }
+      if (p != end) return false;
+
+      for (int i = 0; i < TELEMETRY_CHANNELS; i++) last[i] = ch[i];
+      lastTimeMs = timeMs;
+      lastSeq = buf[3];
+      haveRef = true;
+
+      seq = buf[3];
+      s.timeMs = timeMs;
+      s.flags = (uint8_t)(buf[4] & ~TELEM_KEYFRAME);
+      fromChannels(ch, s);
+      return true;
+    }
+
+  public:
+    DeltaParser() : len(0), skipped(0), unusable(0), haveRef(false), lastSeq(0), lastTimeMs(0) {}
+
+    // True when `byte` completes a frame that decodes, into s / seq
+    bool feed(uint8_t byte, TelemetrySample &s, uint8_t &seq) {
+      buf[len++] = byte;
+      for (;;) {
+        if (len >= 1 && buf[0] != TELEMETRY_SYNC0) { resync(); continue; }
+        if (len >= 2 && buf[1] != TELEMETRY_DELTA_SYNC1) { resync(); continue; }
+        if (len >= 3 && (buf[2] < TELEMETRY_DELTA_HEADER - 3 + 7 ||
+                         buf[2] > TELEMETRY_DELTA_MAX_BYTES - 5)) { resync(); continue; }
+        if (len < 3 || len < 3 + buf[2] + 2) return false;
+        int body = 3 + buf[2];
+        if (getU16(buf + body) != telemetryCrc16(buf + 2, body - 2)) { resync(); continue; }
+
+        len = 0;
+        bool key = (buf[4] & TELEM_KEYFRAME) != 0;
+        if (!key && (!haveRef || buf[3] != (uint8_t)(lastSeq + 1))) {
+          haveRef = false;
+          unusable++;
+          return false;
+        }
+        if (apply(s, seq)) return true;
+        haveRef = false;
+        unusable++;
+        return false;
+      }
+    }
+
+    uint32_t bytesSkipped() const { return skipped; }
+    // Intact frames that could not be decoded: deltas after a lost frame
+    uint32_t framesUnusable() const { return unusable; }
+};
+
+#endif
@@ -1,5 +1,53 @@
-#include <Arduino.h>
-#include <Servo.h>
+#include "Hal.h"
+#include "EchoCapture.h"
+#include "SonarScheduler.h"
+#include "RangeGate.h"
+#include "SignalPath.h"
+#include "SpikeFilter.h"
+#include "StateEstimator.h"
+#include "ControlScheduler.h"
+#include "TaskExecutor.h"
+#include "ControlLaw.h"
+#include "ServoTable.h"
+#include "TccServo.h"
+#include "ServoModel.h"
+#include "ServoBudget.h"
+#include "Telemetry.h"
+#include "TelemetryDelta.h"
+#include "FlightRecorder.h"
+#include "StageProfiler.h"
+
+// Build the sensor -> rate -> servo path in Q16.16 fixed point instead of
+// soft-float (the M0+ has no FPU). Override with -DUSE_FIXED_POINT=1.
+#ifndef USE_FIXED_POINT
+#define USE_FIXED_POINT 0
+#endif
+
+#if USE_FIXED_POINT
+typedef Q16 real_t;
+#else
+typedef float real_t;
+#endif
+
+// Control law, fixed at compile time (see ControlLaw.h); the laws not
+// selected are not built. Override with e.g. -DCONTROL_LAW=LAW_PD.
+#ifndef CONTROL_LAW
+#define CONTROL_LAW LAW_BANG_BANG_HOLD
+#endif
+
+// Per-stage latency histograms (StageProfiler.h, 'p' prints). Host drivers
+// that only replay flights build with -DPROFILE_STAGES=0: on Linux the
+// profiler reads the host clock, which costs more than the flight code.
+#ifndef PROFILE_STAGES
+#define PROFILE_STAGES 1
+#endif
+
+// Control constants from the autotuner (tools/tune). Each TUNED_ macro below
+// defaults to the hand-set value; -DTUNED_PARAMS takes the tuner's generated
+// include/TunedParams.h instead, and -DTUNED_<name>=value sets one.
+#ifdef TUNED_PARAMS
+#include "TunedParams.h"
+#endif
 
 // =========================================================
 // 1. HARDWARE PIN CONFIGURATION
@@ -16,18 +64,61 @@ const int PIN_TRIG_RIGHT     = 6;
 // =========================================================
 // 2. SENSOR PHYSICS & LIMITS
 // =========================================================
-const float SPEED_OF_SOUND_DIVISOR = 58.0;   // Divide uS by this to get cm
+const real_t SPEED_OF_SOUND_DIVISOR = 58.0;   // Divide uS by this to get cm
 const unsigned long SONAR_TIMEOUT_US = 30000; // 30ms ~ 400cm range
-const float NO_READING_VAL         = -1.0;   // Return value for timeout
+const unsigned long SONAR_SLOT_US    = 25000; // Stagger between interleaved pings (20Hz per sensor, one per control tick)
+const unsigned long SONAR_LISTEN_US  = 12500; // Widest per-ping listen window (~215cm)
+const unsigned long SONAR_HORIZON_US = 24000; // A burst's echoes die out (400cm and back): nearer the other sensor's burst is crosstalk
+const unsigned long SONAR_BURST_US   = 500;   // Trigger to echo rise (8-cycle burst)
+const real_t NO_READING_VAL        = -1.0;   // Return value for timeout
 
 // Filter Settings
-const float DIST_FILTER_ALPHA      = 0.70;   // Low pass filter strength (0.0 - 1.0)
-const float MAX_DIST_JUMP_CM       = 60.0;   // Spike rejection threshold
-const float FAILSAFE_DIST_CM       = 50.0;   // Default distance if sensor fails at startup
+#ifndef TUNED_DIST_FILTER_ALPHA
+#define TUNED_DIST_FILTER_ALPHA 0.70
+#endif
+const real_t DIST_FILTER_ALPHA     = TUNED_DIST_FILTER_ALPHA;  // Low pass filter strength (0.0 - 1.0)
+const real_t MAX_DIST_JUMP_CM      = 60.0;   // Spike rejection threshold (also caps the Hampel limit)
+const real_t FAILSAFE_DIST_CM      = 50.0;   // Default distance if sensor fails at startup
+
+// Spike Filter Stage (ahead of the low pass filter)
+const int SPIKE_FILTER_JUMP        = 0;      // Hold on jumps > MAX_DIST_JUMP_CM
+const int SPIKE_FILTER_MEDIAN      = 1;      // Running median (adds HAMPEL_WINDOW/2 ticks of lag)
+const int SPIKE_FILTER_HAMPEL      = 2;      // Replace outliers with the running median
+const int SPIKE_FILTER_MODE        = SPIKE_FILTER_HAMPEL;
+const int HAMPEL_WINDOW            = 5;      // Samples (odd)
+const real_t HAMPEL_K              = 3.0;    // Outlier threshold in robust standard deviations
+const real_t HAMPEL_MIN_DEV_CM     = 8.0;    // Never call anything closer than this an outlier
+
+// Range Gate (adaptive listen window per ping)
+const bool  SONAR_RANGE_GATE       = true;   // false = always listen SONAR_LISTEN_US
+const float GATE_MARGIN_CM         = 30.0;   // Slack beyond the predicted range
+const float GATE_HORIZON_SEC       = 0.10;   // How far ahead the rate is projected
+const unsigned long GATE_MIN_US    = 3000;   // Never listen less than ~43cm
+const int   GATE_LOST_AFTER        = 3;      // Misses before the gate reopens fully
 
 // Rate Calculation Settings
-const float MAX_PHYSICAL_RATE_CM_S = 200.0;  // Clamp rates above this (noise rejection)
-const int   RATE_AVG_WINDOW_SIZE   = 3;      // Average the last N rates (Smoothing)
+const real_t MAX_PHYSICAL_RATE_CM_S = 200.0;  // Clamp rates above this (noise rejection)
+#ifndef TUNED_RATE_AVG_WINDOW_SIZE
+#define TUNED_RATE_AVG_WINDOW_SIZE 3
+#endif
+const int   RATE_AVG_WINDOW_SIZE   = TUNED_RATE_AVG_WINDOW_SIZE;  // Average the last N rates (Smoothing)
+
+// Rate Estimator
+const int RATE_ESTIMATOR_DIFF       = 0;     // EMA distance, difference quotient, rolling average
+const int RATE_ESTIMATOR_TRACKER    = 1;     // Joint distance/rate alpha-beta tracker
+#ifndef TUNED_RATE_ESTIMATOR
+#define TUNED_RATE_ESTIMATOR RATE_ESTIMATOR_TRACKER
+#endif
+#ifndef TUNED_TRACKER_ALPHA
+#define TUNED_TRACKER_ALPHA 0.70
+#endif
+#ifndef TUNED_TRACKER_BETA
+#define TUNED_TRACKER_BETA 0.35
+#endif
+const int RATE_ESTIMATOR            = TUNED_RATE_ESTIMATOR;
+const real_t TRACKER_ALPHA          = TUNED_TRACKER_ALPHA;  // Distance correction gain
+const real_t TRACKER_BETA           = TUNED_TRACKER_BETA;   // Rate correction gain
+const int   TRACKER_MAX_COAST       = 6;     // Missed pings predicted through before the rate is dropped
 
 // =========================================================
 // 3. SERVO CALIBRATION
@@ -42,15 +133,68 @@ const int SERVO_ELEVATOR_UP      = 2100;
 const int SERVO_ELEVATOR_MIN     = 900;
 const int SERVO_ELEVATOR_MAX     = 2100;
 
-const float SERVO_SMOOTHING_ALPHA = 0.70;     // Output smoothing
-const int   SERVO_DEADBAND_US     = 300;       // Minimum change to write to servo
+const int   SERVO_SMOOTHING_PERMILLE = 700;  // Output smoothing (700: alpha = 0.70)
+const real_t SERVO_SMOOTHING_ALPHA = SERVO_SMOOTHING_PERMILLE / 1000.0;
+
+// Servo Budget (ServoBudget.h): the minimum change written to a servo
+// follows its heat estimate instead of a fixed deadband
+const int   SERVO_STEP_MIN_US     = 10;        // Granularity with a cold servo
+#ifndef TUNED_SERVO_STEP_MAX_US
+#define TUNED_SERVO_STEP_MAX_US 300
+#endif
+const int   SERVO_STEP_MAX_US     = TUNED_SERVO_STEP_MAX_US;  // At the budget limit (the old fixed deadband)
+const long  SERVO_BUDGET_US       = 20000;     // Heat limit, in us of travel written
+const int   SERVO_HOLD_PERMILLE   = 20;        // Heat per tick per us held off neutral (x1000)
+const float SERVO_COOL_TAU_SEC    = 10.0;      // Heat decay time constant
+
+// Integer command map and table smoothing (ServoTable.h);
+// false = ControlLaw::update(), constrain() and float/Q16 smoothServo()
+const bool  SERVO_LUT             = true;
+// Servo Output
+const int SERVO_BACKEND_LIBRARY     = 0;     // Servo library (TC4 ISR, channels staggered in the frame)
+const int SERVO_BACKEND_TCC         = 1;     // TCC0 compare channels, both latched at one frame start
+#if defined(ARDUINO_ARCH_SAMD)
+const int SERVO_BACKEND             = SERVO_BACKEND_TCC;
+#else
+const int SERVO_BACKEND             = SERVO_BACKEND_LIBRARY;
+#endif
+const unsigned long SERVO_FRAME_US  = 20000; // TCC frame: 20000 for analog servos, >= 2500 for digital
+
+// Servo Lead (ServoModel.h): command ahead of the horn's modelled response.
+// Identify the servo with test/servo_test_battery.cpp (feedback pot wired)
+const bool  SERVO_LEAD            = true;
+const real_t SERVO_DEAD_SEC       = 0.020;   // Command to first horn movement
+const real_t SERVO_SLEW_US_S      = 8000.0;  // Top horn speed (pulse-width us per second)
+const real_t SERVO_TAU_SEC        = 0.030;   // Settling near the target
+const real_t SERVO_LEAD_GAIN      = 1.0;     // Overdrive per us the horn is predicted behind
+#ifndef TUNED_SERVO_FF_GAIN
+#define TUNED_SERVO_FF_GAIN 0.5
+#endif
+const real_t SERVO_FF_GAIN        = TUNED_SERVO_FF_GAIN;  // Share of the not-yet-smoothed step passed on (1.0 undoes the smoothing)
+
+const int   SERVO_SPAN_US = (SERVO_RUDDER_MAX - SERVO_RUDDER_MIN > SERVO_ELEVATOR_MAX - SERVO_ELEVATOR_MIN)
+                            ? SERVO_RUDDER_MAX - SERVO_RUDDER_MIN : SERVO_ELEVATOR_MAX - SERVO_ELEVATOR_MIN;
 
 // =========================================================
 // 4. CONTROL LAW PARAMETERS
 // =========================================================
 // Simple Control: Servo goes to MAX if rate exceeds threshold, neutral otherwise
-float PARAM_RATE_RIGHT_THRESHOLD  = 50.0;    // cm/s - trigger rudder
-float PARAM_RATE_HEIGHT_THRESHOLD = 50.0;    // cm/s - trigger elevator
+#ifndef TUNED_RATE_RIGHT_THRESHOLD
+#define TUNED_RATE_RIGHT_THRESHOLD 50.0
+#endif
+#ifndef TUNED_RATE_HEIGHT_THRESHOLD
+#define TUNED_RATE_HEIGHT_THRESHOLD 50.0
+#endif
+real_t PARAM_RATE_RIGHT_THRESHOLD  = TUNED_RATE_RIGHT_THRESHOLD;   // cm/s - trigger rudder
+real_t PARAM_RATE_HEIGHT_THRESHOLD = TUNED_RATE_HEIGHT_THRESHOLD;  // cm/s - trigger elevator
+
+// Proportional / PD / time-to-collision laws (CONTROL_LAW)
+const real_t PARAM_TARGET_RIGHT_CM  = 45.0;   // Centre of the 3ft corridor exit
+const real_t PARAM_TARGET_HEIGHT_CM = 105.0;  // 3.5ft
+const real_t PARAM_KP_US_PER_CM     = 10.0;   // Correction per cm inside the set-point
+const real_t PARAM_KD_US_PER_CM_S   = 8.0;    // Correction per cm/s of closure
+const real_t PARAM_TAU_SEC          = 1.5;    // Correct when contact is under this far away
+const real_t PARAM_TAU_FULL_SEC     = 0.5;    // LAW_TAU: full correction from here in
 
 // Timeout Settings
 const float SERVO_TIMEOUT_SEC = 0.7;         // Return to neutral after this time (seconds)
@@ -59,8 +203,37 @@ const float SERVO_TIMEOUT_SEC = 0.7;         // Return to neutral after this tim
 // 5. SYSTEM TIMING
 // =========================================================
 const int LOOP_PERIOD_MS         = 50;       // 20Hz Control Loop
-const unsigned long LOG_INTERVAL_MS = 200;   // 5Hz Logging
-const float MS_TO_SEC            = 1000.0;   // Conversion factor
+#if defined(ARDUINO_ARCH_SAMD)
+const bool CONTROL_TIMER         = true;     // TC3 interrupt releases each control cycle
+#else
+const bool CONTROL_TIMER         = false;    // No TC3: poll millis() as before
+#endif
+const unsigned long CONTROL_TIMER_HZ = 750000;  // 48MHz GCLK0 / 64
+
+// Task Executor (see the TASKS table; priority 0 runs first)
+const unsigned long SONAR_POLL_US       = 250;    // Ping scheduler / echo pickup period
+const unsigned long SONAR_DEADLINE_US   = 1000;   // Late pings shift the interleave slots
+const unsigned long CONTROL_DEADLINE_US = 10000;  // Release to servo write
+const unsigned long SERIAL_POLL_US      = 20000;  // Serial command check
+const bool TELEMETRY_LOG                = false;  // Stream telemetry from power-on ('l' toggles); off keeps the console text
+const int TELEMETRY_TEXT                = 0;      // logTelemetry() lines every LOG_INTERVAL_MS
+const int TELEMETRY_BINARY              = 1;      // A 30-byte frame every control tick (tools/telemetry_decode)
+const int TELEMETRY_DELTA               = 2;      // Delta/varint frames, ~20 bytes, keyframe every 1s
+const int TELEMETRY_FORMAT              = TELEMETRY_DELTA;
+const int TELEMETRY_RING_BYTES          = 1024;   // 1.7s of 30-byte frames at 20Hz, ~2.6s of delta frames
+const unsigned long TELEMETRY_DRAIN_US  = 5000;   // Ring drain period (binary formats)
+const unsigned long LOG_INTERVAL_MS = 200;   // 5Hz Logging (TELEMETRY_TEXT)
+
+// Flight Recorder (FlightRecorder.h, SAMD only): every tick to RAM in
+// flight, committed to flash after landing ('d' dumps, 'E' erases)
+const int   RECORDER_RECORDS        = 252;    // 12.6s at 20Hz, one 6KB flash slot
+const int   RECORDER_SLOTS          = 4;      // Flights kept, oldest overwritten
+const uint32_t RECORDER_BASE        = 0x3A000; // Last 24KB of the SAMD21G18's 256KB
+const real_t RECORDER_LANDED_CM     = 20.0;   // Height reading on the ground...
+const unsigned long RECORDER_LANDED_MS = 1000; // ...held this long ends the flight
+const unsigned long RECORDER_POLL_US    = 5000;  // Commit task period
+const unsigned long RECORDER_MARGIN_US  = 1000;  // Flash ops end this long before a release
+const real_t MS_TO_SEC           = 1000.0;   // Conversion factor
 
 const int DELAY_TRIG_LOW_1_US    = 2;
 const int DELAY_TRIG_HIGH_US     = 10;
@@ -68,57 +241,71 @@ const int DELAY_STARTUP_MS       = 1000;
 const int DELAY_SENSOR_STABLE_MS = 20;
 
 // Launch Detection
-const float LAUNCH_HEIGHT_CM     = 60.0;
+const real_t LAUNCH_HEIGHT_CM    = 60.0;
 
 // =========================================================
-// CLASS: Rolling Average (To smooth Rate of Change)
+// GLOBAL OBJECTS & VARIABLES
 // =========================================================
-class RollingAverage {
-  private:
-    float* history;
-    int size;
-    int index;
-    float sum;
-    bool filled;
-  
-  public:
-    RollingAverage(int windowSize) {
-      size = windowSize;
-      history = new float[size];
-      index = 0;
-      sum = 0.0;
-      filled = false;
-      for (int i = 0; i < size; i++) history[i] = 0.0;
-    }
+HalServo rudderServo;
+HalServo elevatorServo;
+#if defined(ARDUINO_ARCH_SAMD)
+static_assert(PIN_SERVO_ELEVATOR == 1 && PIN_SERVO_RUDDER == 2, "TccServo drives D1 and D2");
+Tcc0Hw tcc0;
+TccServo<Tcc0Hw> servoOut(tcc0);           // Channel 0: elevator (D1), 1: rudder (D2)
+#endif
 
-    float add(float val) {
-      sum -= history[index];
-      history[index] = val;
-      sum += history[index];
-      index++;
-      if (index >= size) {
-        index = 0;
-        filled = true;
-      }
-      return filled ? (sum / size) : (sum / index);
-    }
-};
+// Interrupt-driven echo capture (one per HC-SR04). The timeout here only
+// covers setup()'s blocking reads; the scheduler sets each ping's window.
+EchoCapture sonarRight(SONAR_TIMEOUT_US);
+EchoCapture sonarHeight(SONAR_TIMEOUT_US);
 
-// =========================================================
-// GLOBAL OBJECTS & VARIABLES
-// =========================================================
-Servo rudderServo;
-Servo elevatorServo;
+const int SONAR_RIGHT  = 0;
+const int SONAR_HEIGHT = 1;
+bool firePing(int channel);
+SonarScheduler sonar(sonarRight, sonarHeight, firePing, SONAR_SLOT_US, SONAR_LISTEN_US, SONAR_HORIZON_US);
+static_assert(SONAR_SLOT_US >= SONAR_HORIZON_US, "Each ping must wait out the other sensor's echoes");
+static_assert(2 * SONAR_SLOT_US >= 38000, "An HC-SR04 miss holds its echo line ~38ms: pinging sooner is ignored");
+
+RangeGate gateRight(GATE_MARGIN_CM, GATE_HORIZON_SEC, SONAR_BURST_US, GATE_MIN_US,
+                    SONAR_LISTEN_US, SONAR_TIMEOUT_US, GATE_LOST_AFTER);
+RangeGate gateHeight(GATE_MARGIN_CM, GATE_HORIZON_SEC, SONAR_BURST_US, GATE_MIN_US,
+                     SONAR_LISTEN_US, SONAR_TIMEOUT_US, GATE_LOST_AFTER);
+
+// Spike filters on the raw range stream
+HampelFilter<real_t, HAMPEL_WINDOW> spikesRight(HAMPEL_K, HAMPEL_MIN_DEV_CM, MAX_DIST_JUMP_CM);
+HampelFilter<real_t, HAMPEL_WINDOW> spikesHeight(HAMPEL_K, HAMPEL_MIN_DEV_CM, MAX_DIST_JUMP_CM);
 
 // Rolling Average Objects for Rate
-RollingAverage rateSmootherRight(RATE_AVG_WINDOW_SIZE);
-RollingAverage rateSmootherHeight(RATE_AVG_WINDOW_SIZE);
+RollingAverage<real_t, RATE_AVG_WINDOW_SIZE> rateSmootherRight;
+RollingAverage<real_t, RATE_AVG_WINDOW_SIZE> rateSmootherHeight;
+
+// Distance/rate trackers (RATE_ESTIMATOR_TRACKER)
+AlphaBetaTracker<real_t> trackRight(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST);
+AlphaBetaTracker<real_t> trackHeight(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST);
 
 // Sensor State
-float currentRight = 0.0;
-float currentHeight = 0.0;
-float prevRight = 0.0;
-float prevHeight = 0.0;
+real_t currentRight = 0.0;
+real_t currentHeight = 0.0;
+real_t prevRight = 0.0;
+real_t prevHeight = 0.0;
+
+// Latest raw ranges published by the echo ISRs, consumed once per loop tick
+real_t rawRight = NO_READING_VAL;
+real_t rawHeight = NO_READING_VAL;
+
+// The echoes behind them as the telemetry frame logs them for tools/replay:
+// width, and falling edge after the trigger (0 when the tick got none)
+uint16_t rawRightEchoUs = 0;
+uint16_t rawRightEchoAtUs = 0;
+uint16_t rawHeightEchoUs = 0;
+uint16_t rawHeightEchoAtUs = 0;
+
+// Echo mid-point micros() of those raw ranges, and of the last sample each
+// axis accepted (rates use the true interval between samples, not loop dt)
+unsigned long rawRightAtUs = 0;
+unsigned long rawHeightAtUs = 0;
+unsigned long lastRightAtUs = 0;
+unsigned long lastHeightAtUs = 0;
 
 // Control State
 bool isCorrectingWall = false;
@@ -127,247 +314,887 @@ unsigned long wallCorrectionStartTime = 0;
 unsigned long heightCorrectionStartTime = 0;
 bool flightStarted = false;
 unsigned long flightStartTime = 0;
+real_t avgRateRight = 0.0;
+real_t avgRateHeight = 0.0;
 
 // Servo Hold Timers
-unsigned long rudderActivatedTime = 0;
-unsigned long elevatorActivatedTime = 0;
-bool rudderActive = false;
-bool elevatorActive = false;
-const unsigned long SERVO_HOLD_TIME_MS = 500; // Hold servo position for 500ms (0.5 seconds)
+#ifndef TUNED_SERVO_HOLD_TIME_MS
+#define TUNED_SERVO_HOLD_TIME_MS 500
+#endif
+const unsigned long SERVO_HOLD_TIME_MS = TUNED_SERVO_HOLD_TIME_MS; // Hold servo position (500ms hand-set)
+
+// Control Laws (one per axis, CONTROL_LAW)
+const AxisConfig<real_t> RUDDER_AXIS = {
+  SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX,
+  PARAM_RATE_RIGHT_THRESHOLD, SERVO_HOLD_TIME_MS,
+  PARAM_TARGET_RIGHT_CM, PARAM_KP_US_PER_CM, PARAM_KD_US_PER_CM_S,
+  PARAM_TAU_SEC, PARAM_TAU_FULL_SEC
+};
+const AxisConfig<real_t> ELEVATOR_AXIS = {
+  SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP, SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX,
+  PARAM_RATE_HEIGHT_THRESHOLD, SERVO_HOLD_TIME_MS,
+  PARAM_TARGET_HEIGHT_CM, PARAM_KP_US_PER_CM, PARAM_KD_US_PER_CM_S,
+  PARAM_TAU_SEC, PARAM_TAU_FULL_SEC
+};
+typedef ControlLaw<LawPolicy<CONTROL_LAW, real_t>::type> AxisLaw;
+AxisLaw rudderLaw(RUDDER_AXIS);
+AxisLaw elevatorLaw(ELEVATOR_AXIS);
+
+// Servo command map and smoothing table (SERVO_LUT)
+typedef ServoMap<SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX> RudderMap;
+typedef ServoMap<SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP, SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX> ElevatorMap;
+typedef ServoSmoothing<SERVO_SMOOTHING_PERMILLE, SERVO_SPAN_US> ServoSmoother;
+
+// Servo response models (SERVO_LEAD)
+const ServoParams<real_t> SERVO_RESPONSE = { SERVO_DEAD_SEC, SERVO_SLEW_US_S, SERVO_TAU_SEC };
+ServoLead<real_t> rudderLead(SERVO_RESPONSE, real_t(LOOP_PERIOD_MS / 1000.0), SERVO_RUDDER_NEUTRAL,
+                             SERVO_RUDDER_MIN, SERVO_RUDDER_MAX, SERVO_LEAD_GAIN, SERVO_FF_GAIN);
+ServoLead<real_t> elevatorLead(SERVO_RESPONSE, real_t(LOOP_PERIOD_MS / 1000.0), SERVO_ELEVATOR_NEUTRAL,
+                               SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX, SERVO_LEAD_GAIN, SERVO_FF_GAIN);
+
+// Servo budgets (per flight counters: 'b')
+const ServoBudgetConfig SERVO_BUDGET = {
+  SERVO_STEP_MIN_US, SERVO_STEP_MAX_US, SERVO_BUDGET_US, SERVO_HOLD_PERMILLE,
+  (int)(LOOP_PERIOD_MS / SERVO_COOL_TAU_SEC + 0.5)
+};
+ServoBudget rudderBudget(SERVO_BUDGET, SERVO_RUDDER_NEUTRAL);
+ServoBudget elevatorBudget(SERVO_BUDGET, SERVO_ELEVATOR_NEUTRAL);
 
 // Servo State
 int prevRudderPWM = SERVO_RUDDER_NEUTRAL;
 int prevElevatorPWM = SERVO_ELEVATOR_NEUTRAL;
 
 // Timing State
+ControlScheduler controlClock(LOOP_PERIOD_MS * 1000UL);
 unsigned long prevLoopTime = 0;
-unsigned long lastLogTime = 0;
+bool telemetryOn = TELEMETRY_LOG;
+// Hot-path stages timed by the profiler ('p'); servo includes write, and
+// control is the whole tick
+enum Stage {
+  STAGE_SONAR, STAGE_FILTER, STAGE_RATE, STAGE_LAW, STAGE_SERVO, STAGE_WRITE,
+  STAGE_LOG, STAGE_CONTROL, STAGE_DRAIN, STAGE_COUNT
+};
+const char *const STAGE_NAMES[STAGE_COUNT] = {
+  "sonar", "filter", "rate", "law", "servo", "write", "log", "control", "drain"
+};
+typedef StageProfiler<ProfileClock, STAGE_COUNT, PROFILE_STAGES> Profiler;
+Profiler profiler;
+
+// Frame codec for TELEMETRY_FORMAT (unused with the text format)
+template <int Format> struct TelemetryCodecFor { typedef FixedFrameCodec type; };
+template <> struct TelemetryCodecFor<TELEMETRY_DELTA> { typedef DeltaFrameCodec type; };
+TelemetryLog<TELEMETRY_RING_BYTES, TelemetryCodecFor<TELEMETRY_FORMAT>::type> telemetry;   // Control task -> telemetry task
+unsigned long landedSinceMs = 0;                 // Height under RECORDER_LANDED_CM since, or 0
+#if defined(ARDUINO_ARCH_SAMD)
+typedef FlightRecorder<Samd21Flash, RECORDER_RECORDS> Recorder;
+static_assert(RECORDER_BASE % Samd21Flash::ROW_BYTES == 0, "RECORDER_BASE must be row aligned");
+static_assert(RECORDER_BASE + RECORDER_SLOTS * Recorder::SLOT_BYTES <= 0x40000, "Recorder past the end of flash");
+Samd21Flash nvm;
+Recorder recorder(nvm, RECORDER_BASE, RECORDER_SLOTS);
+
+// The image's end in flash is only known after linking: code up to
+// __etext, then the initial values of .data (ArduinoCore-samd's linker
+// script). An image reaching RECORDER_BASE would be erased by a commit,
+// so the recorder stays off then.
+extern "C" uint32_t __etext, __data_start__, __data_end__;
+bool recorderOn = false;
+
+bool recorderClearOfImage() {
+  uintptr_t imageEnd = (uintptr_t)&__etext + ((uintptr_t)&__data_end__ - (uintptr_t)&__data_start__);
+  return imageEnd <= RECORDER_BASE;
+}
+#endif
+
+// Task table (task functions are defined after the control task)
+void sonarTask(uint32_t nowUs);
+void controlTask(uint32_t nowUs);
+void serialTask(uint32_t nowUs);
+void telemetryTask(uint32_t nowUs);
+void recorderTask(uint32_t nowUs);
+
+bool controlReleased(uint32_t nowUs) {
+  return controlClock.begin(nowUs);
+}
+
+uint32_t clockMicros() {
+  return halMicros();
+}
+
+const Task TASKS[] = {
+  // name        run            period                                       release hook                            deadline             priority
+  { "sonar",     sonarTask,     SONAR_POLL_US,                               NULL,                                   SONAR_DEADLINE_US,   0 },
+  { "control",   controlTask,   CONTROL_TIMER ? 0 : LOOP_PERIOD_MS * 1000UL, CONTROL_TIMER ? controlReleased : NULL, CONTROL_DEADLINE_US, 1 },
+  { "serial",    serialTask,    SERIAL_POLL_US,                              NULL,                                   0,                   2 },
+  { "telemetry", telemetryTask, TELEMETRY_FORMAT != TELEMETRY_TEXT
+                                ? TELEMETRY_DRAIN_US : LOG_INTERVAL_MS * 1000UL, NULL,                                   0,                   3 },
+  { "recorder",  recorderTask,  RECORDER_POLL_US,                            NULL,                                   0,                   4 },
+};
+const int TASK_COUNT = sizeof(TASKS) / sizeof(TASKS[0]);
+TaskExecutor<TASK_COUNT> tasks(TASKS, clockMicros);
 
 // =========================================================
 // HELPER FUNCTIONS
 // =========================================================
 
-float readUltrasonic(int trigPin, int echoPin) {
-  digitalWrite(trigPin, LOW);
-  delayMicroseconds(DELAY_TRIG_LOW_1_US);
-  digitalWrite(trigPin, HIGH);
-  delayMicroseconds(DELAY_TRIG_HIGH_US);
-  digitalWrite(trigPin, LOW);
-  
-  long duration = pulseIn(echoPin, HIGH, SONAR_TIMEOUT_US);
-  
-  if (duration == 0) return NO_READING_VAL;
-  return duration / SPEED_OF_SOUND_DIVISOR;
+void onEchoRight() {
+  sonarRight.onEdge(halEchoRead(PIN_ECHO_RIGHT), halMicros());
 }
 
-float getFilteredDistance(int trigPin, int echoPin, float prevSmoothed) {
-  float raw = readUltrasonic(trigPin, echoPin);
-  
+void onEchoHeight() {
+  sonarHeight.onEdge(halEchoRead(PIN_ECHO_HEIGHT), halMicros());
+}
+
+// Fires the trigger pulse and returns right away; the echo ISR does the rest.
+void triggerPing(int trigPin, EchoCapture &sonar) {
+  halTriggerWrite(trigPin, false);
+  halDelayUs(DELAY_TRIG_LOW_1_US);
+  sonar.arm(halMicros());
+  halTriggerWrite(trigPin, true);
+  halDelayUs(DELAY_TRIG_HIGH_US);
+  halTriggerWrite(trigPin, false);
+}
+
+real_t echoToDistance(const EchoSample &sample) {
+  if (sample.widthUs == 0) return NO_READING_VAL;
+  return real_t(sample.widthUs) / SPEED_OF_SOUND_DIVISOR;
+}
+
+// Width and trigger-to-fall time of an echo as logged, saturated to 16 bits
+void keepRawEcho(const EchoSample &sample, uint16_t &widthUs, uint16_t &atUs) {
+  uint32_t at = sample.stampUs - sample.armedUs;
+  widthUs = (uint16_t)(sample.widthUs > 0xFFFF ? 0xFFFF : sample.widthUs);
+  atUs = (uint16_t)(sample.widthUs == 0 ? 0 : at > 0xFFFF ? 0xFFFF : at);
+}
+
+// Blocking read, only used by the startup sensor test in setup()
+float readUltrasonic(int trigPin, EchoCapture &sonar) {
+  triggerPing(trigPin, sonar);
+  EchoSample sample;
+  while (!sonar.fetch(halMicros(), sample)) {}
+  if (trigPin == PIN_TRIG_RIGHT) keepRawEcho(sample, rawRightEchoUs, rawRightEchoAtUs);
+  else                           keepRawEcho(sample, rawHeightEchoUs, rawHeightEchoAtUs);
+  return toFloat(echoToDistance(sample));
+}
+
+// One telemetry frame per sensor test reading, so a replay of a stream
+// captured from power-on starts the filters where the board did
+void logSensorTest(float right, float height) {
+  if (TELEMETRY_FORMAT != TELEMETRY_TEXT && telemetryOn) {
+    TelemetrySample rec = TelemetrySample();
+    rec.rightMm = toTelemetryMm(right);
+    rec.heightMm = toTelemetryMm(height);
+    rec.rightEchoUs = rawRightEchoUs;
+    rec.rightEchoAtUs = rawRightEchoAtUs;
+    rec.heightEchoUs = rawHeightEchoUs;
+    rec.heightEchoAtUs = rawHeightEchoAtUs;
+    rec.flags = TELEM_SENSOR_TEST;
+    telemetry.push(rec);
+  }
+  rawRightEchoUs = rawRightEchoAtUs = 0;
+  rawHeightEchoUs = rawHeightEchoAtUs = 0;
+}
+
+// Scheduler callback: pings one sensor of the interleaved pair, unless its
+// echo line is still high from a miss (the sensor would ignore the trigger)
+bool firePing(int channel) {
+  if (channel == SONAR_RIGHT) {
+    if (halEchoRead(PIN_ECHO_RIGHT)) return false;
+    triggerPing(PIN_TRIG_RIGHT, sonarRight);
+  } else {
+    if (halEchoRead(PIN_ECHO_HEIGHT)) return false;
+    triggerPing(PIN_TRIG_HEIGHT, sonarHeight);
+  }
+  return true;
+}
+
+// Sonar task, every SONAR_POLL_US. Fires whichever sensor is due and keeps the
+// newest accepted range of each until the control tick consumes it.
+void servicePings() {
+  EchoSample sample;
+
+  sonar.update(halMicros());
+  if (sonar.take(SONAR_RIGHT, sample)) {
+    rawRight = echoToDistance(sample);
+    rawRightAtUs = echoMidpointUs(sample);
+    keepRawEcho(sample, rawRightEchoUs, rawRightEchoAtUs);
+  }
+  if (sonar.take(SONAR_HEIGHT, sample)) {
+    rawHeight = echoToDistance(sample);
+    rawHeightAtUs = echoMidpointUs(sample);
+    keepRawEcho(sample, rawHeightEchoUs, rawHeightEchoAtUs);
+  }
+}
+
+// Both surfaces in one call; with the TCC backend they change in the same frame
+void writeServos(int rudderUs, int elevatorUs) {
+  StageScope<Profiler> scope(profiler, STAGE_WRITE);
+#if defined(ARDUINO_ARCH_SAMD)
+  if (SERVO_BACKEND == SERVO_BACKEND_TCC) {
+    servoOut.write(elevatorUs, rudderUs);
+    return;
+  }
+#endif
+  rudderServo.writeMicroseconds(rudderUs);
+  elevatorServo.writeMicroseconds(elevatorUs);
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+// TC3 in 16-bit match-frequency mode releases the control task every
+// LOOP_PERIOD_MS (37500 counts at 750kHz). TC4/TC5 stay free for Servo and
+// tone(). Priority sits below the echo pin interrupts so edge stamps win.
+void startControlTimer() {
+  static_assert(LOOP_PERIOD_MS * (CONTROL_TIMER_HZ / 1000) <= 65536, "LOOP_PERIOD_MS too long for TC3");
+
+  GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TCC2_TC3);
+  while (GCLK->STATUS.bit.SYNCBUSY);
+
+  TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+  while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+  TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV64;
+  while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+  TC3->COUNT16.CC[0].reg = LOOP_PERIOD_MS * (CONTROL_TIMER_HZ / 1000) - 1;
+  while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+
+  TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+  NVIC_SetPriority(TC3_IRQn, 2);
+  NVIC_EnableIRQ(TC3_IRQn);
+
+  TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+  while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+void TC3_Handler() {
+  TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  controlClock.release(halMicros());
+}
+#endif
+
+// Seconds from an axis' last accepted sample to this one; advances the stamp
+real_t sampleInterval(unsigned long sampleAtUs, unsigned long &lastSampleAtUs) {
+  unsigned long elapsedUs = sampleAtUs - lastSampleAtUs;
+  lastSampleAtUs = sampleAtUs;
+  return microsToSeconds<real_t>(elapsedUs);
+}
+
+// Spike stage on its own: the cleaned range, or NO_READING_VAL if the ping
+// timed out or the jump check threw the sample away
+real_t rejectSpikes(real_t raw, real_t reference, HampelFilter<real_t, HAMPEL_WINDOW> &spikes) {
   // Timeout check
-  if (raw == NO_READING_VAL) return prevSmoothed;
-  
-  // Spike rejection
-  if (abs(raw - prevSmoothed) > MAX_DIST_JUMP_CM) return prevSmoothed;
+  if (raw == NO_READING_VAL) return NO_READING_VAL;
+
+  if (SPIKE_FILTER_MODE == SPIKE_FILTER_JUMP) {
+    return absValue(raw - reference) > MAX_DIST_JUMP_CM ? NO_READING_VAL : raw;
+  }
+
+  // Spike rejection on the last HAMPEL_WINDOW samples
+  if (SPIKE_FILTER_MODE == SPIKE_FILTER_MEDIAN) return spikes.push(raw);
+  return spikes.filter(raw);
+}
+
+// Hold on a missing or rejected sample, else low pass filter (see SignalPath.h)
+real_t getFilteredDistance(real_t clean, real_t prevSmoothed) {
+  if (clean == NO_READING_VAL) return prevSmoothed;
 
   // Low pass filter
-  return (DIST_FILTER_ALPHA * raw) + ((1.0 - DIST_FILTER_ALPHA) * prevSmoothed);
+  return lowPass(clean, prevSmoothed, DIST_FILTER_ALPHA);
 }
 
 void logTelemetry(float timeVal, float distR, float distH, float rateR, float rateH, int rudPWM, int elePWM) {
   // Simple direct printing for debugging
-  Serial.print("T:");
-  Serial.print(timeVal, 2);
-  Serial.print(" | DistR:");
-  Serial.print(distR, 1);
-  Serial.print(" | DistH:");
-  Serial.print(distH, 1);
-  Serial.print(" | RateR:");
-  Serial.print(rateR, 1);
-  Serial.print(" | RateH:");
-  Serial.print(rateH, 1);
-  Serial.print(" | Rud:");
-  Serial.print(rudPWM);
-  Serial.print(" | Ele:");
-  Serial.println(elePWM);
+  halLog.print("T:");
+  halLog.print(timeVal, 2);
+  halLog.print(" | DistR:");
+  halLog.print(distR, 1);
+  halLog.print(" | DistH:");
+  halLog.print(distH, 1);
+  halLog.print(" | RateR:");
+  halLog.print(rateR, 1);
+  halLog.print(" | RateH:");
+  halLog.print(rateH, 1);
+  halLog.print(" | Rud:");
+  halLog.print(rudPWM);
+  halLog.print(" | Ele:");
+  halLog.println(elePWM);
+}
+
+void logSonarStats() {
+  unsigned long now = halMicros();
+  for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+    const SonarStats &st = sonar.channelStats(ch);
+    halLog.print(ch == SONAR_RIGHT ? "Sonar Right" : "Sonar Height");
+    halLog.print(" | Hz:");
+    halLog.print(sonar.effectiveHz(ch, now), 1);
+    halLog.print(" | Pings:");
+    halLog.print(st.pings);
+    halLog.print(" | Valid:");
+    halLog.print(st.valid);
+    halLog.print(" | Timeouts:");
+    halLog.print(st.timeouts);
+    halLog.print(" | Crosstalk:");
+    halLog.print(st.crosstalkDrops);
+    halLog.print(" | Busy:");
+    halLog.print(st.busySkips);
+    halLog.print(" | Window(us):");
+    halLog.println(sonar.listenWindow(ch));
+  }
+
+  // Listening time saved against the fixed SONAR_TIMEOUT_US, for one ping
+  // per sensor as the old blocking loop did
+  halLog.print("Range gate saved (us/loop): ");
+  halLog.println(gateRight.meanSavedUs() + gateHeight.meanSavedUs());
+}
+
+void logControlTiming() {
+  const ControlStats &st = controlClock.timingStats();
+  halLog.print("Control | Cycles:");
+  halLog.print(st.cycles);
+  halLog.print(" | Overruns:");
+  halLog.print(st.overruns);
+  halLog.print(" | Jitter(us) min:");
+  halLog.print(st.minJitterUs);
+  halLog.print(" mean:");
+  halLog.print(controlClock.meanJitterUs(), 1);
+  halLog.print(" max:");
+  halLog.print(st.maxJitterUs);
+  halLog.print(" | Latency(us) mean:");
+  halLog.print(controlClock.meanLatencyUs(), 1);
+  halLog.print(" max:");
+  halLog.print(st.maxLatencyUs);
+  halLog.print(" | Busy(us) max:");
+  halLog.println(st.maxBusyUs);
+}
+
+void logTaskStats() {
+  for (int i = 0; i < tasks.size(); i++) {
+    const TaskStats &st = tasks.taskStats(i);
+    halLog.print("Task ");
+    halLog.print(tasks.task(i).name);
+    halLog.print(" | Runs:");
+    halLog.print(st.runs);
+    halLog.print(" | Skipped:");
+    halLog.print(st.skipped);
+    halLog.print(" | DeadlineMiss:");
+    halLog.print(st.deadlineMisses);
+    halLog.print(" | Latency(us) max:");
+    halLog.print(st.maxLatencyUs);
+    halLog.print(" | Run(us) max:");
+    halLog.print(st.maxRunUs);
+    halLog.print(" mean:");
+    halLog.println(st.runs ? (float)st.totalRunUs / st.runs : 0.0, 1);
+  }
+  halLog.print("Telemetry | Frames:");
+  halLog.print(telemetry.framesPushed());
+  halLog.print(" | Dropped:");
+  halLog.print(telemetry.framesDropped());
+  halLog.print(" | Queued(bytes):");
+  halLog.println(telemetry.bytesQueued());
+}
+
+// Per-flight servo activity (reset at launch)
+void logServoBudget() {
+  for (int i = 0; i < 2; i++) {
+    const ServoBudget &b = i == 0 ? rudderBudget : elevatorBudget;
+    const ServoBudgetStats &st = b.budgetStats();
+    halLog.print(i == 0 ? "Rudder" : "Elevator");
+    halLog.print(" | Writes:");
+    halLog.print(st.writes);
+    halLog.print(" | Held:");
+    halLog.print(st.suppressed);
+    halLog.print(" | Moved(us):");
+    halLog.print(st.movedUs);
+    halLog.print(" | Deflected(s):");
+    halLog.print(st.deflectedTicks * LOOP_PERIOD_MS / 1000.0, 2);
+    halLog.print(" | Deflection(us*s):");
+    halLog.print(st.deflectionUsTicks * (LOOP_PERIOD_MS / 1000.0), 0);
+    halLog.print(" | Heat(%) now:");
+    halLog.print(b.heatPermille() / 10.0, 1);
+    halLog.print(" peak:");
+    halLog.print(st.peakHeatUs * 100.0 / SERVO_BUDGET_US, 1);
+    halLog.print(" | Step(us) now:");
+    halLog.print(b.stepUs());
+    halLog.print(" max:");
+    halLog.println(st.peakStepUs);
+  }
+}
+
+// Stored flights, oldest first, as CSV
+void dumpFlights() {
+#if defined(ARDUINO_ARCH_SAMD)
+  if (recorder.status() != Recorder::IDLE) {
+    halLog.println("Recorder busy (recording or writing flash)");
+    return;
+  }
+  int first = recorder.newest() + 1;
+  for (int i = 0; i < recorder.slotCount(); i++) {
+    int slot = (first + i) % recorder.slotCount();
+    RecorderHeader h;
+    if (!recorder.readHeader(slot, h)) continue;
+    halLog.print("# Flight ");
+    halLog.print(h.flight);
+    halLog.print(" | Records:");
+    halLog.print(h.records);
+    halLog.print(" | Truncated:");
+    halLog.print(h.truncated);
+    halLog.print(" | Checksum:");
+    halLog.println(recorder.verify(slot) ? "OK" : "BAD");
+    halLog.println("time_s,right_cm,height_cm,rate_right_cm_s,rate_height_cm_s,rudder_us,elevator_us,"
+                   "right_echo_us,right_echo_at_us,height_echo_us,height_echo_at_us,flags");
+    for (int k = 0; k < h.records; k++) {
+      TelemetrySample s;
+      recorder.readRecord(slot, k, s);
+      halLog.print(s.timeMs / 1000.0, 3);
+      halLog.print(",");
+      halLog.print(s.rightMm / 10.0, 1);
+      halLog.print(",");
+      halLog.print(s.heightMm / 10.0, 1);
+      halLog.print(",");
+      halLog.print(s.rateRightMmS / 10.0, 1);
+      halLog.print(",");
+      halLog.print(s.rateHeightMmS / 10.0, 1);
+      halLog.print(",");
+      halLog.print(s.rudderUs);
+      halLog.print(",");
+      halLog.print(s.elevatorUs);
+      halLog.print(",");
+      halLog.print(s.rightEchoUs);
+      halLog.print(",");
+      halLog.print(s.rightEchoAtUs);
+      halLog.print(",");
+      halLog.print(s.heightEchoUs);
+      halLog.print(",");
+      halLog.print(s.heightEchoAtUs);
+      halLog.print(",");
+      halLog.println(s.flags);
+    }
+  }
+  halLog.println("# End");
+#else
+  halLog.println("No flight recorder on this board");
+#endif
+}
+
+// Per-stage latency histograms as CSV: counts per µs bucket
+void logStageProfile() {
+  if (!Profiler::ENABLED) {
+    halLog.println("Stage profiler off (PROFILE_STAGES)");
+    return;
+  }
+  halLog.print("# Stage latency (us), clock overhead ");
+  halLog.print(profiler.overheadTicks());
+  halLog.println(" ticks removed");
+  halLog.print("stage,n,min,mean,max");
+  for (int b = 0; b < PROFILE_BUCKETS - 1; b++) {
+    halLog.print(",<");
+    halLog.print(PROFILE_BUCKET_US[b]);
+  }
+  halLog.print(",>=");
+  halLog.println(PROFILE_BUCKET_US[PROFILE_BUCKETS - 2]);
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    const StageHistogram &h = profiler.stageStats(i);
+    halLog.print(STAGE_NAMES[i]);
+    halLog.print(",");
+    halLog.print(h.count);
+    halLog.print(",");
+    halLog.print(h.count ? Profiler::toUs(h.minTicks) : 0.0, 1);
+    halLog.print(",");
+    halLog.print(profiler.meanUs(i), 1);
+    halLog.print(",");
+    halLog.print(Profiler::toUs(h.maxTicks), 1);
+    for (int b = 0; b < PROFILE_BUCKETS; b++) {
+      halLog.print(",");
+      halLog.print(h.buckets[b]);
+    }
+    halLog.println();
+  }
+}
+
+// Single-character commands over USB serial
+//   s - sonar stats (per-sensor Hz, timeouts, crosstalk drops, busy skips, range gate)
+//   S - reset sonar stats
+//   t - control cycle timing (period jitter, latency, overruns)
+//   T - reset control cycle timing
+//   x - per-task executor stats (runs, skipped releases, deadline misses)
+//   X - reset executor stats
+//   b - servo budget (writes, travel, time at deflection, heat, granularity)
+//   B - reset servo budget counters
+//   p - per-stage latency histograms (CSV)
+//   P - reset stage histograms
+//   d - dump recorded flights (CSV)
+//   E - erase recorded flights (spread between control ticks)
+//   l - telemetry stream on/off
+void handleSerialCommand() {
+  if (!halLog.available()) return;
+
+  char cmd = halLog.read();
+  switch (cmd) {
+    case 's': logSonarStats(); break;
+    case 'S':
+      sonar.resetStats(halMicros());
+      gateRight.resetStats();
+      gateHeight.resetStats();
+      break;
+    case 't': logControlTiming(); break;
+    case 'T': controlClock.resetStats(); break;
+    case 'x': logTaskStats(); break;
+    case 'X': tasks.resetStats(); break;
+    case 'b': logServoBudget(); break;
+    case 'B':
+      rudderBudget.resetStats();
+      elevatorBudget.resetStats();
+      break;
+    case 'p': logStageProfile(); break;
+    case 'P': profiler.resetStats(); break;
+    case 'd': dumpFlights(); break;
+#if defined(ARDUINO_ARCH_SAMD)
+    case 'E': if (recorderOn) recorder.eraseAll(); break;
+#endif
+    case 'l': telemetryOn = !telemetryOn; break;
+    default: break;
+  }
 }
 
 // =========================================================
 // MAIN SETUP
 // =========================================================
 void setup() {
-  Serial.begin(115200);
+  halLog.begin(115200);
 
-  pinMode(PIN_TRIG_RIGHT, OUTPUT);
-  pinMode(PIN_ECHO_RIGHT, INPUT);
-  pinMode(PIN_TRIG_HEIGHT, OUTPUT);
-  pinMode(PIN_ECHO_HEIGHT, INPUT);
+  halSonarPins(PIN_TRIG_RIGHT, PIN_ECHO_RIGHT);
+  halSonarPins(PIN_TRIG_HEIGHT, PIN_ECHO_HEIGHT);
 
-  rudderServo.attach(PIN_SERVO_RUDDER);
-  elevatorServo.attach(PIN_SERVO_ELEVATOR);
-  
-  rudderServo.writeMicroseconds(SERVO_RUDDER_NEUTRAL);
-  elevatorServo.writeMicroseconds(SERVO_ELEVATOR_NEUTRAL);
+  halEchoInterrupt(PIN_ECHO_RIGHT, onEchoRight);
+  halEchoInterrupt(PIN_ECHO_HEIGHT, onEchoHeight);
+
+#if defined(ARDUINO_ARCH_SAMD)
+  if (SERVO_BACKEND == SERVO_BACKEND_TCC) {
+    servoOut.begin(SERVO_FRAME_US, SERVO_ELEVATOR_NEUTRAL, SERVO_RUDDER_NEUTRAL);
+  }
+#endif
+  if (SERVO_BACKEND == SERVO_BACKEND_LIBRARY) {
+    rudderServo.attach(PIN_SERVO_RUDDER);
+    elevatorServo.attach(PIN_SERVO_ELEVATOR);
+
+    rudderServo.writeMicroseconds(SERVO_RUDDER_NEUTRAL);
+    elevatorServo.writeMicroseconds(SERVO_ELEVATOR_NEUTRAL);
+  }
 
   // Initialize sensors with stable data
-  Serial.println("Testing sensors...");
+  halLog.println("Testing sensors...");
   float sumR = 0, sumH = 0;
   int validCount = 0;
   
   for(int i=0; i<5; i++) {
-    float r = readUltrasonic(PIN_TRIG_RIGHT, PIN_ECHO_RIGHT);
-    float h = readUltrasonic(PIN_TRIG_HEIGHT, PIN_ECHO_HEIGHT);
-    Serial.print("Test ");
-    Serial.print(i+1);
-    Serial.print(" - Right: ");
-    Serial.print(r);
-    Serial.print(" cm, Height: ");
-    Serial.print(h);
-    Serial.println(" cm");
+    float r = readUltrasonic(PIN_TRIG_RIGHT, sonarRight);
+    float h = readUltrasonic(PIN_TRIG_HEIGHT, sonarHeight);
+    halLog.print("Test ");
+    halLog.print(i+1);
+    halLog.print(" - Right: ");
+    halLog.print(r);
+    halLog.print(" cm, Height: ");
+    halLog.print(h);
+    halLog.println(" cm");
+    logSensorTest(r, h);
     if (r > 0 && h > 0) {
       sumR += r; sumH += h; validCount++;
     }
-    delay(DELAY_SENSOR_STABLE_MS);
+    halDelayMs(DELAY_SENSOR_STABLE_MS);
   }
 
   if (validCount > 0) {
     currentRight = sumR / validCount;
     currentHeight = sumH / validCount;
-    Serial.print("Sensor Init OK - Right: ");
-    Serial.print(currentRight);
-    Serial.print(" cm, Height: ");
-    Serial.print(currentHeight);
-    Serial.println(" cm");
+    halLog.print("Sensor Init OK - Right: ");
+    halLog.print(toFloat(currentRight));
+    halLog.print(" cm, Height: ");
+    halLog.print(toFloat(currentHeight));
+    halLog.println(" cm");
   } else {
     currentRight = FAILSAFE_DIST_CM;
     currentHeight = FAILSAFE_DIST_CM;
-    Serial.println("WARNING: Sensor init failed! Using failsafe values.");
+    halLog.println("WARNING: Sensor init failed! Using failsafe values.");
   }
 
   prevRight = currentRight;
   prevHeight = currentHeight;
+  trackRight.reset(currentRight);
+  trackHeight.reset(currentHeight);
 
-  delay(DELAY_STARTUP_MS);
-  Serial.println("System Ready. Waiting for launch...");
+  halDelayMs(DELAY_STARTUP_MS);
+  lastRightAtUs = halMicros();
+  lastHeightAtUs = lastRightAtUs;
+  sonar.start(halMicros());
+  profiler.calibrate();
+  tasks.start(halMicros());
+#if defined(ARDUINO_ARCH_SAMD)
+  if (CONTROL_TIMER) startControlTimer();
+#endif
+#if defined(ARDUINO_ARCH_SAMD)
+  recorderOn = recorderClearOfImage();
+  if (recorderOn) {
+    nvm.begin();
+    recorder.begin();
+    if (recorder.newest() >= 0) halLog.println("Recorded flights stored: send 'd' to dump");
+  } else {
+    halLog.println("Firmware reaches RECORDER_BASE: flight recorder off");
+  }
+#endif
+  halLog.println("System Ready. Waiting for launch...");
 }
 
 // =========================================================
-// MAIN LOOP
+// CONTROL TASK
 // =========================================================
-void loop() {
-  unsigned long currentTime = millis();
+void controlTask(uint32_t taskUs) {
+  StageScope<Profiler> tick(profiler, STAGE_CONTROL);
+  StageLap<Profiler> stages(profiler);
+  unsigned long currentTime = halMillis();
 
-  // 1. Loop Frequency Control
-  if (currentTime - prevLoopTime < LOOP_PERIOD_MS) return;
-  float dt = (currentTime - prevLoopTime) / MS_TO_SEC;
+  // 1. Loop Frequency Control: released by TC3 (controlReleased) or by the
+  // executor's own LOOP_PERIOD_MS schedule
+  if (!CONTROL_TIMER) {
+    controlClock.release(taskUs);
+    controlClock.begin(taskUs);
+  }
+  real_t dt = real_t(currentTime - prevLoopTime) / MS_TO_SEC;
   prevLoopTime = currentTime;
 
-  // 2. Read Sensors
-  float rightDist = getFilteredDistance(PIN_TRIG_RIGHT, PIN_ECHO_RIGHT, currentRight);
-  float height = getFilteredDistance(PIN_TRIG_HEIGHT, PIN_ECHO_HEIGHT, currentHeight);
+  // 2. Read Sensors (ranges from the pings fired last tick)
+  unsigned long nowUs = halMicros();
+  real_t cleanRight = rejectSpikes(rawRight, currentRight, spikesRight);
+  real_t cleanHeight = rejectSpikes(rawHeight, currentHeight, spikesHeight);
+
+  // Per-axis sample intervals from the echo time stamps (loop dt if none)
+  real_t dtRight = dt;
+  real_t dtHeight = dt;
+  if (cleanRight != NO_READING_VAL) dtRight = sampleInterval(rawRightAtUs, lastRightAtUs);
+  if (cleanHeight != NO_READING_VAL) dtHeight = sampleInterval(rawHeightAtUs, lastHeightAtUs);
+
+  real_t rightDist, height;
+  if (RATE_ESTIMATOR == RATE_ESTIMATOR_TRACKER) {
+    // Missed or rejected pings are predicted through, not held
+    if (cleanRight != NO_READING_VAL) trackRight.correct(cleanRight, dtRight);
+    else                              trackRight.miss();
+    if (cleanHeight != NO_READING_VAL) trackHeight.correct(cleanHeight, dtHeight);
+    else                               trackHeight.miss();
+    rightDist = trackRight.predict(microsToSeconds<real_t>(nowUs - lastRightAtUs));
+    height = trackHeight.predict(microsToSeconds<real_t>(nowUs - lastHeightAtUs));
+  } else {
+    rightDist = getFilteredDistance(cleanRight, currentRight);
+    height = getFilteredDistance(cleanHeight, currentHeight);
+  }
+  gateRight.record(rawRight != NO_READING_VAL);
+  gateHeight.record(rawHeight != NO_READING_VAL);
+  rawRight = NO_READING_VAL;
+  rawHeight = NO_READING_VAL;
   
   // Update current values
   currentRight = rightDist;
   currentHeight = height;
+  stages.lap(STAGE_FILTER);
 
   // 3. Launch Detect
   if (!flightStarted && height > LAUNCH_HEIGHT_CM) {
     flightStarted = true;
     flightStartTime = currentTime;
+    rudderBudget.resetStats();
+    elevatorBudget.resetStats();
+#if defined(ARDUINO_ARCH_SAMD)
+    if (recorderOn) recorder.start();
+#endif
     prevRight = rightDist; 
     prevHeight = height;
   }
 
   int targetRudder = SERVO_RUDDER_NEUTRAL;
   int targetElevator = SERVO_ELEVATOR_NEUTRAL;
-  float avgRateRight = 0.0;
-  float avgRateHeight = 0.0;
+  avgRateRight = 0.0;
+  avgRateHeight = 0.0;
 
   if (flightStarted) {
-    // 4. Calculate Raw Rate
-    float rawRateRight = - (rightDist - prevRight) / dt;
-    float rawRateHeight = - (height - prevHeight) / dt;
-
-    // // 5. Clamp Noise (Hard Limit)
-    // if (abs(rawRateRight) > MAX_PHYSICAL_RATE_CM_S) rawRateRight = 0.0;
-    // if (abs(rawRateHeight) > MAX_PHYSICAL_RATE_CM_S) rawRateHeight = 0.0;
-
-    // 6. Smooth Rate (Rolling Average)
-    avgRateRight = rateSmootherRight.add(rawRateRight);
-    avgRateHeight = rateSmootherHeight.add(rawRateHeight);
-
-    // 7. Simple Control Logic: If rate exceeds threshold -> Apply correction, else stay neutral
-    
-    // Rudder Control with Hold Timer
-    if (avgRateRight > PARAM_RATE_RIGHT_THRESHOLD) {
-      // Rate exceeded threshold - activate rudder
-      targetRudder = SERVO_RUDDER_LEFT;
-      rudderActivatedTime = currentTime;
-      rudderActive = true;
-    } else if (rudderActive && (currentTime - rudderActivatedTime < SERVO_HOLD_TIME_MS)) {
-      // Hold rudder position for SERVO_HOLD_TIME_MS
-      targetRudder = SERVO_RUDDER_LEFT;
+    if (RATE_ESTIMATOR == RATE_ESTIMATOR_TRACKER) {
+      // 4-6. Rate comes straight out of the tracker
+      avgRateRight = trackRight.closureRate();
+      avgRateHeight = trackHeight.closureRate();
     } else {
-      // Return to neutral
-      targetRudder = SERVO_RUDDER_NEUTRAL;
-      rudderActive = false;
+      // 4. Calculate Raw Rate
+      real_t rawRateRight = closureRate(rightDist, prevRight, dtRight);
+      real_t rawRateHeight = closureRate(height, prevHeight, dtHeight);
+
+      // // 5. Clamp Noise (Hard Limit)
+      // if (abs(rawRateRight) > MAX_PHYSICAL_RATE_CM_S) rawRateRight = 0.0;
+      // if (abs(rawRateHeight) > MAX_PHYSICAL_RATE_CM_S) rawRateHeight = 0.0;
+
+      // 6. Smooth Rate (Rolling Average)
+      avgRateRight = rateSmootherRight.add(rawRateRight);
+      avgRateHeight = rateSmootherHeight.add(rawRateHeight);
     }
+    stages.lap(STAGE_RATE);
 
-    // Elevator Control with Hold Timer
-    if (avgRateHeight > PARAM_RATE_HEIGHT_THRESHOLD) {
-      // Rate exceeded threshold - activate elevator
-      targetElevator = SERVO_ELEVATOR_UP;
-      elevatorActivatedTime = currentTime;
-      elevatorActive = true;
-    } else if (elevatorActive && (currentTime - elevatorActivatedTime < SERVO_HOLD_TIME_MS)) {
-      // Hold elevator position for SERVO_HOLD_TIME_MS
-      targetElevator = SERVO_ELEVATOR_UP;
+    // 7. Control Law (default: full correction while the rate exceeds the
+    // threshold, held for SERVO_HOLD_TIME_MS, else neutral)
+    if (SERVO_LUT) {
+      targetRudder = RudderMap::command(rudderLaw.offset(rightDist, avgRateRight, currentTime));
+      targetElevator = ElevatorMap::command(elevatorLaw.offset(height, avgRateHeight, currentTime));
     } else {
-      // Return to neutral
-      targetElevator = SERVO_ELEVATOR_NEUTRAL;
-      elevatorActive = false;
+      targetRudder = rudderLaw.update(rightDist, avgRateRight, currentTime);
+      targetElevator = elevatorLaw.update(height, avgRateHeight, currentTime);
     }
 
     prevRight = rightDist;
     prevHeight = height;
   }
 
-  // 9. Output Smoothing & Constraint
-  targetRudder = constrain(targetRudder, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX);
-  targetElevator = constrain(targetElevator, SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX);
+  // 8. Range Gate: size the next pings' listen windows around the prediction
+  if (SONAR_RANGE_GATE) {
+    sonar.setListenWindow(SONAR_RIGHT, gateRight.windowUs(toFloat(rightDist), toFloat(avgRateRight)));
+    sonar.setListenWindow(SONAR_HEIGHT, gateHeight.windowUs(toFloat(height), toFloat(avgRateHeight)));
+  }
+  stages.lap(STAGE_LAW);
 
-  prevRudderPWM = (SERVO_SMOOTHING_ALPHA * targetRudder) + ((1.0 - SERVO_SMOOTHING_ALPHA) * prevRudderPWM);
-  prevElevatorPWM = (SERVO_SMOOTHING_ALPHA * targetElevator) + ((1.0 - SERVO_SMOOTHING_ALPHA) * prevElevatorPWM);
+  // 9. Output Smoothing & Constraint (the tables are already clamped)
+  if (SERVO_LUT) {
+    prevRudderPWM = ServoSmoother::apply(targetRudder, prevRudderPWM);
+    prevElevatorPWM = ServoSmoother::apply(targetElevator, prevElevatorPWM);
+  } else {
+    targetRudder = constrain(targetRudder, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX);
+    targetElevator = constrain(targetElevator, SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX);
 
-  // 10. Write to Servos (Deadband check)
-  // We use static variables to track what we ACTUALLY wrote last time to hardware
-  static int lastWrittenRudder = -1;
-  static int lastWrittenElevator = -1;
+    prevRudderPWM = smoothServo(targetRudder, prevRudderPWM, SERVO_SMOOTHING_ALPHA);
+    prevElevatorPWM = smoothServo(targetElevator, prevElevatorPWM, SERVO_SMOOTHING_ALPHA);
+  }
 
-  if (abs(prevRudderPWM - lastWrittenRudder) > SERVO_DEADBAND_US) {
-    rudderServo.writeMicroseconds(prevRudderPWM);
-    lastWrittenRudder = prevRudderPWM;
+  // 10. Write to Servos (granularity from each servo's budget)
+  // Lead: command where the horn should be heading, not the smoothed pulse
+  int rudderCmd = prevRudderPWM;
+  int elevatorCmd = prevElevatorPWM;
+  if (SERVO_LEAD) {
+    rudderCmd = rudderLead.command(prevRudderPWM, targetRudder);
+    elevatorCmd = elevatorLead.command(prevElevatorPWM, targetElevator);
   }
-  
-  if (abs(prevElevatorPWM - lastWrittenElevator) > SERVO_DEADBAND_US) {
-    elevatorServo.writeMicroseconds(prevElevatorPWM);
-    lastWrittenElevator = prevElevatorPWM;
-  }
-
-  // // 11. Logging
-  // if (currentTime - lastLogTime >= LOG_INTERVAL_MS) {
-  //   // Convert millis to seconds for easier reading
-  //   float timeSec = flightStarted ? (currentTime - flightStartTime) / 1000.0 : 0.0;
-    
-  //   logTelemetry(
-  //     timeSec, 
-  //     rightDist,       // Passed from your sensor read
-  //     height,          // Passed from your sensor read
-  //     avgRateRight,    // The AVERAGED rate
-  //     avgRateHeight,   // The AVERAGED rate
-  //     prevRudderPWM,   // The actual command sent
-  //     prevElevatorPWM  // The actual command sent
-  //   );
-    
-  //   lastLogTime = currentTime;
-  // }
-}
\ No newline at end of file
+
+  int rudderOut = rudderBudget.update(rudderCmd);
+  int elevatorOut = elevatorBudget.update(elevatorCmd);
+
+  // One write for both, so neither surface lags the other by a frame
+  if (rudderBudget.moved() || elevatorBudget.moved()) writeServos(rudderOut, elevatorOut);
+
+  // The models follow what the servos were actually sent
+  if (SERVO_LEAD) {
+    rudderLead.advance(rudderOut);
+    elevatorLead.advance(elevatorOut);
+  }
+  stages.lap(STAGE_SERVO);
+
+  // 11. Telemetry frame into the ring (the telemetry task drains it) and
+  // into the flight recorder's RAM image
+  {
+    TelemetrySample rec;
+    rec.timeMs = flightStarted ? currentTime - flightStartTime : 0;
+    rec.rightMm = toTelemetryMm(rightDist);
+    rec.heightMm = toTelemetryMm(height);
+    rec.rateRightMmS = toTelemetryMm(avgRateRight);
+    rec.rateHeightMmS = toTelemetryMm(avgRateHeight);
+    rec.rudderUs = rudderOut;
+    rec.elevatorUs = elevatorOut;
+    rec.rightEchoUs = rawRightEchoUs;
+    rec.rightEchoAtUs = rawRightEchoAtUs;
+    rec.heightEchoUs = rawHeightEchoUs;
+    rec.heightEchoAtUs = rawHeightEchoAtUs;
+    rec.flags = (flightStarted ? TELEM_FLIGHT : 0)
+              | (cleanRight != NO_READING_VAL ? TELEM_RIGHT_VALID : 0)
+              | (cleanHeight != NO_READING_VAL ? TELEM_HEIGHT_VALID : 0)
+              | (rudderBudget.moved() ? TELEM_RUDDER_WRITE : 0)
+              | (elevatorBudget.moved() ? TELEM_ELEVATOR_WRITE : 0);
+    if (TELEMETRY_FORMAT != TELEMETRY_TEXT && telemetryOn) telemetry.push(rec);
+#if defined(ARDUINO_ARCH_SAMD)
+    recorder.record(rec);
+#endif
+    rawRightEchoUs = rawRightEchoAtUs = 0;
+    rawHeightEchoUs = rawHeightEchoAtUs = 0;
+  }
+
+  // 12. Landing: on the ground for RECORDER_LANDED_MS ends the recording
+  if (flightStarted && height < RECORDER_LANDED_CM) {
+    if (landedSinceMs == 0) landedSinceMs = currentTime;
+#if defined(ARDUINO_ARCH_SAMD)
+    if (currentTime - landedSinceMs >= RECORDER_LANDED_MS) recorder.finish();
+#endif
+  } else {
+    landedSinceMs = 0;
+  }
+  stages.lap(STAGE_LOG);
+
+  controlClock.end(halMicros());
+}
+
+// =========================================================
+// TASKS
+// =========================================================
+void sonarTask(uint32_t) {
+  StageScope<Profiler> scope(profiler, STAGE_SONAR);
+  servicePings();
+}
+
+void serialTask(uint32_t) {
+  handleSerialCommand();
+}
+
+// Lowest priority: one flash operation of a pending commit or erase, and
+// only if it finishes before the next control release. The stall holds off
+// the echo interrupts too, so nothing runs while a sonar is listening, and
+// the operation ends before the next ping.
+void recorderTask(uint32_t nowUs) {
+#if defined(ARDUINO_ARCH_SAMD)
+  uint32_t left = controlClock.usUntilNext(nowUs);
+  uint32_t quiet = sonar.quietUs(nowUs);
+  if (quiet < left) left = quiet;
+  recorder.step(left > RECORDER_MARGIN_US ? left - RECORDER_MARGIN_US : 0);
+#else
+  (void)nowUs;
+#endif
+}
+
+// USB CDC sink for the telemetry ring
+struct SerialSink {
+  uint32_t write(const uint8_t *data, uint32_t len) {
+    return halLog.write(data, len);
+  }
+};
+SerialSink serialSink;
+
+// Lowest priority: only prints in slack left by the tasks above, and only
+// with a serial monitor attached
+void telemetryTask(uint32_t) {
+  if (!telemetryOn || !halLog) return;
+
+  // Binary: hand the port what it can take without blocking; the rest
+  // waits in the ring for the next pass
+  if (TELEMETRY_FORMAT != TELEMETRY_TEXT) {
+    int room = halLog.availableForWrite();
+    if (room > 0) {
+      StageScope<Profiler> scope(profiler, STAGE_DRAIN);
+      telemetry.drain(serialSink, room);
+    }
+    return;
+  }
+
+  // Convert millis to seconds for easier reading
+  float timeSec = flightStarted ? (halMillis() - flightStartTime) / 1000.0 : 0.0;
+
+  logTelemetry(
+    timeSec,
+    toFloat(currentRight),    // Filtered distances
+    toFloat(currentHeight),
+    toFloat(avgRateRight),    // The smoothed rates
+    toFloat(avgRateHeight),
+    prevRudderPWM,            // The actual command sent
+    prevElevatorPWM
+  );
+}
+
+// =========================================================
+// MAIN LOOP
+// =========================================================
+void loop() {
+  tasks.poll();
+}
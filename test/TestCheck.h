@@ -0,0 +1,19 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+// =========================================================
+// CHECK() for the host tests (test/test_*_host.cpp)
+// =========================================================
+// Prints the failing line and condition and counts it; main() ends with
+//   return failures == 0 ? 0 : 1;
+// Included once per test program, after everything the test builds on.
+
+#include <stdio.h>
+
+int failures = 0;
+
+#define CHECK(cond) do { \
+  if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; } \
+} while (0)
+
+#endif
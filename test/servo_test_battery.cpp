@@ -1,9 +1,19 @@
 #include <Arduino.h>
 #include <Servo.h>
+#include "ServoModel.h"
 
 const int SERVO_RUDDER_PIN = 2;
 const int SERVO_ELEVATOR_PIN = 1;
 
+// Optional: the servos' feedback pot wipers (soldered out of each case) on
+// spare analog pins. With them connected, every step of the sweep is
+// sampled at 1kHz and fitted for the SERVO_DEAD_SEC / SERVO_SLEW_US_S /
+// SERVO_TAU_SEC constants in main.cpp. Off by default: with nothing on
+// the pins, the fits are of noise.
+const bool IDENTIFY = false;
+const int PIN_FEEDBACK_RUDDER = A7;
+const int PIN_FEEDBACK_ELEVATOR = A0;
+
 Servo rudderServo;
 Servo elevatorServo;
 
@@ -17,6 +27,65 @@ const int SERVO_ELEVATOR_MAX     = 2100;
 const unsigned long HOLD_TIME = 2000;  // Hold each position for 2 seconds
 const unsigned long DELAY_START = 3000; // Wait 3 seconds before starting
 
+const int STEP_SAMPLES = 400;          // 400ms of each step at 1kHz
+const float MIN_SWING_ADC = 20.0;      // Settled ends closer than this: no fit
+float rudderTrace[STEP_SAMPLES];
+float elevatorTrace[STEP_SAMPLES];
+
+float settledAdc(int pin) {
+  long sum = 0;
+  for (int i = 0; i < 32; i++) sum += analogRead(pin);
+  return sum / 32.0;
+}
+
+// Maps a trace of ADC counts to pulse width with the settled ends and fits
+// it. A wiper that barely moved (not connected, or the servo stalled) has
+// nothing to scale by.
+void fitStep(const char* name, float *trace, float adc0, float adc1, int fromUs, int toUs) {
+  ServoParams<float> fit = ServoParams<float>();
+  Serial.print(name);
+  if (fabs(adc1 - adc0) < MIN_SWING_ADC) {
+    Serial.println(": wiper did not move (check the feedback wiring)");
+    return;
+  }
+  for (int i = 0; i < STEP_SAMPLES; i++) {
+    trace[i] = fromUs + (trace[i] - adc0) * (toUs - fromUs) / (adc1 - adc0);
+  }
+  if (!fitServoStep(trace, STEP_SAMPLES, 0.001, fromUs, toUs, fit)) {
+    Serial.println(": no fit (check the feedback wiring)");
+    return;
+  }
+  Serial.print(": dead ");
+  Serial.print(fit.deadSec * 1000.0, 1);
+  Serial.print(" ms, slew ");
+  Serial.print(fit.slewUsPerSec, 0);
+  Serial.print(" us/s, tau ");
+  Serial.print(fit.tauSec * 1000.0, 1);
+  Serial.println(" ms");
+}
+
+// Writes the step, records both horns, then fits each against the settled
+// ends before and after
+void step(int rudderFrom, int rudderTo, int elevatorFrom, int elevatorTo) {
+  float rudderAdc0 = settledAdc(PIN_FEEDBACK_RUDDER);
+  float elevatorAdc0 = settledAdc(PIN_FEEDBACK_ELEVATOR);
+
+  rudderServo.writeMicroseconds(rudderTo);
+  elevatorServo.writeMicroseconds(elevatorTo);
+  unsigned long start = micros();
+  for (int i = 0; i < STEP_SAMPLES; i++) {
+    while (micros() - start < (unsigned long)i * 1000);
+    rudderTrace[i] = analogRead(PIN_FEEDBACK_RUDDER);
+    elevatorTrace[i] = analogRead(PIN_FEEDBACK_ELEVATOR);
+  }
+  delay(HOLD_TIME - STEP_SAMPLES);
+
+  float rudderAdc1 = settledAdc(PIN_FEEDBACK_RUDDER);
+  float elevatorAdc1 = settledAdc(PIN_FEEDBACK_ELEVATOR);
+  fitStep("  Rudder", rudderTrace, rudderAdc0, rudderAdc1, rudderFrom, rudderTo);
+  fitStep("  Elevator", elevatorTrace, elevatorAdc0, elevatorAdc1, elevatorFrom, elevatorTo);
+}
+
 void setup() {
   Serial.begin(115200);
   
@@ -38,13 +107,21 @@ void setup() {
 void loop() {
   // Move to MAX
   Serial.println("Position: MAX");
-  rudderServo.writeMicroseconds(SERVO_RUDDER_MAX);
-  elevatorServo.writeMicroseconds(SERVO_ELEVATOR_MAX);
-  delay(HOLD_TIME);
+  if (IDENTIFY) {
+    step(SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_MAX, SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_MAX);
+  } else {
+    rudderServo.writeMicroseconds(SERVO_RUDDER_MAX);
+    elevatorServo.writeMicroseconds(SERVO_ELEVATOR_MAX);
+    delay(HOLD_TIME);
+  }
   
   // Return to NEUTRAL
   Serial.println("Position: NEUTRAL");
-  rudderServo.writeMicroseconds(SERVO_RUDDER_NEUTRAL);
-  elevatorServo.writeMicroseconds(SERVO_ELEVATOR_NEUTRAL);
-  delay(HOLD_TIME);
+  if (IDENTIFY) {
+    step(SERVO_RUDDER_MAX, SERVO_RUDDER_NEUTRAL, SERVO_ELEVATOR_MAX, SERVO_ELEVATOR_NEUTRAL);
+  } else {
+    rudderServo.writeMicroseconds(SERVO_RUDDER_NEUTRAL);
+    elevatorServo.writeMicroseconds(SERVO_ELEVATOR_NEUTRAL);
+    delay(HOLD_TIME);
+  }
 }
\ No newline at end of file
@@ -0,0 +1,233 @@
+// Host-side tests for the batched simulator: the lane kernel against the
+// main.cpp stages it replaces, AVX2 against scalar bit for bit, the
+// polynomial trig, and the outcomes against CorridorSimEngine flying main.cpp
+//   g++ -std=c++11 -O2 -mavx2 -ffp-contract=off -pthread -Iinclude test/test_batch_sim_host.cpp -o batch_sim_test && ./batch_sim_test
+#define PROFILE_STAGES 0
+#include "../src/main.cpp"
+#include "../tools/sim/BatchSim.h"
+#include <chrono>
+#include <string.h>
+#include "TestCheck.h"
+
+// controlTask() for one axis, from the stages themselves
+struct RefAxis {
+  int axis;
+  HampelFilter<float, HAMPEL_WINDOW> spikes;
+  AlphaBetaTracker<float> track;
+  RangeGate gate;
+  AxisLaw law;
+  ServoLead<float> lead;
+  ServoBudget budget;
+  unsigned long lastAtUs;
+  float current;
+  int neutralUs;
+  int pwm;
+  uint32_t windowUs;
+
+  RefAxis(int a, const AxisConfig<float> &cfg, float startCm)
+    : axis(a), spikes(HAMPEL_K, HAMPEL_MIN_DEV_CM, MAX_DIST_JUMP_CM),
+      track(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST),
+      gate(GATE_MARGIN_CM, GATE_HORIZON_SEC, SONAR_BURST_US, GATE_MIN_US, SONAR_LISTEN_US, SONAR_TIMEOUT_US,
+           GATE_LOST_AFTER),
+      law(cfg), lead(SERVO_RESPONSE, float(LOOP_PERIOD_MS / 1000.0), cfg.neutralUs, cfg.minUs, cfg.maxUs,
+                     SERVO_LEAD_GAIN, SERVO_FF_GAIN),
+      budget(SERVO_BUDGET, cfg.neutralUs), lastAtUs(0), current(startCm), neutralUs(cfg.neutralUs), pwm(cfg.neutralUs),
+      windowUs(SONAR_LISTEN_US) {
+    track.reset(startCm);
+  }
+
+  void sense(float raw, unsigned long rawAtUs, unsigned long nowUs) {
+    float clean = raw == NO_READING_VAL ? NO_READING_VAL : spikes.filter(raw);
+    if (clean != NO_READING_VAL) track.correct(clean, sampleInterval(rawAtUs, lastAtUs));
+    else                         track.miss();
+    current = track.predict(microsToSeconds<float>(nowUs - lastAtUs));
+    gate.record(raw != NO_READING_VAL);
+  }
+
+  // Returns whether the budget let the command through
+  bool control(bool started, uint32_t nowMs) {
+    int target = neutralUs;
+    float rate = 0;
+    if (started) {
+      rate = track.closureRate();
+      int offset = law.offset(current, rate, nowMs);
+      target = axis == 0 ? RudderMap::command(offset) : ElevatorMap::command(offset);
+    }
+    windowUs = gate.windowUs(current, rate);
+    pwm = ServoSmoother::apply(target, pwm);
+    int out = budget.update(lead.command(pwm, target));
+    lead.advance(out);
+    return budget.moved();
+  }
+};
+
+// Wall ranges closing and opening at random rates, with dropouts and jumps
+float rangeSequence(SimRng &rng, float &cm) {
+  cm += rng.uniform(-12.0f, 10.0f);
+  if (cm < 5.0f) cm = 5.0f;
+  if (cm > 300.0f) cm = 300.0f;
+  if (rng.chance(0.08f)) return (float)NO_READING_VAL;
+  if (rng.chance(0.05f)) return cm + rng.uniform(-100.0f, 100.0f);
+  return cm;
+}
+
+// Ticks both axes through L's kernel and one RefAxis per lane; returns the
+// number of values that differ in any bit
+template <class L>
+int kernelMismatches(uint32_t seed, int ticks) {
+  typedef typename L::F F;
+  typedef typename L::I I;
+  const int W = L::WIDTH;
+  const BatchControl c = defaultBatchControl();
+  const AxisConfig<float> *axes[2] = { &RUDDER_AXIS, &ELEVATOR_AXIS };
+  int bad = 0;
+  for (int a = 0; a < 2; a++) {
+    SimRng rng(seed + a);
+    float start[BATCH_MAX_WIDTH], cm[BATCH_MAX_WIDTH], launchAt[BATCH_MAX_WIDTH];
+    std::vector<RefAxis> ref;
+    for (int k = 0; k < W; k++) {
+      start[k] = cm[k] = rng.uniform(30.0f, 200.0f);
+      launchAt[k] = (float)(int)rng.uniform(0.0f, 10.0f);
+      ref.push_back(RefAxis(a, *axes[a], start[k]));
+    }
+    BatchAxis<L> axis;
+    axis.reset(c, a, L::load(start));
+    for (int t = 0; t < ticks; t++) {
+      float raw[BATCH_MAX_WIDTH], on[BATCH_MAX_WIDTH];
+      int32_t rawAt[BATCH_MAX_WIDTH];
+      uint32_t nowUs = t * c.periodUs + c.trigUs;
+      for (int k = 0; k < W; k++) {
+        raw[k] = rangeSequence(rng, cm[k]);
+        rawAt[k] = t == 0 ? 0 : (t - 1) * c.periodUs + (int32_t)rng.uniform(600.0f, 40000.0f);
+        on[k] = t >= launchAt[k] ? 1.0f : 0.0f;
+      }
+      uint32_t nowMs = t * c.periodMs;
+      typename L::M started = L::load(on) > F(0.5f);
+      axis.sense(c, L::load(raw), L::loadI(rawAt), I((int32_t)nowUs));
+      typename L::M move = axis.control(c, a, started, nowMs);
+
+      float current[BATCH_MAX_WIDTH];
+      int32_t pwm[BATCH_MAX_WIDTH], pulse[BATCH_MAX_WIDTH], window[BATCH_MAX_WIDTH], moved[BATCH_MAX_WIDTH];
+      L::store(current, axis.current);
+      L::storeI(pwm, axis.pwm);
+      L::storeI(pulse, axis.pulse);
+      L::storeI(window, axis.listenUs);
+      L::storeI(moved, L::selectI(move, I(1), I(0)));
+      for (int k = 0; k < W; k++) {
+        ref[k].sense(raw[k], (uint32_t)rawAt[k], nowUs);
+        bool refMoved = ref[k].control(on[k] > 0.5f, nowMs);
+        bad += memcmp(&current[k], &ref[k].current, sizeof(float)) != 0;
+        bad += pwm[k] != ref[k].pwm;
+        bad += pulse[k] != ref[k].budget.pulseUs();
+        bad += window[k] != (int32_t)ref[k].windowUs;
+        bad += moved[k] != (int)refMoved;
+      }
+    }
+  }
+  return bad;
+}
+
+bool sameResult(const SimResult &a, const SimResult &b) {
+  return a.outcome == b.outcome && a.launched == b.launched && a.servoWrites == b.servoWrites &&
+         !memcmp(&a.timeSec, &b.timeSec, sizeof(float)) && !memcmp(&a.distanceM, &b.distanceM, sizeof(float)) &&
+         !memcmp(&a.minRightM, &b.minRightM, sizeof(float)) && !memcmp(&a.minLeftM, &b.minLeftM, sizeof(float)) &&
+         !memcmp(&a.minGroundM, &b.minGroundM, sizeof(float));
+}
+
+template <class L>
+double flightsPerSec(const BatchSim &sim, int n, std::vector<SimResult> &out) {
+  out.resize(n);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  sim.fly<L>(1, n, &out[0]);
+  return n / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+  // ---------------------------------------------------------
+  // 1. Trig: polynomial sin/cos over a few turns
+  // ---------------------------------------------------------
+  {
+    float worst = 0;
+    for (int i = -4000; i <= 4000; i++) {
+      float x = i * 0.005f;
+      worst = fmaxf(worst, fabsf(batchSin<ScalarLanes>(x) - sinf(x)));
+      worst = fmaxf(worst, fabsf(batchCos<ScalarLanes>(x) - cosf(x)));
+    }
+    printf("Trig: worst error %.2g over +-20 rad\n", worst);
+    CHECK(worst < 2e-5f);
+  }
+
+  // ---------------------------------------------------------
+  // 2. Kernel: Hampel filter, tracker, range gate, law, smoothing table,
+  //    lead and budget bit for bit with the stages, started at a different
+  //    tick in each lane
+  // ---------------------------------------------------------
+  {
+    int scalar = 0;
+    for (uint32_t seed = 1; seed <= 64; seed++) scalar += kernelMismatches<ScalarLanes>(seed, 400);
+    CHECK(scalar == 0);
+    int wide = kernelMismatches<BatchLanes>(99, 2000);
+    CHECK(wide == 0);
+    printf("Kernel: %d scalar / %d %d-lane mismatches against the stages\n", scalar, wide, BatchLanes::WIDTH);
+  }
+
+  // ---------------------------------------------------------
+  // 3. Flights: every lane of the wide build flies its glider exactly as the
+  //    scalar build does, including a partial last block
+  // ---------------------------------------------------------
+  const int N = 2003;
+  BatchSim sim(defaultSimConfig(), defaultBatchControl());
+  std::vector<SimResult> scalar, wide;
+  double scalarRate = flightsPerSec<ScalarLanes>(sim, N, scalar);
+  double wideRate = flightsPerSec<BatchLanes>(sim, N, wide);
+  int differ = 0, cleared = 0, launched = 0;
+  for (int i = 0; i < N; i++) {
+    differ += !sameResult(scalar[i], wide[i]);
+    cleared += wide[i].outcome == GliderSim::CLEARED;
+    launched += wide[i].launched;
+  }
+  printf("Flights: %d, %d differ, %d cleared, %d launched\n", N, differ, cleared, launched);
+  printf("Speed: %.0f flights/s scalar, %.0f flights/s %d-lane (%.1fx)\n", scalarRate, wideRate,
+         BatchLanes::WIDTH, wideRate / scalarRate);
+  CHECK(differ == 0);
+  CHECK(launched == N);
+  // Far better than the surfaces at neutral (11%), short of every flight
+  CHECK(cleared > N / 5 && cleared < N * 9 / 10);
+
+  // ---------------------------------------------------------
+  // 4. Agreement: the outcome shares match CorridorSimEngine flying
+  //    main.cpp on the same seeds, within three standard errors of the
+  //    difference plus 1% for the lockstep approximations
+  // ---------------------------------------------------------
+  {
+    const int CORRIDOR_N = 600;
+    const int BATCH_N = 20000;
+    std::vector<SimResult> batch(BATCH_N);
+    sim.fly<BatchLanes>(1, BATCH_N, &batch[0]);
+    CorridorSimEngine engine;
+    SimConfig cfg = defaultSimConfig();
+    const GliderSim::Outcome kinds[3] = { GliderSim::CLEARED, GliderSim::HIT_RIGHT, GliderSim::HIT_LEFT };
+    int inCorridor[3] = { 0, 0, 0 }, inBatch[3] = { 0, 0, 0 }, flown = 0;
+    for (int i = 0; i < CORRIDOR_N; i++) {
+      SimResult r;
+      if (!engine.fly(cfg, 1 + i, r)) continue;
+      flown++;
+      for (int k = 0; k < 3; k++) inCorridor[k] += r.outcome == kinds[k];
+    }
+    for (int i = 0; i < BATCH_N; i++) {
+      for (int k = 0; k < 3; k++) inBatch[k] += batch[i].outcome == kinds[k];
+    }
+    CHECK(flown == CORRIDOR_N);
+    for (int k = 0; k < 3; k++) {
+      double pc = (double)inCorridor[k] / CORRIDOR_N, pb = (double)inBatch[k] / BATCH_N;
+      double p = (pc + pb) / 2;
+      double tolerance = 3 * sqrt(p * (1 - p) * (1.0 / CORRIDOR_N + 1.0 / BATCH_N)) + 0.01;
+      printf("Agreement: %-10s %5.1f%% corridor_sim, %5.1f%% batch (tolerance %.1f%%)\n",
+             simOutcomeName(kinds[k]), 100 * pc, 100 * pb, 100 * tolerance);
+      CHECK(fabs(pc - pb) < tolerance);
+    }
+  }
+
+  if (failures == 0) printf("Batch simulator: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
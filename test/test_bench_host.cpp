@@ -0,0 +1,202 @@
+// Host-side tests for the micro-benchmark suite: the robust statistics, the
+// Cortex-M0+ cost model's operation counts and constant folding, and the
+// JSON the suite writes
+//   g++ -std=c++11 -O2 -Iinclude test/test_bench_host.cpp -o bench_test && ./bench_test
+#define PROFILE_STAGES 0
+#include "../src/main.cpp"
+#include "../tools/bench/PrimitiveBench.h"
+#include "TestCheck.h"
+
+typedef M0Counted<float> CF;
+typedef M0Counted<Q16> CQ;
+
+bool only(const M0Tally &t, M0Op a, uint32_t na, M0Op b = M0_OP_COUNT, uint32_t nb = 0,
+          M0Op c = M0_OP_COUNT, uint32_t nc = 0, M0Op d = M0_OP_COUNT, uint32_t nd = 0) {
+  for (int op = 0; op < M0_OP_COUNT; op++) {
+    uint32_t want = op == a ? na : op == b ? nb : op == c ? nc : op == d ? nd : 0;
+    if (t.ops[op] != want) return false;
+  }
+  return true;
+}
+
+int count(const std::string &s, const std::string &what) {
+  int n = 0;
+  for (size_t at = s.find(what); at != std::string::npos; at = s.find(what, at + 1)) n++;
+  return n;
+}
+
+int main() {
+  // ---------------------------------------------------------
+  // 1. Statistics: median, MAD and its interval ignore a few wild samples
+  // ---------------------------------------------------------
+  {
+    std::vector<double> ns;
+    for (int i = 0; i < 95; i++) ns.push_back(10.0 + (i % 5) * 0.1);   // 10.0 .. 10.4
+    for (int i = 0; i < 6; i++) ns.push_back(500.0);                   // Descheduled batches
+    BenchStats s = benchStats(ns, 1000);
+    CHECK(s.samples == 101 && s.batch == 1000);
+    CHECK(fabs(s.medianNs - 10.2) < 1e-9);
+    CHECK(fabs(s.madNs - 1.4826 * 0.1) < 1e-6);
+    CHECK(s.ciLowNs <= s.medianNs && s.ciHighNs >= s.medianNs && s.ciHighNs < 11.0);
+    CHECK(s.outliers == 6);
+    CHECK(s.minNs == 10.0 && s.maxNs == 500.0 && s.meanNs > 30.0);
+
+    std::vector<double> even;
+    even.push_back(4);
+    even.push_back(1);
+    even.push_back(3);
+    even.push_back(2);
+    CHECK(benchStats(even, 1).medianNs == 2.5);
+    CHECK(benchStats(std::vector<double>(), 1).samples == 0);
+  }
+
+  // ---------------------------------------------------------
+  // 2. Timing: more work measures slower, per call
+  // ---------------------------------------------------------
+  {
+    BenchConfig quick = { 21, 2e-4, 0.0 };
+    volatile float seed = 1.0f;
+    BenchStats one = benchTime([&](long n) {
+      float x = seed;
+      for (long i = 0; i < n; i++) { x = x * 0.999f + 0.5f; benchKeep(x); }
+    }, quick);
+    BenchStats fifty = benchTime([&](long n) {
+      float x = seed;
+      for (long i = 0; i < n; i++) {
+        for (int k = 0; k < 50; k++) x = x * 0.999f + 0.5f;
+        benchKeep(x);
+      }
+    }, quick);
+    printf("Timing: %.2f ns for one multiply-add, %.2f ns for fifty\n", one.medianNs, fifty.medianNs);
+    CHECK(one.medianNs > 0 && one.batch > 1);
+    CHECK(fifty.medianNs > 10 * one.medianNs);
+  }
+
+  // ---------------------------------------------------------
+  // 3. Cost model: the stages' float arithmetic, double promotions
+  //    included, and the same values as plain float
+  // ---------------------------------------------------------
+  {
+    CF raw = CF::input(120.0f), prev = CF::input(101.5f);
+    m0Tally().clear();
+    CF out = lowPass(raw, prev, CF(0.7f));
+    // alpha * raw, then (1.0 - alpha) * prev and the sum in double
+    M0Tally t = m0Tally();
+    CHECK(t.ops[M0_FMUL] == 1 && t.ops[M0_F2D] == 2 && t.ops[M0_DMUL] == 1 && t.ops[M0_DADD] == 1 &&
+          t.ops[M0_D2F] == 1);
+    CHECK(t.cycles() == M0_OPS[M0_FMUL].cycles + 2 * M0_OPS[M0_F2D].cycles + M0_OPS[M0_DMUL].cycles +
+                        M0_OPS[M0_DADD].cycles + M0_OPS[M0_D2F].cycles);
+    float plain = lowPass(120.0f, 101.5f, 0.7f);
+    CHECK(!memcmp(&out.v, &plain, sizeof(float)));
+
+    // Constants fold
+    m0Tally().clear();
+    CF folded = lowPass(CF(3.0f), CF(5.0f), CF(0.5f));
+    CHECK(m0Tally().cycles() == 0 && folded.folded && folded.v == 4.0f);
+
+    m0Tally().clear();
+    CF rate = closureRate(CF::input(98.0f), CF::input(100.0f), CF::input(0.05f));
+    CHECK(only(m0Tally(), M0_FADD, 1, M0_FDIV, 1, M0_ALU, 2, M0_FCMP, 1));   // Compare: dt > 0
+    CHECK(rate.v == closureRate(98.0f, 100.0f, 0.05f));
+
+    m0Tally().clear();
+    int pwm = smoothServo(1300, 1700, CF(0.7f));
+    t = m0Tally();
+    CHECK(t.ops[M0_I2F] == 1 && t.ops[M0_FMUL] == 1 && t.ops[M0_I2D] == 1 && t.ops[M0_DMUL] == 1 &&
+          t.ops[M0_DADD] == 1 && t.ops[M0_D2I] == 1);
+    CHECK(pwm == smoothServo(1300, 1700, 0.7f));
+
+    // Tracker correction: predict, residual, both gains, the rate over dt
+    AlphaBetaTracker<CF> track(CF(0.5f), CF(0.4f), 6);
+    AlphaBetaTracker<float> plainTrack(0.5f, 0.4f, 6);
+    track.reset(CF::input(100.0f));
+    plainTrack.reset(100.0f);
+    m0Tally().clear();
+    CF dist = track.correct(CF::input(97.0f), CF::input(0.05f));
+    CHECK(only(m0Tally(), M0_FADD, 4, M0_FMUL, 3, M0_FDIV, 1, M0_FCMP, 1));
+    float plainDist = plainTrack.correct(97.0f, 0.05f);
+    CHECK(!memcmp(&dist.v, &plainDist, sizeof(float)));
+
+    // A spike into a full Hampel window comes out as the median
+    HampelFilter<CF, 5> spikes(CF(3.0f), CF(8.0f), CF(60.0f));
+    for (int i = 0; i < 5; i++) spikes.filter(CF::input(96.0f + 2 * (i % 3)));
+    CHECK(spikes.filter(CF::input(250.0f)).v == 98.0f);
+
+    // Over the threshold: a compare, the correction from int and back
+    ControlLaw<BangBangHold<CF> > law(m0Axis(RUDDER_AXIS));
+    m0Tally().clear();
+    int us = law.offset(CF::input(80.0f), CF::input(toFloat(RUDDER_AXIS.rateThreshold) + 10.0f), 0);
+    CHECK(only(m0Tally(), M0_FCMP, 1, M0_I2F, 1, M0_F2I, 1));
+    CHECK(us == toInt(fullCorrection(RUDDER_AXIS)));
+  }
+
+  // ---------------------------------------------------------
+  // 4. Cost model: Q16 is integer instructions and 64-bit calls
+  // ---------------------------------------------------------
+  {
+    m0Tally().clear();
+    CQ out = lowPass(CQ::input(120.0f), CQ::input(101.5f), CQ(0.7));
+    CHECK(only(m0Tally(), M0_LMUL, 2, M0_ALU, 1));
+    CHECK(out.v == lowPass(Q16(120.0f), Q16(101.5f), Q16(0.7)));
+
+    m0Tally().clear();
+    closureRate(CQ::input(98.0f), CQ::input(100.0f), CQ::input(0.05f));
+    CHECK(only(m0Tally(), M0_LDIV, 1, M0_ALU, 6));   // dt > 0, zero and saturation checks
+
+    RollingAverage<CQ, 3> avg;
+    for (int i = 0; i < 4; i++) avg.add(CQ::input(10.0f * i));
+    m0Tally().clear();
+    avg.add(CQ::input(40.0f));
+    CHECK(only(m0Tally(), M0_ALU, 4, M0_IDIV, 1));
+  }
+
+  // ---------------------------------------------------------
+  // 5. Suite: every case timed and modelled, written as JSON
+  // ---------------------------------------------------------
+  {
+    BenchConfig quick = { 7, 5e-5, 0.0 };
+    BenchStats overhead;
+    std::vector<PrimitiveResult> results = runPrimitiveBench(quick, NULL, overhead);
+    const char *names[] = { "filter", "hampel", "rate", "rolling_average", "tracker_correct", "tracker_predict",
+                            "law_trigger", "law_hold", "law_idle", "servo", "servo_lead", "servo_budget" };
+    const int CASES = 12;
+    CHECK(results.size() == CASES);
+    for (size_t i = 0; i < results.size() && i < CASES; i++) {
+      CHECK(!strcmp(results[i].name, names[i]));
+      CHECK(results[i].host.samples == 7 && results[i].host.medianNs > 0);
+      CHECK(results[i].netNs >= 0 && results[i].m0.cycles() > 0);
+    }
+    // Restarting the timer costs more than finding it idle (one conversion
+    // to and from the correction)
+    CHECK(results[6].m0.cycles() > results[8].m0.cycles());
+    // The smoothing and the budget cost more than the budget alone
+    CHECK(results[9].m0.cycles() > results[11].m0.cycles());
+    CHECK(runPrimitiveBench(quick, "law_", overhead).size() == 3);
+    CHECK(runPrimitiveBench(quick, "tracker_", overhead).size() == 2);
+
+    char path[] = "/tmp/bench_json_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *out = fdopen(fd, "w");
+    writePrimitiveJson(out, results, overhead, quick, "abc123");
+    fclose(out);
+    std::string json;
+    FILE *in = fopen(path, "r");
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) json.append(buf, n);
+    fclose(in);
+    remove(path);
+
+    CHECK(count(json, "{") == count(json, "}") && count(json, "[") == count(json, "]"));
+    CHECK(json.find("\"commit\": \"abc123\"") != std::string::npos);
+    CHECK(json.find("\"suite\": \"primitives\"") != std::string::npos);
+    CHECK(count(json, "\"host_ns\": {") == CASES);
+    CHECK(count(json, "\"cycles\": ") == CASES);
+    for (int i = 0; i < CASES; i++) CHECK(json.find(std::string("\"name\": \"") + names[i] + "\"") != std::string::npos);
+    CHECK(json.find(",\n  }") == std::string::npos && json.find("nan") == std::string::npos);
+    printf("JSON: %zu bytes, %d cases\n", json.size(), count(json, "\"name\""));
+  }
+
+  if (failures == 0) printf("Benchmarks: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
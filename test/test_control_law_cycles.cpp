@@ -0,0 +1,72 @@
+#include <Arduino.h>
+#include "ControlLaw.h"
+
+// Cycle counts of one ControlLaw<Policy>::update() per policy, float vs Q16.
+// SysTick runs at the 48MHz core clock and reloads every 1ms, so each
+// measured block must stay well under 48000 cycles. For flash cost, build
+// src/main.cpp with each -DCONTROL_LAW=... and compare `pio run -t size`:
+// only the selected policy is compiled in.
+
+const int REPEAT = 100;
+
+volatile float distIn = 60.0;
+volatile float rateIn = 55.0;
+
+uint32_t cyclesSince(uint32_t start) {
+  uint32_t now = SysTick->VAL;
+  uint32_t reload = SysTick->LOAD + 1;
+  return (start >= now) ? (start - now) : (start + reload - now);
+}
+
+template <class Law>
+void measure(const char* label) {
+  typedef typename Law::Value T;
+  AxisConfig<T> axis = { 1700, 900, 900, 2100, 50.0, 500, 45.0, 10.0, 8.0, 1.5, 0.5 };
+  Law law(axis);
+  T dist = T(distIn);
+  T rate = T(rateIn);
+  uint32_t start, total = 0;
+  int us = 0;
+
+  for (int i = 0; i < REPEAT; i++) {
+    noInterrupts();
+    start = SysTick->VAL;
+    us = law.update(dist, rate, i * 50);
+    total += cyclesSince(start);
+    interrupts();
+  }
+
+  Serial.print(label);
+  Serial.print(",");
+  Serial.print(total / REPEAT);
+  Serial.print(",");
+  Serial.print(sizeof(Law));
+  Serial.print("  (pwm ");
+  Serial.print(us);
+  Serial.println(")");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  Serial.println("========================================");
+  Serial.println("CONTROL LAW CYCLE COUNT (per axis, per tick)");
+  Serial.println("========================================");
+  Serial.println("Policy,Cycles,StateBytes");
+}
+
+void loop() {
+  measure<ControlLaw<BangBangHold<float> > >("bang-bang+hold float");
+  measure<ControlLaw<Proportional<float> > >("P float");
+  measure<ControlLaw<ProportionalDerivative<float> > >("PD float");
+  measure<ControlLaw<TimeToCollision<float> > >("time-to-collision float");
+  measure<ControlLaw<TauProportional<float> > >("tau proportional float");
+  measure<ControlLaw<BangBangHold<Q16> > >("bang-bang+hold Q16");
+  measure<ControlLaw<Proportional<Q16> > >("P Q16");
+  measure<ControlLaw<ProportionalDerivative<Q16> > >("PD Q16");
+  measure<ControlLaw<TimeToCollision<Q16> > >("time-to-collision Q16");
+  measure<ControlLaw<TauProportional<Q16> > >("tau proportional Q16");
+  Serial.println();
+  delay(2000);
+}
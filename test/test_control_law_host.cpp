@@ -0,0 +1,217 @@
+// Host-side test + benchmark for the ControlLaw policies on one input trace
+//   g++ -std=c++11 -O2 -Iinclude test/test_control_law_host.cpp -o law_test && ./law_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "ControlLaw.h"
+#include "TestCheck.h"
+
+// Same settings as main.cpp
+const int SERVO_RUDDER_NEUTRAL = 1700;
+const int SERVO_RUDDER_LEFT    = 900;
+const int SERVO_RUDDER_MIN     = 900;
+const int SERVO_RUDDER_MAX     = 2100;
+const float PARAM_RATE_RIGHT_THRESHOLD = 50.0;
+const unsigned long SERVO_HOLD_TIME_MS = 500;
+
+template <typename T>
+AxisConfig<T> rudderAxis() {
+  AxisConfig<T> c = {
+    SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX,
+    PARAM_RATE_RIGHT_THRESHOLD, SERVO_HOLD_TIME_MS,
+    45.0, 10.0, 8.0, 1.0, 0.4
+  };
+  return c;
+}
+
+// The rudder block loop() had before ControlLaw, verbatim
+struct OriginalRudder {
+  unsigned long rudderActivatedTime;
+  bool rudderActive;
+
+  OriginalRudder() : rudderActivatedTime(0), rudderActive(false) {}
+
+  int update(float avgRateRight, unsigned long currentTime) {
+    int targetRudder;
+    if (avgRateRight > PARAM_RATE_RIGHT_THRESHOLD) {
+      targetRudder = SERVO_RUDDER_LEFT;
+      rudderActivatedTime = currentTime;
+      rudderActive = true;
+    } else if (rudderActive && (currentTime - rudderActivatedTime < SERVO_HOLD_TIME_MS)) {
+      targetRudder = SERVO_RUDDER_LEFT;
+    } else {
+      targetRudder = SERVO_RUDDER_NEUTRAL;
+      rudderActive = false;
+    }
+    return targetRudder;
+  }
+};
+
+// ---------------------------------------------------------
+// Shared input trace: a 4 s flight closing on and turning away from the
+// wall, with rate noise and jittery tick times
+// ---------------------------------------------------------
+const int TRACE_LEN = 80;
+float traceDist[TRACE_LEN];
+float traceRate[TRACE_LEN];
+uint32_t traceMs[TRACE_LEN];
+
+void buildTrace() {
+  srand(11);
+  float dist = 120.0;
+  uint32_t t = 1000;
+  for (int i = 0; i < TRACE_LEN; i++) {
+    float rate = 60.0 * sinf(i * 0.15) + 20.0 + (rand() % 2000 - 1000) / 50.0;
+    dist -= rate * 0.05;
+    if (dist < 5.0) dist = 5.0;
+    traceDist[i] = dist;
+    traceRate[i] = rate;
+    traceMs[i] = t;
+    t += 50 + rand() % 3;
+  }
+}
+
+// ---------------------------------------------------------
+// Behaviour
+// ---------------------------------------------------------
+template <typename T>
+void checkMatchesOriginal() {
+  ControlLaw<BangBangHold<T> > law(rudderAxis<T>());
+  OriginalRudder ref;
+  srand(5);
+  uint32_t t = 0;
+  for (int i = 0; i < 20000; i++) {
+    float rate = (rand() % 30000) / 100.0 - 100.0;
+    t += 40 + rand() % 30;
+    if (ref.update(rate, t) != law.update(T(100.0), T(rate), t)) {
+      CHECK(false);
+      return;
+    }
+  }
+}
+
+void testProportional() {
+  ControlLaw<Proportional<float> > law(rudderAxis<float>());
+  CHECK(law.update(45.0, 0.0, 0) == SERVO_RUDDER_NEUTRAL);       // On the set-point
+  CHECK(law.update(25.0, 0.0, 0) == SERVO_RUDDER_NEUTRAL - 200); // 20cm inside: away
+  CHECK(law.update(85.0, 0.0, 0) == SERVO_RUDDER_NEUTRAL + 400); // 40cm out: back in
+  CHECK(law.update(-200.0, 0.0, 0) == SERVO_RUDDER_MIN);         // Clamped
+  CHECK(law.update(500.0, 0.0, 0) == SERVO_RUDDER_MAX);
+
+  // The old test_control_laws.cpp sketch: 1500 +- 200, K_P 2.0 us/cm
+  AxisConfig<float> sketch = { 1500, 1700, 1300, 1700, 0.0, 0, 152.0, 2.0, 0.0, 0.0, 0.0 };
+  ControlLaw<Proportional<float> > p(sketch);
+  CHECK(p.update(152.0 - 50.0, 0.0, 0) == 1600);
+  CHECK(p.update(152.0 + 40.0, 0.0, 0) == 1420);
+  CHECK(p.update(152.0 - 100.0, 0.0, 0) == 1700);
+}
+
+void testProportionalDerivative() {
+  ControlLaw<ProportionalDerivative<float> > law(rudderAxis<float>());
+  CHECK(law.update(45.0, 25.0, 0) == SERVO_RUDDER_NEUTRAL - 200); // Closing at 25 cm/s
+  CHECK(law.update(65.0, 25.0, 0) == SERVO_RUDDER_NEUTRAL);       // 20cm out, closing
+  ControlLaw<ProportionalDerivative<Q16> > fx(rudderAxis<Q16>());
+  CHECK(fx.update(Q16(45.0), Q16(25.0), 0) == SERVO_RUDDER_NEUTRAL - 200);
+}
+
+void testTimeToCollision() {
+  ControlLaw<TimeToCollision<float> > law(rudderAxis<float>());
+  CHECK(law.update(100.0, 80.0, 0) == SERVO_RUDDER_NEUTRAL);      // 1.25 s away
+  CHECK(law.update(100.0, 120.0, 50) == SERVO_RUDDER_LEFT);       // 0.83 s away
+  CHECK(law.update(100.0, -10.0, 100) == SERVO_RUDDER_LEFT);      // Held
+  CHECK(law.update(100.0, -10.0, 600) == SERVO_RUDDER_NEUTRAL);   // Hold expired
+  CHECK(law.update(20.0, 10.0, 650) == SERVO_RUDDER_NEUTRAL);     // Slow: 2 s away
+  CHECK(law.update(20.0, 30.0, 700) == SERVO_RUDDER_LEFT);        // Close: 0.67 s
+  CHECK(law.update(5.0, 0.0, 1300) == SERVO_RUDDER_NEUTRAL);      // Not closing
+}
+
+void testTauProportional() {
+  ControlLaw<TauProportional<float> > law(rudderAxis<float>());
+  CHECK(law.update(100.0, 80.0, 0) == SERVO_RUDDER_NEUTRAL);      // 1.25 s: not yet
+  CHECK(law.update(100.0, 100.0, 0) == SERVO_RUDDER_NEUTRAL);     // 1.0 s: onset
+  CHECK(abs(law.update(70.0, 100.0, 0) - (SERVO_RUDDER_NEUTRAL - 400)) <= 1); // 0.7 s: half way
+  CHECK(law.update(30.0, 100.0, 0) == SERVO_RUDDER_LEFT);         // 0.3 s: full
+  CHECK(law.update(1.0, 100.0, 0) == SERVO_RUDDER_LEFT);          // Clamped
+  CHECK(law.update(5.0, 0.0, 0) == SERVO_RUDDER_NEUTRAL);         // Not closing
+  CHECK(law.update(5.0, -50.0, 0) == SERVO_RUDDER_NEUTRAL);       // Opening: no hold
+
+  // Q16: no overflow when the rate is a few LSBs and the wall is close
+  ControlLaw<TauProportional<Q16> > fx(rudderAxis<Q16>());
+  CHECK(abs(fx.update(Q16(70.0), Q16(100.0), 0) - (SERVO_RUDDER_NEUTRAL - 400)) <= 1);
+  CHECK(fx.update(Q16(2.0), Q16::fromRaw(3), 0) == SERVO_RUDDER_NEUTRAL);
+  CHECK(fx.update(Q16::fromRaw(1), Q16::fromRaw(3), 0) == SERVO_RUDDER_LEFT);
+  CHECK(abs(fx.update(Q16(300.0), Q16(500.0), 0) - (SERVO_RUDDER_NEUTRAL - 533)) <= 1);
+}
+
+// ---------------------------------------------------------
+// Report: every policy on the shared trace
+// ---------------------------------------------------------
+template <class Law>
+void report(const char* name) {
+  typedef typename Law::Value T;
+  Law law(rudderAxis<T>());
+  int first = -1;
+  int correcting = 0;
+  double effort = 0;
+  for (int i = 0; i < TRACE_LEN; i++) {
+    int us = law.update(T(traceDist[i]), T(traceRate[i]), traceMs[i]);
+    if (us < SERVO_RUDDER_NEUTRAL) {
+      correcting++;
+      if (first < 0) first = i;
+    }
+    effort += fabs((double)(us - SERVO_RUDDER_NEUTRAL));
+  }
+
+  // Cost per update (both axes run one each per tick)
+  const int N = 2000000;
+  Law bench(rudderAxis<T>());
+  volatile int sink = 0;
+  clock_t start = clock();
+  for (int i = 0; i < N; i++) {
+    int k = i % TRACE_LEN;
+    sink = sink + bench.update(T(traceDist[k]), T(traceRate[k]), (uint32_t)i * 50);
+  }
+  double ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / N;
+
+  printf("%-20s %9d %10d %12.0f %8.1f %8u\n", name, first, correcting, effort / TRACE_LEN, ns,
+         (unsigned)sizeof(Law));
+}
+
+void reportOriginal() {
+  OriginalRudder ref;
+  const int N = 2000000;
+  volatile int sink = 0;
+  clock_t start = clock();
+  for (int i = 0; i < N; i++) sink = sink + ref.update(traceRate[i % TRACE_LEN], (uint32_t)i * 50);
+  double ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / N;
+  printf("%-20s %9s %10s %12s %8.1f %8u\n", "hand-coded original", "-", "-", "-", ns,
+         (unsigned)sizeof(OriginalRudder));
+}
+
+int main() {
+  buildTrace();
+  checkMatchesOriginal<float>();
+  checkMatchesOriginal<Q16>();
+  testProportional();
+  testProportionalDerivative();
+  testTimeToCollision();
+  testTauProportional();
+
+  printf("%-20s %9s %10s %12s %8s %8s\n", "Policy", "FirstTick", "Correcting", "MeanEff(us)", "ns/upd", "Bytes");
+  report<ControlLaw<BangBangHold<float> > >("bang-bang+hold");
+  report<ControlLaw<Proportional<float> > >("P");
+  report<ControlLaw<ProportionalDerivative<float> > >("PD");
+  report<ControlLaw<TimeToCollision<float> > >("time-to-collision");
+  report<ControlLaw<TauProportional<float> > >("tau proportional");
+  report<ControlLaw<BangBangHold<Q16> > >("bang-bang+hold Q16");
+  report<ControlLaw<Proportional<Q16> > >("P Q16");
+  report<ControlLaw<ProportionalDerivative<Q16> > >("PD Q16");
+  report<ControlLaw<TimeToCollision<Q16> > >("time-to-collision Q16");
+  report<ControlLaw<TauProportional<Q16> > >("tau proportional Q16");
+  reportOriginal();
+  printf("(M0+ cycles per policy: test/test_control_law_cycles.cpp on the board)\n");
+
+  if (failures == 0) printf("ControlLaw: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+// Host-side simulation of ControlScheduler (no board needed)
+//   g++ -std=c++11 -Iinclude test/test_control_scheduler_host.cpp -o control_test && ./control_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "ControlScheduler.h"
+#include "TestCheck.h"
+
+const uint32_t PERIOD_US = 50000;        // LOOP_PERIOD_MS = 50
+
+// ---------------------------------------------------------
+// Bookkeeping on hand-placed releases and starts
+// ---------------------------------------------------------
+void testJitterBookkeeping() {
+  ControlScheduler sched(PERIOD_US);
+  // Start latency for cycles 0..4; cycle 0 only sets the reference
+  uint32_t latency[] = { 100, 300, 50, 1200, 100 };
+
+  for (int i = 0; i < 5; i++) {
+    uint32_t releaseAt = i * PERIOD_US;
+    CHECK(!sched.begin(releaseAt - 1));  // Nothing due yet
+    sched.release(releaseAt);
+    CHECK(sched.begin(releaseAt + latency[i]));
+    CHECK(!sched.begin(releaseAt + latency[i] + 1));   // Consumed
+    sched.end(releaseAt + latency[i] + 4000 + i * 10);
+  }
+
+  // Periods: 50200, 49750, 51150, 48900 -> jitter 200, -250, 1150, -1100
+  const ControlStats &st = sched.timingStats();
+  CHECK(st.cycles == 4);
+  CHECK(st.overruns == 0);
+  CHECK(st.minJitterUs == -1100);
+  CHECK(st.maxJitterUs == 1150);
+  CHECK(fabsf(sched.meanJitterUs() - 0.0) < 1e-3);
+  CHECK(st.maxLatencyUs == 1200);
+  CHECK(fabsf(sched.meanLatencyUs() - (300 + 50 + 1200 + 100) / 4.0) < 1e-3);
+  CHECK(st.maxBusyUs == 4040);
+}
+
+void testOverrunSkipsWithoutBurst() {
+  ControlScheduler sched(PERIOD_US);
+  sched.release(0);
+  CHECK(sched.begin(0));
+  sched.end(120000);                     // Blocked through two releases
+
+  sched.release(50000);
+  sched.release(100000);
+  CHECK(sched.begin(120000));            // Runs once, on the newest release
+  CHECK(!sched.begin(120010));           // No back-to-back catch-up cycle
+  CHECK(sched.timingStats().overruns == 1);
+  CHECK(sched.timingStats().maxLatencyUs == 20000);
+
+  sched.release(150000);
+  CHECK(sched.begin(150020));
+  CHECK(sched.timingStats().overruns == 1);
+  CHECK(sched.timingStats().maxJitterUs == 120000 - (int32_t)PERIOD_US);
+}
+
+void testResetStats() {
+  ControlScheduler sched(PERIOD_US);
+  for (int i = 0; i < 3; i++) {
+    sched.release(i * PERIOD_US);
+    sched.begin(i * PERIOD_US + 500);
+  }
+  sched.resetStats();
+  CHECK(sched.timingStats().cycles == 0);
+
+  // First cycle after a reset is only the reference
+  sched.release(3 * PERIOD_US);
+  sched.begin(3 * PERIOD_US);
+  CHECK(sched.timingStats().cycles == 0);
+  sched.release(4 * PERIOD_US);
+  sched.begin(4 * PERIOD_US + 10);
+  CHECK(sched.timingStats().cycles == 1);
+  CHECK(sched.timingStats().minJitterUs == 10);
+}
+
+void testWrapAround() {
+  ControlScheduler sched(PERIOD_US);
+  uint32_t start = 0xFFFFFFFFu - 20000;
+  sched.release(start);
+  sched.begin(start + 100);
+  sched.release(start + PERIOD_US);      // Wraps past zero
+  CHECK(sched.begin(start + PERIOD_US + 40));
+  CHECK(sched.timingStats().minJitterUs == -60);
+  CHECK(sched.timingStats().maxLatencyUs == 40);
+}
+
+// ---------------------------------------------------------
+// Timer release vs the old millis() gate on a loop with uneven passes
+// ---------------------------------------------------------
+struct Run {
+  ControlStats stats;
+  float meanJitter;
+  uint32_t cycles;
+};
+
+// Each loop() pass takes 200us-2ms (echo service, serial); every 40th pass
+// blocks for 30ms (a long serial dump). The control step itself takes 3ms.
+uint32_t passDuration(int pass) {
+  if (pass % 40 == 39) return 30000;
+  return 200 + rand() % 1800;
+}
+
+Run runTimer(uint32_t durationUs) {
+  ControlScheduler sched(PERIOD_US);
+  uint32_t now = 0;
+  uint32_t nextRelease = 0;
+  int pass = 0;
+  srand(3);
+  while (now < durationUs) {
+    uint32_t passEnd = now + passDuration(pass++);
+    // The ISR fires mid-pass; begin() sees it on the next pass
+    while (nextRelease <= passEnd) {
+      sched.release(nextRelease);
+      nextRelease += PERIOD_US;
+    }
+    now = passEnd;
+    if (sched.begin(now)) {
+      now += 3000;
+      sched.end(now);
+    }
+  }
+  Run r = { sched.timingStats(), sched.meanJitterUs(), sched.timingStats().cycles };
+  return r;
+}
+
+Run runMillisGate(uint32_t durationUs) {
+  ControlScheduler sched(PERIOD_US);     // Bookkeeping only, as main.cpp does
+  uint32_t now = 0;
+  uint32_t prevLoopMs = 0;
+  int pass = 0;
+  srand(3);
+  while (now < durationUs) {
+    now += passDuration(pass++);
+    uint32_t ms = now / 1000;
+    if (ms - prevLoopMs < PERIOD_US / 1000) continue;
+    prevLoopMs = ms;
+    sched.release(now);
+    sched.begin(now);
+    now += 3000;
+    sched.end(now);
+  }
+  Run r = { sched.timingStats(), sched.meanJitterUs(), sched.timingStats().cycles };
+  return r;
+}
+
+void testTimerVsMillisGate() {
+  const uint32_t DURATION_US = 60000000;  // One minute
+  Run timer = runTimer(DURATION_US);
+  Run gate = runMillisGate(DURATION_US);
+
+  printf("%-12s %8s %9s %10s %10s %10s\n", "Scheduler", "Cycles", "Overruns", "Jit min", "Jit mean", "Jit max");
+  printf("%-12s %8u %9u %10d %10.1f %10d\n", "TC3 release", timer.cycles, timer.stats.overruns,
+         timer.stats.minJitterUs, timer.meanJitter, timer.stats.maxJitterUs);
+  printf("%-12s %8u %9u %10d %10.1f %10d\n", "millis gate", gate.cycles, gate.stats.overruns,
+         gate.stats.minJitterUs, gate.meanJitter, gate.stats.maxJitterUs);
+
+  // The timer holds the nominal rate on average; the gate drifts late by
+  // each pass's overshoot and loses cycles.
+  CHECK(fabsf(timer.meanJitter) < 50.0);
+  CHECK(gate.meanJitter > 500.0);
+  CHECK(timer.cycles > gate.cycles);
+  CHECK(timer.cycles + timer.stats.overruns >= DURATION_US / PERIOD_US - 2);
+  CHECK(timer.stats.maxLatencyUs <= 30000 + 2000);
+}
+
+int main() {
+  testJitterBookkeeping();
+  testOverrunSkipsWithoutBurst();
+  testResetStats();
+  testWrapAround();
+  testTimerVsMillisGate();
+
+  if (failures == 0) printf("ControlScheduler: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Host-side tests for the corridor simulator: sonar beam geometry, dropout
+// and spike rates, servo dead time and slew, the trimmed glide, surface
+// authority, and src/main.cpp flying it in closed loop (tools/sim/corridor_sim
+// reports the speed)
+//   g++ -std=c++11 -O2 -Iinclude test/test_corridor_sim_host.cpp -o corridor_sim_test && ./corridor_sim_test
+#define PROFILE_STAGES 0
+#include "../src/main.cpp"
+#include "../tools/sim/CorridorSim.h"
+#include "TestCheck.h"
+
+// No dispersion, gusts or mis-trim: straight down the centre line
+LaunchSpread calmSpread() {
+  LaunchSpread s = { { 2.5f, 2.5f }, { 1.07f, 1.07f }, { 0.0f, 0.0f }, { 0.0f, 0.0f },
+                     { 0.0f, 0.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0.0f, 0.5f };
+  return s;
+}
+
+int main() {
+  SimConfig cfg = defaultSimConfig();
+
+  // ---------------------------------------------------------
+  // 1. Beam geometry: perpendicular inside the cone, the cone's edge past
+  //    it, nothing past the reflection limit
+  // ---------------------------------------------------------
+  CHECK(fabsf(sonarGeometryCm(cfg.sonar, 1.0f, 0.0f) - 100.0f) < 0.01f);
+  CHECK(fabsf(sonarGeometryCm(cfg.sonar, 1.0f, -10.0f * SIM_DEG) - 100.0f) < 0.01f);
+  CHECK(fabsf(sonarGeometryCm(cfg.sonar, 1.0f, 25.0f * SIM_DEG) - 100.0f / cosf(10.0f * SIM_DEG)) < 0.01f);
+  CHECK(sonarGeometryCm(cfg.sonar, 1.0f, 45.0f * SIM_DEG) < 0);
+  CHECK(sonarGeometryCm(cfg.sonar, -0.1f, 0.0f) < 0);
+
+  // ---------------------------------------------------------
+  // 2. Reading errors at their configured rates
+  // ---------------------------------------------------------
+  {
+    SonarParams clean = cfg.sonar;
+    clean.dropout = clean.spike = clean.noiseCm = clean.noiseFrac = 0;
+    GliderSim exact(cfg.glider, clean, cfg.rudder, cfg.elevator, calmSpread(), 7);
+    GliderSim noisy(cfg.glider, cfg.sonar, cfg.rudder, cfg.elevator, calmSpread(), 7);
+    float truth = exact.heightSonarCm();
+    const int N = 100000;
+    int dropouts = 0, spikes = 0;
+    double sum = 0, sumSq = 0;
+    int kept = 0;
+    for (int i = 0; i < N; i++) {
+      float cm = noisy.heightSonarCm();
+      if (cm <= 0) dropouts++;
+      else if (fabsf(cm - truth) > 5.0f) spikes++;
+      else {
+        sum += cm - truth;
+        sumSq += (cm - truth) * (cm - truth);
+        kept++;
+      }
+    }
+    float sigma = sqrtf(sumSq / kept - (sum / kept) * (sum / kept));
+    printf("Sonar at %.1fcm: %.2f%% dropouts, %.2f%% spikes, sigma %.2fcm\n",
+           truth, 100.0 * dropouts / N, 100.0 * spikes / N, sigma);
+    CHECK(fabsf(truth - 107.0f) < 0.01f);
+    CHECK(fabsf(dropouts / (float)N - cfg.sonar.dropout) < 0.003f);
+    CHECK(fabsf(spikes / (float)N - cfg.sonar.spike) < 0.002f);
+    CHECK(fabsf(sigma - (cfg.sonar.noiseCm + cfg.sonar.noiseFrac * truth)) < 0.05f);
+  }
+
+  // ---------------------------------------------------------
+  // 3. Servo: nothing for the dead time, then the slew limit
+  // ---------------------------------------------------------
+  {
+    SimServo servo;
+    servo.reset(cfg.rudder);
+    servo.write(900, 0.0);
+    double t = 0;
+    for (; t < cfg.rudder.deadSec - 0.0015; t += 0.001) servo.step(t, 0.001f);
+    CHECK(servo.positionUs() == 1700.0f);
+    for (; t < 0.100; t += 0.001) servo.step(t, 0.001f);
+    float expect = 1700.0f - (0.100f - cfg.rudder.deadSec) * cfg.rudder.slewUsPerSec;
+    CHECK(fabsf(servo.positionUs() - expect) < 15.0f);
+    for (; t < 0.200; t += 0.001) servo.step(t, 0.001f);
+    CHECK(servo.positionUs() == 900.0f && fabsf(servo.deflection() - 1.0f) < 1e-6f);
+  }
+
+  // ---------------------------------------------------------
+  // 4. Trimmed glide: trim speed, glide ratio; each surface turns the
+  //    glider the way the sketch expects
+  // ---------------------------------------------------------
+  {
+    GliderSim glide(cfg.glider, cfg.sonar, cfg.rudder, cfg.elevator, calmSpread(), 1);
+    glide.advanceTo(10.0);
+    float glideRatio = CORRIDOR_LEN_M / (1.07f - glide.state().z);
+    printf("Calm glide: %s after %.2fs, %.2f m/s, glide ratio %.1f\n", simOutcomeName(glide.result()),
+           glide.time(), glide.state().speed, glideRatio);
+    CHECK(glide.result() == GliderSim::CLEARED);
+    CHECK(glide.time() > 1.6 && glide.time() < 2.1);
+    CHECK(glideRatio > 6.0f && glideRatio < 14.0f);
+
+    GliderSim up(cfg.glider, cfg.sonar, cfg.rudder, cfg.elevator, calmSpread(), 1);
+    GliderSim left(cfg.glider, cfg.sonar, cfg.rudder, cfg.elevator, calmSpread(), 1);
+    up.elevator.write(SERVO_ELEVATOR_UP, 0.0);
+    left.rudder.write(SERVO_RUDDER_LEFT, 0.0);
+    up.advanceTo(1.0);
+    left.advanceTo(1.0);
+    GliderSim ref(cfg.glider, cfg.sonar, cfg.rudder, cfg.elevator, calmSpread(), 1);
+    ref.advanceTo(1.0);
+    CHECK(up.state().z > ref.state().z + 0.05f);
+    CHECK(left.state().y > ref.state().y + 0.05f && left.state().heading < -20.0f * SIM_DEG);
+  }
+
+  // ---------------------------------------------------------
+  // 5. main.cpp in the loop: flies every flight, beats the uncontrolled
+  //    glider at the right wall, repeats exactly. As shipped it clears
+  //    75 of the 300 and hits the right wall 8 times; the uncontrolled
+  //    glider clears 34 and hits it 266 times.
+  // ---------------------------------------------------------
+  CorridorSimEngine engine;
+  const int FLIGHTS = 300;
+  int rightHits = 0, rightHitsOpen = 0, cleared = 0, clearedOpen = 0, launched = 0;
+  SimResult r;
+  for (int f = 0; f < FLIGHTS; f++) {
+    CHECK(engine.fly(cfg, 100 + f, r));
+    if (r.launched && r.servoWrites > 0) launched++;
+    if (r.outcome == GliderSim::HIT_RIGHT) rightHits++;
+    if (r.outcome == GliderSim::CLEARED) cleared++;
+  }
+  for (int f = 0; f < FLIGHTS; f++) {
+    CorridorSimEngine::flyUncontrolled(cfg, 100 + f, r);
+    if (r.outcome == GliderSim::HIT_RIGHT) rightHitsOpen++;
+    if (r.outcome == GliderSim::CLEARED) clearedOpen++;
+  }
+  printf("main.cpp: cleared %d/%d, right wall %d; uncontrolled: cleared %d, right wall %d\n",
+         cleared, FLIGHTS, rightHits, clearedOpen, rightHitsOpen);
+  CHECK(launched == FLIGHTS);
+  CHECK(rightHits * 4 < rightHitsOpen);
+  CHECK(cleared > clearedOpen);
+
+  SimResult a, b;
+  engine.fly(cfg, 123, a);
+  engine.fly(cfg, 124, b);
+  engine.fly(cfg, 123, b);
+  CHECK(a.outcome == b.outcome && a.timeSec == b.timeSec && a.minRightM == b.minRightM &&
+        a.servoWrites == b.servoWrites);
+
+  if (failures == 0) printf("Corridor sim: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// Host-side test for EchoCapture (no board needed)
+//   g++ -std=c++11 -Iinclude test/test_echo_capture_host.cpp -o echo_test && ./echo_test
+#include <stdio.h>
+#include "EchoCapture.h"
+#include "TestCheck.h"
+
+const uint32_t SONAR_TIMEOUT_US = 30000;
+
+// Simulated clock and echo line
+uint32_t simMicros = 0;
+
+void advance(uint32_t us) { simMicros += us; }
+
+// Drives one complete echo: rise after `riseDelayUs`, fall `widthUs` later.
+void simulateEcho(EchoCapture &sonar, uint32_t riseDelayUs, uint32_t widthUs) {
+  advance(riseDelayUs);
+  sonar.onEdge(true, simMicros);
+  advance(widthUs);
+  sonar.onEdge(false, simMicros);
+}
+
+void testNormalEcho() {
+  EchoCapture sonar(SONAR_TIMEOUT_US);
+  EchoSample sample;
+
+  uint32_t armedAt = simMicros;
+  sonar.arm(simMicros);
+  CHECK(sonar.pending(simMicros));
+  CHECK(!sonar.fetch(simMicros, sample));
+
+  simulateEcho(sonar, 450, 5800);        // 100 cm
+  uint32_t fallAt = simMicros;
+  CHECK(!sonar.pending(simMicros));
+
+  advance(1000);
+  CHECK(sonar.fetch(simMicros, sample));
+  CHECK(sample.widthUs == 5800);
+  CHECK(sample.stampUs == fallAt);
+  CHECK(sample.armedUs == armedAt);
+
+  // Handed over exactly once
+  CHECK(!sonar.fetch(simMicros, sample));
+}
+
+void testTimeout() {
+  EchoCapture sonar(SONAR_TIMEOUT_US);
+  EchoSample sample;
+
+  sonar.arm(simMicros);
+  advance(SONAR_TIMEOUT_US - 1);
+  CHECK(!sonar.fetch(simMicros, sample));
+  advance(1);
+  CHECK(!sonar.pending(simMicros));
+  CHECK(sonar.fetch(simMicros, sample));
+  CHECK(sample.widthUs == 0);
+
+  // A late falling edge must not resurrect the timed-out ping
+  sonar.onEdge(true, simMicros);
+  advance(100);
+  sonar.onEdge(false, simMicros);
+  CHECK(!sonar.fetch(simMicros, sample));
+}
+
+void testStaleEdgeAfterRearm() {
+  EchoCapture sonar(SONAR_TIMEOUT_US);
+  EchoSample sample;
+
+  // First ping rises but its echo line is still high when we re-arm
+  sonar.arm(simMicros);
+  advance(400);
+  sonar.onEdge(true, simMicros);
+  advance(SONAR_TIMEOUT_US);
+  CHECK(sonar.fetch(simMicros, sample));
+  CHECK(sample.widthUs == 0);
+
+  sonar.arm(simMicros);
+  advance(2000);
+  sonar.onEdge(false, simMicros);        // Old ping's falling edge
+  CHECK(!sonar.fetch(simMicros, sample));
+
+  simulateEcho(sonar, 300, 2900);        // 50 cm
+  CHECK(sonar.fetch(simMicros, sample));
+  CHECK(sample.widthUs == 2900);
+}
+
+void testEdgesWhileIdleIgnored() {
+  EchoCapture sonar(SONAR_TIMEOUT_US);
+  EchoSample sample;
+
+  sonar.onEdge(true, simMicros);
+  advance(500);
+  sonar.onEdge(false, simMicros);
+  CHECK(!sonar.fetch(simMicros, sample));
+  CHECK(!sonar.pending(simMicros));
+}
+
+void testMicrosWrap() {
+  EchoCapture sonar(SONAR_TIMEOUT_US);
+  EchoSample sample;
+
+  simMicros = 0xFFFFFFFFu - 1000;
+  sonar.arm(simMicros);
+  simulateEcho(sonar, 400, 3000);
+  CHECK(sonar.fetch(simMicros, sample));
+  CHECK(sample.widthUs == 3000);
+
+  simMicros = 0xFFFFFFFFu - 1000;
+  sonar.arm(simMicros);
+  advance(SONAR_TIMEOUT_US);
+  CHECK(sonar.fetch(simMicros, sample));
+  CHECK(sample.widthUs == 0);
+}
+
+// Two channels pinged back to back never block: the loop keeps running
+// while both echoes are in flight.
+void testNonBlockingLoop() {
+  EchoCapture right(SONAR_TIMEOUT_US);
+  EchoCapture height(SONAR_TIMEOUT_US);
+  EchoSample sample;
+  int loopPasses = 0;
+
+  simMicros = 0;
+  right.arm(simMicros);
+  height.arm(simMicros);
+
+  bool gotRight = false, gotHeight = false;
+  while (!(gotRight && gotHeight)) {
+    loopPasses++;
+    if (simMicros == 500) { right.onEdge(true, simMicros); }
+    if (simMicros == 600) { height.onEdge(true, simMicros); }
+    if (simMicros == 500 + 8700) { right.onEdge(false, simMicros); }
+    if (gotRight == false && right.fetch(simMicros, sample)) {
+      gotRight = true;
+      CHECK(sample.widthUs == 8700);
+    }
+    if (gotHeight == false && height.fetch(simMicros, sample)) {
+      gotHeight = true;
+      CHECK(sample.widthUs == 0);        // Height never answered
+      CHECK(simMicros == SONAR_TIMEOUT_US);
+    }
+    advance(100);
+  }
+  CHECK(loopPasses > 100);
+}
+
+int main() {
+  testNormalEcho();
+  testTimeout();
+  testStaleEdgeAfterRearm();
+  testEdgesWhileIdleIgnored();
+  testMicrosWrap();
+  testNonBlockingLoop();
+
+  if (failures == 0) printf("EchoCapture: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
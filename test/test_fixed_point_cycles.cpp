@@ -0,0 +1,91 @@
+#include <Arduino.h>
+#include "SignalPath.h"
+
+// Cycle counts of each sensor -> rate -> servo stage, float vs Q16.
+// SysTick runs at the 48MHz core clock and reloads every 1ms, so each
+// measured block must stay well under 48000 cycles.
+
+const int REPEAT = 100;
+const int RATE_AVG_WINDOW_SIZE = 3;
+
+volatile uint32_t widthIn = 5800;
+volatile int targetIn = 900;
+
+uint32_t cyclesSince(uint32_t start) {
+  uint32_t now = SysTick->VAL;
+  uint32_t reload = SysTick->LOAD + 1;
+  return (start >= now) ? (start - now) : (start + reload - now);
+}
+
+template <typename T>
+void measure(const char* label) {
+  T prev = 100.0;
+  T current = 100.0;
+  T rate = 0.0;
+  int pwm = 1700;
+  RollingAverage<T, RATE_AVG_WINDOW_SIZE> smoother;
+  uint32_t start, convert = 0, filter = 0, rateCyc = 0, avg = 0, servo = 0;
+
+  for (int i = 0; i < REPEAT; i++) {
+    noInterrupts();
+
+    start = SysTick->VAL;
+    T raw = T(widthIn) / T(58.0);
+    convert += cyclesSince(start);
+
+    start = SysTick->VAL;
+    current = filterDistance(raw, current, T(0.70), T(60.0), T(-1.0));
+    filter += cyclesSince(start);
+
+    start = SysTick->VAL;
+    T rawRate = closureRate(current, prev, T(50UL) / T(1000.0));
+    rateCyc += cyclesSince(start);
+
+    start = SysTick->VAL;
+    rate = smoother.add(rawRate);
+    avg += cyclesSince(start);
+
+    start = SysTick->VAL;
+    pwm = smoothServo(targetIn, pwm, T(0.70));
+    servo += cyclesSince(start);
+
+    interrupts();
+    prev = current;
+  }
+
+  Serial.print(label);
+  Serial.print(",");
+  Serial.print(convert / REPEAT);
+  Serial.print(",");
+  Serial.print(filter / REPEAT);
+  Serial.print(",");
+  Serial.print(rateCyc / REPEAT);
+  Serial.print(",");
+  Serial.print(avg / REPEAT);
+  Serial.print(",");
+  Serial.print(servo / REPEAT);
+  Serial.print(",");
+  Serial.print((convert + filter + rateCyc + avg + servo) / REPEAT);
+  Serial.print("  (rate ");
+  Serial.print(toFloat(rate), 2);
+  Serial.print(", pwm ");
+  Serial.print(pwm);
+  Serial.println(")");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  Serial.println("========================================");
+  Serial.println("FIXED POINT CYCLE COUNT (per axis, per tick)");
+  Serial.println("========================================");
+  Serial.println("Type,Convert,Filter,Rate,RollingAvg,Servo,Total");
+}
+
+void loop() {
+  measure<float>("float");
+  measure<Q16>("Q16");
+  Serial.println();
+  delay(2000);
+}
@@ -0,0 +1,250 @@
+// Host-side equivalence test: Q16 vs float sensor -> rate -> servo path
+//   g++ -std=c++11 -O2 -Iinclude test/test_fixed_point_host.cpp -o fixed_test && ./fixed_test
+//
+// Stated tolerance of the Q16 build against the float build:
+//   low-pass path (filterDistance, closure rate, rolling average)
+//     filtered distance  +-0.01 cm
+//     averaged rate      +-0.10 cm/s
+//     servo command      +-1 us
+//   shipped path (Hampel filter, alpha-beta tracker on echo stamps)
+//     predicted distance +-0.01 cm
+//     tracker rate       +-1.0 cm/s
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SignalPath.h"
+#include "SpikeFilter.h"
+#include "StateEstimator.h"
+#include "TestCheck.h"
+
+const float DIST_TOL_CM = 0.01;
+const float RATE_TOL_CM_S = 0.10;
+const int   PWM_TOL_US = 1;
+const float TRACK_DIST_TOL_CM = 0.01;
+const float TRACK_RATE_TOL_CM_S = 1.0;
+
+const int RATE_AVG_WINDOW_SIZE = 3;
+
+// Mirrors the per-tick arithmetic of loop() for one axis
+template <typename T>
+struct AxisPipeline {
+  T current;
+  T prev;
+  T rate;
+  RollingAverage<T, RATE_AVG_WINDOW_SIZE> smoother;
+  int pwm;
+
+  AxisPipeline(float start) : current(start), prev(start), rate(0.0), pwm(1700) {}
+
+  void step(uint32_t widthUs, unsigned long elapsedMs, int target) {
+    const T noReading = -1.0;
+    T raw = widthUs == 0 ? noReading : T(widthUs) / T(58.0);
+    T dt = T(elapsedMs) / T(1000.0);
+
+    current = filterDistance(raw, current, T(0.70), T(60.0), noReading);
+    rate = smoother.add(closureRate(current, prev, dt));
+    prev = current;
+    pwm = smoothServo(target, pwm, T(0.70));
+  }
+};
+
+// Mirrors main.cpp's default path for one axis: Hampel spike filter, then
+// the tracker corrected over each echo's own interval and predicted to the
+// tick
+template <typename T>
+struct TrackerPipeline {
+  HampelFilter<T, 5> spikes;
+  AlphaBetaTracker<T> tracker;
+  uint32_t lastAtUs;
+  T predicted;
+
+  TrackerPipeline(float start)
+      : spikes(T(3.0), T(8.0), T(60.0)), tracker(T(0.70), T(0.35), 6), lastAtUs(0), predicted(start) {
+    tracker.reset(start);
+  }
+
+  void step(uint32_t widthUs, uint32_t echoAtUs, uint32_t tickUs) {
+    if (widthUs == 0) {
+      tracker.miss();
+    } else {
+      T clean = spikes.filter(T(widthUs) / T(58.0));
+      tracker.correct(clean, microsToSeconds<T>(echoAtUs - lastAtUs));
+      lastAtUs = echoAtUs;
+    }
+    predicted = tracker.predict(microsToSeconds<T>(tickUs - lastAtUs));
+  }
+};
+
+// ---------------------------------------------------------
+// Q16 primitives
+// ---------------------------------------------------------
+void testQ16Basics() {
+  CHECK(Q16(1).rawValue() == 65536);
+  CHECK(Q16(0.5).rawValue() == 32768);
+  CHECK(Q16(-1.5).rawValue() == -98304);
+  CHECK((Q16(3.0) * Q16(2.5)) == Q16(7.5));
+  CHECK((Q16(7.5) / Q16(2.5)) == Q16(3));
+  CHECK((Q16(1.5) * 2) == Q16(3));
+  CHECK((Q16(1.0) * 2.5) == Q16(2.5));    // Not truncated to * 2
+  CHECK((Q16(9) / 3) == Q16(3));
+  CHECK(toInt(Q16(1234.99)) == 1234);
+  CHECK(toInt(Q16(-2.7)) == -2);          // Truncates toward zero like (int)float
+  CHECK(fabs(toFloat(Q16(105.3)) - 105.3) < 1e-4);
+  CHECK(Q16(-3) < Q16(0));
+  CHECK(absValue(Q16(-4.25)) == Q16(4.25));
+
+  // Constants are folded at compile time
+  constexpr Q16 alpha = 0.70;
+  CHECK(alpha.rawValue() == 45875);
+
+  // Out of range saturates instead of wrapping
+  CHECK(Q16(40000) > Q16(32767));
+  CHECK(Q16(-40000) < Q16(-32767));
+  CHECK(Q16(40000L) > Q16(32767));
+  CHECK(Q16(100000ul) > Q16(32767));
+  CHECK(Q16(70000u) > Q16(0));
+  CHECK((Q16(30000) / Q16(0.5)) == Q16::fromRaw(INT32_MAX));
+  CHECK((Q16(5) / Q16(0)) == Q16::fromRaw(INT32_MAX));
+  CHECK((Q16(-5) / Q16(0)) == Q16::fromRaw(INT32_MIN));
+  CHECK((Q16(0) / Q16(0)) == Q16(0));
+  CHECK((Q16(5) / 0) == Q16::fromRaw(INT32_MAX));
+  CHECK((Q16::fromRaw(INT32_MIN) / -1) == Q16::fromRaw(INT32_MAX));
+}
+
+// ---------------------------------------------------------
+// Short intervals: Q16 seconds never read 0 for a nonzero interval, and a
+// zero interval gives no rate instead of a division by zero
+// ---------------------------------------------------------
+void testZeroInterval() {
+  CHECK(microsToSeconds<Q16>(0) == Q16(0));
+  CHECK(microsToSeconds<Q16>(5) > Q16(0));
+  CHECK(microsToSeconds<Q16>(14) > Q16(0));
+  CHECK(fabs(toFloat(microsToSeconds<Q16>(50000)) - 0.05) < 1e-4);
+  CHECK(microsToSeconds<float>(5) > 0);
+
+  CHECK(closureRate(Q16(90), Q16(100), Q16(0)) == Q16(0));
+  CHECK(closureRate(90.0f, 100.0f, 0.0f) == 0.0f);
+
+  AlphaBetaTracker<Q16> fx(Q16(0.70), Q16(0.35), 6);
+  AlphaBetaTracker<float> fl(0.70f, 0.35f, 6);
+  fx.reset(Q16(100));
+  fl.reset(100.0f);
+  fx.correct(Q16(90), Q16(0));
+  fl.correct(90.0f, 0.0f);
+  CHECK(fx.closureRate() == Q16(0));
+  CHECK(fl.closureRate() == 0.0f);
+  CHECK(fabs(toFloat(fx.distance()) - 93.0) < 0.01);
+  CHECK(fabs(fl.distance() - 93.0f) < 0.01f);
+}
+
+// ---------------------------------------------------------
+// Equivalence on a synthetic corridor approach
+// ---------------------------------------------------------
+void testEquivalence() {
+  srand(1234);
+  AxisPipeline<float> fl(150.0);
+  AxisPipeline<Q16> fx(150.0);
+
+  float worstDist = 0, worstRate = 0;
+  int worstPwm = 0;
+  const int STEPS = 20000;
+
+  for (int i = 0; i < STEPS; i++) {
+    // Wall closes from 150 to 25 cm and back, with noise, dropouts and spikes
+    float phase = (i % 400) / 400.0;
+    float truth = 25.0 + 125.0 * fabs(1.0 - 2.0 * phase);
+    float noise = ((rand() % 401) - 200) / 100.0;
+    int roll = rand() % 100;
+
+    uint32_t widthUs = (uint32_t)((truth + noise) * 58.0);
+    if (roll < 5) widthUs = 0;                        // Dropout
+    else if (roll < 8) widthUs = 390 * 58;            // Spike
+    unsigned long elapsedMs = 50 + rand() % 4;        // Loop jitter
+    int target = (i / 10) % 2 ? 900 : 1700;
+
+    fl.step(widthUs, elapsedMs, target);
+    fx.step(widthUs, elapsedMs, target);
+
+    float dDist = fabs(fl.current - toFloat(fx.current));
+    float dRate = fabs(fl.rate - toFloat(fx.rate));
+    int dPwm = abs(fl.pwm - fx.pwm);
+    if (dDist > worstDist) worstDist = dDist;
+    if (dRate > worstRate) worstRate = dRate;
+    if (dPwm > worstPwm) worstPwm = dPwm;
+  }
+
+  printf("Q16 vs float over %d ticks: |dist| %.5f cm, |rate| %.5f cm/s, |pwm| %d us\n",
+         STEPS, worstDist, worstRate, worstPwm);
+  CHECK(worstDist <= DIST_TOL_CM);
+  CHECK(worstRate <= RATE_TOL_CM_S);
+  CHECK(worstPwm <= PWM_TOL_US);
+}
+
+// Same approach through the Hampel filter and the tracker, on echo stamps
+// that jitter around a 50 ms tick
+void testTrackerEquivalence() {
+  srand(4321);
+  TrackerPipeline<float> fl(150.0);
+  TrackerPipeline<Q16> fx(150.0);
+
+  float worstDist = 0, worstRate = 0;
+  const int STEPS = 20000;
+  uint32_t tickUs = 0;
+
+  for (int i = 0; i < STEPS; i++) {
+    float phase = (i % 400) / 400.0;
+    float truth = 25.0 + 125.0 * fabs(1.0 - 2.0 * phase);
+    float noise = ((rand() % 401) - 200) / 100.0;
+    int roll = rand() % 100;
+
+    uint32_t widthUs = (uint32_t)((truth + noise) * 58.0);
+    if (roll < 5) widthUs = 0;
+    else if (roll < 8) widthUs = 390 * 58;
+    tickUs += 50000 + rand() % 4000;
+    uint32_t echoAtUs = tickUs - 30000 + rand() % 20000;
+
+    fl.step(widthUs, echoAtUs, tickUs);
+    fx.step(widthUs, echoAtUs, tickUs);
+
+    float dDist = fabs(fl.predicted - toFloat(fx.predicted));
+    float dRate = fabs(fl.tracker.closureRate() - toFloat(fx.tracker.closureRate()));
+    if (dDist > worstDist) worstDist = dDist;
+    if (dRate > worstRate) worstRate = dRate;
+  }
+
+  printf("Q16 vs float, Hampel + tracker over %d ticks: |dist| %.5f cm, |rate| %.5f cm/s\n",
+         STEPS, worstDist, worstRate);
+  CHECK(worstDist <= TRACK_DIST_TOL_CM);
+  CHECK(worstRate <= TRACK_RATE_TOL_CM_S);
+}
+
+// ---------------------------------------------------------
+// Host timing (relative only; the M0+ has no FPU, see
+// test_fixed_point_cycles.cpp for on-target cycle counts)
+// ---------------------------------------------------------
+template <typename T>
+double timePipeline(int steps) {
+  AxisPipeline<T> p(100.0);
+  clock_t start = clock();
+  for (int i = 0; i < steps; i++) {
+    p.step(5800 + (i % 64), 50, (i & 8) ? 900 : 1700);
+  }
+  clock_t end = clock();
+  volatile int sink = p.pwm;
+  (void)sink;
+  return (double)(end - start) * 1e9 / CLOCKS_PER_SEC / steps;
+}
+
+int main() {
+  testQ16Basics();
+  testZeroInterval();
+  testEquivalence();
+  testTrackerEquivalence();
+
+  const int STEPS = 2000000;
+  printf("Host ns/tick: float %.1f, Q16 %.1f\n", timePipeline<float>(STEPS), timePipeline<Q16>(STEPS));
+
+  if (failures == 0) printf("FixedPoint: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
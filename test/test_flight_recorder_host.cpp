@@ -0,0 +1,319 @@
+// Host-side tests for FlightRecorder on an emulated SAMD21 flash: records
+// round trip, the commit fitting between control ticks, slot rotation,
+// power loss mid-commit, erase
+//   g++ -std=c++11 -O2 -Iinclude test/test_flight_recorder_host.cpp -o recorder_test && ./recorder_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "FlightRecorder.h"
+#include "TestCheck.h"
+
+// ---------------------------------------------------------
+// Flash emulator: 64-byte pages, 256-byte rows, erase sets a row to 0xFF,
+// a page write can only clear bits (writing over data that isn't erased
+// is counted as an error). Each operation adds its worst-case time to
+// busyUs. `opsLeft` cuts the power after that many operations.
+// ---------------------------------------------------------
+class FlashEmulator {
+  public:
+    static const uint32_t PAGE_BYTES = 64;
+    static const uint32_t ROW_BYTES = 256;
+    static const uint32_t ERASE_US = 6000;
+    static const uint32_t WRITE_US = 2500;
+
+    uint32_t base;
+    std::vector<uint8_t> mem;
+    std::vector<int> rowErases;
+    int errors;
+    int ops;
+    uint64_t busyUs;
+    int opsLeft;                 // -1: no power loss
+
+    FlashEmulator(uint32_t baseAddr, uint32_t size)
+      : base(baseAddr), mem(size, 0x00), rowErases(size / ROW_BYTES, 0),
+        errors(0), ops(0), busyUs(0), opsLeft(-1) {
+      // Factory state is erased; start from leftover data instead
+      for (size_t i = 0; i < mem.size(); i++) mem[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    bool powered() {
+      if (opsLeft == 0) return false;
+      if (opsLeft > 0) opsLeft--;
+      return true;
+    }
+
+    void eraseRow(uint32_t addr) {
+      if (!powered()) return;
+      uint32_t off = addr - base;
+      if (off % ROW_BYTES || off >= mem.size()) { errors++; return; }
+      memset(&mem[off], 0xFF, ROW_BYTES);
+      rowErases[off / ROW_BYTES]++;
+      ops++;
+      busyUs += ERASE_US;
+    }
+
+    void writePage(uint32_t addr, const uint32_t *words) {
+      if (!powered()) return;
+      uint32_t off = addr - base;
+      if (off % PAGE_BYTES || off >= mem.size()) { errors++; return; }
+      const uint8_t *src = (const uint8_t *)words;
+      for (uint32_t i = 0; i < PAGE_BYTES; i++) {
+        if (mem[off + i] != 0xFF) errors++;
+        mem[off + i] &= src[i];
+      }
+      ops++;
+      busyUs += WRITE_US;
+    }
+
+    void read(uint32_t addr, void *out, uint32_t len) const {
+      memcpy(out, &mem[addr - base], len);
+    }
+};
+
+const uint32_t BASE = 0x3A000;
+const int SLOTS = 4;
+const int RECORDS = 252;
+typedef FlightRecorder<FlashEmulator, RECORDS> Recorder;
+
+const uint32_t PERIOD_US = 50000;       // Control tick
+const uint32_t CONTROL_BUSY_US = 4000;  // Release to end of the control task
+const uint32_t POLL_US = 5000;          // Recorder task period
+const uint32_t MARGIN_US = 1000;        // As main.cpp
+const uint32_t SLOT_US = 25000;         // Right ping at the release, height ping a slot later
+const uint32_t LISTEN_US = 12500;       // Widest echo window after each ping
+
+TelemetrySample sampleFor(int flight, int k) {
+  TelemetrySample s = TelemetrySample();
+  s.timeMs = 50 * k;
+  s.rightMm = (int16_t)(450 + k * 3 - flight);
+  s.heightMm = (int16_t)(1050 - k * 2);
+  s.rateRightMmS = (int16_t)(-300 + k * 5);
+  s.rateHeightMmS = (int16_t)(flight * 10 - k);
+  s.rudderUs = (uint16_t)(1700 - k);
+  s.elevatorUs = (uint16_t)(1100 + k + flight);
+  s.rightEchoUs = (uint16_t)(2610 + k * 2);
+  s.rightEchoAtUs = (uint16_t)(2840 + k * 2 + flight);
+  s.heightEchoUs = (uint16_t)((k % 7) ? 6090 - k : 0);
+  s.heightEchoAtUs = (uint16_t)((k % 7) ? 6320 - k : 0);
+  s.flags = (uint8_t)(TELEM_FLIGHT | (k & TELEM_RUDDER_WRITE));
+  return s;
+}
+
+// Runs the commit the way main.cpp schedules it: a control task at every
+// release, the recorder polled in between with the time left before the
+// next release or ping, and nothing while an echo window is open. Returns
+// the control periods it took; counts any flash operation still running at
+// a release or inside an echo window.
+struct CommitRun {
+  int periods;
+  int lateReleases;
+  int stalledEchoes;
+  uint32_t maxOpsPerPeriod;
+};
+
+CommitRun commitBetweenTicks(Recorder &rec, FlashEmulator &flash) {
+  CommitRun r = { 0, 0, 0, 0 };
+  uint64_t release = 0;
+  while (rec.status() == Recorder::COMMITTING || rec.status() == Recorder::ERASING) {
+    uint64_t next = release + PERIOD_US;
+    uint64_t height = release + SLOT_US;
+    uint64_t t = release + CONTROL_BUSY_US;
+    uint32_t opsThisPeriod = 0;
+    for (uint64_t poll = t; poll < next; poll += POLL_US) {
+      if (poll < t) continue;                   // Still inside the last operation
+      // SonarScheduler::quietUs()
+      bool listening = poll < release + LISTEN_US || (poll >= height && poll < height + LISTEN_US);
+      uint64_t ping = poll < height ? height : next;
+      uint32_t left = listening ? 0 : (uint32_t)(ping - poll);
+      uint64_t before = flash.busyUs;
+      if (!rec.step(left > MARGIN_US ? left - MARGIN_US : 0)) continue;
+      t = poll + (flash.busyUs - before);
+      if (flash.busyUs != before) opsThisPeriod++;
+      if (t > next) r.lateReleases++;
+      if (poll < height + LISTEN_US && t > height) r.stalledEchoes++;
+    }
+    if (opsThisPeriod > r.maxOpsPerPeriod) r.maxOpsPerPeriod = opsThisPeriod;
+    release = next;
+    r.periods++;
+  }
+  return r;
+}
+
+void fly(Recorder &rec, int flight, int ticks) {
+  rec.start();
+  for (int k = 0; k < ticks; k++) rec.record(sampleFor(flight, k));
+  rec.finish();
+}
+
+bool flightMatches(const Recorder &rec, int slot, int flight, int ticks) {
+  RecorderHeader h;
+  if (!rec.readHeader(slot, h) || h.records != ticks) return false;
+  for (int k = 0; k < ticks; k++) {
+    TelemetrySample s, e = sampleFor(flight, k);
+    rec.readRecord(slot, k, s);
+    if (s.timeMs != e.timeMs || s.rightMm != e.rightMm || s.heightMm != e.heightMm ||
+        s.rateRightMmS != e.rateRightMmS || s.rateHeightMmS != e.rateHeightMmS ||
+        s.rudderUs != e.rudderUs || s.elevatorUs != e.elevatorUs || s.rightEchoUs != e.rightEchoUs ||
+        s.rightEchoAtUs != e.rightEchoAtUs || s.heightEchoUs != e.heightEchoUs ||
+        s.heightEchoAtUs != e.heightEchoAtUs || s.flags != e.flags) {
+      return false;
+    }
+  }
+  return rec.verify(slot);
+}
+
+// ---------------------------------------------------------
+// 1. One 5 s flight: nothing touches flash while recording, the commit
+//    stays out of the control ticks, the records read back
+// ---------------------------------------------------------
+void testOneFlight() {
+  FlashEmulator flash(BASE, SLOTS * Recorder::SLOT_BYTES);
+  Recorder rec(flash, BASE, SLOTS);
+  rec.begin();
+  CHECK(rec.newest() < 0);                      // Leftover data is not a flight
+
+  rec.start();
+  for (int k = 0; k < 100; k++) rec.record(sampleFor(1, k));
+  CHECK(flash.ops == 0);
+  rec.finish();
+  CHECK(rec.status() == Recorder::COMMITTING);
+
+  CommitRun run = commitBetweenTicks(rec, flash);
+  printf("Commit of a %u-byte slot: %d flash ops (%.0f ms busy) over %d control periods, "
+         "at most %u per period, %d late releases, %d in echo windows\n",
+         (unsigned)Recorder::SLOT_BYTES, flash.ops, flash.busyUs / 1000.0, run.periods,
+         (unsigned)run.maxOpsPerPeriod, run.lateReleases, run.stalledEchoes);
+  printf("  in one go it would hold the CPU %.0f ms, %d control ticks\n",
+         flash.busyUs / 1000.0, (int)(flash.busyUs / PERIOD_US));
+  CHECK(run.lateReleases == 0);
+  CHECK(run.stalledEchoes == 0);
+  CHECK(flash.errors == 0);
+  CHECK(rec.status() == Recorder::IDLE);
+  CHECK(rec.newest() == 0);
+  CHECK(flightMatches(rec, 0, 1, 100));
+
+  RecorderHeader h;
+  CHECK(rec.readHeader(0, h) && h.flight == 1 && h.truncated == 0);
+
+  // A fresh boot finds it
+  Recorder again(flash, BASE, SLOTS);
+  again.begin();
+  CHECK(again.newest() == 0);
+}
+
+// ---------------------------------------------------------
+// 2. Filling the image ends the recording and commits it
+// ---------------------------------------------------------
+void testFull() {
+  FlashEmulator flash(BASE, SLOTS * Recorder::SLOT_BYTES);
+  Recorder rec(flash, BASE, SLOTS);
+  rec.begin();
+  rec.start();
+  for (int k = 0; k < RECORDS + 30; k++) rec.record(sampleFor(2, k));
+  CHECK(rec.status() == Recorder::COMMITTING);
+  rec.finish();                                 // Landing afterwards: no effect
+  commitBetweenTicks(rec, flash);
+  RecorderHeader h;
+  CHECK(rec.readHeader(0, h) && h.records == RECORDS && h.truncated == 1);
+  CHECK(flightMatches(rec, 0, 2, RECORDS));
+  CHECK(flash.errors == 0);
+}
+
+// ---------------------------------------------------------
+// 3. Six flights in four slots: the newest four survive, wear spreads
+// ---------------------------------------------------------
+void testRotation() {
+  FlashEmulator flash(BASE, SLOTS * Recorder::SLOT_BYTES);
+  Recorder rec(flash, BASE, SLOTS);
+  rec.begin();
+  for (int f = 1; f <= 6; f++) {
+    fly(rec, f, 40 + f * 10);
+    commitBetweenTicks(rec, flash);
+  }
+  CHECK(flash.errors == 0);
+  for (int f = 3; f <= 6; f++) {
+    int slot = (f - 1) % SLOTS;
+    RecorderHeader h;
+    CHECK(rec.readHeader(slot, h) && (int)h.flight == f);
+    CHECK(flightMatches(rec, slot, f, 40 + f * 10));
+  }
+  CHECK(rec.newest() == 1);
+  int minErase = 1 << 30, maxErase = 0;
+  for (size_t i = 0; i < flash.rowErases.size(); i++) {
+    if (flash.rowErases[i] < minErase) minErase = flash.rowErases[i];
+    if (flash.rowErases[i] > maxErase) maxErase = flash.rowErases[i];
+  }
+  CHECK(minErase == 1 && maxErase == 2);
+}
+
+// ---------------------------------------------------------
+// 4. Power lost mid-commit: that flight is gone, the others are intact,
+//    and the next flight reuses the slot
+// ---------------------------------------------------------
+void testPowerLoss() {
+  FlashEmulator flash(BASE, SLOTS * Recorder::SLOT_BYTES);
+  {
+    Recorder rec(flash, BASE, SLOTS);
+    rec.begin();
+    fly(rec, 1, 80);
+    commitBetweenTicks(rec, flash);
+    fly(rec, 2, 80);
+    flash.opsLeft = 50;                         // Dies before the header is written
+    commitBetweenTicks(rec, flash);
+  }
+  flash.opsLeft = -1;
+
+  Recorder rec(flash, BASE, SLOTS);
+  rec.begin();
+  RecorderHeader h;
+  CHECK(!rec.readHeader(1, h));
+  CHECK(rec.newest() == 0);
+  CHECK(flightMatches(rec, 0, 1, 80));
+
+  fly(rec, 2, 60);
+  commitBetweenTicks(rec, flash);
+  CHECK(rec.newest() == 1);
+  CHECK(rec.readHeader(1, h) && h.flight == 2);
+  CHECK(flightMatches(rec, 1, 2, 60));
+  CHECK(flash.errors == 0);
+}
+
+// ---------------------------------------------------------
+// 5. Erase all, also spread between ticks
+// ---------------------------------------------------------
+void testEraseAll() {
+  FlashEmulator flash(BASE, SLOTS * Recorder::SLOT_BYTES);
+  Recorder rec(flash, BASE, SLOTS);
+  rec.begin();
+  fly(rec, 1, 50);
+  commitBetweenTicks(rec, flash);
+
+  rec.eraseAll();
+  CommitRun run = commitBetweenTicks(rec, flash);
+  CHECK(run.lateReleases == 0);
+  RecorderHeader h;
+  for (int s = 0; s < SLOTS; s++) CHECK(!rec.readHeader(s, h));
+  CHECK(rec.newest() < 0);
+  bool erased = true;
+  for (size_t i = 0; i < flash.mem.size(); i++) {
+    if (flash.mem[i] != 0xFF) erased = false;
+  }
+  CHECK(erased);
+
+  // Recording is never interrupted by an erase request
+  rec.start();
+  rec.eraseAll();
+  CHECK(rec.status() == Recorder::RECORDING);
+}
+
+int main() {
+  testOneFlight();
+  testFull();
+  testRotation();
+  testPowerLoss();
+  testEraseAll();
+
+  if (failures == 0) printf("FlightRecorder: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
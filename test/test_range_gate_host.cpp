@@ -0,0 +1,134 @@
+// Host-side test for RangeGate + SonarScheduler windowing (no board needed)
+//   g++ -std=c++11 -Iinclude test/test_range_gate_host.cpp -o gate_test && ./gate_test
+#include <stdio.h>
+#include "RangeGate.h"
+#include "SonarScheduler.h"
+#include "TestCheck.h"
+
+const uint32_t SONAR_TIMEOUT_US = 30000;
+const uint32_t LISTEN_US = 12500;
+const uint32_t BURST_US = 500;
+const uint32_t MIN_US = 3000;
+const uint32_t SLOT_US = 12500;
+
+RangeGate makeGate() {
+  return RangeGate(30.0, 0.10, BURST_US, MIN_US, LISTEN_US, SONAR_TIMEOUT_US, 3);
+}
+
+void testOpenUntilAcquired() {
+  RangeGate gate = makeGate();
+  CHECK(gate.windowUs(100.0, 0.0) == LISTEN_US);
+  gate.record(true);
+  CHECK(gate.tracking());
+  CHECK(gate.windowUs(100.0, 0.0) < LISTEN_US);
+}
+
+void testWindowFollowsRangeAndRate() {
+  RangeGate gate = makeGate();
+  gate.record(true);
+
+  // 100 cm + 30 cm margin, no motion: 130 * 58 + 500
+  CHECK(gate.windowUs(100.0, 0.0) == 130 * 58 + BURST_US);
+
+  // Either sign of rate widens the window by |rate| * horizon
+  uint32_t closing = gate.windowUs(100.0, 100.0);
+  uint32_t opening = gate.windowUs(100.0, -100.0);
+  CHECK(closing == opening);
+  CHECK(closing == 140 * 58 + BURST_US);
+
+  // Clamped at both ends
+  CHECK(gate.windowUs(2.0, 0.0) == MIN_US);
+  CHECK(gate.windowUs(400.0, 0.0) == LISTEN_US);
+}
+
+void testReopensAfterMisses() {
+  RangeGate gate = makeGate();
+  gate.record(true);
+  gate.record(false);
+  gate.record(false);
+  CHECK(gate.tracking());
+  gate.record(false);
+  CHECK(!gate.tracking());
+  CHECK(gate.windowUs(50.0, 0.0) == LISTEN_US);
+  gate.record(true);
+  CHECK(gate.windowUs(50.0, 0.0) < LISTEN_US);
+}
+
+void testSavingsReported() {
+  RangeGate gate = makeGate();
+  gate.record(true);
+  for (int i = 0; i < 10; i++) gate.windowUs(105.0, 20.0);
+  uint32_t window = (uint32_t)((105.0 + 2.0 + 30.0) * 58 + BURST_US);
+  printf("Height at 105 cm: window %lu us, saved %lu us per ping vs %lu us timeout\n",
+         (unsigned long)window, (unsigned long)gate.meanSavedUs(), (unsigned long)SONAR_TIMEOUT_US);
+  CHECK(gate.meanSavedUs() == SONAR_TIMEOUT_US - window);
+  gate.resetStats();
+  CHECK(gate.meanSavedUs() == 0);
+}
+
+// ---------------------------------------------------------
+// Scheduler integration: a far multipath echo becomes a miss
+// ---------------------------------------------------------
+EchoCapture captureA(SONAR_TIMEOUT_US);
+EchoCapture captureB(SONAR_TIMEOUT_US);
+uint32_t simMicros = 0;
+uint32_t echoWidthUs = 0;
+uint32_t riseAt = 0, fallAt = 0;
+bool pendingEcho = false;
+
+bool simTrigger(int ch) {
+  if (ch == 0) {
+    captureA.arm(simMicros);
+    riseAt = simMicros + 450;
+    fallAt = riseAt + echoWidthUs;
+    pendingEcho = true;
+  } else {
+    captureB.arm(simMicros);              // Channel B never answers
+  }
+  return true;
+}
+
+void testMultipathGatedOut() {
+  SonarScheduler sched(captureA, captureB, simTrigger, SLOT_US, LISTEN_US, SLOT_US);
+  sched.start(0);
+
+  // Wall is at 80 cm; gate window sized for it
+  RangeGate gate = makeGate();
+  gate.record(true);
+  sched.setListenWindow(0, gate.windowUs(80.0, 0.0));
+  sched.setListenWindow(1, MIN_US);        // Keep B's window clear of A's echoes
+
+  // First ping: a 250 cm multipath return instead of the wall
+  echoWidthUs = 250 * 58;
+  for (simMicros = 0; simMicros < 20000; simMicros += 10) {
+    if (pendingEcho && simMicros == riseAt) captureA.onEdge(true, simMicros);
+    if (pendingEcho && simMicros == fallAt) { captureA.onEdge(false, simMicros); pendingEcho = false; }
+    sched.update(simMicros);
+  }
+  CHECK(sched.channelStats(0).valid == 0);
+  CHECK(sched.channelStats(0).timeouts == 1);
+  CHECK(sched.listenWindow(0) == 110 * 58 + BURST_US);
+
+  // Next ping: the wall answers inside the window
+  echoWidthUs = 80 * 58;
+  for (; simMicros < 40000; simMicros += 10) {
+    if (pendingEcho && simMicros == riseAt) captureA.onEdge(true, simMicros);
+    if (pendingEcho && simMicros == fallAt) { captureA.onEdge(false, simMicros); pendingEcho = false; }
+    sched.update(simMicros);
+  }
+  CHECK(sched.channelStats(0).valid == 1);
+  EchoSample sample;
+  CHECK(sched.take(0, sample));
+  CHECK(sample.widthUs == 80 * 58);
+}
+
+int main() {
+  testOpenUntilAcquired();
+  testWindowFollowsRangeAndRate();
+  testReopensAfterMisses();
+  testSavingsReported();
+  testMultipathGatedOut();
+
+  if (failures == 0) printf("RangeGate: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
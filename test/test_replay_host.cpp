@@ -0,0 +1,197 @@
+// Host-side tests for the flight replay harness: logs read back by header
+// name, src/main.cpp flying them on the Linux HAL, golden logs re-replaying
+// exactly, a changed pulse caught, every flight starting from the same
+// board, simulated flights replayed exactly from their telemetry, and the
+// replay rate
+//   g++ -std=c++11 -O2 -Iinclude test/test_replay_host.cpp -o replay_test && ./replay_test
+#define PROFILE_STAGES 0
+#include "../src/main.cpp"
+#include "../tools/replay/Replay.h"
+#include "../tools/sim/CorridorSim.h"
+#include <chrono>
+#include "TestCheck.h"
+
+// A 4s glide at the control rate: height sinking 110 -> 70cm, the wall
+// closing from 120cm to `closestCm` over the first 1.5s
+void writeFlight(FILE *out, const char *name, float closestCm) {
+  fprintf(out, "# %s\n", name);
+  fprintf(out, "time_s,right_cm,height_cm\n");
+  for (int i = 0; i < 80; i++) {
+    float t = i * 0.05f;
+    float k = t < 1.5f ? t / 1.5f : 1.0f;
+    fprintf(out, "%.3f,%.1f,%.1f\n", t, 120.0f + (closestCm - 120.0f) * k, 110.0f - 10.0f * t);
+  }
+}
+
+int maxDeflection(const ReplayResult &r) {
+  int worst = 0;
+  for (size_t i = 0; i < r.rudderUs.size(); i++) {
+    int d = abs(r.rudderUs[i] - SERVO_RUDDER_NEUTRAL);
+    if (d > worst) worst = d;
+  }
+  return worst;
+}
+
+bool samePulses(const ReplayResult &a, const ReplayResult &b) {
+  return a.rudderUs == b.rudderUs && a.elevatorUs == b.elevatorUs;
+}
+
+// A telemetry capture as tools/telemetry_decode's CSV (the columns the
+// replay reads)
+void writeDecoded(FILE *out, const std::string &capture) {
+  fprintf(out, "seq,time_s,right_cm,height_cm,rudder_us,elevator_us,"
+               "right_echo_us,right_echo_at_us,height_echo_us,height_echo_at_us,flight,sensor_test\n");
+  TelemetryParser fixed;
+  DeltaParser delta;
+  TelemetrySample s;
+  uint8_t seq;
+  for (size_t i = 0; i < capture.size(); i++) {
+    uint8_t b = (uint8_t)capture[i];
+    bool got = fixed.feed(b, s, seq);
+    if (delta.feed(b, s, seq)) got = true;
+    if (!got) continue;
+    fprintf(out, "%u,%.3f,%.1f,%.1f,%u,%u,%u,%u,%u,%u,%d,%d\n", seq, s.timeMs / 1000.0,
+            s.rightMm / 10.0, s.heightMm / 10.0, s.rudderUs, s.elevatorUs,
+            s.rightEchoUs, s.rightEchoAtUs, s.heightEchoUs, s.heightEchoAtUs,
+            (s.flags & TELEM_FLIGHT) != 0, (s.flags & TELEM_SENSOR_TEST) != 0);
+  }
+}
+
+int main() {
+  ReplayEngine engine;
+
+  // ---------------------------------------------------------
+  // 1. Log reading: '#' lines name flights, ground rows skipped
+  // ---------------------------------------------------------
+  const char *logPath = "replay_test_flights.csv";
+  FILE *log = fopen(logPath, "w");
+  writeFlight(log, "steady", 120.0f);
+  writeFlight(log, "wall", 30.0f);
+  fprintf(log, "time_s,flight,right_cm,height_cm,rudder_us,elevator_us\n");
+  fprintf(log, "0.000,0,120.0,5.0,1500,1500\n");      // On the ground
+  fprintf(log, "0.050,1,120.0,110.0,1500,1500\n");
+  fprintf(log, "0.100,1,120.0,109.0,1500,1500\n");
+  fprintf(log, "0.050,1,120.0,110.0,1500,1500\n");    // Step back: next flight
+  fclose(log);
+
+  std::vector<ReplayFlight> flights;
+  std::string error;
+  CHECK(loadReplayLog(logPath, flights, error));
+  CHECK(flights.size() == 4);
+  CHECK(flights[0].name == "steady" && flights[0].rows.size() == 80);
+  CHECK(flights[1].name == "wall" && flights[1].rows[0].rudderUs == -1);
+  CHECK(flights[2].rows.size() == 2 && flights[2].rows[0].timeS == 0.05f);
+  CHECK(flights[2].rows[1].rudderUs == 1500 && flights[3].rows.size() == 1);
+  CHECK(!loadReplayLog("replay_test_missing.csv", flights, error) && !error.empty());
+  remove(logPath);
+
+  // ---------------------------------------------------------
+  // 2. The control code flies the logs
+  // ---------------------------------------------------------
+  ReplayResult steady, wall;
+  engine.replay(flights[0], steady);
+  engine.replay(flights[1], wall);
+  printf("Rudder deflection: steady %d us, wall at 30cm %d us\n", maxDeflection(steady), maxDeflection(wall));
+  CHECK(steady.launched && wall.launched);
+  CHECK(steady.compared == 0 && steady.mismatched == 0);
+  CHECK(steady.rudderUs.size() == 80);
+  CHECK(maxDeflection(wall) > maxDeflection(steady) + 100);
+
+  // ---------------------------------------------------------
+  // 3. Golden log: re-replays exactly; one changed pulse is caught
+  // ---------------------------------------------------------
+  const char *goldenPath = "replay_test_golden.csv";
+  FILE *golden = fopen(goldenPath, "w");
+  writeReplayLog(golden, flights[1], wall);
+  fclose(golden);
+  std::vector<ReplayFlight> goldens;
+  CHECK(loadReplayLog(goldenPath, goldens, error) && goldens.size() == 1);
+  remove(goldenPath);
+
+  ReplayResult again;
+  engine.replay(goldens[0], again);
+  CHECK(again.compared == 80);
+  CHECK(again.mismatched == 0 && again.maxDiffUs == 0 && again.firstMismatch == -1);
+
+  goldens[0].rows[40].rudderUs += 7;
+  engine.replay(goldens[0], again);
+  CHECK(again.mismatched == 1 && again.firstMismatch == 40 && again.maxDiffUs == 7);
+  engine.replay(goldens[0], again, 7);
+  CHECK(again.mismatched == 0);
+
+  // ---------------------------------------------------------
+  // 4. Every flight starts from a fresh board
+  // ---------------------------------------------------------
+  ReplayResult first, last;
+  engine.replay(flights[0], first);
+  engine.replay(flights[1], again);
+  engine.replay(flights[0], last);
+  CHECK(samePulses(first, steady));
+  CHECK(samePulses(last, steady));
+
+  // ---------------------------------------------------------
+  // 5. Raw logs: the lost frame keeps its tick, sensor test rows apart
+  // ---------------------------------------------------------
+  const char *rawPath = "replay_test_raw.csv";
+  FILE *rawLog = fopen(rawPath, "w");
+  fprintf(rawLog, "seq,time_s,right_cm,height_cm,rudder_us,elevator_us,"
+                  "right_echo_us,right_echo_at_us,height_echo_us,height_echo_at_us,flight,sensor_test\n");
+  fprintf(rawLog, "254,0.000,120.0,110.0,0,0,6960,7200,6380,6620,0,1\n");
+  fprintf(rawLog, "255,0.000,120.0,110.0,1500,1500,0,0,0,0,0,0\n");
+  fprintf(rawLog, "0,0.000,120.0,110.0,1500,1500,6960,7200,6380,6620,0,0\n");
+  fprintf(rawLog, "3,0.100,120.0,109.0,1500,1500,6960,7200,6322,6562,1,0\n");
+  fprintf(rawLog, "4,0.000,120.0,110.0,0,0,6960,7200,6380,6620,0,1\n");   // Restarted
+  fclose(rawLog);
+  std::vector<ReplayFlight> raws;
+  CHECK(loadReplayLog(rawPath, raws, error) && raws.size() == 2);
+  remove(rawPath);
+  CHECK(raws[0].raw && raws[0].sensorTest.size() == 1 && raws[0].rows.size() == 5);
+  CHECK(raws[0].rows[2].rudderUs == -1 && raws[0].rows[3].heightEchoUs == 0);
+  CHECK(raws[0].rows[4].heightEchoUs == 6322);
+  CHECK(raws[1].sensorTest.size() == 1 && raws[1].rows.empty());
+
+  // ---------------------------------------------------------
+  // 6. Simulated flights, streamed from power-on, replay exactly from
+  //    their telemetry
+  // ---------------------------------------------------------
+  SimConfig cfg = defaultSimConfig();
+  CorridorSimEngine sim;
+  const int SIM_FLIGHTS = 10;
+  int exact = 0, rows = 0;
+  for (int f = 0; f < SIM_FLIGHTS; f++) {
+    SimResult flown;
+    std::string capture;
+    CHECK(sim.fly(cfg, 500 + f, flown, NULL, NULL, &capture));
+    const char *streamPath = "replay_test_stream.csv";
+    FILE *stream = fopen(streamPath, "w");
+    writeDecoded(stream, capture);
+    fclose(stream);
+    std::vector<ReplayFlight> logged;
+    CHECK(loadReplayLog(streamPath, logged, error) && logged.size() == 1);
+    remove(streamPath);
+    if (logged.size() != 1) continue;
+    CHECK(logged[0].raw && logged[0].sensorTest.size() == 5);
+
+    ReplayResult replayed;
+    CHECK(engine.replay(logged[0], replayed));
+    CHECK(replayed.launched == flown.launched);
+    CHECK(replayed.compared == (int)logged[0].rows.size());
+    if (replayed.mismatched == 0) exact++;
+    else printf("Seed %d diverges at row %d by up to %d us\n", 500 + f, replayed.firstMismatch, replayed.maxDiffUs);
+    rows += replayed.compared;
+  }
+  printf("Simulated flights replayed from telemetry: %d/%d exact over %d ticks\n", exact, SIM_FLIGHTS, rows);
+  CHECK(exact == SIM_FLIGHTS);
+
+  // ---------------------------------------------------------
+  // 7. Replay rate (reported, not checked: it depends on the machine)
+  // ---------------------------------------------------------
+  const int RUNS = 200;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < RUNS; i++) engine.replay(flights[i & 1], again);
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("Replay: %.0f 4s flights/s, %.0fx real time, one process per flight\n", RUNS / sec, RUNS * 4.0 / sec);
+
+  if (failures == 0) printf("Replay: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+// Host-side test: rate from per-echo time stamps vs loop dt under timing jitter
+//   g++ -std=c++11 -O2 -Iinclude test/test_sample_timing_host.cpp -o timing_test && ./timing_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "SonarScheduler.h"
+#include "SignalPath.h"
+#include "StateEstimator.h"
+#include "TestCheck.h"
+
+// Same settings as main.cpp
+const uint32_t SLOT_US = 12500;
+const uint32_t LISTEN_US = 12500;
+const uint32_t TIMEOUT_US = 30000;
+const uint32_t LOOP_PERIOD_US = 50000;
+const float US_PER_CM = 58.0;
+const float DIST_FILTER_ALPHA = 0.70;
+const int   RATE_AVG_WINDOW_SIZE = 3;
+const float TRACKER_ALPHA = 0.70;
+const float TRACKER_BETA = 0.35;
+const int   TRACKER_MAX_COAST = 6;
+
+const uint32_t BURST_DELAY_US = 450;
+const uint32_t STEP_US = 10;
+const float START_CM = 200.0;
+const float CLOSING_CM_S = 80.0;
+
+float gaussian() {
+  float u1 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+  float u2 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+  return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+// ---------------------------------------------------------
+// Simulated approach: one sensor closing at CLOSING_CM_S, the other idle
+// ---------------------------------------------------------
+EchoCapture captureA(TIMEOUT_US);
+EchoCapture captureB(TIMEOUT_US);
+EchoCapture* captures[SONAR_CHANNELS] = { &captureA, &captureB };
+
+uint32_t simMicros = 0;
+uint32_t riseAt[SONAR_CHANNELS];
+uint32_t fallAt[SONAR_CHANNELS];
+bool pendingRise[SONAR_CHANNELS];
+bool pendingFall[SONAR_CHANNELS];
+float noiseCm = 0.0;
+
+float truthCm(uint32_t us) {
+  return START_CM - CLOSING_CM_S * us / 1e6;
+}
+
+bool simTrigger(int ch) {
+  captures[ch]->arm(simMicros);
+  float dist = ch == 0 ? truthCm(simMicros + BURST_DELAY_US) : 100.0;
+  uint32_t width = (uint32_t)((dist + noiseCm * gaussian()) * US_PER_CM);
+  riseAt[ch] = simMicros + BURST_DELAY_US;
+  fallAt[ch] = riseAt[ch] + width;
+  pendingRise[ch] = true;
+  pendingFall[ch] = true;
+  return true;
+}
+
+void stepEdges() {
+  for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+    if (pendingRise[ch] && simMicros >= riseAt[ch]) {
+      captures[ch]->onEdge(true, simMicros);
+      pendingRise[ch] = false;
+    }
+    if (pendingFall[ch] && simMicros >= fallAt[ch]) {
+      captures[ch]->onEdge(false, simMicros);
+      pendingFall[ch] = false;
+    }
+  }
+}
+
+// Rate error statistics for each estimator, with loop dt and with stamps
+struct Stats {
+  double sum;
+  double sq;
+  int n;
+  void add(float err) { sum += err; sq += err * err; n++; }
+  double stddev() const {
+    double var = sq / n - (sum / n) * (sum / n);
+    return var > 0 ? sqrt(var) : 0.0;
+  }
+};
+
+const int EST_RAW = 0;       // Bare difference quotient
+const int EST_CHAIN = 1;     // EMA + difference + 3-sample average
+const int EST_TRACKER = 2;   // Alpha-beta tracker
+const char* EST_NAMES[] = { "difference", "EMA+diff+avg3", "alpha-beta" };
+
+struct Axis {
+  bool stamped;
+  float current;
+  float prev;
+  uint32_t lastAtUs;
+  RollingAverage<float, RATE_AVG_WINDOW_SIZE> smoother;
+  AlphaBetaTracker<float> tracker;
+
+  Axis(bool s) : stamped(s), current(START_CM), prev(START_CM), lastAtUs(0),
+                 tracker(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST) {
+    tracker.reset(START_CM);
+  }
+
+  // One control tick with a fresh sample; returns the closure rate
+  float tick(int est, float raw, uint32_t sampleAtUs, float loopDt) {
+    float dt = stamped ? microsToSeconds<float>(sampleAtUs - lastAtUs) : loopDt;
+    lastAtUs = sampleAtUs;
+
+    if (est == EST_TRACKER) {
+      tracker.correct(raw, dt);
+      return tracker.closureRate();
+    }
+    current = est == EST_RAW ? raw : lowPass(raw, current, DIST_FILTER_ALPHA);
+    float rate = closureRate(current, prev, dt);
+    prev = current;
+    return est == EST_RAW ? rate : smoother.add(rate);
+  }
+};
+
+// Runs the interleaved pair and a jittery 20 Hz loop over one approach.
+// Each loop tick is late by up to jitterUs (serial output, ISR load), and
+// loop dt comes from millis() like main.cpp.
+void simulate(int est, uint32_t jitterUs, float noise, Stats &loopDtStats, Stats &stampedStats) {
+  simMicros = 0;
+  noiseCm = noise;
+  for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+    pendingRise[ch] = false;
+    pendingFall[ch] = false;
+  }
+  SonarScheduler sched(captureA, captureB, simTrigger, SLOT_US, LISTEN_US, SLOT_US);
+  sched.start(0);
+
+  Axis byLoop(false), byStamp(false);
+  byStamp.stamped = true;
+  uint32_t nextTickUs = LOOP_PERIOD_US;
+  uint32_t prevTickMs = 0;
+  float raw = -1.0;
+  uint32_t rawAtUs = 0;
+  int ticks = 0;
+
+  while (simMicros < 1500000) {
+    stepEdges();
+    sched.update(simMicros);
+    EchoSample sample;
+    if (sched.take(0, sample)) {
+      raw = sample.widthUs / US_PER_CM;
+      rawAtUs = echoMidpointUs(sample);
+    }
+    sched.take(1, sample);
+
+    if (simMicros >= nextTickUs) {
+      uint32_t nowMs = simMicros / 1000;
+      float loopDt = (nowMs - prevTickMs) / 1000.0;
+      prevTickMs = nowMs;
+      nextTickUs = simMicros + LOOP_PERIOD_US + (jitterUs ? rand() % jitterUs : 0);
+
+      if (raw != -1.0) {
+        float a = byLoop.tick(est, raw, rawAtUs, loopDt);
+        float b = byStamp.tick(est, raw, rawAtUs, loopDt);
+        if (++ticks > 8) {                 // Past start-up transients
+          loopDtStats.add(a - CLOSING_CM_S);
+          stampedStats.add(b - CLOSING_CM_S);
+        }
+        raw = -1.0;
+      }
+    }
+    simMicros += STEP_US;
+  }
+}
+
+// ---------------------------------------------------------
+// Unit checks
+// ---------------------------------------------------------
+void testMidpoint() {
+  EchoSample s = { 5800, 20000, 13750 }; // 100 cm echo, falling edge at 20 ms
+  CHECK(echoMidpointUs(s) == 17100);
+  EchoSample wrap = { 1000, 200, 0xFFFFFC00u };  // micros() wrapped during the echo
+  CHECK(echoMidpointUs(wrap) == 0xFFFFFFFFu - 299);
+}
+
+void testMicrosToSeconds() {
+  CHECK(fabsf(microsToSeconds<float>(37512) - 0.037512) < 1e-6);
+  CHECK(fabsf(microsToSeconds<float>(2500000) - 2.5) < 1e-6);
+  // Q16 keeps intervals past its 32767 integer range to within two LSBs
+  CHECK(fabsf(toFloat(microsToSeconds<Q16>(37512)) - 0.037512) < 2.0 / 65536);
+  CHECK(fabsf(toFloat(microsToSeconds<Q16>(2500000)) - 2.5) < 2.0 / 65536);
+}
+
+int main() {
+  testMidpoint();
+  testMicrosToSeconds();
+
+  const int SEEDS = 20;
+  uint32_t jitters[] = { 0, 5000 };
+  float noises[] = { 0.0, 0.5 };
+
+  printf("%-14s %9s %8s %14s %14s %8s\n", "Estimator", "Jitter", "Noise",
+         "loop dt (cm/s)", "stamped (cm/s)", "Var cut");
+  for (int est = 0; est < 3; est++) {
+    for (int j = 0; j < 2; j++) {
+      for (int k = 0; k < 2; k++) {
+        Stats byLoop = { 0, 0, 0 }, byStamp = { 0, 0, 0 };
+        srand(1);
+        for (int seed = 0; seed < SEEDS; seed++) simulate(est, jitters[j], noises[k], byLoop, byStamp);
+
+        double cut = 1.0 - (byStamp.stddev() * byStamp.stddev()) / (byLoop.stddev() * byLoop.stddev());
+        printf("%-14s %7uus %6.1fcm %14.2f %14.2f %7.0f%%\n", EST_NAMES[est], jitters[j], noises[k],
+               byLoop.stddev(), byStamp.stddev(), cut * 100.0);
+
+        // On a perfect loop the two agree; under jitter the stamps remove
+        // almost all of the rate noise the loop dt adds
+        if (jitters[j] == 0) {
+          CHECK(byStamp.stddev() < byLoop.stddev() * 1.05);
+        } else {
+          CHECK(byStamp.stddev() < byLoop.stddev());
+          if (noises[k] == 0.0) CHECK(cut > 0.75);
+        }
+      }
+    }
+  }
+
+  if (failures == 0) printf("SampleTiming: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
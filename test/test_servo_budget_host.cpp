@@ -0,0 +1,158 @@
+// Host-side tests for ServoBudget: granularity against the heat estimate,
+// the first write, cooling, hold heating, per-flight counters, and a flight
+// trace against the fixed 300us deadband
+//   g++ -std=c++11 -O2 -Iinclude test/test_servo_budget_host.cpp -o budget_test && ./budget_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "ServoBudget.h"
+#include "TestCheck.h"
+
+// Same settings as main.cpp
+const int LOOP_PERIOD_MS = 50;
+const int SERVO_ELEVATOR_NEUTRAL = 1100;
+const ServoBudgetConfig BUDGET = { 10, 300, 20000, 20, 5 };
+const ServoBudgetConfig FIXED_300 = { 300, 300, 20000, 20, 5 };
+const ServoBudgetConfig NO_LIMIT = { 0, 0, 20000, 20, 5 };
+
+const int TICKS_PER_SEC = 1000 / LOOP_PERIOD_MS;
+
+// ---------------------------------------------------------
+// 1. First write and small corrections on a cold servo
+// ---------------------------------------------------------
+void testFirstWrite() {
+  ServoBudget b(BUDGET, SERVO_ELEVATOR_NEUTRAL);
+  CHECK(b.stepUs() == 10);
+  CHECK(b.update(SERVO_ELEVATOR_NEUTRAL) == SERVO_ELEVATOR_NEUTRAL);
+  CHECK(!b.moved());                           // Already at neutral: nothing to send
+  CHECK(b.update(SERVO_ELEVATOR_NEUTRAL + 25) == SERVO_ELEVATOR_NEUTRAL + 25);
+  CHECK(b.moved());
+  CHECK(b.update(SERVO_ELEVATOR_NEUTRAL + 30) == SERVO_ELEVATOR_NEUTRAL + 25);
+  CHECK(!b.moved());                           // Inside the granularity
+  CHECK(b.budgetStats().writes == 1 && b.budgetStats().suppressed == 1);
+
+  // min == max is the old fixed deadband, starting from neutral
+  ServoBudget fixed(FIXED_300, SERVO_ELEVATOR_NEUTRAL);
+  CHECK(fixed.update(SERVO_ELEVATOR_NEUTRAL + 300) == SERVO_ELEVATOR_NEUTRAL);
+  CHECK(fixed.update(SERVO_ELEVATOR_NEUTRAL + 301) == SERVO_ELEVATOR_NEUTRAL + 301);
+}
+
+// ---------------------------------------------------------
+// 2. Sustained dithering heats the servo and coarsens the granularity;
+//    idle at neutral cools it back
+// ---------------------------------------------------------
+void testHeatAndCool() {
+  ServoBudget b(BUDGET, SERVO_ELEVATOR_NEUTRAL);
+  uint32_t movedFirst = 0;
+  uint32_t writesBefore = 0;
+  for (int k = 0; k < 120 * TICKS_PER_SEC; k++) {
+    b.update(k % 2 ? 1500 : 1700);             // 200us every tick
+    if (k == 2 * TICKS_PER_SEC - 1) movedFirst = b.budgetStats().movedUs;
+    if (k == 60 * TICKS_PER_SEC - 1) writesBefore = b.budgetStats().writes;
+  }
+  const ServoBudgetStats &st = b.budgetStats();
+  printf("Dither 200us/tick, 120 s: %u writes, %u held, peak heat %d us, step %d us\n",
+         (unsigned)st.writes, (unsigned)st.suppressed, (int)st.peakHeatUs, b.stepUs());
+  // Everything passes at first (the first write is 600us from neutral)
+  CHECK(movedFirst == 600 + (2 * TICKS_PER_SEC - 1) * 200);
+  CHECK(st.suppressed > 0);
+  CHECK(st.peakStepUs > 200);                  // Throttled to the dither...
+  CHECK(st.writes > writesBefore);             // ...but writes resume as it cools
+  // The heat settles where the granularity meets the dither, under the limit
+  CHECK(st.peakHeatUs < BUDGET.limitUs);
+  // Versus 4000us/s requested
+  double rate = (double)st.movedUs / 120.0;
+  printf("  travel written %.0f us/s of 4000 requested\n", rate);
+  CHECK(rate < 2500);
+
+  // Cool at neutral for 3 time constants (tau = 1000/5 ticks = 10 s)
+  b.update(SERVO_ELEVATOR_NEUTRAL);
+  for (int k = 0; k < 30 * TICKS_PER_SEC; k++) b.update(SERVO_ELEVATOR_NEUTRAL);
+  printf("  after 30 s at neutral: heat %d us, step %d us\n", (int)b.heatUs(), b.stepUs());
+  CHECK(b.heatUs() < BUDGET.limitUs / 10);
+  CHECK(b.stepUs() < 40);
+}
+
+// ---------------------------------------------------------
+// 3. Holding off neutral heats, holding at neutral doesn't
+// ---------------------------------------------------------
+void testHold() {
+  ServoBudget held(BUDGET, SERVO_ELEVATOR_NEUTRAL);
+  ServoBudget idle(BUDGET, SERVO_ELEVATOR_NEUTRAL);
+  held.update(SERVO_ELEVATOR_NEUTRAL + 1000);
+  idle.update(SERVO_ELEVATOR_NEUTRAL + 1000);
+  idle.update(SERVO_ELEVATOR_NEUTRAL);
+  for (int k = 0; k < 20 * TICKS_PER_SEC; k++) {
+    held.update(SERVO_ELEVATOR_NEUTRAL + 1000);
+    idle.update(SERVO_ELEVATOR_NEUTRAL);
+  }
+  printf("Held 1000us off neutral 20 s: heat %d us (at neutral: %d us)\n",
+         (int)held.heatUs(), (int)idle.heatUs());
+  CHECK(held.heatUs() > idle.heatUs() + 2000);
+  CHECK(held.budgetStats().deflectedTicks == (uint32_t)(20 * TICKS_PER_SEC + 1));
+  CHECK(held.budgetStats().deflectionUsTicks == (uint32_t)(20 * TICKS_PER_SEC + 1) * 1000);
+  CHECK(idle.budgetStats().deflectedTicks == 1);
+
+  held.resetStats();
+  CHECK(held.budgetStats().ticks == 0 && held.budgetStats().movedUs == 0);
+  CHECK(held.budgetStats().peakHeatUs == held.heatUs());
+}
+
+// ---------------------------------------------------------
+// 4. One flight: a P-law elevator trace (slow swing plus sensor noise,
+//    then a full step), through each granularity rule
+// ---------------------------------------------------------
+struct FlightResult {
+  uint32_t writes;
+  uint32_t movedUs;
+  double rmsUs;            // Written vs commanded
+  int32_t peakHeatUs;
+};
+
+FlightResult fly(const ServoBudgetConfig &cfg) {
+  ServoBudget b(cfg, SERVO_ELEVATOR_NEUTRAL);
+  srand(3);
+  double sq = 0;
+  const int N = 5 * TICKS_PER_SEC;
+  for (int k = 0; k < N; k++) {
+    double t = (double)k / TICKS_PER_SEC;
+    int cmd;
+    if (k < N - TICKS_PER_SEC) {
+      cmd = 1300 + (int)(150 * sin(2 * M_PI * 0.5 * t)) + rand() % 31 - 15;
+    } else {
+      cmd = 2100;
+    }
+    int out = b.update(cmd);
+    sq += (double)(out - cmd) * (out - cmd);
+  }
+  FlightResult r = { b.budgetStats().writes, b.budgetStats().movedUs, sqrt(sq / N),
+                     b.budgetStats().peakHeatUs };
+  return r;
+}
+
+int main() {
+  testFirstWrite();
+  testHeatAndCool();
+  testHold();
+
+  FlightResult fixed = fly(FIXED_300);
+  FlightResult budget = fly(BUDGET);
+  FlightResult none = fly(NO_LIMIT);
+  printf("%-22s %8s %10s %10s %10s\n", "5 s flight (elevator)", "Writes", "Moved(us)", "RMS(us)", "Heat(us)");
+  printf("%-22s %8u %10u %10.0f %10d\n", "Fixed 300us deadband", (unsigned)fixed.writes,
+         (unsigned)fixed.movedUs, fixed.rmsUs, (int)fixed.peakHeatUs);
+  printf("%-22s %8u %10u %10.0f %10d\n", "ServoBudget", (unsigned)budget.writes,
+         (unsigned)budget.movedUs, budget.rmsUs, (int)budget.peakHeatUs);
+  printf("%-22s %8u %10u %10.0f %10d\n", "Every change", (unsigned)none.writes,
+         (unsigned)none.movedUs, none.rmsUs, (int)none.peakHeatUs);
+
+  // The corrections the deadband swallowed now get through...
+  CHECK(budget.rmsUs < fixed.rmsUs / 4);
+  CHECK(budget.writes > fixed.writes * 5);
+  // ...at less travel than writing every change
+  CHECK(budget.movedUs < none.movedUs);
+  CHECK(budget.peakHeatUs < BUDGET.limitUs);
+
+  if (failures == 0) printf("ServoBudget: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+// Host-side validation of the servo response model and lead compensation:
+// identification from a simulated servo_test_battery sweep, then the output
+// path with and without ServoLead on a finer-grained servo
+//   g++ -std=c++11 -O2 -Iinclude test/test_servo_lead_host.cpp -o lead_test && ./lead_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "ServoModel.h"
+#include "SignalPath.h"
+#include "TestCheck.h"
+
+// Same settings as main.cpp
+const float LOOP_DT = 0.05;
+const float SERVO_SMOOTHING_ALPHA = 0.70;
+const int SERVO_DEADBAND_US = 300;
+const int SERVO_ELEVATOR_NEUTRAL = 1100;
+const int SERVO_ELEVATOR_UP = 2100;
+const int SERVO_ELEVATOR_MIN = 900;
+const int SERVO_ELEVATOR_MAX = 2100;
+const float SERVO_LEAD_GAIN = 1.0;
+const float SERVO_FF_GAIN = 0.5;
+
+// The "real" micro servo: 20ms dead time, 1000us in 125ms, 30ms tail
+const ServoParams<float> TRUE_SERVO = { 0.020, 8000.0, 0.030 };
+
+// ---------------------------------------------------------
+// Plant: same physics as the model, integrated at 0.1ms with the dead
+// time exact rather than rounded to model sub-steps
+// ---------------------------------------------------------
+struct Plant {
+  ServoParams<float> p;
+  float pos, following, pending;
+  double t, switchAt;
+
+  Plant(const ServoParams<float> &params, float us)
+    : p(params), pos(us), following(us), pending(us), t(0), switchAt(-1) {}
+
+  void write(float us) {
+    pending = us;
+    switchAt = t + p.deadSec;
+  }
+
+  void run(double sec) {
+    const double H = 1e-4;
+    for (int i = 0; i < (int)(sec / H + 0.5); i++) {
+      if (switchAt >= 0 && t >= switchAt) {
+        following = pending;
+        switchAt = -1;
+      }
+      float move = (following - pos) * H / p.tauSec;
+      float lim = p.slewUsPerSec * H;
+      if (move > lim) move = lim;
+      else if (move < -lim) move = -lim;
+      pos += move;
+      t += H;
+    }
+  }
+};
+
+// ---------------------------------------------------------
+// 1. Identification from the sweep: neutral -> max, horn pot sampled at
+// 1kHz by the 10-bit ADC (~180 degrees over 600-2400us), 2 LSB of noise
+// ---------------------------------------------------------
+void testIdentification() {
+  const int N = 400;
+  float pos[N];
+  const float ADC_US_PER_LSB = 1800.0 / 1023.0;
+  srand(4);
+  Plant servo(TRUE_SERVO, SERVO_ELEVATOR_NEUTRAL);
+  servo.write(SERVO_ELEVATOR_UP);
+  for (int i = 0; i < N; i++) {
+    int adc = (int)((servo.pos - 600.0) / ADC_US_PER_LSB + (rand() % 5 - 2) + 0.5);
+    pos[i] = 600.0 + adc * ADC_US_PER_LSB;
+    servo.run(0.001);
+  }
+
+  ServoParams<float> fit = ServoParams<float>();
+  CHECK(fitServoStep(pos, N, 0.001, SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP, fit));
+  printf("Identified: dead %.1fms (true %.1f), slew %.0fus/s (%.0f), tau %.1fms (%.1f)\n",
+         fit.deadSec * 1000, TRUE_SERVO.deadSec * 1000, fit.slewUsPerSec, TRUE_SERVO.slewUsPerSec,
+         fit.tauSec * 1000, TRUE_SERVO.tauSec * 1000);
+  CHECK(fabsf(fit.deadSec - TRUE_SERVO.deadSec) < 0.004);
+  CHECK(fabsf(fit.slewUsPerSec / TRUE_SERVO.slewUsPerSec - 1.0) < 0.10);
+  CHECK(fabsf(fit.tauSec / TRUE_SERVO.tauSec - 1.0) < 0.25);
+
+  // Falling step too
+  Plant back(TRUE_SERVO, SERVO_ELEVATOR_UP);
+  back.write(SERVO_ELEVATOR_NEUTRAL);
+  for (int i = 0; i < N; i++) {
+    pos[i] = back.pos;
+    back.run(0.001);
+  }
+  CHECK(fitServoStep(pos, N, 0.001, SERVO_ELEVATOR_UP, SERVO_ELEVATOR_NEUTRAL, fit));
+  CHECK(fabsf(fit.slewUsPerSec / TRUE_SERVO.slewUsPerSec - 1.0) < 0.05);
+
+  // A step that never finishes can't be fitted
+  CHECK(!fitServoStep(pos, 20, 0.001, SERVO_ELEVATOR_UP, SERVO_ELEVATOR_NEUTRAL, fit));
+}
+
+// ---------------------------------------------------------
+// 2. The tick-rate model follows the plant
+// ---------------------------------------------------------
+// Random commands every 300ms; step() is given the held command each tick
+template <typename T>
+float modelTrackingError() {
+  ServoParams<T> p = { T(TRUE_SERVO.deadSec), T(TRUE_SERVO.slewUsPerSec), T(TRUE_SERVO.tauSec) };
+  ServoResponse<T> model(p, T(LOOP_DT), SERVO_ELEVATOR_NEUTRAL);
+  Plant plant(TRUE_SERVO, SERVO_ELEVATOR_NEUTRAL);
+  srand(9);
+  float worst = 0;
+  int cmd = SERVO_ELEVATOR_NEUTRAL;
+  for (int k = 0; k < 400; k++) {
+    if (k % 6 == 0) {
+      cmd = SERVO_ELEVATOR_MIN + rand() % 1200;
+      plant.write(cmd);
+    }
+    model.step(cmd);
+    plant.run(LOOP_DT);
+    float err = fabsf(toFloat(model.position()) - plant.pos);
+    if (err > worst) worst = err;
+  }
+  return worst;
+}
+
+// ---------------------------------------------------------
+// 3./4. Output path: EMA -> [lead] -> deadband -> servo
+// ---------------------------------------------------------
+struct PathResult {
+  float t90Ms;             // Trigger to 90% deflection
+  float holdPct;           // Deflection delivered inside the 500ms hold
+  float returnMs;          // Release to within 10% of neutral
+  float trackRmsUs;        // Horn vs law target, small P-law moves
+};
+
+// `deadband` false: every tick is written
+PathResult runPath(bool lead, bool deadband, const ServoParams<float> &modelParams) {
+  PathResult r = { -1, 0, -1, 0 };
+  const float FULL = SERVO_ELEVATOR_UP - SERVO_ELEVATOR_NEUTRAL;
+
+  for (int scenario = 0; scenario < 2; scenario++) {
+    Plant servo(TRUE_SERVO, SERVO_ELEVATOR_NEUTRAL);
+    ServoLead<float> stage(modelParams, LOOP_DT, SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_MIN,
+                           SERVO_ELEVATOR_MAX, SERVO_LEAD_GAIN, SERVO_FF_GAIN);
+    int smoothed = SERVO_ELEVATOR_NEUTRAL;
+    int written = -1;
+    double sq = 0;
+    int samples = 0;
+    srand(21);
+    int target = SERVO_ELEVATOR_NEUTRAL;
+
+    for (int k = 0; k < 80; k++) {
+      if (scenario == 0) {
+        // Bang-bang trigger at tick 2, held 500ms
+        target = (k >= 2 && k < 12) ? SERVO_ELEVATOR_UP : SERVO_ELEVATOR_NEUTRAL;
+      } else if (k % 3 == 0) {
+        // P law: small corrections around 1400us
+        target = 1400 + rand() % 400 - 200;
+      }
+      smoothed = smoothServo(target, smoothed, SERVO_SMOOTHING_ALPHA);
+      int cmd = lead ? stage.command(smoothed, target) : smoothed;
+      if (!deadband || abs(cmd - written) > SERVO_DEADBAND_US) {
+        written = cmd;
+        servo.write(written);
+      }
+      if (lead) stage.advance(written);
+
+      for (int ms = 0; ms < 50; ms++) {
+        servo.run(0.001);
+        float t = k * LOOP_DT + (ms + 1) * 0.001;
+        if (scenario == 0) {
+          float defl = (servo.pos - SERVO_ELEVATOR_NEUTRAL) / FULL;
+          if (t > 0.1 && t <= 0.6) r.holdPct += defl * 0.001 / 0.5 * 100;
+          if (r.t90Ms < 0 && defl >= 0.9) r.t90Ms = (t - 0.1) * 1000;
+          if (t > 0.6 && r.returnMs < 0 && fabsf(defl) <= 0.1) r.returnMs = (t - 0.6) * 1000;
+        } else {
+          sq += (servo.pos - target) * (servo.pos - target);
+          samples++;
+        }
+      }
+    }
+    if (scenario == 1) r.trackRmsUs = sqrt(sq / samples);
+  }
+  return r;
+}
+
+void printPath(const char* name, const PathResult &r) {
+  char t90[16], back[16];
+  if (r.t90Ms < 0) snprintf(t90, sizeof(t90), "never");
+  else snprintf(t90, sizeof(t90), "%.0f", r.t90Ms);
+  if (r.returnMs < 0) snprintf(back, sizeof(back), "never");
+  else snprintf(back, sizeof(back), "%.0f", r.returnMs);
+  printf("%-30s %8s %9.0f%% %10s %11.0f\n", name, t90, r.holdPct, back, r.trackRmsUs);
+}
+
+int main() {
+  testIdentification();
+
+  float fl = modelTrackingError<float>();
+  float fx = modelTrackingError<Q16>();
+  printf("Model vs servo, worst error over 20 s of steps: float %.0fus, Q16 %.0fus\n", fl, fx);
+  CHECK(fl < 60.0);
+  CHECK(fx < 60.0);
+
+  printf("%-30s %8s %10s %10s %11s\n", "Output path (elevator)", "t90(ms)", "Hold", "Back(ms)", "P RMS(us)");
+  ServoParams<float> slow = { TRUE_SERVO.deadSec * 1.3f, TRUE_SERVO.slewUsPerSec * 0.7f, TRUE_SERVO.tauSec * 1.3f };
+  ServoParams<float> fast = { TRUE_SERVO.deadSec * 0.7f, TRUE_SERVO.slewUsPerSec * 1.3f, TRUE_SERVO.tauSec * 0.7f };
+  PathResult base = runPath(false, true, TRUE_SERVO);
+  PathResult baseNoDb = runPath(false, false, TRUE_SERVO);
+  PathResult lead = runPath(true, true, TRUE_SERVO);
+  PathResult leadNoDb = runPath(true, false, TRUE_SERVO);
+  PathResult leadSlow = runPath(true, true, slow);
+  PathResult leadFast = runPath(true, true, fast);
+  printPath("EMA + deadband (current)", base);
+  printPath("EMA, no deadband", baseNoDb);
+  printPath("EMA + lead + deadband", lead);
+  printPath("EMA + lead, no deadband", leadNoDb);
+  printPath("  lead, model 30% slow", leadSlow);
+  printPath("  lead, model 30% fast", leadFast);
+
+  // The deadband freezes the smoothed step at 70% and never returns the
+  // last 30%; the lead's first command is the whole step
+  CHECK(base.t90Ms < 0);
+  CHECK(lead.t90Ms > 0 && lead.t90Ms < 160);
+  CHECK(lead.holdPct > base.holdPct + 15);
+  CHECK(lead.returnMs > 0 && lead.returnMs < 160);
+  CHECK(leadNoDb.t90Ms <= baseNoDb.t90Ms);
+  CHECK(leadNoDb.trackRmsUs < baseNoDb.trackRmsUs);
+  CHECK(lead.trackRmsUs < base.trackRmsUs);
+  // Still ahead of the current path with the model 30% off either way
+  CHECK(leadSlow.holdPct > base.holdPct && leadFast.holdPct > base.holdPct);
+  CHECK(leadSlow.trackRmsUs < base.trackRmsUs && leadFast.trackRmsUs < base.trackRmsUs);
+
+  if (failures == 0) printf("ServoModel: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <Arduino.h>
+#include "ControlLaw.h"
+#include "ServoTable.h"
+#include "SignalPath.h"
+
+// Cycle counts of the control tick's output path (both axes): correction ->
+// direction / limits -> constrain -> EMA, as formulas in float and Q16 vs
+// the integer map and the compile-time smoothing table. SysTick runs at the
+// 48MHz core clock.
+
+const int REPEAT = 100;
+
+typedef ServoMap<1700, 900, 900, 2100> RudderMap;
+typedef ServoMap<1100, 2100, 900, 2100> ElevatorMap;
+typedef ServoSmoothing<700, 1200> ServoSmoother;
+
+volatile int offsetIn = 350;
+
+uint32_t cyclesSince(uint32_t start) {
+  uint32_t now = SysTick->VAL;
+  uint32_t reload = SysTick->LOAD + 1;
+  return (start >= now) ? (start - now) : (start + reload - now);
+}
+
+template <typename T>
+int formulaPath(int offset, int &r, int &e, T alpha) {
+  int tr = 1700 - toInt(T(offset));
+  int te = 1100 + toInt(T(offset));
+  tr = constrain(tr, 900, 2100);
+  te = constrain(te, 900, 2100);
+  r = smoothServo(tr, r, alpha);
+  e = smoothServo(te, e, alpha);
+  return r + e;
+}
+
+template <typename T>
+int tablePath(int offset, int &r, int &e) {
+  r = ServoSmoother::apply(RudderMap::command(toInt(T(offset))), r);
+  e = ServoSmoother::apply(ElevatorMap::command(toInt(T(offset))), e);
+  return r + e;
+}
+
+void report(const char* label, uint32_t total) {
+  Serial.print(label);
+  Serial.print(",");
+  Serial.println(total / REPEAT);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  Serial.println("========================================");
+  Serial.println("SERVO OUTPUT PATH CYCLE COUNT (both axes)");
+  Serial.println("========================================");
+  Serial.println("Path,Cycles");
+}
+
+void loop() {
+  uint32_t start, fl = 0, fx = 0, lut = 0;
+  int r = 1700, e = 1100;
+  volatile int sink = 0;
+
+  for (int i = 0; i < REPEAT; i++) {
+    int offset = offsetIn + i;
+    noInterrupts();
+    start = SysTick->VAL;
+    sink = formulaPath<float>(offset, r, e, 0.70f);
+    fl += cyclesSince(start);
+
+    start = SysTick->VAL;
+    sink = formulaPath<Q16>(offset, r, e, Q16(0.70));
+    fx += cyclesSince(start);
+
+    start = SysTick->VAL;
+    sink = tablePath<Q16>(offset, r, e);
+    lut += cyclesSince(start);
+    interrupts();
+  }
+  (void)sink;
+
+  report("formula float", fl);
+  report("formula Q16", fx);
+  report("table", lut);
+  Serial.println();
+  delay(2000);
+}
@@ -0,0 +1,177 @@
+// Host-side check of the servo command map and the compile-time smoothing
+// table against the formulas they replace, plus a timing comparison of the two output paths
+//   g++ -std=c++11 -O2 -Iinclude test/test_servo_table_host.cpp -o table_test && ./table_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ControlLaw.h"
+#include "ServoTable.h"
+#include "SignalPath.h"
+#include "TestCheck.h"
+
+// Same settings as main.cpp
+const int SERVO_RUDDER_NEUTRAL   = 1700;
+const int SERVO_RUDDER_LEFT      = 900;
+const int SERVO_RUDDER_MIN       = 900;
+const int SERVO_RUDDER_MAX       = 2100;
+
+const int SERVO_ELEVATOR_NEUTRAL = 1100;
+const int SERVO_ELEVATOR_UP      = 2100;
+const int SERVO_ELEVATOR_MIN     = 900;
+const int SERVO_ELEVATOR_MAX     = 2100;
+
+const int SERVO_SMOOTHING_PERMILLE = 700;
+const int SERVO_SPAN_US = 1200;
+
+typedef ServoMap<SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX> RudderMap;
+typedef ServoMap<SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP, SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX> ElevatorMap;
+typedef ServoSmoothing<SERVO_SMOOTHING_PERMILLE, SERVO_SPAN_US> ServoSmoother;
+
+// Built by the compiler, not at start-up
+static_assert(RudderMap::command(0) == SERVO_RUDDER_NEUTRAL, "neutral");
+static_assert(RudderMap::command(-5000) == SERVO_RUDDER_MAX, "rudder left is down");
+static_assert(ElevatorMap::command(5000) == SERVO_ELEVATOR_UP, "up");
+static_assert(ServoSmoother::Steps::values[SERVO_SPAN_US + 10] == 7, "0.7 * 10");
+static_assert(ServoSmoother::Steps::values[SERVO_SPAN_US - 1] == -1, "floor");
+
+// Hands ControlLaw a given correction, so update() can be compared with the
+// table for every offset
+template <typename T>
+class GivenCorrection {
+  public:
+    typedef T Value;
+    T correction(const AxisConfig<T> &, T dist, T, uint32_t) { return dist; }
+};
+
+template <typename T>
+AxisConfig<T> axis(int neutral, int correct, int lo, int hi) {
+  AxisConfig<T> c = { neutral, correct, lo, hi, 50.0, 500, 45.0, 10.0, 8.0, 1.5, 0.5 };
+  return c;
+}
+
+// ---------------------------------------------------------
+// Command map == ControlLaw::update() + constrain()
+// ---------------------------------------------------------
+template <class Map, typename T>
+void checkCommand(int neutral, int correct, int lo, int hi) {
+  ControlLaw<GivenCorrection<T> > law(axis<T>(neutral, correct, lo, hi));
+  int mismatches = 0;
+  for (int offset = -3000; offset <= 3000; offset++) {
+    int us = law.update(T(offset), T(0), 0);
+    us = us < lo ? lo : (us > hi ? hi : us);
+    if (Map::command(law.offset(T(offset), T(0), 0)) != us) mismatches++;
+  }
+  CHECK(mismatches == 0);
+  // Fractional corrections round like update() does
+  CHECK(Map::command(law.offset(T(12.75), T(0), 0)) == law.update(T(12.75), T(0), 0));
+  CHECK(Map::command(law.offset(T(-12.75), T(0), 0)) == law.update(T(-12.75), T(0), 0));
+}
+
+// ---------------------------------------------------------
+// Smoothing == exact EMA everywhere, == smoothServo() off exact integers
+// ---------------------------------------------------------
+void checkSmoothing() {
+  long pairs = 0, exactMiss = 0, floatMiss = 0, floatOdd = 0, q16Miss = 0, q16Worst = 0;
+  for (int target = SERVO_RUDDER_MIN; target <= SERVO_RUDDER_MAX; target++) {
+    for (int prev = SERVO_RUDDER_MIN; prev <= SERVO_RUDDER_MAX; prev++) {
+      int d = target - prev;
+      int exact = prev + ServoSmoother::floorDiv(d * SERVO_SMOOTHING_PERMILLE, 1000);
+      int table = ServoSmoother::apply(target, prev);
+      int fl = smoothServo(target, prev, 0.70f);
+      int fx = smoothServo(target, prev, Q16(0.70));
+      pairs++;
+      if (table != exact) exactMiss++;
+      if (table != fl) {
+        floatMiss++;
+        // Only where 0.7 * d is a whole number and float lands just below it
+        if (table - fl != 1 || (d * SERVO_SMOOTHING_PERMILLE) % 1000 != 0) floatOdd++;
+      }
+      if (table != fx) {
+        q16Miss++;
+        long diff = labs((long)(table - fx));
+        if (diff > q16Worst) q16Worst = diff;
+      }
+    }
+  }
+  CHECK(exactMiss == 0);
+  CHECK(floatOdd == 0);
+  CHECK(q16Worst <= 1);
+  printf("Smoothing, %ld (target, prev) pairs: exact EMA %ld differ, float smoothServo %ld (%.1f%%, "
+         "all 1us on whole-number results), Q16 smoothServo %ld (max %ldus)\n",
+         pairs, exactMiss, floatMiss, 100.0 * floatMiss / pairs, q16Miss, q16Worst);
+}
+
+// ---------------------------------------------------------
+// Timing: both output paths for both axes, as controlTask() runs them
+// ---------------------------------------------------------
+const int TRACE_LEN = 64;
+float traceOffset[TRACE_LEN];
+
+template <typename T>
+double timeFormula(int n) {
+  ControlLaw<GivenCorrection<T> > rudder(axis<T>(SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT,
+                                                 SERVO_RUDDER_MIN, SERVO_RUDDER_MAX));
+  ControlLaw<GivenCorrection<T> > elevator(axis<T>(SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP,
+                                                   SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX));
+  T alpha = T(0.70);
+  T in[TRACE_LEN];
+  for (int i = 0; i < TRACE_LEN; i++) in[i] = T(traceOffset[i]);
+  int r = SERVO_RUDDER_NEUTRAL, e = SERVO_ELEVATOR_NEUTRAL;
+  clock_t start = clock();
+  for (int i = 0; i < n; i++) {
+    int tr = rudder.update(in[i % TRACE_LEN], T(0), 0);
+    int te = elevator.update(in[(i + 7) % TRACE_LEN], T(0), 0);
+    tr = tr < SERVO_RUDDER_MIN ? SERVO_RUDDER_MIN : (tr > SERVO_RUDDER_MAX ? SERVO_RUDDER_MAX : tr);
+    te = te < SERVO_ELEVATOR_MIN ? SERVO_ELEVATOR_MIN : (te > SERVO_ELEVATOR_MAX ? SERVO_ELEVATOR_MAX : te);
+    r = smoothServo(tr, r, alpha);
+    e = smoothServo(te, e, alpha);
+  }
+  double ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / n;
+  volatile int sink = r + e;
+  (void)sink;
+  return ns;
+}
+
+template <typename T>
+double timeTable(int n) {
+  ControlLaw<GivenCorrection<T> > rudder(axis<T>(SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT,
+                                                 SERVO_RUDDER_MIN, SERVO_RUDDER_MAX));
+  ControlLaw<GivenCorrection<T> > elevator(axis<T>(SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP,
+                                                   SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX));
+  T in[TRACE_LEN];
+  for (int i = 0; i < TRACE_LEN; i++) in[i] = T(traceOffset[i]);
+  int r = SERVO_RUDDER_NEUTRAL, e = SERVO_ELEVATOR_NEUTRAL;
+  clock_t start = clock();
+  for (int i = 0; i < n; i++) {
+    int tr = RudderMap::command(rudder.offset(in[i % TRACE_LEN], T(0), 0));
+    int te = ElevatorMap::command(elevator.offset(in[(i + 7) % TRACE_LEN], T(0), 0));
+    r = ServoSmoother::apply(tr, r);
+    e = ServoSmoother::apply(te, e);
+  }
+  double ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / n;
+  volatile int sink = r + e;
+  (void)sink;
+  return ns;
+}
+
+int main() {
+  checkCommand<RudderMap, float>(SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX);
+  checkCommand<RudderMap, Q16>(SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX);
+  checkCommand<ElevatorMap, float>(SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP, SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX);
+  checkCommand<ElevatorMap, Q16>(SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP, SERVO_ELEVATOR_MIN, SERVO_ELEVATOR_MAX);
+  checkSmoothing();
+
+  srand(12);
+  for (int i = 0; i < TRACE_LEN; i++) traceOffset[i] = (rand() % 24000) / 10.0 - 1200.0;
+  const int N = 5000000;
+  printf("%-24s %8s\n", "Output path (2 axes)", "ns/tick");
+  printf("%-24s %8.1f\n", "formula, float", timeFormula<float>(N));
+  printf("%-24s %8.1f\n", "formula, Q16", timeFormula<Q16>(N));
+  printf("%-24s %8.1f\n", "map+table, float offset", timeTable<float>(N));
+  printf("%-24s %8.1f\n", "map+table, Q16 offset", timeTable<Q16>(N));
+  printf("Table flash: smoothing %u bytes\n", (unsigned)sizeof(ServoSmoother::Steps::values));
+  printf("(M0+ cycles: test/test_servo_table_cycles.cpp on the board)\n");
+
+  if (failures == 0) printf("ServoTable: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+// Host-side test for SonarScheduler with main.cpp's slot, listen window and
+// crosstalk horizon (no board needed)
+//   g++ -std=c++11 -Iinclude test/test_sonar_scheduler_host.cpp -o sonar_test && ./sonar_test
+#define PROFILE_STAGES 0
+#include "../src/main.cpp"
+#include "TestCheck.h"
+
+const uint32_t STEP_US = 10;
+const uint32_t CLONE_HOLD_US = 60000;    // Some HC-SR04 clones hold a miss this long
+
+// ---------------------------------------------------------
+// Simulated sensors: each trigger schedules one rise and one fall. With no
+// echo the line still goes high and falls missHoldUs later, as on an
+// HC-SR04, and a trigger while it is high is refused.
+// ---------------------------------------------------------
+EchoCapture captureA(SONAR_TIMEOUT_US);
+EchoCapture captureB(SONAR_TIMEOUT_US);
+EchoCapture* captures[SONAR_CHANNELS] = { &captureA, &captureB };
+
+uint32_t simMicros = 0;
+uint32_t echoWidthUs[SONAR_CHANNELS];    // 0 = no echo
+uint32_t missHoldUs = HAL_LINUX_MISS_HOLD_US;
+uint32_t riseAt[SONAR_CHANNELS];
+uint32_t fallAt[SONAR_CHANNELS];
+bool pendingRise[SONAR_CHANNELS];
+bool pendingFall[SONAR_CHANNELS];
+bool lineHigh[SONAR_CHANNELS];
+bool firedB;
+uint32_t lastFireB;
+
+// When set, channel A's receiver hears each of B's bursts this long after
+// B fired, if it is listening by then and its own echo is later
+uint32_t crosstalkIntoAUs = 0;
+
+void hearB(uint32_t heardAt) {
+  if (pendingFall[0] && heardAt > riseAt[0] && heardAt < fallAt[0]) fallAt[0] = heardAt;
+}
+
+bool simTrigger(int ch) {
+  if (lineHigh[ch]) return false;
+  captures[ch]->arm(simMicros);
+
+  riseAt[ch] = simMicros + SONAR_BURST_US;
+  fallAt[ch] = riseAt[ch] + (echoWidthUs[ch] ? echoWidthUs[ch] : missHoldUs);
+  pendingRise[ch] = true;
+  pendingFall[ch] = true;
+  if (ch == 1) {
+    firedB = true;
+    lastFireB = simMicros;
+  }
+  if (crosstalkIntoAUs && firedB) hearB(lastFireB + crosstalkIntoAUs);
+  return true;
+}
+
+void stepEdges() {
+  for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+    if (pendingRise[ch] && simMicros == riseAt[ch]) {
+      lineHigh[ch] = true;
+      captures[ch]->onEdge(true, simMicros);
+      pendingRise[ch] = false;
+    }
+    if (pendingFall[ch] && simMicros == fallAt[ch]) {
+      lineHigh[ch] = false;
+      captures[ch]->onEdge(false, simMicros);
+      pendingFall[ch] = false;
+    }
+  }
+}
+
+void resetSim() {
+  simMicros = 0;
+  for (int ch = 0; ch < SONAR_CHANNELS; ch++) {
+    pendingRise[ch] = false;
+    pendingFall[ch] = false;
+    lineHigh[ch] = false;
+  }
+  firedB = false;
+  missHoldUs = HAL_LINUX_MISS_HOLD_US;
+  crosstalkIntoAUs = 0;
+}
+
+// Steps the clock, calling update() every STEP_US. With stallUs set, the
+// loop is that late for every one of B's slots (odd slots from start).
+void run(SonarScheduler &sched, uint32_t durationUs, uint32_t stallUs = 0) {
+  uint32_t endUs = simMicros + durationUs;
+  while (simMicros < endUs) {
+    stepEdges();
+    bool stalled = stallUs && simMicros % (2 * SONAR_SLOT_US) >= SONAR_SLOT_US &&
+                   simMicros % (2 * SONAR_SLOT_US) < SONAR_SLOT_US + stallUs;
+    if (!stalled) sched.update(simMicros);
+    simMicros += STEP_US;
+  }
+}
+
+// ---------------------------------------------------------
+// Tests
+// ---------------------------------------------------------
+void testInterleavedRate() {
+  resetSim();
+  echoWidthUs[0] = 30 * 58;              // Wall at 30 cm
+  echoWidthUs[1] = 105 * 58;             // Ground at 105 cm
+  SonarScheduler sched(captureA, captureB, simTrigger, SONAR_SLOT_US, SONAR_LISTEN_US, SONAR_HORIZON_US);
+  sched.start(simMicros);
+
+  run(sched, 1000000);
+
+  float hzA = sched.effectiveHz(0, simMicros);
+  float hzB = sched.effectiveHz(1, simMicros);
+  printf("Interleaved: A %.1f Hz, B %.1f Hz (one ping each per %d ms control tick)\n", hzA, hzB,
+         LOOP_PERIOD_MS);
+  CHECK(hzA > 19.0 && hzA <= 20.5);
+  CHECK(hzB > 19.0 && hzB <= 20.5);
+  CHECK(sched.channelStats(0).crosstalkDrops == 0);
+  CHECK(sched.channelStats(1).crosstalkDrops == 0);
+  CHECK(sched.channelStats(0).busySkips == 0 && sched.channelStats(1).busySkips == 0);
+
+  EchoSample sample;
+  CHECK(sched.take(0, sample));
+  CHECK(sample.widthUs == 30 * 58);
+  CHECK(!sched.take(0, sample));
+}
+
+// B's ping goes out 5 ms late, so A's follows it by only 20 ms. A's
+// receiver hears B's burst 22 ms after B fired: a 34 cm "echo" on A's
+// clock, which only the arrival against B's burst gives away.
+void testCrosstalkAfterLatePing() {
+  const uint32_t STALL_US = 5000;
+  const uint32_t B_HEARD_US = 22000;
+
+  resetSim();
+  echoWidthUs[0] = 300 * 58;             // A's own wall out of its window
+  echoWidthUs[1] = 105 * 58;
+  crosstalkIntoAUs = B_HEARD_US;
+  SonarScheduler sched(captureA, captureB, simTrigger, SONAR_SLOT_US, SONAR_LISTEN_US, SONAR_HORIZON_US);
+  sched.start(simMicros);
+
+  run(sched, 500000, STALL_US);
+
+  const SonarStats &a = sched.channelStats(0);
+  printf("Crosstalk: A pings %lu, valid %lu, crosstalk drops %lu\n",
+         (unsigned long)a.pings, (unsigned long)a.valid, (unsigned long)a.crosstalkDrops);
+  CHECK(a.valid == 0);
+  CHECK(a.crosstalkDrops + 1 >= a.pings);
+  CHECK(sched.channelStats(1).crosstalkDrops == 0);
+  EchoSample sample;
+  CHECK(!sched.take(0, sample));
+
+  // A's own echo at 100 cm under the same late pings arrives 26 ms after
+  // B's burst: accepted
+  resetSim();
+  echoWidthUs[0] = 100 * 58;
+  SonarScheduler late(captureA, captureB, simTrigger, SONAR_SLOT_US, SONAR_LISTEN_US, SONAR_HORIZON_US);
+  late.start(simMicros);
+  run(late, 500000, STALL_US);
+  CHECK(late.channelStats(0).crosstalkDrops == 0);
+  CHECK(late.channelStats(0).valid + 1 >= late.channelStats(0).pings);
+}
+
+// A window longer than the slot runs past B's next ping, and A hears B's
+// burst 2 ms after B fired
+void testCrosstalkInLongWindow() {
+  resetSim();
+  echoWidthUs[0] = 0;
+  echoWidthUs[1] = 105 * 58;
+  crosstalkIntoAUs = 2000;
+  SonarScheduler sched(captureA, captureB, simTrigger, SONAR_SLOT_US, SONAR_TIMEOUT_US, SONAR_HORIZON_US);
+  sched.start(simMicros);
+
+  run(sched, 500000);
+
+  const SonarStats &a = sched.channelStats(0);
+  CHECK(a.valid == 0);
+  CHECK(a.crosstalkDrops + 1 >= a.pings);
+}
+
+void testTimeoutsCounted() {
+  resetSim();
+  echoWidthUs[0] = 0;                    // Nothing in range: the line holds ~38 ms
+  echoWidthUs[1] = 80 * 58;
+  SonarScheduler sched(captureA, captureB, simTrigger, SONAR_SLOT_US, SONAR_LISTEN_US, SONAR_HORIZON_US);
+  sched.start(simMicros);
+
+  run(sched, 500000);
+
+  CHECK(sched.channelStats(0).valid == 0);
+  CHECK(sched.channelStats(0).timeouts + 1 >= sched.channelStats(0).pings);
+  CHECK(sched.channelStats(0).busySkips == 0);   // Released before A's next slot
+  CHECK(sched.effectiveHz(1, simMicros) > 19.0);
+}
+
+// A clone holding a miss for 60 ms would ignore A's next trigger: the slot
+// is skipped and counted, and A is pinged again on the one after
+void testBusySensorSkipped() {
+  resetSim();
+  echoWidthUs[0] = 0;
+  echoWidthUs[1] = 80 * 58;
+  missHoldUs = CLONE_HOLD_US;
+  SonarScheduler sched(captureA, captureB, simTrigger, SONAR_SLOT_US, SONAR_LISTEN_US, SONAR_HORIZON_US);
+  sched.start(simMicros);
+
+  run(sched, 1000000);
+
+  const SonarStats &a = sched.channelStats(0);
+  printf("Busy sensor: A pings %lu, busy skips %lu, timeouts %lu\n",
+         (unsigned long)a.pings, (unsigned long)a.busySkips, (unsigned long)a.timeouts);
+  CHECK(a.busySkips >= 9 && a.busySkips <= 11);
+  CHECK(a.pings >= 9 && a.pings <= 11);
+  CHECK(sched.channelStats(1).busySkips == 0);
+  CHECK(sched.effectiveHz(1, simMicros) > 19.0);
+
+  // The sensor answers again: back to every slot
+  echoWidthUs[0] = 60 * 58;
+  run(sched, 200000);
+  EchoSample sample;
+  CHECK(sched.take(0, sample) && sample.widthUs == 60 * 58);
+}
+
+void testNoCatchUpBurst() {
+  resetSim();
+  echoWidthUs[0] = 50 * 58;
+  echoWidthUs[1] = 50 * 58;
+  SonarScheduler sched(captureA, captureB, simTrigger, SONAR_SLOT_US, SONAR_LISTEN_US, SONAR_HORIZON_US);
+  sched.start(simMicros);
+  sched.update(simMicros);
+
+  // loop() stalls for 100 ms, then resumes
+  simMicros += 100000;
+  uint32_t before = sched.channelStats(0).pings + sched.channelStats(1).pings;
+  sched.update(simMicros);
+  sched.update(simMicros + STEP_US);
+  uint32_t after = sched.channelStats(0).pings + sched.channelStats(1).pings;
+  CHECK(after - before == 1);
+}
+
+// The recorder may stall the CPU only while neither sensor is listening,
+// and only until the next ping
+void testQuietUs() {
+  resetSim();
+  echoWidthUs[0] = 30 * 58;
+  echoWidthUs[1] = 0;                    // B listens out its whole window
+  SonarScheduler sched(captureA, captureB, simTrigger, SONAR_SLOT_US, SONAR_LISTEN_US, SONAR_HORIZON_US);
+  CHECK(sched.quietUs(simMicros) == UINT32_MAX);
+  sched.start(simMicros);
+
+  run(sched, 1000);
+  CHECK(sched.quietUs(simMicros) == 0);  // A's echo still out
+
+  run(sched, 4000);                      // A answered at ~1.8 ms
+  CHECK(sched.quietUs(simMicros) == SONAR_SLOT_US - simMicros);
+
+  run(sched, SONAR_SLOT_US + 1000 - simMicros);
+  CHECK(sched.quietUs(simMicros) == 0);
+  run(sched, SONAR_SLOT_US + SONAR_LISTEN_US - 1000 - simMicros);
+  CHECK(sched.quietUs(simMicros) == 0);
+
+  run(sched, 2000);                      // B timed out
+  CHECK(sched.quietUs(simMicros) == 2 * SONAR_SLOT_US - simMicros);
+}
+
+int main() {
+  testInterleavedRate();
+  testCrosstalkAfterLatePing();
+  testCrosstalkInLongWindow();
+  testTimeoutsCounted();
+  testBusySensorSkipped();
+  testNoCatchUpBurst();
+  testQuietUs();
+
+  if (failures == 0) printf("SonarScheduler: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
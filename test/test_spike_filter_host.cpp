@@ -0,0 +1,196 @@
+// Host-side test + benchmark for HampelFilter against the EMA + jump check
+//   g++ -std=c++11 -O2 -Iinclude test/test_spike_filter_host.cpp -o spike_test && ./spike_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include "SignalPath.h"
+#include "SpikeFilter.h"
+#include "TestCheck.h"
+
+// Same settings as main.cpp
+const float NO_READING_VAL = -1.0;
+const float DIST_FILTER_ALPHA = 0.70;
+const float MAX_DIST_JUMP_CM = 60.0;
+const int   HAMPEL_WINDOW = 5;
+const float HAMPEL_K = 3.0;
+const float HAMPEL_MIN_DEV_CM = 8.0;
+
+const int MODE_JUMP = 0;
+const int MODE_MEDIAN = 1;
+const int MODE_HAMPEL = 2;
+const char* MODE_NAMES[] = { "EMA+jump", "median+EMA", "Hampel+EMA" };
+
+float gaussian() {
+  float u1 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+  float u2 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+  return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+// One axis of getFilteredDistance() in each mode
+struct Axis {
+  int mode;
+  float smoothed;
+  HampelFilter<float, HAMPEL_WINDOW> spikes;
+
+  Axis(int m, float start) : mode(m), smoothed(start), spikes(HAMPEL_K, HAMPEL_MIN_DEV_CM, MAX_DIST_JUMP_CM) {}
+
+  float step(float raw) {
+    if (mode == MODE_JUMP) {
+      smoothed = filterDistance(raw, smoothed, DIST_FILTER_ALPHA, MAX_DIST_JUMP_CM, NO_READING_VAL);
+      return smoothed;
+    }
+    if (raw == NO_READING_VAL) return smoothed;
+    raw = (mode == MODE_MEDIAN) ? spikes.push(raw) : spikes.filter(raw);
+    smoothed = lowPass(raw, smoothed, DIST_FILTER_ALPHA);
+    return smoothed;
+  }
+};
+
+// ---------------------------------------------------------
+// Correctness against a brute-force sort
+// ---------------------------------------------------------
+template <typename T>
+void checkAgainstSort() {
+  HampelFilter<T, 7> f(3.0, 0.0, 1000.0);
+  float history[7];
+  int n = 0;
+  srand(42);
+  for (int i = 0; i < 5000; i++) {
+    float x = (rand() % 20000) / 100.0;
+    if (n == 7) { for (int j = 0; j < 6; j++) history[j] = history[j + 1]; n = 6; }
+    history[n++] = toFloat(T(x));
+    T med = f.push(T(x));
+
+    float sorted[7];
+    std::copy(history, history + n, sorted);
+    std::sort(sorted, sorted + n);
+    float expMed = sorted[n / 2];
+    float dev[7];
+    for (int j = 0; j < n; j++) dev[j] = fabsf(sorted[j] - expMed);
+    std::sort(dev, dev + n);
+    float expMad = dev[n / 2];
+
+    if (fabsf(toFloat(med) - expMed) > 1e-3 || fabsf(toFloat(f.mad()) - expMad) > 1e-3) {
+      CHECK(false);
+      return;
+    }
+  }
+}
+
+void testHampelBehaviour() {
+  HampelFilter<float, 5> f(3.0, 8.0, 60.0);
+  for (int i = 0; i < 5; i++) f.filter(100.0 + (i % 2));
+  CHECK(f.filter(400.0) == f.median());   // Lone spike replaced
+  CHECK(f.filter(101.0) == 101.0);        // Inlier untouched
+
+  // A real step is accepted once it holds the window majority
+  HampelFilter<float, 5> g(3.0, 8.0, 60.0);
+  for (int i = 0; i < 5; i++) g.filter(150.0);
+  float out = 0;
+  int ticks = 0;
+  while (out != 70.0 && ticks < 10) { out = g.filter(70.0); ticks++; }
+  CHECK(ticks == 3);
+}
+
+// ---------------------------------------------------------
+// Benchmark: rejection and latency per mode
+// ---------------------------------------------------------
+struct Result {
+  float rmsCm;
+  int spikesPassed;
+  float rampLagCm;
+  int stepTicks;
+  double nsPerUpdate;
+};
+
+Result runBenchmark(int mode) {
+  Result r;
+  const int TICKS = 60;                  // 3 s at 20 Hz, 150 -> 25 cm
+
+  // Spiky approach: noise, 10% spikes, 5% dropouts, averaged over seeds
+  double sq = 0;
+  int samples = 0;
+  r.spikesPassed = 0;
+  for (int seed = 0; seed < 200; seed++) {
+    srand(seed);
+    Axis axis(mode, 150.0);
+    for (int i = 0; i < HAMPEL_WINDOW; i++) axis.step(150.0 + gaussian());  // Ground idle
+    for (int i = 0; i < TICKS; i++) {
+      float truth = 150.0 - 125.0 * i / (TICKS - 1);
+      float raw = truth + gaussian();
+      int roll = rand() % 100;
+      if (roll < 5) raw = NO_READING_VAL;
+      else if (roll < 10) raw = truth + 40.0 + rand() % 200;   // Multipath / far wall
+      else if (roll < 15) raw = truth * 0.3;                    // Crosstalk, short
+      float out = axis.step(raw);
+      float err = out - truth;
+      sq += err * err;
+      samples++;
+      if (fabsf(err) > 10.0) r.spikesPassed++;
+    }
+  }
+  r.rmsCm = sqrt(sq / samples);
+
+  // Clean ramp: mean lag behind the truth once settled
+  {
+    Axis axis(mode, 150.0);
+    float lag = 0;
+    for (int i = 0; i < TICKS; i++) {
+      float truth = 150.0 - 125.0 * i / (TICKS - 1);
+      float out = axis.step(truth);
+      if (i >= 10) lag += out - truth;
+    }
+    r.rampLagCm = lag / (TICKS - 10);
+  }
+
+  // Genuine 80 cm step (next wall segment): ticks to reach 90%
+  {
+    Axis axis(mode, 150.0);
+    for (int i = 0; i < 10; i++) axis.step(150.0);
+    r.stepTicks = -1;
+    for (int i = 1; i <= 40; i++) {
+      if (axis.step(70.0) <= 78.0) { r.stepTicks = i; break; }
+    }
+  }
+
+  // Cost per update
+  {
+    Axis axis(mode, 100.0);
+    const int N = 2000000;
+    clock_t start = clock();
+    for (int i = 0; i < N; i++) axis.step(100.0 + (i % 17) - ((i % 23) == 0 ? 90 : 0));
+    clock_t end = clock();
+    volatile float sink = axis.smoothed;
+    (void)sink;
+    r.nsPerUpdate = (double)(end - start) * 1e9 / CLOCKS_PER_SEC / N;
+  }
+  return r;
+}
+
+int main() {
+  checkAgainstSort<float>();
+  checkAgainstSort<Q16>();
+  testHampelBehaviour();
+
+  printf("%-12s %8s %8s %10s %10s %8s\n", "Mode", "RMS(cm)", "Spikes", "Lag(cm)", "Step(tk)", "ns/upd");
+  Result results[3];
+  for (int mode = 0; mode < 3; mode++) {
+    results[mode] = runBenchmark(mode);
+    const Result &r = results[mode];
+    printf("%-12s %8.2f %8d %10.2f %10d %8.1f\n", MODE_NAMES[mode], r.rmsCm, r.spikesPassed,
+           r.rampLagCm, r.stepTicks, r.nsPerUpdate);
+  }
+
+  // Hampel must beat the jump check on spikes without adding ramp lag,
+  // and must accept a genuine step the jump check holds off forever.
+  CHECK(results[MODE_HAMPEL].spikesPassed < results[MODE_JUMP].spikesPassed);
+  CHECK(results[MODE_HAMPEL].rmsCm < results[MODE_JUMP].rmsCm);
+  CHECK(fabsf(results[MODE_HAMPEL].rampLagCm - results[MODE_JUMP].rampLagCm) < 0.5);
+  CHECK(results[MODE_JUMP].stepTicks == -1);
+  CHECK(results[MODE_HAMPEL].stepTicks > 0);
+
+  if (failures == 0) printf("SpikeFilter: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
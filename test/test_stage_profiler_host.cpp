@@ -0,0 +1,163 @@
+// Host-side tests for the stage profiler: bucket edges, min / mean / max,
+// clock overhead removal, scope and lap markers on a scripted clock, the
+// switched-off profiler compiling to nothing, and the std::chrono clock on
+// real work
+//   g++ -std=c++11 -O2 -Iinclude test/test_stage_profiler_host.cpp -o stage_profiler_test && ./stage_profiler_test
+#include <stdio.h>
+#include <type_traits>
+#include "StageProfiler.h"
+#include "TestCheck.h"
+
+// 48 ticks per µs like the SAMD21; every read costs READ_COST ticks
+struct ScriptedClock {
+  static const uint32_t TICKS_PER_US = 48;
+  static const uint32_t READ_COST = 5;
+  static uint32_t ticks;
+  static uint32_t now() {
+    uint32_t t = ticks;
+    ticks += READ_COST;
+    return t;
+  }
+  static void spendUs(uint32_t us) { ticks += us * TICKS_PER_US; }
+};
+uint32_t ScriptedClock::ticks = 0xFFFFF000;     // Wraps during the tests
+
+enum { A, B, C, STAGES };
+typedef StageProfiler<ScriptedClock, STAGES> Scripted;
+
+// ---------------------------------------------------------
+// 1. Buckets and summary stats from raw samples
+// ---------------------------------------------------------
+void testBuckets() {
+  Scripted p;
+  const uint32_t us[] = { 0, 1, 2, 4, 5, 19, 20, 999, 1000, 4999, 5000, 60000 };
+  const int bucket[] = { 0, 0, 1, 1, 2, 3, 4, 8, 9, 10, 11, 11 };
+  for (int i = 0; i < 12; i++) {
+    Scripted q;
+    q.record(A, us[i] * 48);
+    CHECK(q.stageStats(A).buckets[bucket[i]] == 1);
+    p.record(A, us[i] * 48);
+  }
+  const StageHistogram &h = p.stageStats(A);
+  CHECK(h.count == 12);
+  CHECK(h.minTicks == 0);
+  CHECK(h.maxTicks == 60000u * 48);
+  uint32_t total = 0;
+  for (int b = 0; b < PROFILE_BUCKETS; b++) total += h.buckets[b];
+  CHECK(total == 12);
+  CHECK(p.meanUs(A) > 6004.0f && p.meanUs(A) < 6004.2f);   // 72049 / 12
+  CHECK(p.stageStats(B).count == 0);
+
+  p.resetStats();
+  CHECK(p.stageStats(A).count == 0 && p.stageStats(A).buckets[11] == 0);
+}
+
+// ---------------------------------------------------------
+// 2. Markers: scopes nest, laps split a function, the clock read is
+//    taken off every sample, the 32-bit wrap is harmless
+// ---------------------------------------------------------
+void testMarkers() {
+  Scripted p;
+  p.calibrate();
+  CHECK(p.overheadTicks() == ScriptedClock::READ_COST);
+
+  {
+    StageScope<Scripted> outer(p, C);
+    StageLap<Scripted> laps(p);
+    ScriptedClock::spendUs(30);
+    laps.lap(A);
+    {
+      StageScope<Scripted> inner(p, B);
+      ScriptedClock::spendUs(7);
+    }
+    laps.lap(A);
+    ScriptedClock::spendUs(150);
+  }
+  const StageHistogram &a = p.stageStats(A);
+  const StageHistogram &b = p.stageStats(B);
+  const StageHistogram &c = p.stageStats(C);
+  CHECK(a.count == 2);
+  CHECK(a.maxTicks == 30 * 48);
+  // Second lap holds the inner scope and its two clock reads
+  CHECK(a.minTicks == 7 * 48 + 2 * ScriptedClock::READ_COST);
+  CHECK(b.count == 1 && b.minTicks == 7 * 48 && b.buckets[2] == 1);
+  CHECK(c.count == 1);
+  // Outer: 187µs of work plus the five clock reads made inside it
+  CHECK(c.maxTicks == 187 * 48 + 5 * ScriptedClock::READ_COST);
+  CHECK(c.buckets[6] == 1);
+}
+
+// ---------------------------------------------------------
+// 3. Switched off: no storage, no clock reads, no samples
+// ---------------------------------------------------------
+void testDisabled() {
+  typedef StageProfiler<ScriptedClock, STAGES, false> Off;
+  CHECK(std::is_empty<Off>::value);
+  CHECK(!Off::ENABLED);
+  Off p;
+  p.calibrate();
+  uint32_t before = ScriptedClock::ticks;
+  {
+    StageScope<Off> scope(p, A);
+    StageLap<Off> laps(p);
+    laps.lap(B);
+  }
+  CHECK(ScriptedClock::ticks == before);
+  CHECK(p.stageStats(A).count == 0);
+  printf("Profiler RAM: %u bytes for %d stages, %u switched off (empty class)\n",
+         (unsigned)sizeof(Scripted), (int)STAGES, (unsigned)sizeof(Off));
+}
+
+// ---------------------------------------------------------
+// 4. std::chrono clock on real work
+// ---------------------------------------------------------
+volatile uint32_t sink;
+
+void spin(int n) {
+  uint32_t x = 1;
+  for (int i = 0; i < n; i++) x = x * 1664525u + 1013904223u;
+  sink = x;
+}
+
+void testHostClock() {
+  typedef StageProfiler<HostClock, STAGES> Host;
+  Host p;
+  p.calibrate();
+
+  // Spin count for about 100µs
+  int n = 1000;
+  for (;;) {
+    uint32_t start = HostClock::now();
+    spin(n);
+    if (HostClock::now() - start > 100000) break;
+    n *= 2;
+  }
+  for (int i = 0; i < 200; i++) {
+    StageScope<Host> scope(p, A);
+    spin(n);
+  }
+  for (int i = 0; i < 100000; i++) {
+    StageScope<Host> scope(p, B);
+  }
+  const StageHistogram &a = p.stageStats(A);
+  const StageHistogram &b = p.stageStats(B);
+  printf("Host clock: overhead %u ns; ~100us of work: min %.1f mean %.1f max %.1f us; "
+         "empty scope mean %.3f us\n",
+         (unsigned)p.overheadTicks(), Host::toUs(a.minTicks), p.meanUs(A), Host::toUs(a.maxTicks),
+         p.meanUs(B));
+  CHECK(a.count == 200);
+  CHECK(Host::toUs(a.minTicks) >= 50.0f);
+  CHECK(a.buckets[0] + a.buckets[1] + a.buckets[2] + a.buckets[3] + a.buckets[4] == 0);
+  CHECK(b.count == 100000);
+  CHECK(p.meanUs(B) < 1.0f);
+}
+
+int main() {
+  testBuckets();
+  testMarkers();
+  testDisabled();
+  testHostClock();
+
+  if (failures == 0) printf("Stage profiler: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+// Host-side replay test: alpha-beta tracker vs EMA + difference + RollingAverage
+//   g++ -std=c++11 -O2 -Iinclude test/test_state_estimator_host.cpp -o estimator_test && ./estimator_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "SignalPath.h"
+#include "StateEstimator.h"
+#include "TestCheck.h"
+
+// Same settings as main.cpp
+const float NO_READING_VAL = -1.0;
+const float DIST_FILTER_ALPHA = 0.70;
+const int   RATE_AVG_WINDOW_SIZE = 3;
+const float TRACKER_ALPHA = 0.70;
+const float TRACKER_BETA = 0.35;
+const int   TRACKER_MAX_COAST = 6;
+const float RATE_THRESHOLD = 50.0;
+const float DT = 0.05;
+
+float gaussian() {
+  float u1 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+  float u2 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+  return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+// The loop's original rate path for one axis
+struct LegacyRate {
+  float current;
+  float prev;
+  RollingAverage<float, RATE_AVG_WINDOW_SIZE> smoother;
+  float rate;
+
+  LegacyRate(float start) : current(start), prev(start), rate(0.0) {}
+
+  void step(float raw, float dt) {
+    current = filterDistance(raw, current, DIST_FILTER_ALPHA, (float)1e9, NO_READING_VAL);
+    rate = smoother.add(closureRate(current, prev, dt));
+    prev = current;
+  }
+};
+
+struct TrackerRate {
+  AlphaBetaTracker<float> tracker;
+  float rate;
+
+  TrackerRate(float start) : tracker(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST), rate(0.0) {
+    tracker.reset(start);
+  }
+
+  void step(float raw, float dt) {
+    tracker.step(raw, dt, NO_READING_VAL);
+    rate = tracker.closureRate();
+  }
+};
+
+// ---------------------------------------------------------
+// Synthetic replay: hold at 150 cm for 1 s, then close at closingCmS
+// ---------------------------------------------------------
+struct Replay {
+  float detectMs;      // Onset to first rate > threshold
+  int falseTriggers;   // Rate > threshold while stationary
+  float rateRmsCm;     // Rate error once closing, after 0.5 s
+};
+
+template <typename Est>
+Replay replay(float closingCmS, float noiseCm, int dropoutPct, int seeds) {
+  Replay out = { 0, 0, 0 };
+  double sq = 0;
+  int sqN = 0;
+  int detected = 0;
+
+  for (int seed = 0; seed < seeds; seed++) {
+    srand(seed);
+    Est est(150.0);
+    const int ONSET = 20;
+    for (int i = 0; i < 60; i++) {
+      float t = (i - ONSET) * DT;
+      float truth = i < ONSET ? 150.0 : 150.0 - closingCmS * t;
+      float raw = truth + noiseCm * gaussian();
+      if (rand() % 100 < dropoutPct) raw = NO_READING_VAL;
+      est.step(raw, DT);
+
+      if (i < ONSET && est.rate > RATE_THRESHOLD) out.falseTriggers++;
+      if (i >= ONSET && est.rate > RATE_THRESHOLD && i - ONSET < 40) {
+        out.detectMs += (i - ONSET) * DT * 1000.0;
+        detected++;
+        i = 60;                          // Stop at first detection
+        continue;
+      }
+    }
+
+    // Steady closing rate error
+    srand(seed + 1000);
+    Est est2(150.0);
+    for (int i = 0; i < 40; i++) {
+      float truth = 150.0 - closingCmS * i * DT;
+      float raw = truth + noiseCm * gaussian();
+      if (rand() % 100 < dropoutPct) raw = NO_READING_VAL;
+      est2.step(raw, DT);
+      if (i >= 10) {
+        float e = est2.rate - closingCmS;
+        sq += e * e;
+        sqN++;
+      }
+    }
+  }
+  out.detectMs = detected ? out.detectMs / detected : -1;
+  out.rateRmsCm = sqrt(sq / sqN);
+  return out;
+}
+
+// ---------------------------------------------------------
+// Unit behaviour
+// ---------------------------------------------------------
+void testConvergesOnRamp() {
+  AlphaBetaTracker<float> t(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST);
+  t.reset(150.0);
+  for (int i = 1; i <= 60; i++) t.step(150.0 - 60.0 * i * DT, DT, NO_READING_VAL);
+  CHECK(fabsf(t.closureRate() - 60.0) < 0.1);
+  CHECK(fabsf(t.distance() - (150.0 - 60.0 * 60 * DT)) < 0.1);
+}
+
+void testCoastsThroughMisses() {
+  AlphaBetaTracker<float> t(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST);
+  t.reset(150.0);
+  int i = 1;
+  for (; i <= 40; i++) t.step(150.0 - 60.0 * i * DT, DT, NO_READING_VAL);
+
+  // Three missed pings: rate holds, distance keeps closing
+  float before = t.distance();
+  for (int k = 0; k < 3; k++, i++) t.step(NO_READING_VAL, DT, NO_READING_VAL);
+  CHECK(t.coasting());
+  CHECK(fabsf(t.closureRate() - 60.0) < 0.5);
+  CHECK(fabsf((before - t.distance()) - 60.0 * 3 * DT) < 0.5);
+
+  // Echo returns where predicted: no rate spike
+  t.step(150.0 - 60.0 * i * DT, DT, NO_READING_VAL);
+  CHECK(fabsf(t.closureRate() - 60.0) < 1.0);
+
+  // Long outage: rate is dropped
+  for (int k = 0; k < TRACKER_MAX_COAST; k++) t.step(NO_READING_VAL, DT, NO_READING_VAL);
+  CHECK(t.closureRate() == 0.0);
+}
+
+void testFixedPointMatches() {
+  AlphaBetaTracker<float> fl(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST);
+  AlphaBetaTracker<Q16> fx(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST);
+  fl.reset(150.0);
+  fx.reset(150.0);
+  srand(7);
+  float worst = 0;
+  for (int i = 1; i <= 200; i++) {
+    float z = 150.0 - 0.5 * i + gaussian();
+    if (i % 17 == 0) z = NO_READING_VAL;
+    fl.step(z, DT, NO_READING_VAL);
+    fx.step(Q16(z), Q16(DT), Q16(NO_READING_VAL));
+    float d = fabsf(fl.closureRate() - toFloat(fx.closureRate()));
+    if (d > worst) worst = d;
+  }
+  CHECK(worst < 0.1);
+}
+
+int main() {
+  testConvergesOnRamp();
+  testCoastsThroughMisses();
+  testFixedPointMatches();
+
+  const int SEEDS = 500;
+  printf("%-22s %12s %14s %14s\n", "Estimator", "Detect(ms)", "FalseTrig", "RateRMS(cm/s)");
+  float closing[] = { 80.0, 120.0 };
+  for (int c = 0; c < 2; c++) {
+    Replay legacy = replay<LegacyRate>(closing[c], 1.0, 5, SEEDS);
+    Replay ab = replay<TrackerRate>(closing[c], 1.0, 5, SEEDS);
+    printf("EMA+diff+avg3 @%3.0f    %12.1f %14d %14.2f\n", closing[c], legacy.detectMs, legacy.falseTriggers, legacy.rateRmsCm);
+    printf("alpha-beta    @%3.0f    %12.1f %14d %14.2f\n", closing[c], ab.detectMs, ab.falseTriggers, ab.rateRmsCm);
+
+    CHECK(ab.detectMs < legacy.detectMs);
+    CHECK(ab.falseTriggers <= legacy.falseTriggers);
+    CHECK(ab.rateRmsCm < legacy.rateRmsCm);
+  }
+
+  if (failures == 0) printf("StateEstimator: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+// Host-side test for TaskExecutor on a virtual clock (no board needed)
+//   g++ -std=c++11 -Iinclude test/test_task_executor_host.cpp -o executor_test && ./executor_test
+#include <stdio.h>
+#include <string.h>
+#include "TaskExecutor.h"
+#include "TestCheck.h"
+
+// ---------------------------------------------------------
+// Virtual clock: tasks "take time" by advancing it
+// ---------------------------------------------------------
+uint32_t simMicros = 0;
+uint32_t virtualClock() { return simMicros; }
+
+char trace[256];
+int traceLen = 0;
+void mark(char c) { if (traceLen < 255) { trace[traceLen++] = c; trace[traceLen] = 0; } }
+void clearTrace() { traceLen = 0; trace[0] = 0; }
+
+uint32_t sonarCostUs = 20;
+uint32_t controlCostUs = 3000;
+uint32_t telemetryCostUs = 1500;
+int backgroundRuns = 0;
+
+void sonarTask(uint32_t)     { mark('s'); simMicros += sonarCostUs; }
+void controlTask(uint32_t)   { mark('C'); simMicros += controlCostUs; }
+void telemetryTask(uint32_t) { mark('t'); simMicros += telemetryCostUs; }
+void idleTask(uint32_t)      { backgroundRuns++; simMicros += 5; }
+
+// Externally released task (stands in for the TC3 flag)
+bool controlFlag = false;
+bool controlReleased(uint32_t) {
+  bool f = controlFlag;
+  controlFlag = false;
+  return f;
+}
+
+// Runs the executor until the virtual clock reaches endUs; between polls
+// a loop pass costs passUs.
+template <int N>
+void runUntil(TaskExecutor<N> &ex, uint32_t endUs, uint32_t passUs = 10) {
+  while (simMicros < endUs) {
+    ex.poll();
+    simMicros += passUs;
+  }
+}
+
+// ---------------------------------------------------------
+// Tests
+// ---------------------------------------------------------
+const Task MULTI_RATE[] = {
+  { "sonar",     sonarTask,     250,    NULL, 1000, 0 },
+  { "control",   controlTask,   50000,  NULL, 10000, 1 },
+  { "telemetry", telemetryTask, 200000, NULL, 0,    3 },
+  { "idle",      idleTask,      0,      NULL, 0,    9 },
+};
+
+void testRatesAndPriorities() {
+  simMicros = 0;
+  clearTrace();
+  TaskExecutor<4> ex(MULTI_RATE, virtualClock);
+  ex.start(0);
+
+  // All three periodic tasks are released at t=0 and run by priority, one
+  // per poll; sonar's next release beats telemetry while control runs
+  for (int i = 0; i < 4; i++) ex.poll();
+  CHECK(strcmp(trace, "sCst") == 0);
+
+  runUntil(ex, 1000000);
+  CHECK(ex.taskStats(1).runs == 20);                 // 20 Hz control
+  CHECK(ex.taskStats(2).runs == 5);                  // 5 Hz telemetry
+  CHECK(ex.taskStats(0).runs > 3000);                // Sonar runs between them
+  CHECK(ex.taskStats(1).deadlineMisses == 0);
+  CHECK(ex.taskStats(2).deadlineMisses == 0);
+  CHECK(backgroundRuns > 0);                         // Slack left over
+
+  // Control never waits behind more than one sonar pass
+  CHECK(ex.taskStats(1).maxLatencyUs <= sonarCostUs + 20);
+  // Sonar sits out whole control and telemetry runs: those releases are
+  // skipped, and it restarts on the newest one
+  CHECK(ex.taskStats(0).skipped >= 20 * (controlCostUs / 250 - 1));
+  CHECK(ex.taskStats(0).maxLatencyUs < 250 + sonarCostUs);
+}
+
+void testNoDriftFromSlowRuns() {
+  // Control takes 40% of its period; releases still land on the 50 ms grid
+  const Task table[] = { { "control", controlTask, 50000, NULL, 0, 0 } };
+  simMicros = 0;
+  controlCostUs = 20000;
+  TaskExecutor<1> ex(table, virtualClock);
+  ex.start(0);
+  runUntil(ex, 10000000 - 1, 700);                   // 10 s, coarse loop passes
+  CHECK(ex.taskStats(0).runs == 200);
+  CHECK(ex.taskStats(0).maxLatencyUs < 700);
+  CHECK(ex.taskStats(0).deadlineMisses == 0);
+  controlCostUs = 3000;
+}
+
+void testOverrunSkipsAndMissesDeadline() {
+  const Task table[] = {
+    { "control", controlTask, 50000, NULL, 10000, 0 },
+    { "telemetry", telemetryTask, 200000, NULL, 0, 1 },
+  };
+  simMicros = 0;
+  telemetryCostUs = 120000;                          // A blocking serial dump
+  TaskExecutor<2> ex(table, virtualClock);
+  ex.start(0);
+  ex.poll();                                         // Control at 0
+  ex.poll();                                         // Telemetry 3000..123000
+  CHECK(simMicros == 123000);
+  clearTrace();
+  ex.poll();                                         // Control, once, for 100000
+  CHECK(strcmp(trace, "C") == 0);
+  CHECK(ex.taskStats(0).skipped == 1);               // 50000 release lost
+  CHECK(ex.taskStats(0).deadlineMisses == 1);        // Released 100000, done 126000
+  CHECK(ex.taskStats(0).maxLatencyUs == 23000);
+  ex.poll();                                         // Nothing due: no catch-up
+  CHECK(ex.taskStats(0).runs == 2);
+  telemetryCostUs = 1500;
+}
+
+void testExternalRelease() {
+  const Task table[] = {
+    { "sonar",   sonarTask,   250, NULL,            1000,  0 },
+    { "control", controlTask, 0,   controlReleased, 10000, 1 },
+  };
+  simMicros = 0;
+  TaskExecutor<2> ex(table, virtualClock);
+  ex.start(0);
+  runUntil(ex, 100000);
+  CHECK(ex.taskStats(1).runs == 0);                  // Never released
+
+  controlFlag = true;                                // "ISR" fires
+  runUntil(ex, 101000);
+  CHECK(ex.taskStats(1).runs == 1);
+  CHECK(ex.taskStats(1).deadlineMisses == 0);
+  runUntil(ex, 200000);
+  CHECK(ex.taskStats(1).runs == 1);
+}
+
+void testResetStats() {
+  simMicros = 0;
+  TaskExecutor<4> ex(MULTI_RATE, virtualClock);
+  ex.start(0);
+  runUntil(ex, 100000);
+  ex.resetStats();
+  for (int i = 0; i < ex.size(); i++) {
+    CHECK(ex.taskStats(i).runs == 0);
+    CHECK(ex.taskStats(i).deadlineMisses == 0);
+  }
+}
+
+void testClockWrap() {
+  const Task table[] = { { "control", controlTask, 50000, NULL, 0, 0 } };
+  simMicros = 0xFFFFFFFFu - 120000;
+  TaskExecutor<1> ex(table, virtualClock);
+  ex.start(simMicros);
+  uint32_t start = simMicros;
+  while (simMicros - start < 300000) {
+    ex.poll();
+    simMicros += 10;
+  }
+  CHECK(ex.taskStats(0).runs == 6);
+  CHECK(ex.taskStats(0).skipped == 0);
+}
+
+int main() {
+  testRatesAndPriorities();
+  testNoDriftFromSlowRuns();
+  testOverrunSkipsAndMissesDeadline();
+  testExternalRelease();
+  testResetStats();
+  testClockWrap();
+
+  if (failures == 0) printf("TaskExecutor: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
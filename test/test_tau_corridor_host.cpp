@@ -0,0 +1,65 @@
+// Host-side corridor test of the time-to-contact law: src/main.cpp built
+// with CONTROL_LAW = LAW_TAU, flown by CorridorSimEngine on the seeds
+// test/test_corridor_sim_host.cpp flies the shipped threshold law on
+//   g++ -std=c++11 -O2 -Iinclude test/test_tau_corridor_host.cpp -o tau_test && ./tau_test
+#define PROFILE_STAGES 0
+#define CONTROL_LAW LAW_TAU
+#include "../src/main.cpp"
+#include "../tools/sim/CorridorSim.h"
+#include "TestCheck.h"
+
+// The threshold law on seeds 100-399, from test_corridor_sim_host.cpp
+// (and corridor_sim -n 300 -s 100)
+const int THRESHOLD_CLEARED = 75;
+const int THRESHOLD_RIGHT_HITS = 8;
+
+// ---------------------------------------------------------
+// The cases from the request, straight through the policies with
+// main.cpp's rudder axis
+// ---------------------------------------------------------
+void testRequestCases() {
+  ControlLaw<BangBangHold<real_t> > threshold(RUDDER_AXIS);
+  ControlLaw<TauProportional<real_t> > tau(RUDDER_AXIS);
+
+  // 55 cm/s at 140 cm is 2.5 s out: harmless, but over the threshold
+  CHECK(threshold.update(140.0, 55.0, 0) == RUDDER_AXIS.correctUs);
+  CHECK(tau.update(140.0, 55.0, 0) == RUDDER_AXIS.neutralUs);
+
+  // 40 cm/s at 25 cm is 0.6 s out: the threshold never sees it
+  ControlLaw<BangBangHold<real_t> > threshold2(RUDDER_AXIS);
+  CHECK(threshold2.update(25.0, 40.0, 0) == RUDDER_AXIS.neutralUs);
+  CHECK(abs(tau.update(25.0, 40.0, 0) - RUDDER_AXIS.neutralUs) > 600);
+}
+
+int main() {
+  testRequestCases();
+
+  // ---------------------------------------------------------
+  // main.cpp with the tau law in the loop. The threshold law holds full
+  // rudder into the left wall (72% of these flights); the ramp only turns
+  // as hard as the time to contact calls for, and clears three times as
+  // many, at the price of more right-wall contacts. As built here it
+  // clears 226 of the 300 and hits the right wall 55 times.
+  // ---------------------------------------------------------
+  SimConfig cfg = defaultSimConfig();
+  CorridorSimEngine engine;
+  const int FLIGHTS = 300;
+  int cleared = 0, rightHits = 0, leftHits = 0, launched = 0;
+  for (int f = 0; f < FLIGHTS; f++) {
+    SimResult r;
+    CHECK(engine.fly(cfg, 100 + f, r));
+    if (r.launched && r.servoWrites > 0) launched++;
+    if (r.outcome == GliderSim::CLEARED) cleared++;
+    if (r.outcome == GliderSim::HIT_RIGHT) rightHits++;
+    if (r.outcome == GliderSim::HIT_LEFT) leftHits++;
+  }
+  printf("LAW_TAU: cleared %d/%d, right wall %d, left wall %d; threshold law: cleared %d, right wall %d\n",
+         cleared, FLIGHTS, rightHits, leftHits, THRESHOLD_CLEARED, THRESHOLD_RIGHT_HITS);
+  CHECK(launched == FLIGHTS);
+  CHECK(cleared > 2 * THRESHOLD_CLEARED);
+  CHECK(leftHits * 5 < FLIGHTS - THRESHOLD_CLEARED - THRESHOLD_RIGHT_HITS);
+  CHECK(rightHits < FLIGHTS / 4);
+
+  if (failures == 0) printf("Tau corridor: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+// Host-side model of TCC0 driving two servos: checks that TccServo::write()
+// lands both widths in the same frame and measures command-to-edge latency
+// against the Servo library's staggered channels
+//   g++ -std=c++11 -O2 -Iinclude test/test_tcc_servo_host.cpp -o tcc_test && ./tcc_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "TccServo.h"
+#include "TestCheck.h"
+
+const uint32_t CPU = TccServo<int>::COUNTS_PER_US;   // Counts per microsecond
+
+// ---------------------------------------------------------
+// TCC0 model: counter, PER, CCx with CCBx buffers copied at overflow
+// unless LUPD is set, normal PWM outputs high from each frame start until
+// CCx. Every register access takes one count (synchronisation), and an
+// interrupt can be made to land between the two buffer writes.
+// ---------------------------------------------------------
+struct Pulse {
+  uint64_t startCount;
+  int channel;
+  uint32_t widthCounts;
+};
+
+class MockTcc {
+  public:
+    uint64_t now;                // Counts since configure()
+    uint32_t per;
+    uint32_t cc[2], ccb[2];
+    bool bufferValid[2];
+    bool lupd;
+    uint64_t nextFrame;
+    uint32_t stallAfterFirstCounts;   // "Interrupt" between the two CCB writes
+    std::vector<Pulse> pulses;
+
+    MockTcc() : now(0), per(0), lupd(false), nextFrame(0), stallAfterFirstCounts(0) {
+      cc[0] = cc[1] = ccb[0] = ccb[1] = 0;
+      bufferValid[0] = bufferValid[1] = false;
+    }
+
+    void advanceTo(uint64_t t) {
+      while (nextFrame <= t) {
+        now = nextFrame;
+        for (int ch = 0; ch < 2; ch++) {
+          if (!lupd && bufferValid[ch]) {
+            cc[ch] = ccb[ch];
+            bufferValid[ch] = false;
+          }
+        }
+        for (int ch = 0; ch < 2; ch++) {
+          Pulse p = { now, ch, cc[ch] };
+          pulses.push_back(p);
+        }
+        nextFrame += per + 1;
+      }
+      now = t;
+    }
+
+    void access() { advanceTo(now + 1); }
+
+    // Hw interface
+    void configure(uint32_t period, uint32_t cc0, uint32_t cc1) {
+      per = period;
+      cc[0] = cc0;
+      cc[1] = cc1;
+      now = 0;
+      nextFrame = 0;
+      pulses.clear();
+      advanceTo(0);
+    }
+    void lockUpdate() { access(); lupd = true; }
+    void unlockUpdate() { access(); lupd = false; }
+    void setBuffered(int channel, uint32_t counts) {
+      access();
+      ccb[channel] = counts;
+      bufferValid[channel] = true;
+      if (channel == 0 && stallAfterFirstCounts) advanceTo(now + stallAfterFirstCounts);
+    }
+};
+
+// First pulse on `channel` with `width` starting after `after`, or 0
+uint64_t firstPulse(const MockTcc &tcc, int channel, uint32_t width, uint64_t after) {
+  for (size_t i = 0; i < tcc.pulses.size(); i++) {
+    const Pulse &p = tcc.pulses[i];
+    if (p.channel == channel && p.startCount > after && p.widthCounts == width) return p.startCount;
+  }
+  return 0;
+}
+
+struct LatencyStats {
+  double meanUs;
+  double maxUs;
+  int splitFrames;     // Writes where the two surfaces changed in different frames
+  int writes;
+};
+
+// Random writes at random points of the frame (or, `nearOverflow`, in its
+// last 60us), every fourth with an interrupt of up to 60us between the two
+// buffer writes. `locked` false writes the buffers without LUPD, as two
+// independent channel updates would.
+LatencyStats runTcc(uint32_t frameUs, bool locked, bool nearOverflow, unsigned seed) {
+  MockTcc tcc;
+  TccServo<MockTcc> out(tcc);
+  out.begin(frameUs, 1100, 1700);
+  CHECK(tcc.per == frameUs * CPU - 1);
+
+  srand(seed);
+  LatencyStats st = { 0, 0, 0, 0 };
+  int w0 = 1100, w1 = 1700;
+  for (int i = 0; i < 2000; i++) {
+    if (nearOverflow) tcc.advanceTo(tcc.nextFrame + frameUs * CPU - 1 - rand() % (60 * CPU));
+    else tcc.advanceTo(tcc.now + rand() % (frameUs * CPU) + frameUs * CPU);
+    tcc.pulses.clear();
+    tcc.stallAfterFirstCounts = (i % 4 == 0) ? (rand() % 60) * CPU : 0;
+    w0 = (w0 == 1100) ? 1500 + rand() % 600 : 1100;
+    w1 = (w1 == 1700) ? 900 + rand() % 600 : 1700;
+
+    uint64_t writeAt = tcc.now;
+    if (locked) {
+      out.write(w0, w1);
+    } else {
+      tcc.setBuffered(0, w0 * CPU);
+      tcc.setBuffered(1, w1 * CPU);
+    }
+    tcc.advanceTo(tcc.now + 3 * frameUs * CPU);
+
+    uint64_t e0 = firstPulse(tcc, 0, w0 * CPU, writeAt);
+    uint64_t e1 = firstPulse(tcc, 1, w1 * CPU, writeAt);
+    CHECK(e0 && e1);
+    if (e0 != e1) st.splitFrames++;
+    uint64_t last = e0 > e1 ? e0 : e1;
+    double latencyUs = (double)(last - writeAt) / CPU;
+    st.meanUs += latencyUs;
+    if (latencyUs > st.maxUs) st.maxUs = latencyUs;
+    st.writes++;
+  }
+  st.meanUs /= st.writes;
+  return st;
+}
+
+// ---------------------------------------------------------
+// Servo library model: one 20ms frame, channels pulsed one after another
+// (channel 1 starts when channel 0 ends), each width read when its pulse
+// starts
+// ---------------------------------------------------------
+LatencyStats runLibrary(unsigned seed) {
+  const uint32_t FRAME_US = 20000;
+  srand(seed);
+  LatencyStats st = { 0, 0, 0, 0 };
+  int w0 = 1100;
+  for (int i = 0; i < 2000; i++) {
+    uint32_t writeAt = 1 + rand() % (FRAME_US - 1);   // After frame 0's channel 0 started
+    int newW0 = (w0 == 1100) ? 1500 + rand() % 600 : 1100;
+
+    // Channel 0 starts at each frame start; channel 1 after channel 0's pulse
+    uint32_t e0 = FRAME_US;
+    uint32_t ch1Start = w0;                       // Frame 0, old channel 0 width
+    uint32_t e1 = (writeAt < ch1Start) ? ch1Start : FRAME_US + newW0;
+    uint32_t frame0 = e0 / FRAME_US;
+    uint32_t frame1 = e1 / FRAME_US;
+    if (frame0 != frame1) st.splitFrames++;
+
+    double latencyUs = (double)((e0 > e1 ? e0 : e1) - writeAt);
+    st.meanUs += latencyUs;
+    if (latencyUs > st.maxUs) st.maxUs = latencyUs;
+    st.writes++;
+    w0 = newW0;
+  }
+  st.meanUs /= st.writes;
+  return st;
+}
+
+void printStats(const char* name, uint32_t frameUs, const LatencyStats &st) {
+  printf("%-28s %8u %10.0f %10.0f %8.1f%%\n", name, frameUs, st.meanUs, st.maxUs,
+         100.0 * st.splitFrames / st.writes);
+}
+
+// ---------------------------------------------------------
+// Hand-placed writes
+// ---------------------------------------------------------
+void testWriteAcrossOverflow() {
+  MockTcc tcc;
+  TccServo<MockTcc> out(tcc);
+  out.begin(20000, 1100, 1700);
+  CHECK(out.frameUs() == 20000);
+  CHECK(tcc.pulses.size() == 2 && tcc.pulses[0].widthCounts == 1100 * CPU);
+
+  // Start the write 5us before the frame ends, with an interrupt between
+  // the two buffers that runs past the frame start
+  uint64_t frame = 20000 * CPU;
+  tcc.advanceTo(frame - 5 * CPU);
+  tcc.stallAfterFirstCounts = 30 * CPU;
+  uint64_t writeAt = tcc.now;
+  out.write(2000, 1000);
+  tcc.advanceTo(3 * frame);
+
+  // The overflow inside the write was locked out: both change a frame later
+  CHECK(firstPulse(tcc, 0, 2000 * CPU, writeAt) == 2 * frame);
+  CHECK(firstPulse(tcc, 1, 1000 * CPU, writeAt) == 2 * frame);
+  CHECK(firstPulse(tcc, 0, 1100 * CPU, writeAt) == frame);   // Old width in between
+}
+
+void testMidFrameWrite() {
+  MockTcc tcc;
+  TccServo<MockTcc> out(tcc);
+  out.begin(3030, 1500, 1500);              // 330Hz digital servo frame
+  tcc.advanceTo(1000 * CPU);
+  out.write(1200, 1800);
+  tcc.advanceTo(4 * 3030 * CPU);
+  CHECK(firstPulse(tcc, 0, 1200 * CPU, 1000 * CPU) == 3030 * CPU);
+  CHECK(firstPulse(tcc, 1, 1800 * CPU, 1000 * CPU) == 3030 * CPU);
+}
+
+int main() {
+  testWriteAcrossOverflow();
+  testMidFrameWrite();
+
+  printf("%-28s %8s %10s %10s %9s\n", "Backend", "Frame", "Mean(us)", "Max(us)", "Split");
+  LatencyStats lib = runLibrary(7);
+  LatencyStats tcc20 = runTcc(20000, true, false, 7);
+  LatencyStats tcc10 = runTcc(10000, true, false, 7);
+  LatencyStats tcc3 = runTcc(3030, true, false, 7);
+  LatencyStats edgeLocked = runTcc(20000, true, true, 7);
+  LatencyStats edgeUnlocked = runTcc(20000, false, true, 7);
+  printStats("Servo library (TC4 ISR)", 20000, lib);
+  printStats("TCC0, LUPD", 20000, tcc20);
+  printStats("TCC0, LUPD", 10000, tcc10);
+  printStats("TCC0, LUPD", 3030, tcc3);
+  printStats("TCC0, LUPD, at overflow", 20000, edgeLocked);
+  printStats("TCC0, no LUPD, at overflow", 20000, edgeUnlocked);
+
+  // Locked writes never split; the same writes without the lock sometimes do
+  CHECK(tcc20.splitFrames == 0 && tcc10.splitFrames == 0 && tcc3.splitFrames == 0);
+  CHECK(edgeLocked.splitFrames == 0);
+  CHECK(edgeUnlocked.splitFrames > 0);
+  CHECK(lib.splitFrames > 0);
+  // At most one frame (plus the longest interrupt and the register syncs)
+  CHECK(tcc20.maxUs <= 20000 + 60 + 2);
+  CHECK(tcc3.maxUs <= 3030 + 60 + 2);
+  CHECK(tcc3.meanUs < tcc20.meanUs / 4);
+
+  if (failures == 0) printf("TccServo: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
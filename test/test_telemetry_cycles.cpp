@@ -0,0 +1,133 @@
+#include <Arduino.h>
+#include "FixedPoint.h"
+#include "Telemetry.h"
+#include "TelemetryDelta.h"
+
+// Cycle counts of one telemetry record: logTelemetry()'s text formatting
+// (into a Print that discards the bytes, so USB time is not included)
+// against encoding a fixed or a delta frame into the ring, and against
+// draining it.
+// SysTick runs at the 48MHz core clock.
+
+const int REPEAT = 100;
+
+class NullPrint : public Print {
+  public:
+    size_t bytes;
+    NullPrint() : bytes(0) {}
+    size_t write(uint8_t) { bytes++; return 1; }
+};
+
+struct NullSink {
+  uint32_t write(const uint8_t *, uint32_t len) { return len; }
+};
+
+NullPrint textOut;
+NullSink binaryOut;
+TelemetryLog<1024> ring;
+TelemetryLog<1024, DeltaFrameCodec> deltaRing;
+
+volatile int jitter = 3;
+
+uint32_t cyclesSince(uint32_t start) {
+  uint32_t now = SysTick->VAL;
+  uint32_t reload = SysTick->LOAD + 1;
+  return (start >= now) ? (start - now) : (start + reload - now);
+}
+
+// Same calls as logTelemetry() in main.cpp
+void textRecord(Print &out, float t, float dR, float dH, float rR, float rH, int rud, int ele) {
+  out.print("T:");
+  out.print(t, 2);
+  out.print(" | DistR:");
+  out.print(dR, 1);
+  out.print(" | DistH:");
+  out.print(dH, 1);
+  out.print(" | RateR:");
+  out.print(rR, 1);
+  out.print(" | RateH:");
+  out.print(rH, 1);
+  out.print(" | Rud:");
+  out.print(rud);
+  out.print(" | Ele:");
+  out.println(ele);
+}
+
+template <class Log>
+void binaryRecord(Log &log, uint32_t ms, Q16 dR, Q16 dH, Q16 rR, Q16 rH, int rud, int ele) {
+  TelemetrySample rec;
+  rec.timeMs = ms;
+  rec.rightMm = toTelemetryMm(dR);
+  rec.heightMm = toTelemetryMm(dH);
+  rec.rateRightMmS = toTelemetryMm(rR);
+  rec.rateHeightMmS = toTelemetryMm(rH);
+  rec.rudderUs = rud;
+  rec.elevatorUs = ele;
+  rec.rightEchoUs = 2610;
+  rec.rightEchoAtUs = 2840;
+  rec.heightEchoUs = 0;
+  rec.heightEchoAtUs = 0;
+  rec.flags = TELEM_FLIGHT | TELEM_RIGHT_VALID;
+  log.push(rec);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  Serial.println("========================================");
+  Serial.println("TELEMETRY RECORD CYCLE COUNT");
+  Serial.println("========================================");
+  Serial.println("Path,Cycles,Bytes");
+}
+
+void loop() {
+  uint32_t start, text = 0, encode = 0, deltaEncode = 0, drain = 0;
+  uint32_t textBytes = 0, binaryBytes = 0, deltaBytes = 0;
+
+  for (int i = 0; i < REPEAT; i++) {
+    int k = jitter + i;
+    noInterrupts();
+    textOut.bytes = 0;
+    start = SysTick->VAL;
+    textRecord(textOut, 1.25 + k * 0.05, 45.3 + k, 105.2 - k, -12.5 + k, 3.4, 1700 - k, 1100 + k);
+    text += cyclesSince(start);
+    textBytes += textOut.bytes;
+
+    start = SysTick->VAL;
+    binaryRecord(ring, 1250 + k * 50, Q16(45.3) + k, Q16(105.2) - k, Q16(-12.5) + k, Q16(3.4), 1700 - k, 1100 + k);
+    encode += cyclesSince(start);
+
+    start = SysTick->VAL;
+    binaryRecord(deltaRing, 1250 + k * 50, Q16(45.3) + k, Q16(105.2) - k, Q16(-12.5) + k, Q16(3.4), 1700 - k, 1100 + k);
+    deltaEncode += cyclesSince(start);
+    deltaBytes += deltaRing.drain(binaryOut, 64);
+
+    start = SysTick->VAL;
+    binaryBytes += ring.drain(binaryOut, 64);
+    drain += cyclesSince(start);
+    interrupts();
+  }
+
+  Serial.print("Text (logTelemetry)");
+  Serial.print(",");
+  Serial.print(text / REPEAT);
+  Serial.print(",");
+  Serial.println(textBytes / REPEAT);
+  Serial.print("Binary encode + push");
+  Serial.print(",");
+  Serial.print(encode / REPEAT);
+  Serial.print(",");
+  Serial.println(binaryBytes / REPEAT);
+  Serial.print("Delta encode + push");
+  Serial.print(",");
+  Serial.print(deltaEncode / REPEAT);
+  Serial.print(",");
+  Serial.println(deltaBytes / REPEAT);
+  Serial.print("Binary drain");
+  Serial.print(",");
+  Serial.println(drain / REPEAT);
+  Serial.println();
+
+  delay(2000);
+}
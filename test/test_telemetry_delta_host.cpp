@@ -0,0 +1,313 @@
+// Host-side tests and benchmarks for the delta / varint telemetry frames:
+// varint and CRC building blocks, a flight round trip through the ring,
+// recovery at the next keyframe after corruption, a joined-late decoder
+// and ring drops, then bytes per sample and encode / decode throughput
+//   g++ -std=c++11 -O2 -Iinclude test/test_telemetry_delta_host.cpp -o telemetry_delta_test && ./telemetry_delta_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "TelemetryDelta.h"
+#include "TestCheck.h"
+
+struct CaptureSink {
+  std::vector<uint8_t> bytes;
+  uint32_t write(const uint8_t *data, uint32_t len) {
+    bytes.insert(bytes.end(), data, data + len);
+    return len;
+  }
+};
+
+bool sameSample(const TelemetrySample &a, const TelemetrySample &b) {
+  return a.timeMs == b.timeMs && a.rightMm == b.rightMm && a.heightMm == b.heightMm &&
+         a.rateRightMmS == b.rateRightMmS && a.rateHeightMmS == b.rateHeightMmS &&
+         a.rudderUs == b.rudderUs && a.elevatorUs == b.elevatorUs && a.rightEchoUs == b.rightEchoUs &&
+         a.rightEchoAtUs == b.rightEchoAtUs && a.heightEchoUs == b.heightEchoUs &&
+         a.heightEchoAtUs == b.heightEchoAtUs && a.flags == b.flags;
+}
+
+// A glide down the corridor sampled every `periodMs`: distances drift with
+// the closure rates, the tracker's rates wander with sonar noise, the
+// servos step to a correction and back through the 0.7 smoothing and sit
+// still in between.
+std::vector<TelemetrySample> flightTrace(int samples, int periodMs, unsigned seed) {
+  srand(seed);
+  std::vector<TelemetrySample> trace;
+  double right = 450, height = 1050, rateR = -60, rateH = 120;
+  double rudder = 1500, elevator = 1500;
+  int rudderTarget = 1500, elevatorTarget = 1500, holdMs = 0;
+  double dt = periodMs / 1000.0;
+  for (int k = 0; k < samples; k++) {
+    rateR += (rand() % 41 - 20) * dt * 10;
+    rateH += (rand() % 41 - 20) * dt * 10 - 20 * dt;
+    right += rateR * dt;
+    height -= rateH * dt;
+    if (right < 150 || right > 900) rateR = -rateR;
+    if (height < 200 || height > 1500) rateH = -rateH;
+
+    holdMs -= periodMs;
+    if (holdMs <= 0) {
+      rudderTarget = (rand() % 4 == 0) ? 1700 : 1500;
+      elevatorTarget = (rand() % 5 == 0) ? 1100 : 1500;
+      holdMs = 500;
+    }
+    double a = pow(0.3, periodMs / 50.0);     // Same smoothing per second at any rate
+    rudder = rudder * a + rudderTarget * (1 - a);
+    elevator = elevator * a + elevatorTarget * (1 - a);
+
+    TelemetrySample s = TelemetrySample();
+    s.timeMs = (uint32_t)(k * periodMs + rand() % 2);
+    s.rightMm = (int16_t)(right + rand() % 5 - 2);
+    s.heightMm = (int16_t)(height + rand() % 5 - 2);
+    s.rateRightMmS = (int16_t)(rateR + rand() % 31 - 15);
+    s.rateHeightMmS = (int16_t)(rateH + rand() % 31 - 15);
+    s.rudderUs = (uint16_t)(fabs(rudder - rudderTarget) < 10 ? rudderTarget : rudder);
+    s.elevatorUs = (uint16_t)(fabs(elevator - elevatorTarget) < 10 ? elevatorTarget : elevator);
+    s.flags = TELEM_FLIGHT | TELEM_HEIGHT_VALID | ((rand() % 10) ? TELEM_RIGHT_VALID : 0);
+    // Raw echoes: 58 µs/cm wide, falling edge 230 µs of burst later
+    if (s.flags & TELEM_RIGHT_VALID) {
+      s.rightEchoUs = (uint16_t)(right * 5.8 + rand() % 5);
+      s.rightEchoAtUs = (uint16_t)(s.rightEchoUs + 230);
+    }
+    s.heightEchoUs = (uint16_t)(height * 5.8 + rand() % 5);
+    s.heightEchoAtUs = (uint16_t)(s.heightEchoUs + 230);
+    trace.push_back(s);
+  }
+  return trace;
+}
+
+std::vector<uint8_t> encodeAll(const std::vector<TelemetrySample> &trace) {
+  DeltaFrameCodec codec;
+  std::vector<uint8_t> out;
+  uint8_t frame[DeltaFrameCodec::MAX_BYTES];
+  for (size_t i = 0; i < trace.size(); i++) {
+    int n = codec.encode(trace[i], frame);
+    out.insert(out.end(), frame, frame + n);
+  }
+  return out;
+}
+
+// ---------------------------------------------------------
+// 1. Building blocks
+// ---------------------------------------------------------
+void testPrimitives() {
+  CHECK(telemetryCrc16((const uint8_t *)"123456789", 9) == 0x29B1);   // CRC-16/CCITT-FALSE check value
+
+  const int32_t values[] = { 0, 1, -1, 63, -64, 64, -65, 8191, -8192, 32767, -32768, 65535,
+                             2147483647, -2147483647 - 1 };
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    uint8_t buf[5];
+    uint32_t z = zigzag(values[i]), back;
+    CHECK(unzigzag(z) == values[i]);
+    int n = putVarint(buf, z);
+    CHECK(getVarint(buf, buf + n, back) == n);
+    CHECK(back == z);
+    CHECK(getVarint(buf, buf + n - 1, back) == 0 || n == 1);  // Truncated
+  }
+  uint8_t buf[5];
+  CHECK(putVarint(buf, zigzag(-64)) == 1);
+  CHECK(putVarint(buf, zigzag(64)) == 2);
+  CHECK(putVarint(buf, zigzag(-8192)) == 2);
+  CHECK(putVarint(buf, zigzag(8192)) == 3);
+}
+
+// ---------------------------------------------------------
+// 2. Round trip of a flight through the ring, keyframes where expected
+// ---------------------------------------------------------
+void testRoundTrip() {
+  std::vector<TelemetrySample> trace = flightTrace(400, 50, 1);
+  TelemetryLog<1024, DeltaFrameCodec> log;
+  CaptureSink port;
+  for (size_t i = 0; i < trace.size(); i++) {
+    CHECK(log.push(trace[i]));
+    log.drain(port, 0xFFFFFFFF);
+  }
+  CHECK(log.framesDropped() == 0);
+
+  DeltaParser parser;
+  TelemetrySample s = TelemetrySample();
+  uint8_t seq;
+  size_t got = 0;
+  int keyframes = 0;
+  bool matches = true;
+  for (size_t i = 0; i < port.bytes.size(); i++) {
+    if (port.bytes[i] == TELEMETRY_SYNC0 && i + 4 < port.bytes.size() &&
+        port.bytes[i + 1] == TELEMETRY_DELTA_SYNC1 && (port.bytes[i + 4] & TELEM_KEYFRAME)) keyframes++;
+    if (!parser.feed(port.bytes[i], s, seq)) continue;
+    if (seq != (uint8_t)got || !sameSample(s, trace[got])) matches = false;
+    got++;
+  }
+  CHECK(got == trace.size());
+  CHECK(matches);
+  CHECK(keyframes == 400 / TELEMETRY_KEYFRAME_EVERY);
+  CHECK(parser.bytesSkipped() == 0);
+  CHECK(parser.framesUnusable() == 0);
+
+  // Extremes: every channel jumping end to end
+  DeltaFrameCodec codec;
+  DeltaParser p2;
+  uint8_t frame[DeltaFrameCodec::MAX_BYTES];
+  for (int k = 0; k < 50; k++) {
+    TelemetrySample in = TelemetrySample(), out = TelemetrySample();
+    in.timeMs = (k % 2) ? 0xFFFFFFFFu - k : (uint32_t)k;
+    in.rightMm = in.heightMm = (int16_t)((k % 2) ? 32767 : -32768);
+    in.rateRightMmS = in.rateHeightMmS = (int16_t)((k % 2) ? -32768 : 32767);
+    in.rudderUs = in.elevatorUs = (uint16_t)((k % 2) ? 65535 : 0);
+    in.rightEchoUs = in.rightEchoAtUs = in.heightEchoUs = in.heightEchoAtUs = (uint16_t)((k % 2) ? 0 : 65535);
+    in.flags = TELEM_DROPPED | TELEM_FLIGHT;
+    int n = codec.encode(in, frame);
+    CHECK(n <= DeltaFrameCodec::MAX_BYTES);
+    bool done = false;
+    for (int i = 0; i < n; i++) done = p2.feed(frame[i], out, seq);
+    CHECK(done && sameSample(in, out));
+  }
+}
+
+// ---------------------------------------------------------
+// 3. Corruption, text between frames, a decoder that joins late
+// ---------------------------------------------------------
+void testRecovery() {
+  std::vector<TelemetrySample> trace = flightTrace(200, 50, 2);
+  DeltaFrameCodec codec;
+  std::vector<uint8_t> stream;
+  uint8_t frame[DeltaFrameCodec::MAX_BYTES];
+  const char *text = "Telemetry | Frames:412 | Dropped:0 | Queued:0\r\n";
+  const int corruptAt = 33;                      // Mid-way between keyframes 20 and 40
+  for (size_t k = 0; k < trace.size(); k++) {
+    int n = codec.encode(trace[k], frame);
+    if ((int)k == corruptAt) frame[n / 2] ^= 0x10;
+    stream.insert(stream.end(), frame, frame + n);
+    if (k % 7 == 0) stream.insert(stream.end(), text, text + strlen(text));
+  }
+
+  DeltaParser parser;
+  TelemetrySample s = TelemetrySample();
+  uint8_t seq;
+  int got = 0;
+  bool matches = true, gapRight = true;
+  for (size_t i = 0; i < stream.size(); i++) {
+    if (!parser.feed(stream[i], s, seq)) continue;
+    if (!sameSample(s, trace[seq])) matches = false;
+    if (seq >= corruptAt && seq < 2 * TELEMETRY_KEYFRAME_EVERY) gapRight = false;
+    got++;
+  }
+  int lost = 2 * TELEMETRY_KEYFRAME_EVERY - corruptAt;
+  printf("Recovery: corrupt frame %d, %d frames decoded of %d, %u intact deltas waited for the keyframe\n",
+         corruptAt, got, (int)trace.size(), (unsigned)parser.framesUnusable());
+  CHECK(matches);
+  CHECK(gapRight);
+  CHECK(got == (int)trace.size() - lost);
+  CHECK((int)parser.framesUnusable() == lost - 1);
+
+  // Joining mid-stream: nothing until the first keyframe, then everything
+  DeltaParser late;
+  size_t from = 0;
+  for (int k = 0; k < 5; k++) {                 // Skip five frames and a bit
+    from += 3 + stream[from + 2] + 2;
+    while (stream[from] != TELEMETRY_SYNC0 || stream[from + 1] != TELEMETRY_DELTA_SYNC1) from++;
+  }
+  from += 4;
+  int first = -1;
+  for (size_t i = from; i < stream.size() && first < 0; i++) {
+    if (late.feed(stream[i], s, seq)) first = seq;
+  }
+  CHECK(first == TELEMETRY_KEYFRAME_EVERY);
+}
+
+// ---------------------------------------------------------
+// 4. Ring drops: the next frame that fits is a keyframe, so the decoder
+//    sees a sequence gap but no unusable frames
+// ---------------------------------------------------------
+void testRingDrops() {
+  std::vector<TelemetrySample> trace = flightTrace(300, 50, 3);
+  TelemetryLog<128, DeltaFrameCodec> log;
+  CaptureSink port;
+  for (size_t k = 0; k < trace.size(); k++) {
+    log.push(trace[k]);
+    if ((k / 25) % 2 == 0) log.drain(port, 0xFFFFFFFF);   // Port stalls half the time
+  }
+  log.drain(port, 0xFFFFFFFF);
+
+  DeltaParser parser;
+  TelemetrySample s = TelemetrySample();
+  uint8_t seq;
+  uint32_t got = 0, index = 0;
+  uint8_t lastSeq = 0;
+  bool matches = true;
+  for (size_t i = 0; i < port.bytes.size(); i++) {
+    if (!parser.feed(port.bytes[i], s, seq)) continue;
+    index += (uint8_t)(seq - lastSeq);          // Unwrapped: seq counts dropped frames too
+    lastSeq = seq;
+    s.flags &= ~TELEM_DROPPED;
+    if (index >= trace.size() || !sameSample(s, trace[index])) matches = false;
+    got++;
+  }
+  printf("Ring drops: %u pushed, %u dropped, %u decoded, %u unusable\n",
+         (unsigned)log.framesPushed(), (unsigned)log.framesDropped(), (unsigned)got,
+         (unsigned)parser.framesUnusable());
+  CHECK(log.framesDropped() > 0);
+  CHECK(got == log.framesPushed());
+  CHECK(parser.framesUnusable() == 0);
+  CHECK(matches);
+}
+
+// ---------------------------------------------------------
+// 5. Size and throughput
+// ---------------------------------------------------------
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchmark() {
+  const int rates[] = { 20, 100 };
+  for (int r = 0; r < 2; r++) {
+    std::vector<TelemetrySample> trace = flightTrace(rates[r] * 60, 1000 / rates[r], 4);
+    std::vector<uint8_t> bytes = encodeAll(trace);
+    double perFrame = (double)bytes.size() / trace.size();
+    printf("%3d Hz: %.1f bytes/sample delta against %d fixed, %d bytes/s against %d\n",
+           rates[r], perFrame, TELEMETRY_FRAME_BYTES, (int)(perFrame * rates[r]),
+           TELEMETRY_FRAME_BYTES * rates[r]);
+    CHECK(perFrame < TELEMETRY_FRAME_BYTES * 0.75);
+  }
+
+  std::vector<TelemetrySample> trace = flightTrace(100000, 50, 5);
+  DeltaFrameCodec codec;
+  uint8_t frame[DeltaFrameCodec::MAX_BYTES];
+  uint32_t sink = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const int PASSES = 10;
+  for (int p = 0; p < PASSES; p++) {
+    for (size_t i = 0; i < trace.size(); i++) sink += codec.encode(trace[i], frame);
+  }
+  double encodeSec = secondsSince(start);
+
+  std::vector<uint8_t> bytes = encodeAll(trace);
+  TelemetrySample s = TelemetrySample();
+  uint8_t seq;
+  uint32_t frames = 0;
+  start = std::chrono::steady_clock::now();
+  for (int p = 0; p < PASSES; p++) {
+    DeltaParser parser;
+    for (size_t i = 0; i < bytes.size(); i++) {
+      if (parser.feed(bytes[i], s, seq)) frames++;
+    }
+  }
+  double decodeSec = secondsSince(start);
+  CHECK(frames == trace.size() * PASSES);
+  printf("Encode: %.1f M samples/s (%.0f MB/s out); decode: %.1f M frames/s (%.0f MB/s in)\n",
+         trace.size() * PASSES / encodeSec / 1e6, sink / encodeSec / 1e6,
+         frames / decodeSec / 1e6, bytes.size() * PASSES / decodeSec / 1e6);
+}
+
+int main() {
+  testPrimitives();
+  testRoundTrip();
+  testRecovery();
+  testRingDrops();
+  benchmark();
+
+  if (failures == 0) printf("Delta telemetry: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
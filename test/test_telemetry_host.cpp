@@ -0,0 +1,197 @@
+// Host-side tests for the binary telemetry path: frame round trip, the
+// SPSC ring across wrap-around and partial writes, drops when the port
+// stalls, and the stream parser skipping text and corruption
+//   g++ -std=c++11 -O2 -Iinclude test/test_telemetry_host.cpp -o telemetry_test && ./telemetry_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "Telemetry.h"
+#include "TestCheck.h"
+
+TelemetrySample sampleFor(int k) {
+  TelemetrySample s = TelemetrySample();
+  s.timeMs = 50u * k + 70000u * (k % 3);        // Upper half-word exercised
+  s.rightMm = (int16_t)(450 + k * 7);
+  s.heightMm = (int16_t)(1050 - k * 3);
+  s.rateRightMmS = (int16_t)(-125 + k);
+  s.rateHeightMmS = (int16_t)(-k * 11);
+  s.rudderUs = (uint16_t)(1700 - k);
+  s.elevatorUs = (uint16_t)(1100 + k);
+  s.rightEchoUs = (uint16_t)(2610 + k * 7);
+  s.rightEchoAtUs = (uint16_t)(2840 + k * 7);
+  s.heightEchoUs = (uint16_t)((k % 5) ? 6090 - k * 3 : 0);
+  s.heightEchoAtUs = (uint16_t)((k % 5) ? 6320 - k * 3 : 0);
+  s.flags = (uint8_t)(k & (TELEM_FLIGHT | TELEM_RIGHT_VALID | TELEM_HEIGHT_VALID | TELEM_RUDDER_WRITE));
+  return s;
+}
+
+bool sameSample(const TelemetrySample &a, const TelemetrySample &b) {
+  return a.timeMs == b.timeMs && a.rightMm == b.rightMm && a.heightMm == b.heightMm &&
+         a.rateRightMmS == b.rateRightMmS && a.rateHeightMmS == b.rateHeightMmS &&
+         a.rudderUs == b.rudderUs && a.elevatorUs == b.elevatorUs && a.rightEchoUs == b.rightEchoUs &&
+         a.rightEchoAtUs == b.rightEchoAtUs && a.heightEchoUs == b.heightEchoUs &&
+         a.heightEchoAtUs == b.heightEchoAtUs && a.flags == b.flags;
+}
+
+// Port model: takes up to `room` bytes per call, appends them to `bytes`
+struct CaptureSink {
+  std::vector<uint8_t> bytes;
+  uint32_t room;
+  CaptureSink() : room(0xFFFFFFFF) {}
+  uint32_t write(const uint8_t *data, uint32_t len) {
+    if (len > room) len = room;
+    bytes.insert(bytes.end(), data, data + len);
+    return len;
+  }
+};
+
+// ---------------------------------------------------------
+// 1. Encode / decode
+// ---------------------------------------------------------
+void testRoundTrip() {
+  uint8_t frame[TELEMETRY_FRAME_BYTES];
+  for (int k = 0; k < 200; k++) {
+    TelemetrySample in = sampleFor(k), out = TelemetrySample();
+    uint8_t seq = 0;
+    encodeTelemetry(in, (uint8_t)k, frame);
+    CHECK(decodeTelemetry(frame, out, seq));
+    CHECK(seq == (uint8_t)k);
+    CHECK(sameSample(in, out));
+
+    // Any single flipped bit is caught
+    int bit = k % (TELEMETRY_FRAME_BYTES * 8);
+    frame[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    CHECK(!decodeTelemetry(frame, out, seq));
+  }
+
+  CHECK(toTelemetryMm(45.34f) == 453);
+  CHECK(toTelemetryMm(Q16(45.34)) == 453);
+  CHECK(toTelemetryMm(-12.5f) == -125);
+  CHECK(toTelemetryMm(Q16(-12.5)) == -125);
+  CHECK(toTelemetryMm(5000.0f) == 32767);      // Saturates
+  CHECK(toTelemetryMm(Q16(-5000.0)) == -32768);
+}
+
+// ---------------------------------------------------------
+// 2. Ring: wrap-around with the port taking odd amounts
+// ---------------------------------------------------------
+void testRingStream() {
+  TelemetryLog<256> log;                        // 11 frames
+  CaptureSink port;
+  srand(5);
+  int sent = 0;
+  for (int tick = 0; tick < 2000; tick++) {
+    if (log.push(sampleFor(sent))) sent++;
+    port.room = rand() % 40;                    // Partial frames, wraps mid-frame
+    log.drain(port, port.room);
+  }
+  port.room = 0xFFFFFFFF;
+  log.drain(port, 0xFFFFFFFF);
+
+  TelemetryParser parser;
+  TelemetrySample s = TelemetrySample();
+  uint8_t seq;
+  int got = 0;
+  bool inOrder = true;
+  for (size_t i = 0; i < port.bytes.size(); i++) {
+    if (!parser.feed(port.bytes[i], s, seq)) continue;
+    TelemetrySample expect = sampleFor(got);
+    if (!sameSample(s, expect) && !(s.flags & TELEM_DROPPED)) inOrder = false;
+    got++;
+  }
+  printf("Ring stream: %d frames pushed, %d decoded, %u dropped, %u bytes skipped\n",
+         sent, got, (unsigned)log.framesDropped(), (unsigned)parser.bytesSkipped());
+  CHECK(got == sent);
+  CHECK(inOrder);
+  CHECK(parser.bytesSkipped() == 0);
+  CHECK(log.bytesQueued() == 0);
+}
+
+// ---------------------------------------------------------
+// 3. Port stalled: the ring fills, records are dropped and counted, the
+//    control side never blocks, and the gap shows in the stream
+// ---------------------------------------------------------
+void testStall() {
+  TelemetryLog<1024> log;
+  CaptureSink port;
+  for (int k = 0; k < 100; k++) log.push(sampleFor(k));   // 5s with nothing drained
+  CHECK(log.framesPushed() == 1024 / TELEMETRY_FRAME_BYTES);
+  CHECK(log.framesDropped() == 100 - 1024 / TELEMETRY_FRAME_BYTES);
+
+  log.drain(port, 0xFFFFFFFF);
+  log.push(sampleFor(100));
+
+  log.drain(port, 0xFFFFFFFF);
+  TelemetryParser parser;
+  TelemetrySample s = TelemetrySample();
+  uint8_t seq, lastSeq = 0;
+  int frames = 0;
+  for (size_t i = 0; i < port.bytes.size(); i++) {
+    if (!parser.feed(port.bytes[i], s, seq)) continue;
+    frames++;
+    lastSeq = seq;
+  }
+  CHECK(frames == 1024 / TELEMETRY_FRAME_BYTES + 1);
+  CHECK(lastSeq == 100);                        // Sequence gap = dropped frames
+  CHECK(s.flags & TELEM_DROPPED);
+}
+
+// ---------------------------------------------------------
+// 4. Parser: text replies, garbage and a corrupted frame between frames
+// ---------------------------------------------------------
+void testResync() {
+  std::vector<uint8_t> stream;
+  uint8_t frame[TELEMETRY_FRAME_BYTES];
+  const char *text = "Task control | Runs:412 | Skipped:0 | DeadlineMiss:0\r\n";
+  int expected = 0;
+  for (int k = 0; k < 50; k++) {
+    encodeTelemetry(sampleFor(k), (uint8_t)k, frame);
+    if (k % 7 == 3) {
+      frame[10] ^= 0x40;                        // Corrupt: must be rejected
+    } else {
+      expected++;
+    }
+    stream.insert(stream.end(), frame, frame + TELEMETRY_FRAME_BYTES);
+    if (k % 5 == 0) stream.insert(stream.end(), text, text + strlen(text));
+    if (k % 9 == 0) {                           // Stray sync bytes
+      stream.push_back(TELEMETRY_SYNC0);
+      stream.push_back(TELEMETRY_SYNC1);
+      stream.push_back(TELEMETRY_SYNC0);
+    }
+  }
+
+  TelemetryParser parser;
+  TelemetrySample s = TelemetrySample();
+  uint8_t seq;
+  int got = 0;
+  bool matches = true;
+  for (size_t i = 0; i < stream.size(); i++) {
+    if (!parser.feed(stream[i], s, seq)) continue;
+    if (seq % 7 == 3 || !sameSample(s, sampleFor(seq))) matches = false;
+    got++;
+  }
+  printf("Resync: %d of %d intact frames recovered, %u bytes skipped\n", got, expected,
+         (unsigned)parser.bytesSkipped());
+  CHECK(got == expected);
+  CHECK(matches);
+}
+
+int main() {
+  testRoundTrip();
+  testRingStream();
+  testStall();
+  testResync();
+
+  // Bytes on the wire per record: logTelemetry()'s line for a typical
+  // in-flight sample against one frame, which also carries the raw echoes
+  char line[128];
+  int textBytes = snprintf(line, sizeof(line), "T:%.2f | DistR:%.1f | DistH:%.1f | RateR:%.1f | RateH:%.1f | Rud:%d | Ele:%d\r\n",
+                           1.25, 45.3, 105.2, -12.5, 3.4, 1700, 1100);
+  printf("Per record: text %d bytes, binary %d bytes; at 20Hz %d vs %d bytes/s\n",
+         textBytes, TELEMETRY_FRAME_BYTES, textBytes * 20, TELEMETRY_FRAME_BYTES * 20);
+  CHECK(TELEMETRY_FRAME_BYTES * 2 < textBytes);
+
+  if (failures == 0) printf("Telemetry: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
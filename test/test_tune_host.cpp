@@ -0,0 +1,172 @@
+// Host-side tests for the autotuner: the work-stealing pool, the search
+// space against main.cpp's constants, scoring and the generated header
+//   g++ -std=c++11 -O2 -pthread -Iinclude test/test_tune_host.cpp -o tune_test && ./tune_test
+#define PROFILE_STAGES 0
+#include "../src/main.cpp"
+#include "../tools/tune/Tuner.h"
+#include "../tools/tune/WorkStealingPool.h"
+#include "TestCheck.h"
+
+int paramIndex(const char *name) {
+  for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+    if (!strcmp(TUNE_PARAMS[p].name, name)) return p;
+  }
+  return -1;
+}
+
+int main() {
+  // ---------------------------------------------------------
+  // 1. Pool: every task once, follow-ons included, and idle workers steal
+  // ---------------------------------------------------------
+  {
+    const int TASKS = 64, FOLLOW_ON = 4;
+    std::vector<std::atomic<int> > runs(TASKS * (FOLLOW_ON + 1));
+    for (size_t i = 0; i < runs.size(); i++) runs[i] = 0;
+    WorkStealingPool pool(4);
+    for (int i = 0; i < TASKS; i++) {
+      pool.submit([&pool, &runs, i](int w) {
+        runs[i]++;
+        for (int k = 1; k <= FOLLOW_ON; k++) {
+          int id = TASKS * k + i;
+          pool.submit([&runs, id](int) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            runs[id]++;
+          }, w);
+        }
+      }, 0);                 // All on worker 0: the others only get work by stealing
+    }
+    pool.wait();
+    int once = 0;
+    for (size_t i = 0; i < runs.size(); i++) once += runs[i] == 1;
+    long executed = 0, stolen = 0;
+    for (int w = 0; w < pool.size(); w++) {
+      executed += pool.workerStats(w).executed;
+      stolen += pool.workerStats(w).stolen;
+    }
+    printf("Pool: %ld tasks on 4 workers, %ld stolen\n", executed, stolen);
+    CHECK(once == (int)runs.size());
+    CHECK(executed == (long)runs.size());
+    CHECK(stolen > 0);
+
+    // Reusable after wait()
+    std::atomic<int> more(0);
+    for (int i = 0; i < 10; i++) pool.submit([&more](int) { more++; });
+    pool.wait();
+    CHECK(more == 10);
+  }
+
+  // ---------------------------------------------------------
+  // 2. Search space: hand-set values are main.cpp's, each entry has its
+  //    TUNED_ override, and the hand value is one of the swept ones
+  // ---------------------------------------------------------
+  {
+    CHECK(paramIndex("RATE_ESTIMATOR") == TUNE_ESTIMATOR);
+    TuneConfig hand = tuneHandConfig();
+    CHECK(fabs(hand.v[paramIndex("PARAM_RATE_RIGHT_THRESHOLD")] - toFloat(PARAM_RATE_RIGHT_THRESHOLD)) < 1e-3);
+    CHECK(fabs(hand.v[paramIndex("PARAM_RATE_HEIGHT_THRESHOLD")] - toFloat(PARAM_RATE_HEIGHT_THRESHOLD)) < 1e-3);
+    CHECK(hand.v[paramIndex("SERVO_HOLD_TIME_MS")] == SERVO_HOLD_TIME_MS);
+    CHECK(fabs(hand.v[paramIndex("SERVO_FF_GAIN")] - toFloat(SERVO_FF_GAIN)) < 1e-3);
+    CHECK(hand.v[paramIndex("SERVO_STEP_MAX_US")] == SERVO_STEP_MAX_US);
+    CHECK(fabs(hand.v[paramIndex("DIST_FILTER_ALPHA")] - toFloat(DIST_FILTER_ALPHA)) < 1e-3);
+    CHECK(hand.v[paramIndex("RATE_AVG_WINDOW_SIZE")] == RATE_AVG_WINDOW_SIZE);
+    CHECK(hand.v[paramIndex("RATE_ESTIMATOR")] == RATE_ESTIMATOR);
+    CHECK(fabs(hand.v[paramIndex("TRACKER_ALPHA")] - toFloat(TRACKER_ALPHA)) < 1e-3);
+    CHECK(fabs(hand.v[paramIndex("TRACKER_BETA")] - toFloat(TRACKER_BETA)) < 1e-3);
+    for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+      bool swept = false;
+      for (int i = 0; i < TUNE_PARAMS[p].count; i++) swept |= TUNE_PARAMS[p].values[i] == TUNE_PARAMS[p].hand;
+      CHECK(swept);
+      CHECK(!strncmp(TUNE_PARAMS[p].macro, "TUNED_", 6));
+    }
+
+    // Under the tracker the difference estimator's constants aren't built
+    // or varied; switching estimators brings them in and pins the tracker's
+    std::vector<std::string> defines = tuneDefines(hand);
+    bool filter = false, tracker = false;
+    for (size_t i = 0; i < defines.size(); i++) {
+      filter |= defines[i].find("TUNED_DIST_FILTER_ALPHA") != std::string::npos;
+      tracker |= defines[i] == "-DTUNED_TRACKER_ALPHA=0.7";
+    }
+    CHECK(!filter && tracker);
+    std::vector<TuneConfig> next = tuneNeighbours(hand);
+    int expect = 0;
+    for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+      if (tuneActive(hand, p)) expect += TUNE_PARAMS[p].count - 1;
+    }
+    CHECK((int)next.size() == expect);
+    int diff = 0;
+    for (size_t i = 0; i < next.size(); i++) {
+      if (next[i].v[TUNE_ESTIMATOR] != RATE_ESTIMATOR_DIFF) continue;
+      diff++;
+      CHECK(tuneActive(next[i], paramIndex("DIST_FILTER_ALPHA")));
+      CHECK(!tuneActive(next[i], paramIndex("TRACKER_BETA")));
+      CHECK(tuneKey(next[i]) != tuneKey(hand));
+    }
+    CHECK(diff == 1);
+
+    // Float constants as float literals, integers as integers
+    TuneConfig c = hand;
+    c.v[paramIndex("PARAM_RATE_RIGHT_THRESHOLD")] = 65;
+    c.v[paramIndex("SERVO_HOLD_TIME_MS")] = 400;
+    defines = tuneDefines(c);
+    CHECK(defines[0] == "-DTUNED_RATE_RIGHT_THRESHOLD=65.0");
+    CHECK(defines[2] == "-DTUNED_SERVO_HOLD_TIME_MS=400");
+  }
+
+  // ---------------------------------------------------------
+  // 3. Scoring: completion first, then margin up to the cap
+  // ---------------------------------------------------------
+  {
+    TuneFlight f;
+    CHECK(!parseTuneFlight("seed,outcome,time_s,distance_cm,min_right_cm,min_left_cm,min_ground_cm\n", f));
+    CHECK(parseTuneFlight("7,cleared,1.912,457.2,48.3,12.5,69.9\n", f));
+    CHECK(f.seed == 7 && f.cleared && fabs(tuneMarginCm(f) - 12.5) < 1e-9);
+    CHECK(parseTuneFlight("8,left wall,1.844,432.6,41.1,-0.1,91.6\n", f));
+    CHECK(!f.cleared && tuneMarginCm(f) == 0);
+    CHECK(parseTuneFlight("9,cleared,1.9,457.0,80.0,60.0,70.0\n", f));
+    CHECK(tuneMarginCm(f) == TUNE_MARGIN_CAP_CM);
+
+    // 1% more cleared is worth 5cm more mean margin: it beats 4cm, not 6cm
+    TuneScore a = { 100, 50, 0 }, b = { 100, 51, 0 }, c = { 100, 50, 600 }, d = { 100, 50, 400 };
+    CHECK(tuneScore(c) > tuneScore(b) && tuneScore(b) > tuneScore(d) && tuneScore(d) > tuneScore(a));
+    TuneScore empty = TuneScore();
+    CHECK(tuneScore(empty) < 0);
+    tuneMerge(empty, b);
+    CHECK(tuneScore(empty) == tuneScore(b));
+  }
+
+  // ---------------------------------------------------------
+  // 4. Generated header: one define per active constant
+  // ---------------------------------------------------------
+  {
+    TuneConfig best = tuneHandConfig();
+    best.v[paramIndex("SERVO_HOLD_TIME_MS")] = 300;
+    TuneScore bestScore = { 200, 150, 1200 }, handScore = { 200, 60, 300 };
+    char path[] = "/tmp/tuned_header_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *out = fdopen(fd, "w");
+    writeTunedHeader(out, best, bestScore, handScore, "test");
+    fclose(out);
+    FILE *in = fopen(path, "r");
+    char line[256];
+    int defines = 0;
+    bool hold = false, filter = false;
+    while (fgets(line, sizeof(line), in)) {
+      char macro[64], value[32];
+      if (sscanf(line, "#define %63s %31s", macro, value) == 2 && strncmp(macro, "TUNED_PARAMS_H", 14)) {
+        defines++;
+        hold |= !strcmp(macro, "TUNED_SERVO_HOLD_TIME_MS") && !strcmp(value, "300");
+        filter |= !strcmp(macro, "TUNED_DIST_FILTER_ALPHA");
+      }
+    }
+    fclose(in);
+    remove(path);
+    int active = 0;
+    for (int p = 0; p < TUNE_PARAM_COUNT; p++) active += tuneActive(best, p);
+    CHECK(defines == active);
+    CHECK(hold && !filter);
+  }
+
+  if (failures == 0) printf("Tuner: all tests passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// =========================================================
+// Host micro-benchmark harness (tools/bench)
+// =========================================================
+// Times one operation. Each sample is a batch of calls long enough to
+// swamp the clock's resolution, divided down to ns per call. The result is
+// summarised by statistics that one descheduled batch can't move:
+//   - the median of the samples
+//   - the median absolute deviation (scaled to a normal sigma)
+//   - a distribution-free 95% confidence interval for the median, from the
+//     order statistics
+// Samples more than 3.5 deviations from the median are counted as
+// outliers but kept. The first BenchConfig::warmupSec of calls are not
+// timed, and the batch size is fixed before sampling starts.
+//
+// BenchJson writes the results for tracking from commit to commit.
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Keeps a value, and the work that made it, without storing it anywhere
+template <typename T>
+inline void benchKeep(const T &v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+struct BenchConfig {
+  int samples;
+  double sampleSec;          // Target length of one timed batch
+  double warmupSec;
+};
+
+const BenchConfig BENCH_DEFAULTS = { 101, 1e-3, 0.02 };
+
+struct BenchStats {
+  int samples;
+  long batch;                // Calls per sample
+  double medianNs;
+  double madNs;              // Median absolute deviation x 1.4826
+  double ciLowNs, ciHighNs;  // 95% for the median
+  double minNs, p10Ns, p90Ns, maxNs;
+  double meanNs;
+  int outliers;
+};
+
+// Nearest-rank percentile of sorted samples
+inline double benchPercentile(const std::vector<double> &sorted, double p) {
+  int i = (int)ceil(p / 100.0 * sorted.size()) - 1;
+  if (i < 0) i = 0;
+  if (i >= (int)sorted.size()) i = (int)sorted.size() - 1;
+  return sorted[i];
+}
+
+inline double benchMedian(const std::vector<double> &sorted) {
+  size_t n = sorted.size();
+  return n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+}
+
+inline BenchStats benchStats(std::vector<double> ns, long batch) {
+  BenchStats s = BenchStats();
+  s.samples = (int)ns.size();
+  s.batch = batch;
+  if (ns.empty()) return s;
+  std::sort(ns.begin(), ns.end());
+  s.medianNs = benchMedian(ns);
+
+  std::vector<double> dev(ns.size());
+  for (size_t i = 0; i < ns.size(); i++) dev[i] = fabs(ns[i] - s.medianNs);
+  std::sort(dev.begin(), dev.end());
+  s.madNs = 1.4826 * benchMedian(dev);
+
+  // Ranks n/2 -+ 1.96 sqrt(n)/2 bracket the median 95% of the time
+  int n = (int)ns.size();
+  int lo = (int)floor(0.5 * n - 0.98 * sqrt((double)n));
+  int hi = (int)ceil(0.5 * n + 0.98 * sqrt((double)n));
+  s.ciLowNs = ns[lo < 0 ? 0 : lo];
+  s.ciHighNs = ns[hi >= n ? n - 1 : hi];
+
+  s.minNs = ns.front();
+  s.maxNs = ns.back();
+  s.p10Ns = benchPercentile(ns, 10);
+  s.p90Ns = benchPercentile(ns, 90);
+  double sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += ns[i];
+    if (fabs(ns[i] - s.medianNs) > 3.5 * s.madNs && s.madNs > 0) s.outliers++;
+  }
+  s.meanNs = sum / n;
+  return s;
+}
+
+// Times op(n), which makes n calls, per BenchConfig
+template <class Op>
+BenchStats benchTime(Op op, const BenchConfig &c) {
+  typedef std::chrono::steady_clock Clock;
+
+  // Warm up, doubling the batch until one takes a tenth of a sample
+  long batch = 1;
+  Clock::time_point start = Clock::now();
+  double warm = 0, last = 0;
+  while (warm < c.warmupSec || last < 0.1 * c.sampleSec) {
+    Clock::time_point t0 = Clock::now();
+    op(batch);
+    last = std::chrono::duration<double>(Clock::now() - t0).count();
+    if (last < 0.1 * c.sampleSec) batch *= 2;
+    warm = std::chrono::duration<double>(Clock::now() - start).count();
+  }
+  batch = (long)(batch * c.sampleSec / last);
+  if (batch < 1) batch = 1;
+
+  std::vector<double> ns;
+  ns.reserve(c.samples);
+  for (int i = 0; i < c.samples; i++) {
+    Clock::time_point t0 = Clock::now();
+    op(batch);
+    ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / batch);
+  }
+  return benchStats(ns, batch);
+}
+
+// ---------------------------------------------------------
+// Minimal JSON output: objects, arrays, numbers, strings
+// ---------------------------------------------------------
+class BenchJson {
+  private:
+    FILE *out;
+    std::vector<bool> first;   // Per open container: nothing written yet
+    bool afterKey;
+
+    void separate() {
+      if (afterKey) {
+        afterKey = false;
+        return;
+      }
+      if (!first.empty()) {
+        if (!first.back()) fputc(',', out);
+        first.back() = false;
+        fprintf(out, "\n%*s", 2 * (int)first.size(), "");
+      }
+    }
+    void open(char c) {
+      separate();
+      fputc(c, out);
+      first.push_back(true);
+    }
+    void close(char c) {
+      bool empty = first.back();
+      first.pop_back();
+      if (!empty) fprintf(out, "\n%*s", 2 * (int)first.size(), "");
+      fputc(c, out);
+      if (first.empty()) fputc('\n', out);
+    }
+
+  public:
+    explicit BenchJson(FILE *f) : out(f), afterKey(false) {}
+
+    void beginObject() { open('{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    void key(const char *k) {
+      separate();
+      string(k);
+      fputs(": ", out);
+      afterKey = true;
+    }
+    void value(double v) {
+      separate();
+      if (isfinite(v)) fprintf(out, "%.6g", v);
+      else fputs("null", out);
+    }
+    void value(long v) { separate(); fprintf(out, "%ld", v); }
+    void value(int v) { value((long)v); }
+    void value(unsigned v) { value((long)v); }
+    void value(bool v) { separate(); fputs(v ? "true" : "false", out); }
+    void value(const char *s) { separate(); string(s); }
+    void value(const std::string &s) { value(s.c_str()); }
+
+    template <typename T>
+    void field(const char *k, T v) { key(k); value(v); }
+
+  private:
+    void string(const char *s) {
+      fputc('"', out);
+      for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c == '\n') fputs("\\n", out);
+        else if (c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
+      }
+      fputc('"', out);
+    }
+};
+
+inline void benchJsonStats(BenchJson &j, const BenchStats &s) {
+  j.beginObject();
+  j.field("median", s.medianNs);
+  j.field("mad", s.madNs);
+  j.key("ci95");
+  j.beginArray();
+  j.value(s.ciLowNs);
+  j.value(s.ciHighNs);
+  j.endArray();
+  j.field("min", s.minNs);
+  j.field("p10", s.p10Ns);
+  j.field("p90", s.p90Ns);
+  j.field("max", s.maxNs);
+  j.field("mean", s.meanNs);
+  j.field("samples", s.samples);
+  j.field("batch", s.batch);
+  j.field("outliers", s.outliers);
+  j.endObject();
+}
+
+#endif
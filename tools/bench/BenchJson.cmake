@@ -0,0 +1,15 @@
+# Runs one benchmark build and writes its JSON with the commit the tree is
+# at (the bench_json target in CMakeLists.txt):
+#   cmake -DBENCH=build/bench -DOUT=bench.json -DSOURCE_DIR=. -P tools/bench/BenchJson.cmake
+execute_process(COMMAND git rev-parse HEAD
+                WORKING_DIRECTORY ${SOURCE_DIR}
+                OUTPUT_VARIABLE commit
+                OUTPUT_STRIP_TRAILING_WHITESPACE
+                ERROR_QUIET)
+if(NOT commit)
+  set(commit unknown)
+endif()
+execute_process(COMMAND ${BENCH} -o ${OUT} -c ${commit} RESULT_VARIABLE status)
+if(NOT status EQUAL 0)
+  message(FATAL_ERROR "${BENCH} failed (${status})")
+endif()
@@ -0,0 +1,265 @@
+#ifndef M0_COST_MODEL_H
+#define M0_COST_MODEL_H
+
+// =========================================================
+// Cortex-M0+ cycle estimates for the host benchmarks (tools/bench)
+// =========================================================
+// The SAMD21 has no FPU and no divider, so the cost of a stage is mostly
+// the library calls its arithmetic turns into: __aeabi_fadd, __aeabi_dmul,
+// __aeabi_ldivmod and so on. The stages in SignalPath.h / ControlLaw.h are
+// templates over the number type, so instantiating them with M0Counted<T>
+// instead of T runs the same expressions, with the same float -> double
+// promotions, and tallies each operation they make. Integer code outside
+// the templates (hold timer, servo tables, budget, the Hampel window's
+// shifts) is counted by hand per stage, as Thumb-1 instructions.
+//
+// Operands built from literals and constants are folded as the compiler
+// would: an operation on two of them costs nothing. Conversions from int
+// are counted (as i2f / i2d) except from 0, so `sum / N` in RollingAverage
+// is one conversion high on float.
+//
+// The per-operation cycles are libgcc's armv6-m soft-float and 64-bit
+// routines at 48MHz, call and return included, to within about 25%.
+// test/test_fixed_point_cycles.cpp and test/test_control_law_cycles.cpp
+// measure the real thing on the board.
+
+#include "FixedPoint.h"
+#include <stdint.h>
+
+enum M0Op {
+  M0_ALU,                    // add, sub, cmp, mov, shift, logic, muls
+  M0_MEM,                    // ldr / str
+  M0_BRANCH,                 // Taken branch
+  M0_CALL,                   // bl, push, pop to pc
+  M0_FADD,                   // __aeabi_fadd / fsub
+  M0_FMUL,
+  M0_FDIV,
+  M0_FCMP,
+  M0_I2F,
+  M0_F2I,
+  M0_F2D,
+  M0_D2F,
+  M0_DADD,
+  M0_DMUL,
+  M0_DDIV,
+  M0_I2D,
+  M0_D2I,
+  M0_LMUL,                   // Q16 * Q16: __aeabi_lmul and the 64-bit shift
+  M0_LDIV,                   // Q16 / Q16: __aeabi_ldivmod
+  M0_IDIV,                   // __aeabi_idiv
+  M0_OP_COUNT
+};
+
+struct M0OpInfo {
+  const char *name;
+  uint32_t cycles;
+};
+
+const M0OpInfo M0_OPS[M0_OP_COUNT] = {
+  { "alu", 1 }, { "mem", 2 }, { "branch", 2 }, { "call", 6 },
+  { "fadd", 75 }, { "fmul", 85 }, { "fdiv", 260 }, { "fcmp", 40 },
+  { "i2f", 45 }, { "f2i", 35 }, { "f2d", 40 }, { "d2f", 55 },
+  { "dadd", 130 }, { "dmul", 210 }, { "ddiv", 900 }, { "i2d", 45 }, { "d2i", 50 },
+  { "lmul", 20 }, { "ldiv", 380 }, { "idiv", 65 }
+};
+
+const uint32_t M0_CLOCK_HZ = 48000000;
+
+struct M0Tally {
+  uint32_t ops[M0_OP_COUNT];
+
+  M0Tally() { clear(); }
+  void clear() {
+    for (int i = 0; i < M0_OP_COUNT; i++) ops[i] = 0;
+  }
+  uint32_t cycles() const {
+    uint32_t total = 0;
+    for (int i = 0; i < M0_OP_COUNT; i++) total += ops[i] * M0_OPS[i].cycles;
+    return total;
+  }
+};
+
+// The tally M0Counted operations add to
+inline M0Tally &m0Tally() {
+  static M0Tally tally;
+  return tally;
+}
+
+inline void m0Count(M0Op op, uint32_t n = 1) { m0Tally().ops[op] += n; }
+
+template <typename T> class M0Counted;
+
+// ---------------------------------------------------------
+// double: only reached by promotion from float
+// ---------------------------------------------------------
+template <>
+class M0Counted<double> {
+  public:
+    double v;
+    bool folded;             // Known at compile time
+
+    M0Counted(double x) : v(x), folded(true) {}
+    M0Counted(int x) : v(x), folded(x == 0) { if (!folded) m0Count(M0_I2D); }
+    M0Counted(double x, bool k) : v(x), folded(k) {}
+
+    friend M0Counted operator+(M0Counted a, M0Counted b) { return arith(M0_DADD, a, b, a.v + b.v); }
+    friend M0Counted operator-(M0Counted a, M0Counted b) { return arith(M0_DADD, a, b, a.v - b.v); }
+    friend M0Counted operator*(M0Counted a, M0Counted b) { return arith(M0_DMUL, a, b, a.v * b.v); }
+    friend M0Counted operator/(M0Counted a, M0Counted b) { return arith(M0_DDIV, a, b, a.v / b.v); }
+
+  private:
+    static M0Counted arith(M0Op op, M0Counted a, M0Counted b, double r) {
+      bool k = a.folded && b.folded;
+      if (!k) m0Count(op);
+      return M0Counted(r, k);
+    }
+};
+typedef M0Counted<double> M0Double;
+
+inline int toInt(M0Double x) {
+  if (!x.folded) m0Count(M0_D2I);
+  return (int)x.v;
+}
+
+// ---------------------------------------------------------
+// float: soft-float calls, promoted to double next to a double
+// ---------------------------------------------------------
+template <>
+class M0Counted<float> {
+  public:
+    float v;
+    bool folded;
+
+    M0Counted() : v(0), folded(true) {}
+    M0Counted(float x) : v(x), folded(true) {}
+    M0Counted(double x) : v((float)x), folded(true) {}
+    M0Counted(int x) : v((float)x), folded(x == 0) { if (!folded) m0Count(M0_I2F); }
+    M0Counted(float x, bool k) : v(x), folded(k) {}
+    M0Counted(M0Double x) : v((float)x.v), folded(x.folded) { if (!folded) m0Count(M0_D2F); }
+
+    // A value that arrives at run time
+    static M0Counted input(float x) { return M0Counted(x, false); }
+
+    operator M0Double() const {
+      if (!folded) m0Count(M0_F2D);
+      return M0Double((double)v, folded);
+    }
+
+    friend M0Counted operator+(M0Counted a, M0Counted b) { return arith(M0_FADD, a, b, a.v + b.v); }
+    friend M0Counted operator-(M0Counted a, M0Counted b) { return arith(M0_FADD, a, b, a.v - b.v); }
+    friend M0Counted operator*(M0Counted a, M0Counted b) { return arith(M0_FMUL, a, b, a.v * b.v); }
+    friend M0Counted operator/(M0Counted a, M0Counted b) { return arith(M0_FDIV, a, b, a.v / b.v); }
+    friend M0Counted operator*(M0Counted a, int b) { return a * M0Counted(b); }
+    friend M0Counted operator*(int a, M0Counted b) { return M0Counted(a) * b; }
+    friend M0Counted operator/(M0Counted a, int b) { return a / M0Counted(b); }
+    M0Counted operator-() const {
+      if (!folded) m0Count(M0_ALU, 2);               // Flip the sign bit
+      return M0Counted(-v, folded);
+    }
+    M0Counted &operator+=(M0Counted b) { return *this = *this + b; }
+    M0Counted &operator-=(M0Counted b) { return *this = *this - b; }
+
+    // float op double is done in double
+    friend M0Double operator+(M0Counted a, double b) { return M0Double(a) + M0Double(b); }
+    friend M0Double operator+(double a, M0Counted b) { return M0Double(a) + M0Double(b); }
+    friend M0Double operator-(M0Counted a, double b) { return M0Double(a) - M0Double(b); }
+    friend M0Double operator-(double a, M0Counted b) { return M0Double(a) - M0Double(b); }
+    friend M0Double operator*(M0Counted a, double b) { return M0Double(a) * M0Double(b); }
+    friend M0Double operator*(double a, M0Counted b) { return M0Double(a) * M0Double(b); }
+    friend M0Double operator+(M0Counted a, M0Double b) { return M0Double(a) + b; }
+    friend M0Double operator+(M0Double a, M0Counted b) { return a + M0Double(b); }
+    friend M0Double operator*(M0Double a, M0Counted b) { return a * M0Double(b); }
+
+    friend bool operator==(M0Counted a, M0Counted b) { return compare(a, b), a.v == b.v; }
+    friend bool operator!=(M0Counted a, M0Counted b) { return compare(a, b), a.v != b.v; }
+    friend bool operator<(M0Counted a, M0Counted b) { return compare(a, b), a.v < b.v; }
+    friend bool operator>(M0Counted a, M0Counted b) { return compare(a, b), a.v > b.v; }
+    friend bool operator<=(M0Counted a, M0Counted b) { return compare(a, b), a.v <= b.v; }
+    friend bool operator>=(M0Counted a, M0Counted b) { return compare(a, b), a.v >= b.v; }
+
+  private:
+    static M0Counted arith(M0Op op, M0Counted a, M0Counted b, float r) {
+      bool k = a.folded && b.folded;
+      if (!k) m0Count(op);
+      return M0Counted(r, k);
+    }
+    static void compare(M0Counted a, M0Counted b) {
+      if (!(a.folded && b.folded)) m0Count(M0_FCMP);
+    }
+};
+
+inline int toInt(M0Counted<float> x) {
+  if (!x.folded) m0Count(M0_F2I);
+  return (int)x.v;
+}
+inline float toFloat(M0Counted<float> x) { return x.v; }
+
+// ---------------------------------------------------------
+// Q16: integer instructions, 64-bit multiply and divide calls
+// ---------------------------------------------------------
+template <>
+class M0Counted<Q16> {
+  public:
+    Q16 v;
+    bool folded;
+
+    M0Counted() : v(0), folded(true) {}
+    M0Counted(Q16 x) : v(x), folded(true) {}
+    M0Counted(float x) : v(x), folded(true) {}
+    M0Counted(double x) : v(x), folded(true) {}
+    M0Counted(int x) : v(x), folded(x == 0) { if (!folded) m0Count(M0_ALU); }
+    M0Counted(Q16 x, bool k) : v(x), folded(k) {}
+
+    static M0Counted input(float x) { return M0Counted(Q16(x), false); }
+
+    friend M0Counted operator+(M0Counted a, M0Counted b) { return arith(M0_ALU, a, b, a.v + b.v); }
+    friend M0Counted operator-(M0Counted a, M0Counted b) { return arith(M0_ALU, a, b, a.v - b.v); }
+    friend M0Counted operator*(M0Counted a, M0Counted b) { return arith(M0_LMUL, a, b, a.v * b.v); }
+    // Divisions add the zero and saturation checks
+    friend M0Counted operator/(M0Counted a, M0Counted b) {
+      if (!(a.folded && b.folded)) m0Count(M0_ALU, 3);
+      return arith(M0_LDIV, a, b, a.v / b.v);
+    }
+    // Q16 * int and Q16 / int stay 32-bit
+    friend M0Counted operator*(M0Counted a, int b) { return arith(M0_ALU, a, M0Counted(Q16(b), true), a.v * b); }
+    friend M0Counted operator*(int a, M0Counted b) { return arith(M0_ALU, M0Counted(Q16(a), true), b, a * b.v); }
+    friend M0Counted operator/(M0Counted a, int b) {
+      if (!a.folded) m0Count(M0_ALU, 2);
+      return arith(M0_IDIV, a, M0Counted(Q16(b), true), a.v / b);
+    }
+    // A double operand is a Q16 constant
+    friend M0Counted operator*(M0Counted a, double b) { return a * M0Counted(b); }
+    friend M0Counted operator*(double a, M0Counted b) { return M0Counted(a) * b; }
+    friend M0Counted operator-(double a, M0Counted b) { return M0Counted(a) - b; }
+    M0Counted operator-() const {
+      if (!folded) m0Count(M0_ALU);
+      return M0Counted(-v, folded);
+    }
+    M0Counted &operator+=(M0Counted b) { return *this = *this + b; }
+    M0Counted &operator-=(M0Counted b) { return *this = *this - b; }
+
+    friend bool operator==(M0Counted a, M0Counted b) { return compare(a, b), a.v == b.v; }
+    friend bool operator!=(M0Counted a, M0Counted b) { return compare(a, b), a.v != b.v; }
+    friend bool operator<(M0Counted a, M0Counted b) { return compare(a, b), a.v < b.v; }
+    friend bool operator>(M0Counted a, M0Counted b) { return compare(a, b), a.v > b.v; }
+    friend bool operator<=(M0Counted a, M0Counted b) { return compare(a, b), a.v <= b.v; }
+    friend bool operator>=(M0Counted a, M0Counted b) { return compare(a, b), a.v >= b.v; }
+
+  private:
+    static M0Counted arith(M0Op op, M0Counted a, M0Counted b, Q16 r) {
+      bool k = a.folded && b.folded;
+      if (!k) m0Count(op);
+      return M0Counted(r, k);
+    }
+    static void compare(M0Counted a, M0Counted b) {
+      if (!(a.folded && b.folded)) m0Count(M0_ALU);
+    }
+};
+
+inline int toInt(M0Counted<Q16> x) {
+  if (!x.folded) m0Count(M0_ALU, 4);                  // Sign, shift, negate back
+  return toInt(x.v);
+}
+inline float toFloat(M0Counted<Q16> x) { return toFloat(x.v); }
+
+#endif
@@ -0,0 +1,543 @@
+#ifndef PRIMITIVE_BENCH_H
+#define PRIMITIVE_BENCH_H
+
+// =========================================================
+// Filter and control primitive benchmarks (tools/bench)
+// =========================================================
+// Include after src/main.cpp, on the Linux HAL backend:
+//   #define PROFILE_STAGES 0
+//   #include "../../src/main.cpp"
+//   #include "PrimitiveBench.h"
+//
+// One case per stage of controlTask(), each in main.cpp's build (real_t,
+// SERVO_LUT, the tunables) and on main.cpp's own functions where it has
+// them:
+//   filter          getFilteredDistance(), with 10% missing samples
+//   hampel          HampelFilter::filter(), window full, 10% spikes
+//   rate            closureRate() over a measured interval
+//   rolling_average RollingAverage::add(), window full
+//   tracker_correct AlphaBetaTracker::correct() on an echo's interval
+//   tracker_predict AlphaBetaTracker::predict() to the control tick,
+//                   microsToSeconds() included
+//   law_trigger     BangBangHold over threshold: the hold timer restarts
+//   law_hold        under threshold inside the hold: correction kept
+//   law_idle        under threshold, nothing held: neutral
+//   servo           smoothing (ServoSmoothing or smoothServo) and the
+//                   ServoBudget deadband, half the commands written
+//   servo_lead      ServoLead::command(): the horn model run through its
+//                   dead time, then lead and feedforward
+//   servo_budget    ServoBudget::update() alone
+// Each runs on the host (Bench.h) and through the Cortex-M0+ cost model
+// (M0CostModel.h). The law cases take the servo table lookup (SERVO_LUT)
+// or update()'s clamp, as controlTask() does.
+
+#include "Bench.h"
+#include "M0CostModel.h"
+#include <string.h>
+#include <time.h>
+
+struct PrimitiveResult {
+  const char *name;
+  const char *what;
+  BenchStats host;
+  double netNs;              // Median less the empty loop's
+  M0Tally m0;
+};
+
+const int PRIMITIVE_INPUTS = 1024;         // Power of two
+
+// Inputs the compiler can't see through: ranges, rates and pulses that
+// vary from call to call
+struct PrimitiveInputs {
+  real_t range[PRIMITIVE_INPUTS];          // cm, NO_READING_VAL one in ten
+  real_t echo[PRIMITIVE_INPUTS];           // cm, around 100, a spike one in ten
+  real_t rateLow[PRIMITIVE_INPUTS];        // cm/s, under the rudder threshold
+  real_t rateHigh[PRIMITIVE_INPUTS];       // ...over it
+  real_t dt[PRIMITIVE_INPUTS];             // s, around LOOP_PERIOD_MS
+  uint32_t sinceUs[PRIMITIVE_INPUTS];      // us, last echo to the control tick
+  int target[PRIMITIVE_INPUTS];            // us, neutral or full correction
+  int smoothed[PRIMITIVE_INPUTS];          // us, part way there
+
+  PrimitiveInputs() {
+    uint32_t s = 12345;
+    for (int i = 0; i < PRIMITIVE_INPUTS; i++) {
+      s = s * 1664525u + 1013904223u;
+      float u = (s >> 8) * (1.0f / 16777216.0f);
+      float threshold = toFloat(RUDDER_AXIS.rateThreshold);
+      range[i] = i % 10 == 3 ? NO_READING_VAL : real_t(20.0f + 180.0f * u);
+      echo[i] = real_t(i % 10 == 7 ? 200.0f + 100.0f * u : 95.0f + 10.0f * u);
+      rateLow[i] = real_t(threshold * (0.8f * u - 0.4f));
+      rateHigh[i] = real_t(threshold * (1.1f + u));
+      dt[i] = real_t(LOOP_PERIOD_MS * (0.9f + 0.2f * u) / 1000.0f);
+      sinceUs[i] = (uint32_t)(LOOP_PERIOD_MS * 1000 * (0.1f + 1.1f * u));
+      target[i] = (i / 2) % 2 ? RUDDER_AXIS.correctUs : RUDDER_AXIS.neutralUs;
+      smoothed[i] = target[i] + (int)((RUDDER_AXIS.neutralUs - target[i]) * u);
+    }
+  }
+};
+
+typedef ControlLaw<BangBangHold<real_t> > PrimitiveLaw;
+
+// The law's output as controlTask() takes it
+inline int primitiveCommand(PrimitiveLaw &law, real_t dist, real_t rate, uint32_t nowMs) {
+  if (SERVO_LUT) return RudderMap::command(law.offset(dist, rate, nowMs));
+  return law.update(dist, rate, nowMs);
+}
+
+// ---------------------------------------------------------
+// Cost model: the same expressions on M0Counted<real_t>
+// ---------------------------------------------------------
+typedef M0Counted<real_t> M0Real;
+
+inline AxisConfig<M0Real> m0Axis(const AxisConfig<real_t> &a) {
+  AxisConfig<M0Real> c = {
+    a.neutralUs, a.correctUs, a.minUs, a.maxUs, M0Real(a.rateThreshold), a.holdMs,
+    M0Real(a.targetCm), M0Real(a.kp), M0Real(a.kd), M0Real(a.tauSec), M0Real(a.tauFullSec)
+  };
+  return c;
+}
+
+// HoldTimer::update() per branch, then the rest of offset()/update() and
+// the table lookup or clamp, as Thumb-1 instructions
+enum PrimitiveHoldBranch { HOLD_TRIGGER, HOLD_KEEP, HOLD_IDLE };
+
+inline void m0LawGlue(PrimitiveHoldBranch branch) {
+  m0Count(M0_CALL);
+  m0Count(M0_MEM, 2);                      // cfg.holdMs, cfg.rateThreshold
+  switch (branch) {
+    case HOLD_TRIGGER: m0Count(M0_MEM, 2); m0Count(M0_ALU, 1); m0Count(M0_BRANCH, 1); break;
+    case HOLD_KEEP:    m0Count(M0_MEM, 2); m0Count(M0_ALU, 3); m0Count(M0_BRANCH, 2); break;
+    case HOLD_IDLE:    m0Count(M0_MEM, 3); m0Count(M0_ALU, 3); m0Count(M0_BRANCH, 2); break;
+  }
+  m0Count(M0_ALU, 2);                      // on ? fullCorrection : 0, direction
+  m0Count(M0_BRANCH, 1);
+  if (SERVO_LUT) {
+    m0Count(M0_ALU, 4);                    // Index, two bounds, halfword offset
+    m0Count(M0_MEM, 1);
+    m0Count(M0_BRANCH, 1);
+  } else {
+    m0Count(M0_ALU, 5);
+    m0Count(M0_MEM, 3);
+    m0Count(M0_BRANCH, 2);
+  }
+}
+
+inline M0Tally m0Filter() {
+  M0Real clean = M0Real::input(120.0f), prev = M0Real::input(118.0f);
+  m0Tally().clear();
+  m0Count(M0_CALL);
+  m0Count(M0_MEM, 2);
+  m0Count(M0_BRANCH);
+  M0Real out = clean == M0Real(NO_READING_VAL) ? prev : lowPass(clean, prev, M0Real(DIST_FILTER_ALPHA));
+  benchKeep(out);
+  return m0Tally();
+}
+
+// A new sample into a full window: the spike shifts from one end of the
+// sorted copy to the other
+inline M0Tally m0Hampel() {
+  M0Real k = HAMPEL_K, minDev = HAMPEL_MIN_DEV_CM, maxDev = MAX_DIST_JUMP_CM;
+  HampelFilter<M0Real, HAMPEL_WINDOW> spikes(k, minDev, maxDev);
+  for (int i = 0; i < HAMPEL_WINDOW; i++) spikes.filter(M0Real::input(96.0f + 2 * (i % 3)));
+  m0Tally().clear();
+  m0Count(M0_CALL, 3);                     // filter(), removeSorted(), insertSorted()
+  m0Count(M0_MEM, 4 * HAMPEL_WINDOW + 6);  // Shifts, ring slot, count, head, limits
+  m0Count(M0_ALU, 5 * HAMPEL_WINDOW + 6);  // Loop counters, ring index, merge-walk
+  m0Count(M0_BRANCH, 3 * HAMPEL_WINDOW);
+  M0Real out = spikes.filter(M0Real::input(250.0f));
+  benchKeep(out);
+  return m0Tally();
+}
+
+inline AlphaBetaTracker<M0Real> m0Tracker() {
+  AlphaBetaTracker<M0Real> track(M0Real(TRACKER_ALPHA), M0Real(TRACKER_BETA), TRACKER_MAX_COAST);
+  track.reset(M0Real::input(100.0f));
+  track.correct(M0Real::input(98.0f), M0Real::input(0.05f));
+  return track;
+}
+
+inline M0Tally m0TrackerCorrect() {
+  AlphaBetaTracker<M0Real> track = m0Tracker();
+  m0Tally().clear();
+  m0Count(M0_CALL);
+  m0Count(M0_MEM, 7);                      // alpha, beta, dist and vel in and out, misses
+  m0Count(M0_BRANCH);
+  M0Real dist = track.correct(M0Real::input(97.0f), M0Real::input(0.048f));
+  benchKeep(dist);
+  return m0Tally();
+}
+
+inline M0Tally m0TrackerPredict() {
+  AlphaBetaTracker<M0Real> track = m0Tracker();
+  m0Tally().clear();
+  m0Count(M0_IDIV);                        // us / 1000 and us % 1000: one __aeabi_uidivmod
+  m0Count(M0_ALU, 3);
+  m0Count(M0_BRANCH, 1);
+  m0Count(M0_MEM, 2);                      // dist, vel
+  M0Real dist = track.predict(microsToSeconds<M0Real>(37000));
+  benchKeep(dist);
+  return m0Tally();
+}
+
+inline M0Tally m0Rate() {
+  M0Real cur = M0Real::input(118.0f), prev = M0Real::input(120.0f), dt = M0Real::input(0.05f);
+  m0Tally().clear();
+  m0Count(M0_MEM, 3);
+  M0Real rate = closureRate(cur, prev, dt);
+  benchKeep(rate);
+  return m0Tally();
+}
+
+inline M0Tally m0RollingAverage() {
+  RollingAverage<M0Real, RATE_AVG_WINDOW_SIZE> avg;
+  for (int i = 0; i <= RATE_AVG_WINDOW_SIZE; i++) avg.add(M0Real::input(10.0f * i));
+  m0Tally().clear();
+  m0Count(M0_CALL);
+  m0Count(M0_MEM, 7);                      // index, history[index] x2, sum x2, filled
+  m0Count(M0_ALU, 5);
+  m0Count(M0_BRANCH, 2);
+  M0Real out = avg.add(M0Real::input(42.0f));
+  benchKeep(out);
+  return m0Tally();
+}
+
+inline M0Tally m0Law(PrimitiveHoldBranch branch) {
+  ControlLaw<BangBangHold<M0Real> > law(m0Axis(RUDDER_AXIS));
+  float threshold = toFloat(RUDDER_AXIS.rateThreshold);
+  if (branch == HOLD_KEEP) law.offset(M0Real::input(80.0f), M0Real::input(threshold + 20.0f), 0);
+  M0Real rate = M0Real::input(branch == HOLD_TRIGGER ? threshold + 20.0f : threshold - 20.0f);
+  m0Tally().clear();
+  m0LawGlue(branch);
+  int us = law.offset(M0Real::input(80.0f), rate, 1);
+  benchKeep(us);
+  return m0Tally();
+}
+
+// ServoBudget::update(): stepUs(), the deadband test, heat and stats;
+// heatUs() and the two heat divisions are __aeabi_idiv
+inline void m0BudgetGlue() {
+  m0Count(M0_CALL, 2);
+  m0Count(M0_MEM, 20);
+  m0Count(M0_ALU, 30);
+  m0Count(M0_BRANCH, 9);
+  m0Count(M0_IDIV, 4);
+}
+
+inline M0Tally m0Servo() {
+  m0Tally().clear();
+  if (SERVO_LUT) {
+    m0Count(M0_ALU, 5);                    // ServoSmoothing::apply(): index, bounds, add
+    m0Count(M0_MEM, 1);
+    m0Count(M0_BRANCH, 1);
+  } else {
+    m0Count(M0_ALU, 4);                    // constrain()
+    m0Count(M0_BRANCH, 2);
+    int pwm = smoothServo(RUDDER_AXIS.correctUs, RUDDER_AXIS.neutralUs, M0Real(SERVO_SMOOTHING_ALPHA));
+    benchKeep(pwm);
+  }
+  m0BudgetGlue();
+  return m0Tally();
+}
+
+inline M0Tally m0ServoBudget() {
+  m0Tally().clear();
+  m0BudgetGlue();
+  return m0Tally();
+}
+
+// The horn model is copied and stepped through the dead time on M0Real;
+// the copy, the loop and the clamp to the servo limits are counted by hand
+inline M0Tally m0ServoLead() {
+  ServoParams<M0Real> params = { M0Real(SERVO_RESPONSE.deadSec), M0Real(SERVO_RESPONSE.slewUsPerSec),
+                                 M0Real(SERVO_RESPONSE.tauSec) };
+  ServoLead<M0Real> lead(params, M0Real(LOOP_PERIOD_MS / 1000.0), SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_MIN,
+                         SERVO_RUDDER_MAX, M0Real(SERVO_LEAD_GAIN), M0Real(SERVO_FF_GAIN));
+  lead.advance(RUDDER_AXIS.correctUs);
+  real_t subStepSec = real_t(LOOP_PERIOD_MS / 1000.0) / ServoResponse<real_t>::SUB_STEPS;
+  int deadSteps = toInt(SERVO_RESPONSE.deadSec / subStepSec + real_t(0.5));
+  if (deadSteps > ServoResponse<real_t>::SUB_STEPS) deadSteps = ServoResponse<real_t>::SUB_STEPS;
+  m0Tally().clear();
+  m0Count(M0_CALL, 2);                     // command(), predictAtTakeover()
+  m0Count(M0_MEM, 16);                     // The model's copy, gains and limits
+  m0Count(M0_ALU, 4 + 2 * deadSteps);
+  m0Count(M0_BRANCH, 2 + deadSteps);
+  int us = lead.command(RUDDER_AXIS.neutralUs + 100, RUDDER_AXIS.neutralUs);
+  benchKeep(us);
+  return m0Tally();
+}
+
+// ---------------------------------------------------------
+// The suite
+// ---------------------------------------------------------
+inline bool primitiveSelected(const char *only, const char *name) {
+  return !only || strstr(name, only) != NULL;
+}
+
+// Runs every case whose name contains `only` (all if NULL); the empty loop
+// is timed first into `overhead`
+inline std::vector<PrimitiveResult> runPrimitiveBench(const BenchConfig &cfg, const char *only,
+                                                      BenchStats &overhead) {
+  static PrimitiveInputs in;
+  const int MASK = PRIMITIVE_INPUTS - 1;
+  std::vector<PrimitiveResult> results;
+
+  overhead = benchTime([&](long n) {
+    for (long i = 0; i < n; i++) benchKeep(in.range[i & MASK]);
+  }, cfg);
+
+  PrimitiveResult r;
+
+  r.name = "filter";
+  r.what = "getFilteredDistance()";
+  if (primitiveSelected(only, r.name)) {
+    real_t prev = 100.0;
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        prev = getFilteredDistance(in.range[i & MASK], prev);
+        benchKeep(prev);
+      }
+    }, cfg);
+    r.m0 = m0Filter();
+    results.push_back(r);
+  }
+
+  r.name = "hampel";
+  r.what = "HampelFilter::filter()";
+  if (primitiveSelected(only, r.name)) {
+    HampelFilter<real_t, HAMPEL_WINDOW> spikes(HAMPEL_K, HAMPEL_MIN_DEV_CM, MAX_DIST_JUMP_CM);
+    for (int i = 0; i < HAMPEL_WINDOW; i++) spikes.filter(in.echo[i]);
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        real_t out = spikes.filter(in.echo[i & MASK]);
+        benchKeep(out);
+      }
+    }, cfg);
+    r.m0 = m0Hampel();
+    results.push_back(r);
+  }
+
+  r.name = "rate";
+  r.what = "closureRate()";
+  if (primitiveSelected(only, r.name)) {
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        real_t rate = closureRate(in.range[i & MASK], in.range[(i + 1) & MASK], in.dt[i & MASK]);
+        benchKeep(rate);
+      }
+    }, cfg);
+    r.m0 = m0Rate();
+    results.push_back(r);
+  }
+
+  r.name = "rolling_average";
+  r.what = "RollingAverage::add()";
+  if (primitiveSelected(only, r.name)) {
+    RollingAverage<real_t, RATE_AVG_WINDOW_SIZE> avg;
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        real_t out = avg.add(in.rateLow[i & MASK]);
+        benchKeep(out);
+      }
+    }, cfg);
+    r.m0 = m0RollingAverage();
+    results.push_back(r);
+  }
+
+  r.name = "tracker_correct";
+  r.what = "AlphaBetaTracker::correct()";
+  if (primitiveSelected(only, r.name)) {
+    AlphaBetaTracker<real_t> track(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST);
+    track.reset(100.0);
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        real_t dist = track.correct(in.echo[i & MASK], in.dt[i & MASK]);
+        benchKeep(dist);
+      }
+    }, cfg);
+    r.m0 = m0TrackerCorrect();
+    results.push_back(r);
+  }
+
+  r.name = "tracker_predict";
+  r.what = "AlphaBetaTracker::predict(microsToSeconds())";
+  if (primitiveSelected(only, r.name)) {
+    AlphaBetaTracker<real_t> track(TRACKER_ALPHA, TRACKER_BETA, TRACKER_MAX_COAST);
+    track.reset(100.0);
+    track.correct(98.0, real_t(0.05));
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        benchKeep(track);
+        real_t dist = track.predict(microsToSeconds<real_t>(in.sinceUs[i & MASK]));
+        benchKeep(dist);
+      }
+    }, cfg);
+    r.m0 = m0TrackerPredict();
+    results.push_back(r);
+  }
+
+  r.name = "law_trigger";
+  r.what = "BangBangHold, rate over threshold";
+  if (primitiveSelected(only, r.name)) {
+    PrimitiveLaw law(RUDDER_AXIS);
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        int us = primitiveCommand(law, in.range[i & MASK], in.rateHigh[i & MASK], (uint32_t)i);
+        benchKeep(us);
+      }
+    }, cfg);
+    r.m0 = m0Law(HOLD_TRIGGER);
+    results.push_back(r);
+  }
+
+  r.name = "law_hold";
+  r.what = "BangBangHold, under threshold inside the hold";
+  if (primitiveSelected(only, r.name)) {
+    PrimitiveLaw law(RUDDER_AXIS);
+    primitiveCommand(law, 80.0, in.rateHigh[0], 0);
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        int us = primitiveCommand(law, in.range[i & MASK], in.rateLow[i & MASK], 1);
+        benchKeep(us);
+      }
+    }, cfg);
+    r.m0 = m0Law(HOLD_KEEP);
+    results.push_back(r);
+  }
+
+  r.name = "law_idle";
+  r.what = "BangBangHold, under threshold, nothing held";
+  if (primitiveSelected(only, r.name)) {
+    PrimitiveLaw law(RUDDER_AXIS);
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        int us = primitiveCommand(law, in.range[i & MASK], in.rateLow[i & MASK], (uint32_t)i);
+        benchKeep(us);
+      }
+    }, cfg);
+    r.m0 = m0Law(HOLD_IDLE);
+    results.push_back(r);
+  }
+
+  r.name = "servo";
+  r.what = SERVO_LUT ? "ServoSmoothing::apply() and ServoBudget::update()"
+                     : "constrain(), smoothServo() and ServoBudget::update()";
+  if (primitiveSelected(only, r.name)) {
+    ServoBudget budget(SERVO_BUDGET, SERVO_RUDDER_NEUTRAL);
+    int pwm = SERVO_RUDDER_NEUTRAL;
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        int target = in.target[i & MASK];
+        if (SERVO_LUT) {
+          pwm = ServoSmoother::apply(target, pwm);
+        } else {
+          target = constrain(target, SERVO_RUDDER_MIN, SERVO_RUDDER_MAX);
+          pwm = smoothServo(target, pwm, SERVO_SMOOTHING_ALPHA);
+        }
+        int out = budget.update(pwm);
+        benchKeep(out);
+      }
+    }, cfg);
+    r.m0 = m0Servo();
+    results.push_back(r);
+  }
+
+  r.name = "servo_lead";
+  r.what = "ServoLead::command()";
+  if (primitiveSelected(only, r.name)) {
+    ServoLead<real_t> lead(SERVO_RESPONSE, real_t(LOOP_PERIOD_MS / 1000.0), SERVO_RUDDER_NEUTRAL,
+                           SERVO_RUDDER_MIN, SERVO_RUDDER_MAX, SERVO_LEAD_GAIN, SERVO_FF_GAIN);
+    lead.advance(RUDDER_AXIS.correctUs);
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        benchKeep(lead);
+        int us = lead.command(in.smoothed[i & MASK], in.target[i & MASK]);
+        benchKeep(us);
+      }
+    }, cfg);
+    r.m0 = m0ServoLead();
+    results.push_back(r);
+  }
+
+  r.name = "servo_budget";
+  r.what = "ServoBudget::update()";
+  if (primitiveSelected(only, r.name)) {
+    ServoBudget budget(SERVO_BUDGET, SERVO_RUDDER_NEUTRAL);
+    r.host = benchTime([&](long n) {
+      for (long i = 0; i < n; i++) {
+        int out = budget.update(in.smoothed[i & MASK]);
+        benchKeep(out);
+      }
+    }, cfg);
+    r.m0 = m0ServoBudget();
+    results.push_back(r);
+  }
+
+  for (size_t i = 0; i < results.size(); i++) {
+    results[i].netNs = results[i].host.medianNs - overhead.medianNs;
+    if (results[i].netNs < 0) results[i].netNs = 0;
+  }
+  return results;
+}
+
+inline void writePrimitiveJson(FILE *out, const std::vector<PrimitiveResult> &results,
+                               const BenchStats &overhead, const BenchConfig &cfg, const char *commit) {
+  char when[32];
+  time_t now = time(NULL);
+  strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  BenchJson j(out);
+  j.beginObject();
+  j.field("suite", "primitives");
+  j.field("schema", 1);
+  j.key("commit");
+  if (commit) j.value(commit);
+  else j.value("unknown");
+  j.field("time", when);
+  j.field("compiler", __VERSION__);
+  j.field("number", USE_FIXED_POINT ? "q16" : "float");
+  j.field("servo_lut", SERVO_LUT);
+  j.key("config");
+  j.beginObject();
+  j.field("samples", cfg.samples);
+  j.field("sample_sec", cfg.sampleSec);
+  j.field("warmup_sec", cfg.warmupSec);
+  j.endObject();
+  j.key("overhead_ns");
+  benchJsonStats(j, overhead);
+  j.key("m0_model");
+  j.beginObject();
+  j.field("clock_hz", M0_CLOCK_HZ);
+  j.key("cycles_per_op");
+  j.beginObject();
+  for (int op = 0; op < M0_OP_COUNT; op++) j.field(M0_OPS[op].name, M0_OPS[op].cycles);
+  j.endObject();
+  j.endObject();
+
+  j.key("cases");
+  j.beginArray();
+  for (size_t i = 0; i < results.size(); i++) {
+    const PrimitiveResult &r = results[i];
+    j.beginObject();
+    j.field("name", r.name);
+    j.field("what", r.what);
+    j.key("host_ns");
+    benchJsonStats(j, r.host);
+    j.field("net_ns", r.netNs);
+    j.key("m0");
+    j.beginObject();
+    j.field("cycles", r.m0.cycles());
+    j.field("us", r.m0.cycles() * 1e6 / M0_CLOCK_HZ);
+    j.key("ops");
+    j.beginObject();
+    for (int op = 0; op < M0_OP_COUNT; op++) {
+      if (r.m0.ops[op]) j.field(M0_OPS[op].name, r.m0.ops[op]);
+    }
+    j.endObject();
+    j.endObject();
+    j.endObject();
+  }
+  j.endArray();
+  j.endObject();
+}
+
+#endif
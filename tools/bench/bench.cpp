@@ -0,0 +1,67 @@
+// Micro-benchmarks of the filter and control primitives (PrimitiveBench.h):
+// host timing and a Cortex-M0+ cycle estimate per stage, as a table and as
+// JSON for tracking from commit to commit
+//   g++ -std=c++11 -O2 -Iinclude tools/bench/bench.cpp -o bench
+//   ./bench [-o file.json] [-c commit] [-n samples] [-t sample_ms] [-f name] [-q]
+//     -o  JSON output (default bench.json; - for stdout)
+//     -c  commit recorded in the JSON (default: unknown; the bench_json
+//         target passes git rev-parse HEAD)
+//     -n  samples per case (default 101)
+//     -t  length of one sample in ms (default 1)
+//     -f  only the cases whose name contains this
+//     -q  no table
+// Add -DUSE_FIXED_POINT=1 for the Q16 build (build/bench_q16).
+#define PROFILE_STAGES 0
+#include "../../src/main.cpp"
+#include "PrimitiveBench.h"
+
+int main(int argc, char **argv) {
+  BenchConfig cfg = BENCH_DEFAULTS;
+  const char *path = "bench.json", *only = NULL;
+  std::string commit;
+  bool quiet = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-o") && i + 1 < argc) path = argv[++i];
+    else if (!strcmp(argv[i], "-c") && i + 1 < argc) commit = argv[++i];
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc) cfg.samples = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc) cfg.sampleSec = atof(argv[++i]) / 1000.0;
+    else if (!strcmp(argv[i], "-f") && i + 1 < argc) only = argv[++i];
+    else if (!strcmp(argv[i], "-q")) quiet = true;
+    else {
+      fprintf(stderr, "usage: %s [-o file.json] [-c commit] [-n samples] [-t sample_ms] [-f name] [-q]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (cfg.samples < 5) cfg.samples = 5;
+
+  BenchStats overhead;
+  std::vector<PrimitiveResult> results = runPrimitiveBench(cfg, only, overhead);
+  if (results.empty()) {
+    fprintf(stderr, "no case matches '%s'\n", only);
+    return 2;
+  }
+
+  if (!quiet) {
+    printf("%s build, %d samples per case, empty loop %.2f ns\n", USE_FIXED_POINT ? "Q16" : "float",
+           cfg.samples, overhead.medianNs);
+    printf("%-16s %9s %9s %17s %9s | %8s %8s\n", "case", "median_ns", "mad_ns", "ci95_ns", "net_ns",
+           "m0_cyc", "m0_us");
+    for (size_t i = 0; i < results.size(); i++) {
+      const PrimitiveResult &r = results[i];
+      printf("%-16s %9.2f %9.2f %8.2f-%-8.2f %9.2f | %8u %8.2f\n", r.name, r.host.medianNs, r.host.madNs,
+             r.host.ciLowNs, r.host.ciHighNs, r.netNs, r.m0.cycles(), r.m0.cycles() * 1e6 / M0_CLOCK_HZ);
+    }
+  }
+
+  FILE *out = strcmp(path, "-") ? fopen(path, "w") : stdout;
+  if (!out) {
+    perror(path);
+    return 1;
+  }
+  writePrimitiveJson(out, results, overhead, cfg, commit.empty() ? NULL : commit.c_str());
+  if (out != stdout) {
+    fclose(out);
+    if (!quiet) printf("wrote %s\n", path);
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+// src/main.cpp as a Linux program: one scripted flight on the Linux HAL
+// backend (include/HalLinux.h), in a few ms of wall time
+//   cmake -S . -B build && cmake --build build && ./build/host_flight
+//   ./host_flight [-s seconds] [-w wall_cm_per_s] [-v] [-c commands]
+//     -s  flight length (default 4)
+//     -w  how fast the wall on the right closes in (default 60 cm/s)
+//     -v  print the serial output and every servo write (CSV)
+//     -c  serial commands sent after landing, e.g. -c xp for the task and
+//         stage stats (the stage profiler times on the host clock)
+// The glider launches at 110cm, sinks at 10 cm/s and flies at a wall
+// starting 120cm off to the right; there is no aerodynamics, the ranges
+// are scripted (a closed-loop glider comes with the corridor simulator).
+#include "../../src/main.cpp"
+#include <chrono>
+
+struct Script {
+  uint64_t startUs;
+  float wallCmS;
+  bool verbose;
+  int writes;
+  int rudderMinUs;
+  int rudderMaxUs;
+};
+
+float scriptedRange(void *ctx, int trigPin, uint64_t nowUs) {
+  const Script &s = *(const Script *)ctx;
+  float t = nowUs > s.startUs ? (nowUs - s.startUs) * 1e-6f : 0.0f;
+  if (trigPin == PIN_TRIG_RIGHT) return fmaxf(120.0f - s.wallCmS * t, 5.0f);
+  return fmaxf(110.0f - 10.0f * t, 2.0f);
+}
+
+void servoWritten(void *ctx, int pin, int us, uint64_t atUs) {
+  Script &s = *(Script *)ctx;
+  s.writes++;
+  if (pin == PIN_SERVO_RUDDER) {
+    if (us < s.rudderMinUs) s.rudderMinUs = us;
+    if (us > s.rudderMaxUs) s.rudderMaxUs = us;
+  }
+  if (s.verbose) {
+    printf("servo,%.6f,%s,%d\n", (double)(atUs - s.startUs) * 1e-6,
+           pin == PIN_SERVO_RUDDER ? "rudder" : "elevator", us);
+  }
+}
+
+int main(int argc, char **argv) {
+  float seconds = 4.0f;
+  Script script = { 0, 60.0f, false, 0, SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_NEUTRAL };
+  const char *commands = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-s") && i + 1 < argc) seconds = (float)atof(argv[++i]);
+    else if (!strcmp(argv[i], "-w") && i + 1 < argc) script.wallCmS = (float)atof(argv[++i]);
+    else if (!strcmp(argv[i], "-c") && i + 1 < argc) commands = argv[++i];
+    else if (!strcmp(argv[i], "-v")) script.verbose = true;
+    else {
+      fprintf(stderr, "usage: %s [-s seconds] [-w wall_cm_per_s] [-v] [-c commands]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  HalLinuxState &hal = halLinux();
+  hal.range = scriptedRange;
+  hal.servo = servoWritten;
+  hal.ctx = &script;
+  hal.burstUs = SONAR_BURST_US;
+  hal.usPerCm = toFloat(SPEED_OF_SOUND_DIVISOR);
+  hal.maxRangeCm = 400;
+  hal.missHoldUs = HAL_LINUX_MISS_HOLD_US;
+  hal.logOut = script.verbose || commands ? stdout : NULL;
+
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+  hal.skipIdle = true;
+  setup();
+  hal.skipIdle = false;
+  script.startUs = hal.nowUs;
+  telemetryOn = false;           // The binary stream would interleave with the CSV
+
+  halLinuxRun(script.startUs + (uint64_t)(seconds * 1e6f), loop, [](uint32_t nowUs) {
+    return tasks.nextDueUs(nowUs);
+  });
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  if (commands) {
+    // One command per serial poll
+    hal.logIn = commands;
+    uint64_t endUs = hal.nowUs + (strlen(commands) + 1) * SERIAL_POLL_US;
+    halLinuxRun(endUs, loop, [](uint32_t nowUs) { return tasks.nextDueUs(nowUs); });
+  }
+
+  fprintf(stderr, "%.1fs flight: %s, %d servo writes, rudder %d-%dus; %.2f ms wall, %.0fx real time\n",
+          seconds, flightStarted ? "launched" : "never launched", script.writes,
+          script.rudderMinUs, script.rudderMaxUs, wallSec * 1e3, seconds / wallSec);
+  return flightStarted ? 0 : 1;
+}
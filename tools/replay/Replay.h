@@ -0,0 +1,420 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// =========================================================
+// Flight replay through the unmodified src/main.cpp
+// =========================================================
+// Include after src/main.cpp, which builds on the Linux HAL backend
+// (HalLinux.h):
+//   #define PROFILE_STAGES 0
+//   #include "../../src/main.cpp"
+//   #include "Replay.h"
+//   g++ -std=c++11 -O2 -Iinclude ...
+//
+// A flight log is a CSV of per-tick rows, optionally with the servo pulses
+// written at each tick (rudder_us, elevator_us). Columns are found by
+// header name, so the board's 'd' dump and tools/telemetry_decode output
+// read as they are. A line starting with '#', a step back in time or a
+// sensor test row after ticks starts the next flight.
+//
+// Logs with the raw echo columns (right_echo_us, right_echo_at_us,
+// height_echo_us, height_echo_at_us) replay exactly: every ping gets the
+// echo the board heard, with the same width and the same falling edge
+// after its trigger.
+//   - Row i is control tick i after setup(); ground rows are kept. A ping
+//     fired between ticks i - 1 and i gets row i's echo for its sensor
+//     (the one tick i consumed), or none if the row has none.
+//   - Sensor test rows (sensor_test = 1) feed setup()'s test pings in
+//     order. A stream captured from power-on has them, and then the
+//     filters start where the board's did; a recorder dump starts at
+//     launch, so its first ticks only converge on the flight.
+//   - Frames lost from a stream (sequence gaps in the seq column) come
+//     back as rows without echoes or pulses, so later rows stay on their
+//     ticks. Replay is approximate past a gap.
+// Older logs with only the filtered ranges (time_s, right_cm, height_cm)
+// replay approximately: pings read the ranges interpolated at their
+// trigger times, row 0 is launch and ground rows (flight = 0) are skipped.
+//
+// Per flight, ReplayEngine:
+//   1. Forks a child (halLinuxPowerCycle()), so each flight starts from a
+//      fresh board: the driver itself never runs the sketch.
+//   2. Runs setup().
+//   3. Calls loop() until one control period past the last row. Between
+//      calls the clock jumps straight to the next task release or echo
+//      edge. Nothing runs in between on the board either, so the result is
+//      the same as stepping every µs.
+//   4. Hands the servo writes back to the parent, which reads the pulse
+//      each servo held half a control period after each row's tick, the
+//      tick having written it, and compares it with the recorded pulse.
+//
+// Task run times are zero on the virtual clock, except for the trigger
+// pulse delays. Only the order of events and their stamps matter to the
+// control code.
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct ReplayRow {
+  float timeS;
+  float rightCm;
+  float heightCm;
+  int rudderUs;          // Recorded pulse, -1 if the log has none
+  int elevatorUs;
+  int rightEchoUs;       // Raw echo: width, 0 for none
+  int rightEchoAtUs;     // Falling edge after the trigger
+  int heightEchoUs;
+  int heightEchoAtUs;
+};
+
+struct ReplayFlight {
+  std::string name;
+  bool raw;                          // Raw echo columns: exact replay
+  std::vector<ReplayRow> sensorTest; // setup()'s readings, raw logs only
+  std::vector<ReplayRow> rows;
+};
+
+struct ReplayResult {
+  std::vector<int> rudderUs;       // Replayed pulse per row
+  std::vector<int> elevatorUs;
+  bool launched;
+  int compared;                    // Rows with recorded pulses
+  int mismatched;                  // Rows where either pulse differs by more than the tolerance
+  int maxDiffUs;
+  int firstMismatch;               // Row index, -1 if none
+};
+
+// ---------------------------------------------------------
+// Log reading / writing
+// ---------------------------------------------------------
+inline int replayColumn(const std::vector<std::string> &header, const char *name) {
+  for (size_t i = 0; i < header.size(); i++) {
+    if (header[i] == name) return (int)i;
+  }
+  return -1;
+}
+
+inline std::vector<std::string> replaySplit(const char *line) {
+  std::vector<std::string> fields;
+  std::string field;
+  for (const char *p = line; *p && *p != '\n' && *p != '\r'; p++) {
+    if (*p == ',') {
+      fields.push_back(field);
+      field.clear();
+    } else {
+      field += *p;
+    }
+  }
+  fields.push_back(field);
+  return fields;
+}
+
+// Appends the flights in `path`; false (with `error` set) if it can't be
+// read or lacks the range columns
+inline bool loadReplayLog(const char *path, std::vector<ReplayFlight> &flights, std::string &error) {
+  FILE *in = fopen(path, "r");
+  if (!in) {
+    error = std::string(path) + ": cannot open";
+    return false;
+  }
+  char line[1024];
+  std::vector<std::string> header;
+  int cTime = -1, cRight = -1, cHeight = -1, cRudder = -1, cElevator = -1, cFlight = -1;
+  int cRightEcho = -1, cRightEchoAt = -1, cHeightEcho = -1, cHeightEchoAt = -1, cSeq = -1, cTest = -1;
+  bool raw = false;
+  bool startNew = true;
+  std::string label;
+  int lineNo = 0;
+  int lastSeq = -1;
+  while (fgets(line, sizeof(line), in)) {
+    lineNo++;
+    if (line[0] == '#') {
+      startNew = true;
+      label = std::string(line + 1);
+      while (!label.empty() && (label[label.size() - 1] == '\n' || label[label.size() - 1] == '\r')) {
+        label.erase(label.size() - 1);
+      }
+      while (!label.empty() && label[0] == ' ') label.erase(0, 1);
+      continue;
+    }
+    if (line[0] == '\n' || line[0] == '\r' || line[0] == 0) continue;
+
+    std::vector<std::string> f = replaySplit(line);
+    if (replayColumn(f, "time_s") >= 0) {
+      header = f;
+      cTime = replayColumn(header, "time_s");
+      cRight = replayColumn(header, "right_cm");
+      cHeight = replayColumn(header, "height_cm");
+      cRudder = replayColumn(header, "rudder_us");
+      cElevator = replayColumn(header, "elevator_us");
+      cFlight = replayColumn(header, "flight");
+      cRightEcho = replayColumn(header, "right_echo_us");
+      cRightEchoAt = replayColumn(header, "right_echo_at_us");
+      cHeightEcho = replayColumn(header, "height_echo_us");
+      cHeightEchoAt = replayColumn(header, "height_echo_at_us");
+      cSeq = replayColumn(header, "seq");
+      cTest = replayColumn(header, "sensor_test");
+      raw = cRightEcho >= 0 && cRightEchoAt >= 0 && cHeightEcho >= 0 && cHeightEchoAt >= 0;
+      lastSeq = -1;
+      if (cRight < 0 || cHeight < 0) {
+        fclose(in);
+        error = std::string(path) + ": needs right_cm and height_cm columns";
+        return false;
+      }
+      continue;
+    }
+    if (header.empty() || (int)f.size() < (int)header.size()) continue;
+    if (!raw && cFlight >= 0 && atoi(f[cFlight].c_str()) == 0) continue;
+
+    ReplayRow r;
+    r.timeS = (float)atof(f[cTime].c_str());
+    r.rightCm = (float)atof(f[cRight].c_str());
+    r.heightCm = (float)atof(f[cHeight].c_str());
+    r.rudderUs = cRudder >= 0 ? atoi(f[cRudder].c_str()) : -1;
+    r.elevatorUs = cElevator >= 0 ? atoi(f[cElevator].c_str()) : -1;
+    r.rightEchoUs = raw ? atoi(f[cRightEcho].c_str()) : 0;
+    r.rightEchoAtUs = raw ? atoi(f[cRightEchoAt].c_str()) : 0;
+    r.heightEchoUs = raw ? atoi(f[cHeightEcho].c_str()) : 0;
+    r.heightEchoAtUs = raw ? atoi(f[cHeightEchoAt].c_str()) : 0;
+    bool test = raw && cTest >= 0 && atoi(f[cTest].c_str()) != 0;
+
+    if (!startNew && !flights.empty()) {
+      const ReplayFlight &current = flights.back();
+      if (test && !current.rows.empty()) startNew = true;          // The board restarted
+      else if (!current.rows.empty() && r.timeS < current.rows.back().timeS) startNew = true;
+    }
+    if (startNew) {
+      ReplayFlight flight;
+      char at[32];
+      snprintf(at, sizeof(at), ":%d", lineNo);
+      flight.name = label.empty() ? std::string(path) + at : label;
+      flight.raw = raw;
+      flights.push_back(flight);
+      startNew = false;
+      label.clear();
+      lastSeq = -1;
+    }
+    ReplayFlight &flight = flights.back();
+
+    // Lost frames keep their ticks: no echoes, nothing to compare
+    int seq = cSeq >= 0 ? atoi(f[cSeq].c_str()) : -1;
+    if (raw && seq >= 0 && lastSeq >= 0 && !flight.rows.empty()) {
+      ReplayRow lost = flight.rows.back();
+      lost.rudderUs = lost.elevatorUs = -1;
+      lost.rightEchoUs = lost.rightEchoAtUs = lost.heightEchoUs = lost.heightEchoAtUs = 0;
+      for (int gap = (uint8_t)(seq - lastSeq - 1); gap > 0; gap--) flight.rows.push_back(lost);
+    }
+    lastSeq = seq;
+
+    if (test) flight.sensorTest.push_back(r);
+    else      flight.rows.push_back(r);
+  }
+  fclose(in);
+  return true;
+}
+
+// Same layout as the input, with the replayed pulses: a golden log for the
+// next sweep
+inline void writeReplayLog(FILE *out, const ReplayFlight &flight, const ReplayResult &result) {
+  fprintf(out, "# %s\n", flight.name.c_str());
+  if (!flight.raw) {
+    fprintf(out, "time_s,right_cm,height_cm,rudder_us,elevator_us\n");
+    for (size_t i = 0; i < flight.rows.size(); i++) {
+      const ReplayRow &r = flight.rows[i];
+      fprintf(out, "%.3f,%.1f,%.1f,%d,%d\n", r.timeS, r.rightCm, r.heightCm,
+              result.rudderUs[i], result.elevatorUs[i]);
+    }
+    return;
+  }
+  fprintf(out, "time_s,right_cm,height_cm,rudder_us,elevator_us,"
+               "right_echo_us,right_echo_at_us,height_echo_us,height_echo_at_us,sensor_test\n");
+  for (size_t i = 0; i < flight.sensorTest.size(); i++) {
+    const ReplayRow &r = flight.sensorTest[i];
+    fprintf(out, "%.3f,%.1f,%.1f,-1,-1,%d,%d,%d,%d,1\n", r.timeS, r.rightCm, r.heightCm,
+            r.rightEchoUs, r.rightEchoAtUs, r.heightEchoUs, r.heightEchoAtUs);
+  }
+  for (size_t i = 0; i < flight.rows.size(); i++) {
+    const ReplayRow &r = flight.rows[i];
+    fprintf(out, "%.3f,%.1f,%.1f,%d,%d,%d,%d,%d,%d,0\n", r.timeS, r.rightCm, r.heightCm,
+            result.rudderUs[i], result.elevatorUs[i],
+            r.rightEchoUs, r.rightEchoAtUs, r.heightEchoUs, r.heightEchoAtUs);
+  }
+}
+
+// ---------------------------------------------------------
+// Engine
+// ---------------------------------------------------------
+class ReplayEngine {
+  private:
+    struct Write {
+      uint64_t atUs;
+      int pin;
+      int us;
+    };
+
+    // What the child hands back, followed by `writes` Writes
+    struct Flown {
+      uint64_t startUs;
+      uint32_t launched;
+      uint32_t writes;
+    };
+
+    // Per-flight state the HAL callbacks reach through ctx
+    struct Run {
+      const ReplayFlight *flight;
+      uint64_t startUs;            // Row 0
+      bool started;
+      size_t row;                  // Interpolation cursor
+      size_t testPings[2];         // setup() pings so far, right / height
+      std::vector<Write> writes;
+    };
+
+    static float rangeAt(void *ctx, int trigPin, uint64_t nowUs) {
+      Run &r = *(Run *)ctx;
+      const std::vector<ReplayRow> &rows = r.flight->rows;
+      const ReplayRow *a = &rows[0], *b = &rows[0];
+      if (r.started && nowUs > r.startUs) {
+        float t = (nowUs - r.startUs) * 1e-6f;
+        while (r.row + 1 < rows.size() && rows[r.row + 1].timeS <= t) r.row++;
+        a = &rows[r.row];
+        b = r.row + 1 < rows.size() ? &rows[r.row + 1] : a;
+        if (b != a && b->timeS > a->timeS) {
+          float k = (t - a->timeS) / (b->timeS - a->timeS);
+          float va = trigPin == PIN_TRIG_RIGHT ? a->rightCm : a->heightCm;
+          float vb = trigPin == PIN_TRIG_RIGHT ? b->rightCm : b->heightCm;
+          return va + (vb - va) * k;
+        }
+      }
+      return trigPin == PIN_TRIG_RIGHT ? a->rightCm : a->heightCm;
+    }
+
+    // The recorded echo for the ping whose trigger fell at `nowUs`: armed
+    // DELAY_TRIG_HIGH_US before, falling edge as recorded after that
+    static bool echoAt(void *ctx, int trigPin, uint64_t nowUs, uint64_t &riseUs, uint64_t &fallUs) {
+      Run &r = *(Run *)ctx;
+      const ReplayFlight &flight = *r.flight;
+      bool right = trigPin == PIN_TRIG_RIGHT;
+      const ReplayRow *row = NULL;
+      if (!r.started) {
+        size_t &k = r.testPings[right ? 0 : 1];
+        if (k < flight.sensorTest.size()) {
+          row = &flight.sensorTest[k++];
+        } else {
+          // No sensor test logged: the first echo of the flight
+          for (size_t i = 0; i < flight.rows.size() && !row; i++) {
+            if (right ? flight.rows[i].rightEchoUs : flight.rows[i].heightEchoUs) row = &flight.rows[i];
+          }
+        }
+      } else {
+        size_t i = (size_t)((nowUs - r.startUs) / (LOOP_PERIOD_MS * 1000ULL)) + 1;
+        if (i < flight.rows.size()) row = &flight.rows[i];
+      }
+      if (!row) return false;
+      int width = right ? row->rightEchoUs : row->heightEchoUs;
+      int at = right ? row->rightEchoAtUs : row->heightEchoAtUs;
+      if (width <= 0) return false;
+      fallUs = nowUs - DELAY_TRIG_HIGH_US + at;
+      riseUs = fallUs - width;
+      return true;
+    }
+
+    static uint32_t nextTaskDue(uint32_t nowUs) { return tasks.nextDueUs(nowUs); }
+
+    static void servoWrite(void *ctx, int pin, int us, uint64_t atUs) {
+      Write w = { atUs, pin, us };
+      ((Run *)ctx)->writes.push_back(w);
+    }
+
+    // In the child: setup() and loop() over the flight, the writes into `out`
+    static void replayChild(void *ctx, std::string &out) {
+      const ReplayFlight &flight = *(const ReplayFlight *)ctx;
+      Run run;
+      run.flight = &flight;
+      run.startUs = 0;
+      run.started = false;
+      run.row = 0;
+      run.testPings[0] = run.testPings[1] = 0;
+
+      HalLinuxState &s = halLinux();
+      s.echoPin[PIN_TRIG_RIGHT] = PIN_ECHO_RIGHT + 1;
+      s.echoPin[PIN_TRIG_HEIGHT] = PIN_ECHO_HEIGHT + 1;
+      if (flight.raw) s.echo = echoAt;
+      else            s.range = rangeAt;
+      s.servo = servoWrite;
+      s.ctx = &run;
+      s.burstUs = SONAR_BURST_US;
+      s.usPerCm = toFloat(SPEED_OF_SOUND_DIVISOR);
+      s.maxRangeCm = 400;
+      s.missHoldUs = HAL_LINUX_MISS_HOLD_US;
+
+      s.skipIdle = true;
+      setup();
+      s.skipIdle = false;
+      run.startUs = s.nowUs;
+      run.started = true;
+
+      uint64_t endUs = run.startUs + rowOffsetUs(flight, flight.rows.size() - 1) + LOOP_PERIOD_MS * 1000;
+      halLinuxRun(endUs, loop, nextTaskDue);
+
+      Flown flown = { run.startUs, flightStarted ? 1u : 0u, (uint32_t)run.writes.size() };
+      out.assign((const char *)&flown, sizeof(flown));
+      if (!run.writes.empty()) out.append((const char *)&run.writes[0], run.writes.size() * sizeof(Write));
+    }
+
+    // Row i's tick after row 0's
+    static uint64_t rowOffsetUs(const ReplayFlight &flight, size_t i) {
+      if (flight.raw) return (uint64_t)i * LOOP_PERIOD_MS * 1000;
+      return (uint64_t)(flight.rows[i].timeS * 1e6f + 0.5f);
+    }
+
+  public:
+    // False (out.launched false, nothing compared) if the flight's child
+    // failed
+    bool replay(const ReplayFlight &flight, ReplayResult &out, int toleranceUs = 0) {
+      std::string bytes;
+      Flown flown = { 0, 0, 0 };
+      bool ok = !flight.rows.empty() &&
+                halLinuxPowerCycle(replayChild, (void *)&flight, bytes) && bytes.size() >= sizeof(flown);
+      if (ok) {
+        memcpy(&flown, bytes.data(), sizeof(flown));
+        ok = bytes.size() == sizeof(flown) + flown.writes * sizeof(Write);
+      }
+      std::vector<Write> writes(ok ? flown.writes : 0);
+      if (!writes.empty()) memcpy(&writes[0], bytes.data() + sizeof(flown), writes.size() * sizeof(Write));
+      out.launched = ok && flown.launched;
+
+      // Pulse held half a period after each row's tick
+      size_t n = flight.rows.size();
+      out.rudderUs.assign(n, SERVO_RUDDER_NEUTRAL);
+      out.elevatorUs.assign(n, SERVO_ELEVATOR_NEUTRAL);
+      out.compared = out.mismatched = out.maxDiffUs = 0;
+      out.firstMismatch = -1;
+      if (!ok) return false;
+      int rudder = SERVO_RUDDER_NEUTRAL, elevator = SERVO_ELEVATOR_NEUTRAL;
+      size_t w = 0;
+      for (size_t i = 0; i < n; i++) {
+        uint64_t at = flown.startUs + rowOffsetUs(flight, i) + LOOP_PERIOD_MS * 500;
+        for (; w < writes.size() && writes[w].atUs <= at; w++) {
+          if (writes[w].pin == PIN_SERVO_RUDDER) rudder = writes[w].us;
+          else if (writes[w].pin == PIN_SERVO_ELEVATOR) elevator = writes[w].us;
+        }
+        out.rudderUs[i] = rudder;
+        out.elevatorUs[i] = elevator;
+
+        const ReplayRow &r = flight.rows[i];
+        if (r.rudderUs < 0 || r.elevatorUs < 0) continue;
+        out.compared++;
+        int diff = abs(rudder - r.rudderUs);
+        if (abs(elevator - r.elevatorUs) > diff) diff = abs(elevator - r.elevatorUs);
+        if (diff > out.maxDiffUs) out.maxDiffUs = diff;
+        if (diff > toleranceUs) {
+          out.mismatched++;
+          if (out.firstMismatch < 0) out.firstMismatch = (int)i;
+        }
+      }
+      return true;
+    }
+};
+
+#endif
@@ -0,0 +1,156 @@
+// Replays flight logs through the unmodified control code of src/main.cpp
+// and diffs the servo pulses against the recorded ones (see Replay.h)
+//   g++ -std=c++11 -O2 -Iinclude tools/replay/replay.cpp -o replay
+//   ./replay [-t tolerance_us] [-o golden.csv] [-r repeat] [-j jobs] [-q] flight.csv...
+//     -t  pulse difference still counted as a match (default 0)
+//     -o  write each flight back with the replayed pulses (a golden log)
+//     -r  replay everything this many times (throughput)
+//     -j  replay in this many processes, every jobs-th flight each
+//     -q  summary only
+// Exits 1 if any flight with recorded pulses diverges or fails to replay,
+// for regression sweeps.
+#define PROFILE_STAGES 0
+#include "../../src/main.cpp"
+#include "Replay.h"
+#include <chrono>
+#include <unistd.h>
+#include <sys/wait.h>
+
+struct Tally {
+  int failed;
+  int diverged;
+  int noLaunch;
+  int compared;
+  long runs;
+  double flightSec;
+};
+
+// Replays flights share, share + jobs, ... `repeat` times over; reports the
+// first pass of each
+static Tally replayShare(ReplayEngine &engine, const std::vector<ReplayFlight> &flights,
+                         int share, int jobs, int repeat, int tolerance, bool quiet, FILE *golden) {
+  Tally t = { 0, 0, 0, 0, 0, 0 };
+  ReplayResult result;
+  for (int pass = 0; pass < repeat; pass++) {
+    for (size_t f = share; f < flights.size(); f += jobs) {
+      const ReplayFlight &flight = flights[f];
+      bool ok = engine.replay(flight, result, tolerance);
+      t.runs++;
+      t.flightSec += flight.raw ? flight.rows.size() * LOOP_PERIOD_MS / 1000.0 : flight.rows.back().timeS;
+      if (pass > 0) continue;
+
+      if (golden) writeReplayLog(golden, flight, result);
+      if (!ok) t.failed++;
+      if (!result.launched) t.noLaunch++;
+      if (result.compared) t.compared++;
+      if (result.mismatched) t.diverged++;
+      if (quiet) continue;
+      printf("%s: %d rows%s, %s", flight.name.c_str(), (int)flight.rows.size(), flight.raw ? " (raw echoes)" : "",
+             !ok ? "REPLAY FAILED" : result.launched ? "launched" : "NO LAUNCH");
+      if (!ok) {
+        printf("\n");
+      } else if (result.compared == 0) {
+        printf(", no recorded pulses\n");
+      } else if (result.mismatched == 0) {
+        printf(", matches (max diff %d us)\n", result.maxDiffUs);
+      } else {
+        const ReplayRow &r = flight.rows[result.firstMismatch];
+        printf(", %d of %d rows differ, max %d us, first at %.3fs (rudder %d/%d, elevator %d/%d replayed/recorded)\n",
+               result.mismatched, result.compared, result.maxDiffUs, r.timeS,
+               result.rudderUs[result.firstMismatch], r.rudderUs,
+               result.elevatorUs[result.firstMismatch], r.elevatorUs);
+      }
+      if (jobs > 1) fflush(stdout);     // Whole lines between processes
+    }
+  }
+  return t;
+}
+
+int main(int argc, char **argv) {
+  int tolerance = 0, repeat = 1, jobs = 1;
+  bool quiet = false;
+  const char *goldenPath = NULL;
+  std::vector<ReplayFlight> flights;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-t") && i + 1 < argc) tolerance = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc) repeat = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-j") && i + 1 < argc) jobs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc) goldenPath = argv[++i];
+    else if (!strcmp(argv[i], "-q")) quiet = true;
+    else {
+      std::string error;
+      if (!loadReplayLog(argv[i], flights, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+      }
+    }
+  }
+  if (flights.empty()) {
+    fprintf(stderr, "usage: %s [-t us] [-o golden.csv] [-r n] [-j jobs] [-q] flight.csv...\n", argv[0]);
+    return 2;
+  }
+  if (jobs < 1 || goldenPath) jobs = 1;          // The golden log is written in flight order
+  if (jobs > (int)flights.size()) jobs = (int)flights.size();
+
+  FILE *golden = NULL;
+  if (goldenPath && !(golden = fopen(goldenPath, "w"))) {
+    perror(goldenPath);
+    return 2;
+  }
+
+  ReplayEngine engine;
+  Tally total = { 0, 0, 0, 0, 0, 0 };
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (jobs == 1) {
+    total = replayShare(engine, flights, 0, 1, repeat, tolerance, quiet, golden);
+  } else {
+    // One process per share, each forking its flights in turn; the tallies
+    // come back through a pipe
+    int fds[2];
+    if (pipe(fds) != 0) {
+      perror("pipe");
+      return 2;
+    }
+    fflush(stdout);
+    for (int share = 0; share < jobs; share++) {
+      pid_t pid = fork();
+      if (pid < 0) {
+        perror("fork");
+        return 2;
+      }
+      if (pid == 0) {
+        close(fds[0]);
+        Tally t = replayShare(engine, flights, share, jobs, repeat, tolerance, quiet, NULL);
+        fflush(stdout);
+        ssize_t n = write(fds[1], &t, sizeof(t));   // Atomic: under PIPE_BUF
+        _exit(n == (ssize_t)sizeof(t) ? 0 : 2);
+      }
+    }
+    close(fds[1]);
+    Tally t;
+    int reported = 0;
+    while (read(fds[0], &t, sizeof(t)) == (ssize_t)sizeof(t)) {
+      total.failed += t.failed;
+      total.diverged += t.diverged;
+      total.noLaunch += t.noLaunch;
+      total.compared += t.compared;
+      total.runs += t.runs;
+      total.flightSec += t.flightSec;
+      reported++;
+    }
+    close(fds[0]);
+    while (wait(NULL) > 0) {}
+    if (reported != jobs) {
+      fprintf(stderr, "%d of %d replay processes failed\n", jobs - reported, jobs);
+      return 2;
+    }
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (golden) fclose(golden);
+
+  printf("%d flights: %d compared, %d diverged, %d never launched, %d failed to replay\n",
+         (int)flights.size(), total.compared, total.diverged, total.noLaunch, total.failed);
+  printf("%ld replays in %.3fs on %d process%s: %.0f flights/s, %.0fx real time\n",
+         total.runs, sec, jobs, jobs == 1 ? "" : "es", total.runs / sec, total.flightSec / sec);
+  return total.diverged || total.failed ? 1 : 0;
+}
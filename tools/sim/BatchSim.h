@@ -0,0 +1,690 @@
+#ifndef BATCH_SIM_H
+#define BATCH_SIM_H
+
+// =========================================================
+// Batched Monte Carlo flights: many gliders per instruction
+// =========================================================
+// Include after src/main.cpp (for its constants) on the Linux HAL backend:
+//   #define PROFILE_STAGES 0
+//   #include "../../src/main.cpp"
+//   #include "BatchSim.h"
+//   g++ -std=c++11 -O2 -mavx2 -ffp-contract=off -Iinclude ...
+//
+// CorridorSimEngine flies src/main.cpp itself, one flight at a time at
+// about 1000 flights/s. Robustness estimates want millions, so this engine
+// steps a block of gliders together (8 per AVX2 register, SimdLanes.h).
+// Each glider has its own copy of controlTask()'s per-axis state, in
+// structure-of-arrays form, one register per field, and branches are masks.
+//
+// What is flown is main.cpp's shipped control path, stage for stage:
+//   1. HampelFilter over HAMPEL_WINDOW samples (SPIKE_FILTER_HAMPEL). The
+//      window is sorted afresh each tick with a sorting network, which
+//      gives the same median and MAD as the filter's insertion sort.
+//   2. AlphaBetaTracker (RATE_ESTIMATOR_TRACKER) on each echo's own
+//      interval, predicted to the control tick, coasting on misses.
+//   3. BangBangHold through ServoMap and the ServoSmoothing step
+//      (SERVO_LUT), in exact integer arithmetic.
+//   4. ServoLead's horn model and command (SERVO_LEAD).
+//   5. ServoBudget's heat and granularity; both servos are written when
+//      either moves, as writeServos() does.
+//   6. The RangeGate window for each axis' next ping.
+// main.cpp built with another spike filter, estimator or law, or without
+// the table or the lead, is not what this flies; the static_assert below
+// keeps batch_sim from building then.
+// test/test_batch_sim_host.cpp checks the lane kernel bit for bit against
+// the stages themselves, the AVX2 build against the scalar one, and the
+// flight statistics against CorridorSimEngine flying main.cpp.
+//
+// Pings follow SonarScheduler's interleave as it runs in the corridor
+// simulator: the right sonar fires just before each control tick, the
+// height sonar half a period later, and each tick consumes the previous
+// ping of each. A reading becomes a whole-microsecond echo as on the HAL
+// (range * SPEED_OF_SOUND_DIVISOR), and is a miss if it lands after its
+// ping's listen window. The echo's mid-point is its time stamp. Poll
+// granularity and crosstalk (none with the slots main.cpp uses) are left out.
+//
+// The glider, servo and sonar models are GliderSim.h's, with launch draws
+// from the same seed. The differences keep all lanes in lockstep:
+//   - sin/cos are polynomials, not libm
+//   - Gaussians are a sum of four uniforms, not Box-Muller
+//   - every lane draws the same random numbers every ping, whatever the
+//     outcome
+//   - a servo holds at most one command in its dead time (which must be
+//     shorter than the loop period)
+//   - the sensor test's average is the noise-free range at launch
+// Flights match CorridorSimEngine statistically, not flight for flight.
+
+#include "CorridorSim.h"
+#include "SimdLanes.h"
+#include <vector>
+
+static_assert(SPIKE_FILTER_MODE == SPIKE_FILTER_HAMPEL && RATE_ESTIMATOR == RATE_ESTIMATOR_TRACKER &&
+              CONTROL_LAW == LAW_BANG_BANG_HOLD && SERVO_LUT && SERVO_LEAD && SONAR_RANGE_GATE,
+              "BatchSim lanes main.cpp's shipped control path only");
+
+// controlTask()'s constants, from main.cpp
+struct BatchControl {
+  // Pings (SonarScheduler, EchoCapture and the Linux HAL's echo)
+  int32_t periodUs;          // LOOP_PERIOD_MS
+  int32_t periodMs;
+  int32_t slotUs;            // SONAR_SLOT_US: right ping to height ping
+  int32_t trigUs;            // Ping to trigger fall (triggerPing()'s delays)
+  int32_t burstUs;           // SONAR_BURST_US: trigger fall to echo rise
+  float usPerCm;             // SPEED_OF_SOUND_DIVISOR
+  float maxRangeCm;          // SIM_MAX_RANGE_CM
+  int32_t listenUs;          // SONAR_LISTEN_US: the window until the gate sets one
+  float failsafeCm;          // FAILSAFE_DIST_CM: start value without an echo
+  float launchCm;            // LAUNCH_HEIGHT_CM
+
+  // HampelFilter
+  float hampelScale;         // HAMPEL_K * 1.4826
+  float hampelMinDev;        // HAMPEL_MIN_DEV_CM
+  float hampelMaxDev;        // MAX_DIST_JUMP_CM
+
+  // AlphaBetaTracker
+  float trackAlpha;
+  float trackBeta;
+  int32_t maxCoast;          // TRACKER_MAX_COAST
+
+  // RangeGate
+  float gateMarginCm;
+  float gateHorizonSec;
+  int32_t gateMinUs;
+  int32_t gateLostAfter;
+
+  // BangBangHold through ServoMap: rudder (right sonar), elevator (height)
+  float rateThreshold[2];
+  int32_t holdMs;
+  int32_t neutralUs[2];
+  int32_t onUs[2];           // ServoMap::command() of the full correction...
+  int32_t offUs[2];          // ...and of none
+  int32_t minUs[2], maxUs[2];
+
+  // ServoSmoothing
+  int32_t smoothPermille;    // SERVO_SMOOTHING_PERMILLE
+  int32_t spanUs;            // SERVO_SPAN_US
+
+  // ServoLead and its ServoResponse
+  float leadGain;
+  float ffGain;
+  float hornGain;            // h / tau per sub-step
+  float hornMaxMove;         // slew * h per sub-step
+  int hornDeadSteps;
+
+  // ServoBudget (SERVO_BUDGET)
+  ServoBudgetConfig budget;
+};
+
+inline BatchControl defaultBatchControl() {
+  BatchControl c;
+  c.periodUs = LOOP_PERIOD_MS * 1000;
+  c.periodMs = LOOP_PERIOD_MS;
+  c.slotUs = (int32_t)SONAR_SLOT_US;
+  c.trigUs = DELAY_TRIG_LOW_1_US + DELAY_TRIG_HIGH_US;
+  c.burstUs = (int32_t)SONAR_BURST_US;
+  c.usPerCm = toFloat(SPEED_OF_SOUND_DIVISOR);
+  c.maxRangeCm = SIM_MAX_RANGE_CM;
+  c.listenUs = (int32_t)SONAR_LISTEN_US;
+  c.failsafeCm = toFloat(FAILSAFE_DIST_CM);
+  c.launchCm = toFloat(LAUNCH_HEIGHT_CM);
+
+  // As the constructors compute them, in float
+  float k = toFloat(HAMPEL_K);
+  c.hampelScale = k * 1.4826;
+  c.hampelMinDev = toFloat(HAMPEL_MIN_DEV_CM);
+  c.hampelMaxDev = toFloat(MAX_DIST_JUMP_CM);
+  c.trackAlpha = toFloat(TRACKER_ALPHA);
+  c.trackBeta = toFloat(TRACKER_BETA);
+  c.maxCoast = TRACKER_MAX_COAST;
+  c.gateMarginCm = GATE_MARGIN_CM;
+  c.gateHorizonSec = GATE_HORIZON_SEC;
+  c.gateMinUs = (int32_t)GATE_MIN_US;
+  c.gateLostAfter = GATE_LOST_AFTER;
+
+  c.rateThreshold[0] = toFloat(RUDDER_AXIS.rateThreshold);
+  c.rateThreshold[1] = toFloat(ELEVATOR_AXIS.rateThreshold);
+  c.holdMs = (int32_t)SERVO_HOLD_TIME_MS;
+  c.neutralUs[0] = SERVO_RUDDER_NEUTRAL;
+  c.neutralUs[1] = SERVO_ELEVATOR_NEUTRAL;
+  c.onUs[0] = RudderMap::command(toInt(fullCorrection(RUDDER_AXIS)));
+  c.onUs[1] = ElevatorMap::command(toInt(fullCorrection(ELEVATOR_AXIS)));
+  c.offUs[0] = RudderMap::command(0);
+  c.offUs[1] = ElevatorMap::command(0);
+  c.minUs[0] = SERVO_RUDDER_MIN;
+  c.maxUs[0] = SERVO_RUDDER_MAX;
+  c.minUs[1] = SERVO_ELEVATOR_MIN;
+  c.maxUs[1] = SERVO_ELEVATOR_MAX;
+  c.smoothPermille = SERVO_SMOOTHING_PERMILLE;
+  c.spanUs = SERVO_SPAN_US;
+
+  c.leadGain = toFloat(SERVO_LEAD_GAIN);
+  c.ffGain = toFloat(SERVO_FF_GAIN);
+  float tick = LOOP_PERIOD_MS / 1000.0;
+  float h = tick / ServoResponse<float>::SUB_STEPS;
+  c.hornGain = h / toFloat(SERVO_TAU_SEC);
+  if (c.hornGain > 1.0f) c.hornGain = 1.0f;
+  c.hornMaxMove = toFloat(SERVO_SLEW_US_S) * h;
+  c.hornDeadSteps = toInt(toFloat(SERVO_DEAD_SEC) / h + 0.5f);
+  if (c.hornDeadSteps > ServoResponse<float>::SUB_STEPS) c.hornDeadSteps = ServoResponse<float>::SUB_STEPS;
+
+  c.budget = SERVO_BUDGET;
+  return c;
+}
+
+const int BATCH_MAX_WIDTH = 8;
+const float BATCH_EMPTY = 3.0e38f;       // Sorts after any range
+
+template <class L>
+inline void batchSort2(typename L::F &a, typename L::F &b) {
+  typename L::F lo = L::min(a, b);
+  b = L::max(a, b);
+  a = lo;
+}
+
+// One axis of controlTask() for a block of lanes
+template <class L>
+struct BatchAxis {
+  typedef typename L::F F;
+  typedef typename L::I I;
+  typedef typename L::M M;
+
+  F window[HAMPEL_WINDOW];   // HampelFilter, arrival order
+  I count;
+  I head;
+  F dist;                    // AlphaBetaTracker
+  F vel;
+  I misses;
+  I lastAtUs;                // lastRightAtUs / lastHeightAtUs
+  F current;                 // currentRight / currentHeight
+  F rate;                    // avgRateRight / avgRateHeight
+  M acquired;                // RangeGate
+  I missStreak;
+  I listenUs;                // Window of this axis' next ping
+  M holdActive;              // HoldTimer
+  I holdSinceMs;
+  I pwm;                     // prevRudderPWM / prevElevatorPWM
+  F hornPos;                 // ServoLead's ServoResponse
+  F hornApplied;
+  I pulse;                   // ServoBudget
+  I heatMilli;
+
+  void reset(const BatchControl &c, int axis, F startCm) {
+    for (int k = 0; k < HAMPEL_WINDOW; k++) window[k] = F(0.0f);
+    count = I(0);
+    head = I(0);
+    dist = startCm;
+    vel = F(0.0f);
+    misses = I(0);
+    lastAtUs = I(0);
+    current = startCm;
+    rate = F(0.0f);
+    acquired = L::none();
+    missStreak = I(0);
+    listenUs = I(c.listenUs);
+    holdActive = L::none();
+    holdSinceMs = I(0);
+    pwm = I(c.neutralUs[axis]);
+    hornPos = F((float)c.neutralUs[axis]);
+    hornApplied = hornPos;
+    pulse = I(c.neutralUs[axis]);
+    heatMilli = I(0);
+  }
+
+  // microsToSeconds<float>()
+  static F seconds(I us) {
+    I whole = L::divI(us, 1000);
+    return (L::toF(whole) + L::toF(us - whole * I(1000)) / F(1000.0f)) / F(1000.0f);
+  }
+
+  // HampelFilter::filter() on the lanes in `on`. The median is sorted[n/2]
+  // and the MAD the (n/2)th smallest distance from it among the others,
+  // as the filter's merge-walk finds them.
+  F hampel(const BatchControl &c, M on, F x) {
+    static_assert(HAMPEL_WINDOW == 5, "The sorting network is for five samples");
+    for (int k = 0; k < HAMPEL_WINDOW; k++) window[k] = L::select(on & (head == I(k)), x, window[k]);
+    head = L::selectI(on, head + I(1), head);
+    head = L::selectI(head == I(HAMPEL_WINDOW), I(0), head);
+    count = L::selectI(on & (count < I(HAMPEL_WINDOW)), count + I(1), count);
+
+    F s[HAMPEL_WINDOW];
+    for (int k = 0; k < HAMPEL_WINDOW; k++) s[k] = L::select(I(k) < count, window[k], F(BATCH_EMPTY));
+    batchSort2<L>(s[0], s[1]);
+    batchSort2<L>(s[3], s[4]);
+    batchSort2<L>(s[2], s[4]);
+    batchSort2<L>(s[2], s[3]);
+    batchSort2<L>(s[0], s[3]);
+    batchSort2<L>(s[0], s[2]);
+    batchSort2<L>(s[1], s[4]);
+    batchSort2<L>(s[1], s[3]);
+    batchSort2<L>(s[1], s[2]);
+
+    M three = count == I(3);
+    F med = L::select(three, s[1], s[2]);
+    F madThree = L::min(L::abs(s[0] - s[1]), L::abs(s[2] - s[1]));
+    F d0 = L::abs(s[0] - s[2]), d1 = L::abs(s[1] - s[2]);
+    F d3 = L::abs(s[3] - s[2]), d4 = L::abs(s[4] - s[2]);
+    F madFive = L::min(L::max(L::min(d0, d1), L::min(d3, d4)), L::min(L::max(d0, d1), L::max(d3, d4)));
+    F mad = L::select(three, madThree, madFive);
+
+    F limit = F(c.hampelScale) * mad;
+    limit = L::select(limit < F(c.hampelMinDev), F(c.hampelMinDev), limit);
+    limit = L::select(limit > F(c.hampelMaxDev), F(c.hampelMaxDev), limit);
+    F out = L::select(L::abs(x - med) > limit, med, x);
+    return L::select(count < I(3), x, out);
+  }
+
+  // Steps 2 of controlTask(): spike filter, tracker, prediction to nowUs,
+  // range gate bookkeeping. `raw` is NO_READING_VAL or an echo's range,
+  // stamped at its mid-point.
+  F sense(const BatchControl &c, F raw, I rawAtUs, I nowUs) {
+    M valid = L::notM(raw == F(NO_READING_VAL));
+    F clean = hampel(c, valid, raw);
+
+    F dt = seconds(rawAtUs - lastAtUs);
+    lastAtUs = L::selectI(valid, rawAtUs, lastAtUs);
+    F ahead = dist + vel * dt;
+    F residual = clean - ahead;
+    F corrected = ahead + F(c.trackAlpha) * residual;
+    F steered = L::select(dt > F(0.0f), vel + (F(c.trackBeta) * residual) / dt, vel);
+    misses = L::selectI(valid, I(0), misses + I(1));
+    dist = L::select(valid, corrected, dist);
+    vel = L::select(valid, steered, L::select(L::notM(misses < I(c.maxCoast)), F(0.0f), vel));
+    current = dist + vel * seconds(nowUs - lastAtUs);
+
+    missStreak = L::selectI(valid, I(0), missStreak + I(1));
+    acquired = valid | (acquired & (missStreak < I(c.gateLostAfter)));
+    return current;
+  }
+
+  // ServoResponse::subStep()
+  static F hornStep(const BatchControl &c, F pos, F command) {
+    F move = (command - pos) * F(c.hornGain);
+    move = L::select(move > F(c.hornMaxMove), F(c.hornMaxMove),
+                     L::select(move < F(-c.hornMaxMove), F(-c.hornMaxMove), move));
+    return pos + move;
+  }
+
+  // Steps 4-10 of controlTask(): the law on `started` lanes, the gate
+  // window, smoothing, lead and budget. Returns the lanes whose budget
+  // let the command through.
+  M control(const BatchControl &c, int axis, M started, int32_t nowMs) {
+    rate = L::select(started, -vel, F(0.0f));
+    M trigger = rate > F(c.rateThreshold[axis]);
+    M held = holdActive & ((I(nowMs) - holdSinceMs) < I(c.holdMs));
+    holdSinceMs = L::selectI(started & trigger, I(nowMs), holdSinceMs);
+    holdActive = (started & (trigger | held)) | (L::notM(started) & holdActive);
+    I target = L::selectI(started & holdActive, I(c.onUs[axis]),
+                          L::selectI(started, I(c.offUs[axis]), I(c.neutralUs[axis])));
+
+    // RangeGate::windowUs()
+    F reach = current + L::abs(rate) * F(c.gateHorizonSec) + F(c.gateMarginCm);
+    F us = reach * F(SONAR_US_PER_CM) + F((float)c.burstUs);
+    I window = L::selectI(us < F((float)c.gateMinUs), I(c.gateMinUs),
+                          L::selectI(us < F((float)c.listenUs), L::truncI(us), I(c.listenUs)));
+    listenUs = L::selectI(acquired, window, I(c.listenUs));
+
+    // ServoSmoothing::apply(): prev + floorDiv(step * permille, 1000)
+    I step = target - pwm;
+    step = L::selectI(step < I(-c.spanUs), I(-c.spanUs), L::selectI(step > I(c.spanUs), I(c.spanUs), step));
+    I scaled = step * I(c.smoothPermille);
+    I down = I(0) - L::divI(I(0) - scaled + I(999), 1000);
+    pwm = pwm + L::selectI(scaled < I(0), down, L::divI(scaled, 1000));
+
+    // ServoLead::command()
+    F ref = L::toF(pwm);
+    F predicted = hornPos;
+    for (int i = 0; i < c.hornDeadSteps; i++) predicted = hornStep(c, predicted, hornApplied);
+    F u = (ref + F(c.leadGain) * (ref - predicted)) + F(c.ffGain) * L::toF(target - pwm);
+    I command = L::truncI(u);
+    command = L::selectI(command < I(c.minUs[axis]), I(c.minUs[axis]),
+                         L::selectI(command > I(c.maxUs[axis]), I(c.maxUs[axis]), command));
+
+    // ServoBudget::update()
+    const ServoBudgetConfig &b = c.budget;
+    I heat = L::divI(heatMilli, 1000);
+    I granularity = L::selectI(heat < I(b.limitUs),
+                               I(b.minStepUs) + L::divI(I(b.maxStepUs - b.minStepUs) * heat, b.limitUs),
+                               I(b.maxStepUs));
+    I delta = L::absI(command - pulse);
+    M moved = delta > granularity;
+    pulse = L::selectI(moved, command, pulse);
+    heatMilli = heatMilli + L::selectI(moved, delta * I(1000), I(0));
+    heatMilli = heatMilli + L::absI(pulse - I(c.neutralUs[axis])) * I(b.holdPermille);
+    heatMilli = heatMilli - L::divI(heatMilli, 1000) * I(b.coolPermille);
+    heatMilli = L::selectI(heatMilli > I(b.limitUs * 2000), I(b.limitUs * 2000), heatMilli);
+
+    // ServoLead::advance(): the horn model follows what was sent
+    F pending = L::toF(pulse);
+    for (int i = 0; i < ServoResponse<float>::SUB_STEPS; i++) {
+      if (i == c.hornDeadSteps) hornApplied = pending;
+      hornPos = hornStep(c, hornPos, hornApplied);
+    }
+    hornApplied = pending;
+    return moved;
+  }
+};
+
+// ---------------------------------------------------------
+// Lane math shared by both builds
+// ---------------------------------------------------------
+const float BATCH_PI = 3.14159265f;
+
+// Range-reduced to [-pi/2, pi/2], then odd Taylor to x^9 (error < 4e-6)
+template <class L>
+inline typename L::F batchSin(typename L::F x) {
+  typedef typename L::F F;
+  F k = L::round(x * F(1.0f / (2.0f * BATCH_PI)));
+  F r = x - k * F(2.0f * BATCH_PI);
+  r = L::select(r > F(0.5f * BATCH_PI), F(BATCH_PI) - r, r);
+  r = L::select(r < F(-0.5f * BATCH_PI), F(-BATCH_PI) - r, r);
+  F r2 = r * r;
+  F p = F(1.0f / 362880.0f);
+  p = p * r2 + F(-1.0f / 5040.0f);
+  p = p * r2 + F(1.0f / 120.0f);
+  p = p * r2 + F(-1.0f / 6.0f);
+  p = p * r2 + F(1.0f);
+  return r * p;
+}
+
+template <class L>
+inline typename L::F batchCos(typename L::F x) {
+  return batchSin<L>(x + typename L::F(0.5f * BATCH_PI));
+}
+
+// GliderSim::halfWidth()
+template <class L>
+inline typename L::F batchHalfWidth(typename L::F x) {
+  typedef typename L::F F;
+  F k = L::min(L::max(x / F(CORRIDOR_LEN_M), F(0.0f)), F(1.0f));
+  return F(0.5f) * (F(CORRIDOR_START_M) + F(CORRIDOR_END_M - CORRIDOR_START_M) * k);
+}
+
+// Sum of four uniforms, unit variance (tails end at +-3.5 sigma)
+template <class L>
+inline typename L::F batchGaussian(typename L::U &s) {
+  typedef typename L::F F;
+  F a = L::uniform(s);
+  F b = L::uniform(s);
+  F c = L::uniform(s);
+  F d = L::uniform(s);
+  return (((a + b) + c) + d - F(2.0f)) * F(1.7320508f);
+}
+
+// GliderSim's sonarGeometryCm() and reading(), with every draw made
+template <class L>
+inline typename L::F batchSonar(const SonarParams &s, typename L::F perpM, typename L::F incidence,
+                                typename L::U &rng) {
+  typedef typename L::F F;
+  typedef typename L::M M;
+  F inc = L::abs(incidence);
+  F beam = F(s.beamHalfDeg * SIM_DEG);
+  M echo = (perpM > F(0.0f)) & (inc <= F(s.maxIncidenceDeg * SIM_DEG));
+  F r = L::select(inc <= beam, perpM, perpM / batchCos<L>(inc - beam));
+  F cm = r * F(100.0f);
+
+  F drop = L::uniform(rng);
+  F spike = L::uniform(rng);
+  F which = L::uniform(rng);
+  F where = L::uniform(rng);
+  F noise = batchGaussian<L>(rng);
+  F minCm = F(s.minRangeCm);
+  F clean = L::max(cm + noise * (F(s.noiseCm) + F(s.noiseFrac) * cm), minCm);
+  F spiked = L::select(which < F(0.5f), F(2.0f) * cm, minCm + (cm - minCm) * where);
+  F out = L::select(spike < F(s.spike), spiked, clean);
+  return L::select(L::notM(echo) | (drop < F(s.dropout)), F(NO_READING_VAL), out);
+}
+
+// ---------------------------------------------------------
+// The engine
+// ---------------------------------------------------------
+class BatchSim {
+  private:
+    // Launch draws, one block, structure of arrays
+    struct Launch {
+      float y[BATCH_MAX_WIDTH], z[BATCH_MAX_WIDTH], speed[BATCH_MAX_WIDTH];
+      float gamma[BATCH_MAX_WIDTH], heading[BATCH_MAX_WIDTH];
+      float yawDrift[BATCH_MAX_WIDTH], clTrim[BATCH_MAX_WIDTH];
+      float rightCm[BATCH_MAX_WIDTH], heightCm[BATCH_MAX_WIDTH];
+      uint32_t rng[BATCH_MAX_WIDTH], sonarRng[BATCH_MAX_WIDTH];
+    };
+    struct Outcome {
+      int32_t outcome[BATCH_MAX_WIDTH], launched[BATCH_MAX_WIDTH], writes[BATCH_MAX_WIDTH];
+      float timeSec[BATCH_MAX_WIDTH], distanceM[BATCH_MAX_WIDTH];
+      float minRight[BATCH_MAX_WIDTH], minLeft[BATCH_MAX_WIDTH], minGround[BATCH_MAX_WIDTH];
+    };
+
+    SimConfig cfg;
+    BatchControl ctl;
+    float wallAngle;
+    float vTrim;
+
+    // GliderSim's constructor draws, and the sensor test's ranges
+    void draw(uint32_t seed, int lane, Launch &l) const {
+      SimRng rng(seed);
+      const LaunchSpread &sp = cfg.spread;
+      l.y[lane] = rng.uniform(sp.offsetM[0], sp.offsetM[1]);
+      l.z[lane] = rng.uniform(sp.heightM[0], sp.heightM[1]);
+      l.speed[lane] = rng.uniform(sp.speedMS[0], sp.speedMS[1]);
+      l.gamma[lane] = rng.uniform(sp.gammaDeg[0], sp.gammaDeg[1]) * SIM_DEG;
+      l.heading[lane] = rng.uniform(sp.headingDeg[0], sp.headingDeg[1]) * SIM_DEG;
+      l.yawDrift[lane] = rng.uniform(sp.yawDriftDegS[0], sp.yawDriftDegS[1]) * SIM_DEG;
+      l.clTrim[lane] = cfg.glider.clTrim + rng.uniform(sp.clTrimDelta[0], sp.clTrimDelta[1]);
+      l.rng[lane] = rng.state;
+      l.sonarRng[lane] = SimRng(~seed).state;
+
+      float right = sonarGeometryCm(cfg.sonar, (l.y[lane] + 0.5f * CORRIDOR_START_M) * cosf(wallAngle),
+                                    l.heading[lane] + wallAngle);
+      float height = sonarGeometryCm(cfg.sonar, l.z[lane], l.gamma[lane]);
+      bool echoes = right > 0 && height > 0;
+      l.rightCm[lane] = echoes ? right : ctl.failsafeCm;
+      l.heightCm[lane] = echoes ? height : ctl.failsafeCm;
+    }
+
+    // A ping fired at pingUs reading `cm`: the echo the HAL would send and
+    // the range servicePings() would take from it, or NO_READING_VAL if
+    // there is none or it came after the listen window
+    template <class L>
+    void ping(typename L::F cm, typename L::I listenUs, int32_t pingUs, typename L::F &raw,
+              typename L::I &atUs) const {
+      typedef typename L::F F;
+      typedef typename L::I I;
+      typename L::M heard = (cm > F(0.0f)) & (cm <= F(ctl.maxRangeCm));
+      I width = L::truncI(cm * F(ctl.usPerCm) + F(0.5f));
+      I fallUs = I(ctl.trigUs + ctl.burstUs) + width;
+      heard = heard & L::notM(fallUs > listenUs);
+      raw = L::select(heard, L::toF(width) / F(ctl.usPerCm), F(NO_READING_VAL));
+      atUs = I(pingUs) + fallUs - L::divI(width, 2);
+    }
+
+    template <class L>
+    void flyBlock(const Launch &l, Outcome &o) const {
+      typedef typename L::F F;
+      typedef typename L::I I;
+      typedef typename L::U U;
+      typedef typename L::M M;
+      const GliderParams &g = cfg.glider;
+      const float h = SIM_STEP_SEC;
+
+      F x = F(0.0f), y = L::load(l.y), z = L::load(l.z), speed = L::load(l.speed);
+      F gamma = L::load(l.gamma), heading = L::load(l.heading), yawRate = F(0.0f);
+      F yawDrift = L::load(l.yawDrift), clTrim = L::load(l.clTrim), cl = clTrim;
+      F gustY = F(0.0f), gustZ = F(0.0f);
+      U rng = L::loadU(l.rng), sonarRng = L::loadU(l.sonarRng);
+
+      F rudPos = F((float)cfg.rudder.neutralUs), elePos = F((float)cfg.elevator.neutralUs);
+      I rudTarget = I(cfg.rudder.neutralUs), eleTarget = I(cfg.elevator.neutralUs);
+      I rudPending = rudTarget, elePending = eleTarget;
+      M rudQueued = L::none(), eleQueued = L::none();
+      double rudAt = 0, eleAt = 0;         // When the queued commands land
+
+      BatchAxis<L> right, height;
+      right.reset(ctl, 0, L::load(l.rightCm));
+      height.reset(ctl, 1, L::load(l.heightCm));
+      F rightRaw = F(NO_READING_VAL), heightRaw = F(NO_READING_VAL);
+      I rightAtUs = I(0), heightAtUs = I(0);
+      M started = L::none();
+      I writes = I(2);                     // setup() writes both at neutral
+
+      I outcome = I(GliderSim::FLYING);
+      M flying = L::all();
+      F endTime = F(0.0f), endX = F(0.0f);
+      F minRight = F(1e9f), minLeft = F(1e9f), minGround = F(1e9f);
+
+      const float kick = cfg.spread.gustMS * sqrtf(2.0f * h / cfg.spread.gustTauSec);
+      const float wallCos = cosf(wallAngle);
+      const int tickSteps = (int)(ctl.periodUs * 1e-6f / h + 0.5f);
+      const int slotSteps = (int)(ctl.slotUs * 1e-6f / h + 0.5f);
+      const int maxSteps = (int)(cfg.maxSec / h + 0.5f);
+      double t = 0;
+
+      for (int step = 0; step < maxSteps; step++) {
+        // Control tick: the right sonar fires first (the sonar task runs
+        // ahead of the control task), then controlTask() on the pings of
+        // the tick before, then the writes
+        int phase = step % tickSteps;
+        if (phase == 0) {
+          if (!L::any(flying)) break;
+          int32_t tickUs = (step / tickSteps) * ctl.periodUs;
+          F rawRight = rightRaw, rawHeight = heightRaw;
+          I rawRightAt = rightAtUs, rawHeightAt = heightAtUs;
+          F w = batchHalfWidth<L>(x);
+          ping<L>(batchSonar<L>(cfg.sonar, (y + w) * F(wallCos), heading + F(wallAngle), sonarRng),
+               right.listenUs, tickUs, rightRaw, rightAtUs);
+
+          I nowUs = I(tickUs + ctl.trigUs);
+          right.sense(ctl, rawRight, rawRightAt, nowUs);
+          height.sense(ctl, rawHeight, rawHeightAt, nowUs);
+
+          // Lanes that have landed keep stepping until the block is done, but
+          // nothing they do after that counts
+          M launch = flying & L::notM(started) & (height.current > F(ctl.launchCm));
+          started = started | launch;
+
+          int32_t nowMs = (step / tickSteps) * ctl.periodMs;
+          M rudMoved = right.control(ctl, 0, started, nowMs);
+          M eleMoved = height.control(ctl, 1, started, nowMs);
+          M write = rudMoved | eleMoved;
+          rudPending = L::selectI(write, right.pulse, rudPending);
+          elePending = L::selectI(write, height.pulse, elePending);
+          rudQueued = rudQueued | write;
+          eleQueued = eleQueued | write;
+          writes = L::selectI(flying & write, writes + I(2), writes);
+          rudAt = t + cfg.rudder.deadSec;
+          eleAt = t + cfg.elevator.deadSec;
+        } else if (phase == slotSteps) {
+          int32_t pingUs = (step / tickSteps) * ctl.periodUs + ctl.slotUs;
+          ping<L>(batchSonar<L>(cfg.sonar, z, gamma, sonarRng), height.listenUs, pingUs, heightRaw, heightAtUs);
+        }
+
+        // Servos: the queued command lands after the dead time, then slew
+        if (rudAt <= t) {
+          rudTarget = L::selectI(rudQueued, rudPending, rudTarget);
+          rudQueued = L::none();
+        }
+        if (eleAt <= t) {
+          eleTarget = L::selectI(eleQueued, elePending, eleTarget);
+          eleQueued = L::none();
+        }
+        F rudGoal = L::toF(rudTarget), eleGoal = L::toF(eleTarget);
+        F rudMove = F(cfg.rudder.slewUsPerSec * h), eleMove = F(cfg.elevator.slewUsPerSec * h);
+        rudPos = L::select(rudGoal > rudPos, L::min(rudPos + rudMove, rudGoal), L::max(rudPos - rudMove, rudGoal));
+        elePos = L::select(eleGoal > elePos, L::min(elePos + eleMove, eleGoal), L::max(elePos - eleMove, eleGoal));
+        F rudDefl = (rudPos - F((float)cfg.rudder.neutralUs)) /
+                    F((float)(cfg.rudder.fullUs - cfg.rudder.neutralUs));
+        F eleDefl = (elePos - F((float)cfg.elevator.neutralUs)) /
+                    F((float)(cfg.elevator.fullUs - cfg.elevator.neutralUs));
+
+        // GliderSim::step()
+        F sinG = batchSin<L>(gamma), cosG = batchCos<L>(gamma);
+        F clCmd = clTrim + F(g.clElevator) * eleDefl;
+        cl += (clCmd - cl) * F(h) / F(g.pitchTauSec);
+        F q = F(0.5f * SIM_RHO) * speed * speed * F(g.wingAreaM2);
+        F lift = q * cl;
+        F drag = q * (F(g.cd0) + F(g.inducedK) * cl * cl);
+        speed += (-drag / F(g.massKg) - F(SIM_G) * sinG) * F(h);
+        speed = L::select(speed < F(0.5f), F(0.5f), speed);
+        gamma += (lift - F(g.massKg * SIM_G) * cosG) / (F(g.massKg) * speed) * F(h);
+
+        F yawCmd = F(-g.yawRateFullDegS * SIM_DEG) * rudDefl * (speed * speed) / F(vTrim * vTrim) + yawDrift;
+        yawRate += (yawCmd - yawRate) * F(h) / F(g.yawTauSec);
+        heading += yawRate * F(h);
+
+        gustY += -gustY * F(h / cfg.spread.gustTauSec) + F(kick) * batchGaussian<L>(rng);
+        gustZ += -gustZ * F(h / cfg.spread.gustTauSec) + F(kick) * batchGaussian<L>(rng);
+
+        F ground = speed * cosG;
+        x += ground * batchCos<L>(heading) * F(h);
+        y += (-ground * batchSin<L>(heading) + gustY) * F(h);
+        z += (speed * batchSin<L>(gamma) + gustZ) * F(h);
+        t += h;
+
+        F w = batchHalfWidth<L>(x);
+        F toRight = y + w - F(0.5f * g.spanM);
+        F toLeft = w - y - F(0.5f * g.spanM);
+        minRight = L::select(flying, L::min(toRight, minRight), minRight);
+        minLeft = L::select(flying, L::min(toLeft, minLeft), minLeft);
+        minGround = L::select(flying, L::min(z, minGround), minGround);
+
+        M hitGround = z <= F(0.0f);
+        M hitRight = toRight <= F(0.0f);
+        M hitLeft = toLeft <= F(0.0f);
+        M cleared = x >= F(CORRIDOR_LEN_M);
+        I code = L::selectI(hitGround, I(GliderSim::HIT_GROUND),
+                 L::selectI(hitRight, I(GliderSim::HIT_RIGHT),
+                 L::selectI(hitLeft, I(GliderSim::HIT_LEFT), I(GliderSim::CLEARED))));
+        M ends = flying & (hitGround | hitRight | hitLeft | cleared);
+        outcome = L::selectI(ends, code, outcome);
+        endTime = L::select(ends, F((float)t), endTime);
+        endX = L::select(ends, x, endX);
+        flying = flying & L::notM(ends);
+      }
+      endTime = L::select(flying, F((float)t), endTime);
+      endX = L::select(flying, x, endX);
+
+      L::storeI(o.outcome, outcome);
+      L::storeI(o.launched, L::selectI(started, I(1), I(0)));
+      L::storeI(o.writes, writes);
+      L::store(o.timeSec, endTime);
+      L::store(o.distanceM, endX);
+      L::store(o.minRight, minRight);
+      L::store(o.minLeft, minLeft);
+      L::store(o.minGround, minGround);
+    }
+
+  public:
+    BatchSim(const SimConfig &config, const BatchControl &control) : cfg(config), ctl(control) {
+      wallAngle = atanf(0.5f * (CORRIDOR_START_M - CORRIDOR_END_M) / CORRIDOR_LEN_M);
+      vTrim = sqrtf(2.0f * cfg.glider.massKg * SIM_G / (SIM_RHO * cfg.glider.wingAreaM2 * cfg.glider.clTrim));
+    }
+
+    // Flights firstSeed ... firstSeed + n - 1, L::WIDTH at a time
+    template <class L>
+    void fly(uint32_t firstSeed, int n, SimResult *out) const {
+      Launch l;
+      Outcome o;
+      for (int first = 0; first < n; first += L::WIDTH) {
+        for (int lane = 0; lane < L::WIDTH; lane++) draw(firstSeed + first + lane, lane, l);
+        flyBlock<L>(l, o);
+        for (int lane = 0; lane < L::WIDTH && first + lane < n; lane++) {
+          SimResult &r = out[first + lane];
+          r.outcome = (GliderSim::Outcome)o.outcome[lane];
+          r.timeSec = o.timeSec[lane];
+          r.distanceM = o.distanceM[lane];
+          r.minRightM = o.minRight[lane];
+          r.minLeftM = o.minLeft[lane];
+          r.minGroundM = o.minGround[lane];
+          r.launched = o.launched[lane] != 0;
+          r.servoWrites = o.writes[lane];
+        }
+      }
+    }
+};
+
+// The widest lanes this build has
+#if defined(__AVX2__)
+typedef Avx2Lanes BatchLanes;
+#else
+typedef ScalarLanes BatchLanes;
+#endif
+
+#endif
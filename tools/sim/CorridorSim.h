@@ -0,0 +1,203 @@
+#ifndef CORRIDOR_SIM_H
+#define CORRIDOR_SIM_H
+
+// =========================================================
+// src/main.cpp flying the simulated glider (GliderSim.h)
+// =========================================================
+// Include after src/main.cpp, which builds on the Linux HAL backend:
+//   #define PROFILE_STAGES 0
+//   #include "../../src/main.cpp"
+//   #include "CorridorSim.h"
+//
+// Per flight, CorridorSimEngine:
+//   1. Forks a child (halLinuxPowerCycle()), so each flight starts from a
+//      fresh board: the driver itself never runs the sketch.
+//   2. Runs setup() with the glider held at its launch pose: the sensor
+//      test reads the launch ranges.
+//   3. Releases the glider and calls loop() until the flight ends (cleared,
+//      hit something) or maxSec. Pings read the model at the instant of
+//      the trigger; servo writes reach the model's servos at the instant
+//      they are made. The model is integrated up to each of those, and the
+//      clock skips idle time as in the replay (halLinuxRun()).
+//   3. Hands the result, and on request the telemetry stream the sketch
+//      sent, back to the parent.
+// Nothing of the control code is stubbed: sonar scheduling, echo capture,
+// filtering, the law, servo smoothing, lead and budget all run as on the
+// board, only with zero run time.
+
+#include <string>
+#include "GliderSim.h"
+
+const float SIM_MAX_RANGE_CM = 400;      // HC-SR04: farther gives no echo
+
+struct SimConfig {
+  GliderParams glider;
+  SonarParams sonar;
+  SimServoParams rudder;     // The real servos, not the sketch's model of them
+  SimServoParams elevator;
+  LaunchSpread spread;
+  float maxSec;
+};
+
+// The README's mission with main.cpp's servo wiring
+inline SimConfig defaultSimConfig() {
+  SimConfig c;
+  c.glider = DEFAULT_GLIDER;
+  c.sonar = DEFAULT_SONAR;
+  SimServoParams rudder = { SERVO_RUDDER_NEUTRAL, SERVO_RUDDER_LEFT, 0.025f, 6500.0f };
+  SimServoParams elevator = { SERVO_ELEVATOR_NEUTRAL, SERVO_ELEVATOR_UP, 0.025f, 6500.0f };
+  c.rudder = rudder;
+  c.elevator = elevator;
+  c.spread = DEFAULT_SPREAD;
+  c.maxSec = 5.0f;
+  return c;
+}
+
+struct SimResult {
+  GliderSim::Outcome outcome;
+  float timeSec;             // Release to the end of the flight
+  float distanceM;           // Down the corridor
+  float minRightM;           // Closest wingtip-to-wall and height
+  float minLeftM;
+  float minGroundM;
+  bool launched;             // The sketch saw the launch
+  int servoWrites;
+};
+
+// Called with the model after every loop() chunk, e.g. to trace a flight.
+// It runs in the flight's child: it may print, but anything it keeps is
+// gone when fly() returns.
+typedef void (*SimTraceFn)(void *ctx, const GliderSim &sim);
+
+class CorridorSimEngine {
+  private:
+    struct Run {
+      GliderSim *sim;
+      uint64_t releaseUs;
+      bool released;
+      int writes;
+    };
+
+    // One fly() call, handed to the child
+    struct Job {
+      const SimConfig *cfg;
+      uint32_t seed;
+      SimTraceFn trace;
+      void *traceCtx;
+      bool telemetry;
+    };
+
+    static double sinceRelease(const Run &r, uint64_t atUs) {
+      return r.released && atUs > r.releaseUs ? (atUs - r.releaseUs) * 1e-6 : 0.0;
+    }
+
+    static float rangeAt(void *ctx, int trigPin, uint64_t nowUs) {
+      Run &r = *(Run *)ctx;
+      if (r.released) r.sim->advanceTo(sinceRelease(r, nowUs));
+      return trigPin == PIN_TRIG_RIGHT ? r.sim->rightSonarCm() : r.sim->heightSonarCm();
+    }
+
+    static void servoWrite(void *ctx, int pin, int us, uint64_t atUs) {
+      Run &r = *(Run *)ctx;
+      double t = sinceRelease(r, atUs);
+      if (r.released) r.sim->advanceTo(t);
+      if (pin == PIN_SERVO_RUDDER) r.sim->rudder.write(us, t);
+      else if (pin == PIN_SERVO_ELEVATOR) r.sim->elevator.write(us, t);
+      r.writes++;
+    }
+
+    static uint32_t nextTaskDue(uint32_t nowUs) { return tasks.nextDueUs(nowUs); }
+
+    static void summarize(const GliderSim &sim, SimResult &out) {
+      out.outcome = sim.result();
+      out.timeSec = (float)sim.time();
+      out.distanceM = sim.state().x;
+      out.minRightM = sim.minRightM();
+      out.minLeftM = sim.minLeftM();
+      out.minGroundM = sim.minGroundM();
+    }
+
+    // In the child: the flight, then the SimResult's bytes and the
+    // telemetry stream into `out`
+    static void flyChild(void *ctx, std::string &out) {
+      const Job &job = *(const Job *)ctx;
+      const SimConfig &cfg = *job.cfg;
+      GliderSim sim(cfg.glider, cfg.sonar, cfg.rudder, cfg.elevator, cfg.spread, job.seed);
+      Run run = { &sim, 0, false, 0 };
+
+      HalLinuxState &s = halLinux();
+      s.range = rangeAt;
+      s.servo = servoWrite;
+      s.ctx = &run;
+      s.burstUs = SONAR_BURST_US;
+      s.usPerCm = toFloat(SPEED_OF_SOUND_DIVISOR);
+      s.maxRangeCm = SIM_MAX_RANGE_CM;
+      s.missHoldUs = HAL_LINUX_MISS_HOLD_US;
+
+      // The port as a capture from power-on, console text included
+      char *stream = NULL;
+      size_t streamBytes = 0;
+      if (job.telemetry) {
+        s.logOut = open_memstream(&stream, &streamBytes);
+        telemetryOn = true;
+      }
+
+      s.skipIdle = true;
+      setup();
+      s.skipIdle = false;
+      run.releaseUs = s.nowUs;
+      run.released = true;
+
+      // Chunks of a few ms so the flight stops soon after it ends
+      const uint64_t CHUNK_US = 5000;
+      uint64_t endUs = run.releaseUs + (uint64_t)(cfg.maxSec * 1e6f);
+      for (uint64_t t = run.releaseUs; t < endUs && sim.result() == GliderSim::FLYING; ) {
+        t += CHUNK_US;
+        halLinuxRun(t, loop, nextTaskDue);
+        sim.advanceTo(sinceRelease(run, t));
+        if (job.trace) job.trace(job.traceCtx, sim);
+      }
+
+      SimResult result;
+      summarize(sim, result);
+      result.launched = flightStarted;
+      result.servoWrites = run.writes;
+      out.assign((const char *)&result, sizeof(result));
+
+      if (s.logOut) {
+        telemetry.drain(serialSink, UINT32_MAX);
+        fclose(s.logOut);
+        s.logOut = NULL;
+        out.append(stream, streamBytes);
+        free(stream);
+      }
+    }
+
+  public:
+    // With `capture` set, the bytes the sketch sent on its port (telemetry
+    // on from power-on) land there. False (out zeroed) if the flight's
+    // child failed.
+    bool fly(const SimConfig &cfg, uint32_t seed, SimResult &out,
+             SimTraceFn trace = NULL, void *traceCtx = NULL, std::string *capture = NULL) {
+      Job job = { &cfg, seed, trace, traceCtx, capture != NULL };
+      std::string bytes;
+      bool ok = halLinuxPowerCycle(flyChild, &job, bytes) && bytes.size() >= sizeof(out);
+      out = SimResult();
+      if (!ok) return false;
+      memcpy(&out, bytes.data(), sizeof(out));
+      if (capture) capture->assign(bytes, sizeof(out), std::string::npos);
+      return true;
+    }
+
+    // The same flight with the surfaces left at neutral: the baseline the
+    // control code has to beat
+    static void flyUncontrolled(const SimConfig &cfg, uint32_t seed, SimResult &out) {
+      GliderSim sim(cfg.glider, cfg.sonar, cfg.rudder, cfg.elevator, cfg.spread, seed);
+      sim.advanceTo(cfg.maxSec);
+      summarize(sim, out);
+      out.launched = false;
+      out.servoWrites = 0;
+    }
+};
+
+#endif
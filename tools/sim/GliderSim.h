@@ -0,0 +1,339 @@
+#ifndef GLIDER_SIM_H
+#define GLIDER_SIM_H
+
+// =========================================================
+// Glider, corridor and sonar model for closed-loop simulation
+// =========================================================
+// The mission from the README: a corridor 8ft wide narrowing to 3ft over
+// 15ft (both walls converge), entered at 3.5ft. The glider is a point mass
+// in the vertical plane (speed, flight path angle, lift and drag from a
+// lift coefficient the elevator moves with a pitch lag) plus a lateral
+// model (heading driven by a first-order yaw rate from the rudder, trim
+// drift and crosswind gusts). x runs down the corridor, y is the offset left
+// of the centre line, z the height; heading is positive towards the right
+// wall, the one the right sonar sees.
+//
+// Servos obey a dead time and a slew limit before moving the surfaces.
+// Each HC-SR04 returns the nearest echo inside its beam cone: the
+// perpendicular distance while the surface normal is inside the cone,
+// longer (the cone's edge) past it, and nothing once the incidence is so
+// steep that the echo reflects away. Readings carry Gaussian noise, and at
+// random a dropout (no echo: NO_READING_VAL in the sketch) or a spike (a
+// multipath echo at twice the range, or a phantom short one).
+//
+// Everything is deterministic for a given seed. No globals, so a model can
+// live in the driver or in the child a flight runs in (halLinuxPowerCycle()).
+
+#include <stdint.h>
+#include <math.h>
+
+// Mission
+const float CORRIDOR_LEN_M    = 4.57f;   // 15ft
+const float CORRIDOR_START_M  = 2.44f;   // 8ft wide at the entrance
+const float CORRIDOR_END_M    = 0.91f;   // 3ft at the exit
+const float CORRIDOR_HEIGHT_M = 1.07f;   // 3.5ft: the entry height
+
+const float SIM_STEP_SEC = 0.001f;
+const float SIM_G = 9.81f;
+const float SIM_RHO = 1.225f;
+const float SIM_DEG = 3.14159265f / 180.0f;
+
+// xorshift32, with Box-Muller for Gaussians
+struct SimRng {
+  uint32_t state;
+
+  explicit SimRng(uint32_t seed) : state(seed * 2654435761u + 0x9E3779B9u) {
+    if (!state) state = 1;
+  }
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+  float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+  float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+  bool chance(float p) { return uniform() < p; }
+  float gaussian() {
+    float u = uniform(1e-7f, 1.0f), v = uniform();
+    return sqrtf(-2.0f * logf(u)) * cosf(6.2831853f * v);
+  }
+};
+
+struct GliderParams {
+  float massKg;
+  float wingAreaM2;
+  float spanM;
+  float clTrim;              // Lift coefficient with the elevator neutral
+  float clElevator;          // Added by full up elevator
+  float cd0;                 // Drag: cd0 + inducedK * CL^2
+  float inducedK;
+  float pitchTauSec;         // Lift coefficient lag behind the elevator
+  float yawRateFullDegS;     // Yaw rate away from the right wall at full rudder
+  float yawTauSec;
+};
+
+// A light foam glider trimmed for ~2.5 m/s at L/D ~9: 1.8s down the
+// corridor, inside the README's 2-5s flights once launch is counted
+const GliderParams DEFAULT_GLIDER = {
+  0.040f, 0.15f, 0.40f,
+  0.68f, 0.50f,
+  0.030f, 0.080f,
+  0.15f,
+  45.0f, 0.20f
+};
+
+struct SimServoParams {
+  int neutralUs;
+  int fullUs;                // Full deflection (rudder away from the wall, elevator up)
+  float deadSec;
+  float slewUsPerSec;
+};
+
+struct SonarParams {
+  float beamHalfDeg;         // Nearest echo anywhere inside this cone
+  float maxIncidenceDeg;     // Steeper: the echo reflects away
+  float noiseCm;             // Gaussian sigma: noiseCm + noiseFrac * range
+  float noiseFrac;
+  float dropout;             // Per ping
+  float spike;               // Per ping
+  float minRangeCm;
+};
+
+const SonarParams DEFAULT_SONAR = { 15.0f, 40.0f, 0.3f, 0.005f, 0.03f, 0.01f, 2.0f };
+
+// Ranges the flights are drawn from, uniform
+struct LaunchSpread {
+  float speedMS[2];
+  float heightM[2];
+  float offsetM[2];          // Left of the centre line
+  float headingDeg[2];       // Towards the right wall
+  float gammaDeg[2];
+  float yawDriftDegS[2];     // Mis-trim, towards the right wall
+  float clTrimDelta[2];      // Mis-trim in pitch
+  float gustMS;              // Gust sigma, lateral and vertical
+  float gustTauSec;
+};
+
+// Launched 90-112cm off the right wall and trimmed to drift into it: the
+// rudder only turns away from that wall (as in test_tau_corridor_host.cpp)
+const LaunchSpread DEFAULT_SPREAD = {
+  { 2.2f, 2.8f }, { 0.99f, 1.15f }, { -0.32f, -0.10f }, { -4.0f, 8.0f },
+  { -4.0f, 2.0f }, { 0.0f, 12.0f }, { -0.08f, 0.08f }, 0.15f, 0.5f
+};
+
+// ---------------------------------------------------------
+// Servo: dead time, then the horn slews to the newest command
+// ---------------------------------------------------------
+class SimServo {
+  private:
+    static const int QUEUE = 8;
+    SimServoParams p;
+    float posUs;
+    int targetUs;
+    double queuedAt[QUEUE];
+    int queuedUs[QUEUE];
+    int head, count;
+
+  public:
+    SimServo() : posUs(0), targetUs(0), head(0), count(0) {}
+
+    void reset(const SimServoParams &params) {
+      p = params;
+      posUs = (float)p.neutralUs;
+      targetUs = p.neutralUs;
+      head = count = 0;
+    }
+
+    // Written at `atSec`; the horn starts after the dead time
+    void write(int us, double atSec) {
+      if (count == QUEUE) {          // Only the newest matters once they land
+        head = (head + 1) % QUEUE;
+        count--;
+      }
+      int i = (head + count) % QUEUE;
+      queuedAt[i] = atSec + p.deadSec;
+      queuedUs[i] = us;
+      count++;
+    }
+
+    void step(double tSec, float h) {
+      while (count && queuedAt[head] <= tSec) {
+        targetUs = queuedUs[head];
+        head = (head + 1) % QUEUE;
+        count--;
+      }
+      float move = p.slewUsPerSec * h;
+      if (targetUs > posUs) posUs = fminf(posUs + move, (float)targetUs);
+      else posUs = fmaxf(posUs - move, (float)targetUs);
+    }
+
+    float positionUs() const { return posUs; }
+    // 1 at full deflection, negative past neutral the other way
+    float deflection() const { return (posUs - p.neutralUs) / (float)(p.fullUs - p.neutralUs); }
+};
+
+// Range the sonar sees `perpM` from a flat surface whose normal is
+// `incidenceRad` off its axis; <= 0 for no echo. Noise-free.
+inline float sonarGeometryCm(const SonarParams &s, float perpM, float incidenceRad) {
+  float inc = fabsf(incidenceRad);
+  if (perpM <= 0 || inc > s.maxIncidenceDeg * SIM_DEG) return -1.0f;
+  float beam = s.beamHalfDeg * SIM_DEG;
+  float r = inc <= beam ? perpM : perpM / cosf(inc - beam);
+  return r * 100.0f;
+}
+
+// ---------------------------------------------------------
+// Glider in the corridor
+// ---------------------------------------------------------
+class GliderSim {
+  public:
+    enum Outcome { FLYING, CLEARED, HIT_RIGHT, HIT_LEFT, HIT_GROUND };
+
+    struct State {
+      float x, y, z;           // m
+      float speed;             // m/s
+      float gamma;             // Flight path angle, rad (up positive)
+      float heading;           // rad, towards the right wall positive
+      float yawRate;           // rad/s
+      float cl;
+      float gustY, gustZ;      // m/s
+    };
+
+  private:
+    GliderParams g;
+    SonarParams sonar;
+    SimRng rng;                // Launch and gusts
+    SimRng sonarRng;           // Noise, so pings don't change the gusts
+    State s;
+    double t;
+    float yawDrift;            // rad/s
+    float clTrim;
+    float vTrim;               // Level-flight speed at the nominal trim
+    float gustMS, gustTauSec;
+    Outcome outcome;
+    float minRight, minLeft, minGround;
+
+    static float halfWidth(float x) {
+      float k = fminf(fmaxf(x / CORRIDOR_LEN_M, 0.0f), 1.0f);
+      return 0.5f * (CORRIDOR_START_M + (CORRIDOR_END_M - CORRIDOR_START_M) * k);
+    }
+
+    // Both walls lean in by this much
+    static float wallAngle() {
+      return atanf(0.5f * (CORRIDOR_START_M - CORRIDOR_END_M) / CORRIDOR_LEN_M);
+    }
+
+    float reading(float cm) {
+      if (cm <= 0 || sonarRng.chance(sonar.dropout)) return -1.0f;
+      if (sonarRng.chance(sonar.spike)) {
+        return sonarRng.chance(0.5f) ? 2.0f * cm : sonarRng.uniform(sonar.minRangeCm, cm);
+      }
+      cm += sonarRng.gaussian() * (sonar.noiseCm + sonar.noiseFrac * cm);
+      return fmaxf(cm, sonar.minRangeCm);
+    }
+
+    void step(float h) {
+      rudder.step(t, h);
+      elevator.step(t, h);
+
+      // Longitudinal
+      float clCmd = clTrim + g.clElevator * elevator.deflection();
+      s.cl += (clCmd - s.cl) * h / g.pitchTauSec;
+      float q = 0.5f * SIM_RHO * s.speed * s.speed * g.wingAreaM2;
+      float lift = q * s.cl;
+      float drag = q * (g.cd0 + g.inducedK * s.cl * s.cl);
+      s.speed += (-drag / g.massKg - SIM_G * sinf(s.gamma)) * h;
+      if (s.speed < 0.5f) s.speed = 0.5f;
+      s.gamma += (lift - g.massKg * SIM_G * cosf(s.gamma)) / (g.massKg * s.speed) * h;
+
+      // Lateral: rudder authority scales with dynamic pressure
+      float yawCmd = -g.yawRateFullDegS * SIM_DEG * rudder.deflection() * (s.speed * s.speed) / (vTrim * vTrim)
+                     + yawDrift;
+      s.yawRate += (yawCmd - s.yawRate) * h / g.yawTauSec;
+      s.heading += s.yawRate * h;
+
+      // Gusts: first-order Gauss-Markov
+      float kick = gustMS * sqrtf(2.0f * h / gustTauSec);
+      s.gustY += -s.gustY * h / gustTauSec + kick * rng.gaussian();
+      s.gustZ += -s.gustZ * h / gustTauSec + kick * rng.gaussian();
+
+      float ground = s.speed * cosf(s.gamma);
+      s.x += ground * cosf(s.heading) * h;
+      s.y += (-ground * sinf(s.heading) + s.gustY) * h;
+      s.z += (s.speed * sinf(s.gamma) + s.gustZ) * h;
+      t += h;
+
+      float w = halfWidth(s.x);
+      float right = s.y + w - 0.5f * g.spanM;
+      float left = w - s.y - 0.5f * g.spanM;
+      if (right < minRight) minRight = right;
+      if (left < minLeft) minLeft = left;
+      if (s.z < minGround) minGround = s.z;
+      if (s.z <= 0) outcome = HIT_GROUND;
+      else if (right <= 0) outcome = HIT_RIGHT;
+      else if (left <= 0) outcome = HIT_LEFT;
+      else if (s.x >= CORRIDOR_LEN_M) outcome = CLEARED;
+    }
+
+  public:
+    SimServo rudder;
+    SimServo elevator;
+
+    // A flight drawn from `spread` by `seed`
+    GliderSim(const GliderParams &glider, const SonarParams &sonarParams,
+              const SimServoParams &rudderParams, const SimServoParams &elevatorParams,
+              const LaunchSpread &spread, uint32_t seed)
+      : g(glider), sonar(sonarParams), rng(seed), sonarRng(~seed), t(0), outcome(FLYING) {
+      rudder.reset(rudderParams);
+      elevator.reset(elevatorParams);
+      s.x = 0;
+      s.y = rng.uniform(spread.offsetM[0], spread.offsetM[1]);
+      s.z = rng.uniform(spread.heightM[0], spread.heightM[1]);
+      s.speed = rng.uniform(spread.speedMS[0], spread.speedMS[1]);
+      s.gamma = rng.uniform(spread.gammaDeg[0], spread.gammaDeg[1]) * SIM_DEG;
+      s.heading = rng.uniform(spread.headingDeg[0], spread.headingDeg[1]) * SIM_DEG;
+      s.yawRate = 0;
+      yawDrift = rng.uniform(spread.yawDriftDegS[0], spread.yawDriftDegS[1]) * SIM_DEG;
+      clTrim = g.clTrim + rng.uniform(spread.clTrimDelta[0], spread.clTrimDelta[1]);
+      s.cl = clTrim;
+      vTrim = sqrtf(2.0f * g.massKg * SIM_G / (SIM_RHO * g.wingAreaM2 * g.clTrim));
+      s.gustY = s.gustZ = 0;
+      gustMS = spread.gustMS;
+      gustTauSec = spread.gustTauSec;
+      minRight = minLeft = minGround = 1e9f;
+    }
+
+    // Integrates to `tSec` after release, or until the flight ends
+    void advanceTo(double tSec) {
+      while (outcome == FLYING && t + 0.5 * SIM_STEP_SEC < tSec) step(SIM_STEP_SEC);
+    }
+
+    // What each sonar reads now (cm, <= 0 for no echo)
+    float rightSonarCm() {
+      float wall = wallAngle();
+      float perp = (s.y + halfWidth(s.x)) * cosf(wall);
+      return reading(sonarGeometryCm(sonar, perp, s.heading + wall));
+    }
+    float heightSonarCm() { return reading(sonarGeometryCm(sonar, s.z, s.gamma)); }
+
+    double time() const { return t; }
+    const State &state() const { return s; }
+    Outcome result() const { return outcome; }
+    // Closest approach so far: wingtip to each wall, and height (m)
+    float minRightM() const { return minRight; }
+    float minLeftM() const { return minLeft; }
+    float minGroundM() const { return minGround; }
+};
+
+inline const char *simOutcomeName(GliderSim::Outcome o) {
+  switch (o) {
+    case GliderSim::CLEARED:    return "cleared";
+    case GliderSim::HIT_RIGHT:  return "right wall";
+    case GliderSim::HIT_LEFT:   return "left wall";
+    case GliderSim::HIT_GROUND: return "ground";
+    default:                    return "flying";
+  }
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef SIMD_LANES_H
+#define SIMD_LANES_H
+
+// =========================================================
+// Lane types for the batch simulator (BatchSim.h)
+// =========================================================
+// BatchSim's kernel is written once against a lane type L:
+//   L::F   float per lane        L::I   int32 per lane
+//   L::U   uint32 per lane (RNG)  L::M   per-lane mask
+// ScalarLanes is one glider (plain float/int/bool, the reference);
+// Avx2Lanes is eight in __m256 / __m256i registers. Every operation is the
+// same IEEE operation in both, so a lane computes bit for bit what the
+// scalar build computes for that glider:
+//   - no fused multiply-add: build with -ffp-contract=off and without -mfma
+//   - min/max as a < b ? a : b, which is what minps/maxps do
+//   - the blends main.cpp does in double ((1.0 - alpha) * prev) are done
+//     in double here too, four lanes at a time
+//   - integer division by a constant (divI) is a double division, then
+//     truncation: exact for |a| < 2^31 and divisors below 2^21, which is
+//     all the servo stages need (AVX2 has no integer divide)
+// Branches become masks: select(m, a, b) is a where m, else b.
+
+#include <math.h>
+#include <stdint.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+struct ScalarLanes {
+  static const int WIDTH = 1;
+  typedef float F;
+  typedef int32_t I;
+  typedef uint32_t U;
+  typedef bool M;
+
+  static F load(const float *p) { return *p; }
+  static I loadI(const int32_t *p) { return *p; }
+  static U loadU(const uint32_t *p) { return *p; }
+  static void store(float *p, F v) { *p = v; }
+  static void storeI(int32_t *p, I v) { *p = v; }
+  static void storeU(uint32_t *p, U v) { *p = v; }
+  static F splat(float v) { return v; }
+  static I splatI(int32_t v) { return v; }
+
+  static F select(M m, F a, F b) { return m ? a : b; }
+  static I selectI(M m, I a, I b) { return m ? a : b; }
+  static M none() { return false; }
+  static M all() { return true; }
+  static M notM(M m) { return !m; }
+  static bool any(M m) { return m; }
+
+  static F min(F a, F b) { return a < b ? a : b; }
+  static F max(F a, F b) { return a > b ? a : b; }
+  static F abs(F a) { return fabsf(a); }
+  static F round(F a) { return nearbyintf(a); }
+  static F toF(I i) { return (float)i; }
+  static I truncI(F a) { return (int32_t)a; }
+  static I absI(I i) { return i < 0 ? -i : i; }
+  static I divI(I a, int32_t d) { return a / d; }
+
+  // (float)(a + k * prev) with the sum in double: lowPass()
+  static F blendD(F a, double k, F prev) { return (float)((double)a + k * (double)prev); }
+  // (int)(a + k * prev) with the sum in double: smoothServo()
+  static I blendDI(F a, double k, I prev) { return (int32_t)((double)a + k * (double)prev); }
+
+  // xorshift32, as SimRng
+  static U next(U &s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+  }
+  static F uniform(U &s) { return (float)(int32_t)(next(s) >> 8) * (1.0f / 16777216.0f); }
+};
+
+#if defined(__AVX2__)
+struct Avx2Lanes {
+  static const int WIDTH = 8;
+
+  struct F {
+    __m256 v;
+    F() {}
+    F(__m256 x) : v(x) {}
+    F(float x) : v(_mm256_set1_ps(x)) {}
+  };
+  struct I {
+    __m256i v;
+    I() {}
+    I(__m256i x) : v(x) {}
+    I(int32_t x) : v(_mm256_set1_epi32(x)) {}
+  };
+  typedef I U;
+  struct M {
+    __m256 v;                // All ones / all zeros per lane
+    M() {}
+    M(__m256 x) : v(x) {}
+  };
+
+  static F load(const float *p) { return _mm256_loadu_ps(p); }
+  static I loadI(const int32_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+  static U loadU(const uint32_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+  static void store(float *p, F x) { _mm256_storeu_ps(p, x.v); }
+  static void storeI(int32_t *p, I x) { _mm256_storeu_si256((__m256i *)p, x.v); }
+  static void storeU(uint32_t *p, U x) { _mm256_storeu_si256((__m256i *)p, x.v); }
+  static F splat(float x) { return F(x); }
+  static I splatI(int32_t x) { return I(x); }
+
+  static F select(M m, F a, F b) { return _mm256_blendv_ps(b.v, a.v, m.v); }
+  static I selectI(M m, I a, I b) {
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b.v), _mm256_castsi256_ps(a.v), m.v));
+  }
+  static M none() { return _mm256_setzero_ps(); }
+  static M all() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+  static M notM(M m) { return _mm256_xor_ps(m.v, all().v); }
+  static bool any(M m) { return _mm256_movemask_ps(m.v) != 0; }
+
+  static F min(F a, F b) { return _mm256_min_ps(a.v, b.v); }
+  static F max(F a, F b) { return _mm256_max_ps(a.v, b.v); }
+  static F abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+  static F round(F a) { return _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+  static F toF(I i) { return _mm256_cvtepi32_ps(i.v); }
+  static I truncI(F a) { return _mm256_cvttps_epi32(a.v); }
+  static I absI(I i) { return _mm256_abs_epi32(i.v); }
+  static I divI(I a, int32_t d) {
+    __m256d dd = _mm256_set1_pd((double)d);
+    __m256d lo = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(a.v)), dd);
+    __m256d hi = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(a.v, 1)), dd);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)), _mm256_cvttpd_epi32(hi), 1);
+  }
+
+  static F blendD(F a, double k, F prev) {
+    __m256d kk = _mm256_set1_pd(k);
+    __m256d lo = _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a.v)),
+                               _mm256_mul_pd(kk, _mm256_cvtps_pd(_mm256_castps256_ps128(prev.v))));
+    __m256d hi = _mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a.v, 1)),
+                               _mm256_mul_pd(kk, _mm256_cvtps_pd(_mm256_extractf128_ps(prev.v, 1))));
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+  }
+  static I blendDI(F a, double k, I prev) {
+    __m256d kk = _mm256_set1_pd(k);
+    __m256d lo = _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a.v)),
+                               _mm256_mul_pd(kk, _mm256_cvtepi32_pd(_mm256_castsi256_si128(prev.v))));
+    __m256d hi = _mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a.v, 1)),
+                               _mm256_mul_pd(kk, _mm256_cvtepi32_pd(_mm256_extracti128_si256(prev.v, 1))));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)), _mm256_cvttpd_epi32(hi), 1);
+  }
+
+  static U next(U &s) {
+    s.v = _mm256_xor_si256(s.v, _mm256_slli_epi32(s.v, 13));
+    s.v = _mm256_xor_si256(s.v, _mm256_srli_epi32(s.v, 17));
+    s.v = _mm256_xor_si256(s.v, _mm256_slli_epi32(s.v, 5));
+    return s;
+  }
+  static F uniform(U &s) {
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(next(s).v, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+  }
+};
+
+inline Avx2Lanes::F operator+(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_add_ps(a.v, b.v); }
+inline Avx2Lanes::F operator-(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_sub_ps(a.v, b.v); }
+inline Avx2Lanes::F operator*(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_mul_ps(a.v, b.v); }
+inline Avx2Lanes::F operator/(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_div_ps(a.v, b.v); }
+inline Avx2Lanes::F operator-(Avx2Lanes::F a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+inline Avx2Lanes::F &operator+=(Avx2Lanes::F &a, Avx2Lanes::F b) { return a = a + b; }
+inline Avx2Lanes::F &operator-=(Avx2Lanes::F &a, Avx2Lanes::F b) { return a = a - b; }
+inline Avx2Lanes::M operator<(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline Avx2Lanes::M operator>(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline Avx2Lanes::M operator<=(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline Avx2Lanes::M operator>=(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline Avx2Lanes::M operator==(Avx2Lanes::F a, Avx2Lanes::F b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+
+inline Avx2Lanes::I operator+(Avx2Lanes::I a, Avx2Lanes::I b) { return _mm256_add_epi32(a.v, b.v); }
+inline Avx2Lanes::I operator-(Avx2Lanes::I a, Avx2Lanes::I b) { return _mm256_sub_epi32(a.v, b.v); }
+inline Avx2Lanes::I operator*(Avx2Lanes::I a, Avx2Lanes::I b) { return _mm256_mullo_epi32(a.v, b.v); }
+inline Avx2Lanes::M operator>(Avx2Lanes::I a, Avx2Lanes::I b) {
+  return _mm256_castsi256_ps(_mm256_cmpgt_epi32(a.v, b.v));
+}
+inline Avx2Lanes::M operator<(Avx2Lanes::I a, Avx2Lanes::I b) { return b > a; }
+inline Avx2Lanes::M operator==(Avx2Lanes::I a, Avx2Lanes::I b) {
+  return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v));
+}
+
+inline Avx2Lanes::M operator&(Avx2Lanes::M a, Avx2Lanes::M b) { return _mm256_and_ps(a.v, b.v); }
+inline Avx2Lanes::M operator|(Avx2Lanes::M a, Avx2Lanes::M b) { return _mm256_or_ps(a.v, b.v); }
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+// Batched Monte Carlo over the corridor (BatchSim.h): main.cpp's control
+// path flown by many gliders at once, scalar and AVX2, with the flights/s of each
+//   g++ -std=c++11 -O2 -mavx2 -ffp-contract=off -Iinclude tools/sim/batch_sim.cpp -o batch_sim
+//   ./batch_sim [-n flights] [-s first_seed] [-w]
+//     -n  flights, seeds first_seed, first_seed + 1, ... (default 100000)
+//     -w  widest lanes only (skip the scalar timing and the comparison)
+// Without -mavx2 both runs are scalar.
+#define PROFILE_STAGES 0
+#include "../../src/main.cpp"
+#include "BatchSim.h"
+#include <chrono>
+
+template <class L>
+static double run(const BatchSim &sim, uint32_t firstSeed, std::vector<SimResult> &out) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  sim.fly<L>(firstSeed, (int)out.size(), &out[0]);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+  int flights = 100000;
+  uint32_t firstSeed = 1;
+  bool wideOnly = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) flights = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc) firstSeed = (uint32_t)strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-w")) wideOnly = true;
+    else {
+      fprintf(stderr, "usage: %s [-n flights] [-s first_seed] [-w]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (flights < 1) flights = 1;
+
+  BatchSim sim(defaultSimConfig(), defaultBatchControl());
+  std::vector<SimResult> wide(flights), scalar;
+  double wideSec = run<BatchLanes>(sim, firstSeed, wide);
+
+  int outcomes[5] = { 0, 0, 0, 0, 0 };
+  double simSec = 0, minWallM = 0;
+  long writes = 0;
+  for (int f = 0; f < flights; f++) {
+    outcomes[wide[f].outcome]++;
+    simSec += wide[f].timeSec;
+    minWallM += fminf(wide[f].minRightM, wide[f].minLeftM);
+    writes += wide[f].servoWrites;
+  }
+  printf("%d flights: cleared %5.1f%% | right wall %5.1f%% | left wall %5.1f%% | ground %5.1f%% | "
+         "flying %4.1f%% | mean closest wall %5.1fcm, %.1f writes\n", flights,
+         100.0 * outcomes[GliderSim::CLEARED] / flights, 100.0 * outcomes[GliderSim::HIT_RIGHT] / flights,
+         100.0 * outcomes[GliderSim::HIT_LEFT] / flights, 100.0 * outcomes[GliderSim::HIT_GROUND] / flights,
+         100.0 * outcomes[GliderSim::FLYING] / flights, 100.0 * minWallM / flights, (double)writes / flights);
+  printf("%d-lane: %.3fs, %.0f flights/s, %.0fx real time\n", BatchLanes::WIDTH, wideSec,
+         flights / wideSec, simSec / wideSec);
+  if (wideOnly) return 0;
+
+  scalar.resize(flights);
+  double scalarSec = run<ScalarLanes>(sim, firstSeed, scalar);
+  int differ = 0;
+  for (int f = 0; f < flights; f++) {
+    differ += memcmp(&scalar[f].timeSec, &wide[f].timeSec, sizeof(float)) || scalar[f].outcome != wide[f].outcome ||
+              memcmp(&scalar[f].distanceM, &wide[f].distanceM, sizeof(float));
+  }
+  printf("scalar: %.3fs, %.0f flights/s\n", scalarSec, flights / scalarSec);
+  printf("speedup %.1fx, %d flights differ from scalar\n", scalarSec / wideSec, differ);
+  return differ == 0 ? 0 : 1;
+}
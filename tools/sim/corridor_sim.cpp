@@ -0,0 +1,123 @@
+// Flies src/main.cpp, unmodified, through the simulated corridor
+// (GliderSim.h, CorridorSim.h) and reports how the flights end
+//   g++ -std=c++11 -O2 -Iinclude tools/sim/corridor_sim.cpp -o corridor_sim
+//   ./corridor_sim [-n flights] [-s first_seed] [-u] [-t seed] [-q] [-r]
+//     -n  flights, seeds first_seed, first_seed + 1, ... (default 1000)
+//     -u  also fly each with the surfaces held at neutral (baseline)
+//     -t  trace that one flight as CSV instead (every 5ms)
+//     -q  summary only
+//     -r  one CSV row per flight instead of the summary (tools/tune reads these)
+// Tunables are main.cpp's: change one (or -DTUNED_<name>=value), rebuild, compare.
+#define PROFILE_STAGES 0
+#include "../../src/main.cpp"
+#include "CorridorSim.h"
+#include <chrono>
+
+struct Tally {
+  int flights;
+  int outcomes[5];
+  double minWallM;           // Mean closest wingtip-to-wall over the flights
+  double minGroundM;
+  double simSec;
+};
+
+static void add(Tally &t, const SimResult &r) {
+  t.flights++;
+  t.outcomes[r.outcome]++;
+  t.minWallM += fminf(r.minRightM, r.minLeftM);
+  t.minGroundM += r.minGroundM;
+  t.simSec += r.timeSec;
+}
+
+static void printTally(const char *label, const Tally &t) {
+  printf("%-12s %6d flights: cleared %5.1f%% | right wall %5.1f%% | left wall %5.1f%% | ground %5.1f%% | "
+         "flying %4.1f%% | mean closest wall %5.1fcm, ground %5.1fcm\n",
+         label, t.flights,
+         100.0 * t.outcomes[GliderSim::CLEARED] / t.flights,
+         100.0 * t.outcomes[GliderSim::HIT_RIGHT] / t.flights,
+         100.0 * t.outcomes[GliderSim::HIT_LEFT] / t.flights,
+         100.0 * t.outcomes[GliderSim::HIT_GROUND] / t.flights,
+         100.0 * t.outcomes[GliderSim::FLYING] / t.flights,
+         100.0 * t.minWallM / t.flights, 100.0 * t.minGroundM / t.flights);
+}
+
+static void traceRow(void *, const GliderSim &sim) {
+  const GliderSim::State &s = sim.state();
+  printf("%.3f,%.1f,%.1f,%.1f,%.2f,%.1f,%.1f,%.0f,%.0f\n", sim.time(), s.x * 100, s.y * 100, s.z * 100,
+         s.speed, s.gamma / SIM_DEG, s.heading / SIM_DEG, sim.rudder.positionUs(), sim.elevator.positionUs());
+}
+
+// A flight whose child died is a crash of the sketch, not an outcome
+static void flyOrExit(CorridorSimEngine &engine, const SimConfig &cfg, uint32_t seed, SimResult &r,
+                      SimTraceFn trace = NULL) {
+  if (!engine.fly(cfg, seed, r, trace, NULL)) {
+    fprintf(stderr, "seed %u: flight process failed\n", seed);
+    exit(1);
+  }
+}
+
+int main(int argc, char **argv) {
+  int flights = 1000, traceSeed = -1;
+  uint32_t firstSeed = 1;
+  bool uncontrolled = false, quiet = false, rows = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) flights = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc) firstSeed = (uint32_t)strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc) traceSeed = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-u")) uncontrolled = true;
+    else if (!strcmp(argv[i], "-q")) quiet = true;
+    else if (!strcmp(argv[i], "-r")) rows = true;
+    else {
+      fprintf(stderr, "usage: %s [-n flights] [-s first_seed] [-u] [-t seed] [-q] [-r]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  SimConfig cfg = defaultSimConfig();
+  CorridorSimEngine engine;
+  SimResult r;
+
+  if (traceSeed >= 0) {
+    printf("t_s,x_cm,y_cm,z_cm,speed_m_s,gamma_deg,heading_deg,rudder_us,elevator_us\n");
+    flyOrExit(engine, cfg, (uint32_t)traceSeed, r, traceRow);
+    fprintf(stderr, "seed %d: %s after %.2fs at %.0fcm\n", traceSeed, simOutcomeName(r.outcome),
+            r.timeSec, r.distanceM * 100);
+    return 0;
+  }
+
+  if (rows) {
+    printf("seed,outcome,time_s,distance_cm,min_right_cm,min_left_cm,min_ground_cm\n");
+    for (int f = 0; f < flights; f++) {
+      flyOrExit(engine, cfg, firstSeed + f, r);
+      printf("%u,%s,%.3f,%.1f,%.1f,%.1f,%.1f\n", firstSeed + f, simOutcomeName(r.outcome), r.timeSec,
+             r.distanceM * 100, r.minRightM * 100, r.minLeftM * 100, r.minGroundM * 100);
+    }
+    return 0;
+  }
+
+  Tally closed = Tally(), open = Tally();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int f = 0; f < flights; f++) {
+    flyOrExit(engine, cfg, firstSeed + f, r);
+    add(closed, r);
+    if (!quiet && f < 20) {
+      printf("seed %u: %-10s %.2fs %5.0fcm  closest right %5.1fcm left %5.1fcm ground %5.1fcm  %d writes\n",
+             firstSeed + f, simOutcomeName(r.outcome), r.timeSec, r.distanceM * 100,
+             r.minRightM * 100, r.minLeftM * 100, r.minGroundM * 100, r.servoWrites);
+    }
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (uncontrolled) {
+    for (int f = 0; f < flights; f++) {
+      CorridorSimEngine::flyUncontrolled(cfg, firstSeed + f, r);
+      add(open, r);
+    }
+  }
+
+  printTally("main.cpp", closed);
+  if (uncontrolled) printTally("uncontrolled", open);
+  printf("%d flights in %.3fs: %.0f flights/s, %.0fx real time\n",
+         flights, sec, flights / sec, closed.simSec / sec);
+  return 0;
+}
@@ -0,0 +1,82 @@
+// Converts a binary telemetry capture to CSV: fixed frames
+// (include/Telemetry.h) or delta frames (include/TelemetryDelta.h), told
+// apart by their sync bytes
+//   g++ -std=c++11 -O2 -Iinclude tools/telemetry_decode.cpp -o telemetry_decode
+//   stty -F /dev/ttyACM0 raw 115200 && cat /dev/ttyACM0 > flight.bin &
+//   printf l > /dev/ttyACM0                           (streaming is off at power-on)
+//   ./telemetry_decode flight.bin > flight.csv        (or from stdin)
+// Text on the port between frames is skipped. Frames lost on the board
+// (ring full) or on the wire show up as sequence gaps; delta frames after a
+// gap can't be rebuilt until the next keyframe. All are counted on stderr,
+// with the decode throughput.
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "Telemetry.h"
+#include "TelemetryDelta.h"
+
+void printSample(uint8_t seq, const TelemetrySample &s) {
+  printf("%u,%.3f,%.1f,%.1f,%.1f,%.1f,%u,%u,%u,%u,%u,%u,%d,%d,%d,%d,%d,%d,%d\n",
+         seq, s.timeMs / 1000.0, s.rightMm / 10.0, s.heightMm / 10.0,
+         s.rateRightMmS / 10.0, s.rateHeightMmS / 10.0, s.rudderUs, s.elevatorUs,
+         s.rightEchoUs, s.rightEchoAtUs, s.heightEchoUs, s.heightEchoAtUs,
+         (s.flags & TELEM_FLIGHT) != 0, (s.flags & TELEM_RIGHT_VALID) != 0,
+         (s.flags & TELEM_HEIGHT_VALID) != 0, (s.flags & TELEM_RUDDER_WRITE) != 0,
+         (s.flags & TELEM_ELEVATOR_WRITE) != 0, (s.flags & TELEM_DROPPED) != 0,
+         (s.flags & TELEM_SENSOR_TEST) != 0);
+}
+
+int main(int argc, char **argv) {
+  FILE *in = stdin;
+  if (argc > 1) {
+    in = fopen(argv[1], "rb");
+    if (!in) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+  std::vector<uint8_t> bytes;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) bytes.insert(bytes.end(), chunk, chunk + n);
+  if (in != stdin) fclose(in);
+
+  printf("seq,time_s,right_cm,height_cm,rate_right_cm_s,rate_height_cm_s,rudder_us,elevator_us,"
+         "right_echo_us,right_echo_at_us,height_echo_us,height_echo_at_us,"
+         "flight,right_valid,height_valid,rudder_write,elevator_write,dropped,sensor_test\n");
+
+  TelemetryParser fixed;
+  DeltaParser delta;
+  TelemetrySample s;
+  uint8_t seq;
+  uint32_t frames[2] = { 0, 0 };
+  uint32_t missing = 0;
+  int expected = -1;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < bytes.size(); i++) {
+    for (int kind = 0; kind < 2; kind++) {
+      bool got = kind == 0 ? fixed.feed(bytes[i], s, seq) : delta.feed(bytes[i], s, seq);
+      if (!got) continue;
+      if (expected >= 0) missing += (uint8_t)(seq - expected);
+      expected = (uint8_t)(seq + 1);
+      frames[kind]++;
+      printSample(seq, s);
+    }
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bool isDelta = frames[1] > frames[0];
+  uint32_t total = frames[0] + frames[1];
+  fprintf(stderr, "%u frames (%s), %u missing (sequence gaps), %u bytes of other output skipped\n",
+          (unsigned)total, isDelta ? "delta" : "fixed", (unsigned)missing,
+          (unsigned)(isDelta ? delta.bytesSkipped() : fixed.bytesSkipped()));
+  if (isDelta) {
+    fprintf(stderr, "%u delta frames after a gap dropped until the next keyframe\n",
+            (unsigned)delta.framesUnusable());
+  }
+  if (total > 0) {
+    fprintf(stderr, "%.1f bytes/frame; decoded in %.1f ms, %.1f MB/s, %.2f M frames/s (CSV output included)\n",
+            (double)bytes.size() / total, sec * 1000, bytes.size() / sec / 1e6, total / sec / 1e6);
+  }
+  return 0;
+}
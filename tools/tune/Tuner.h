@@ -0,0 +1,202 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+// =========================================================
+// Control-constant search space and scoring (tools/tune)
+// =========================================================
+// A configuration is one value per TUNE_PARAMS entry. Each entry is a
+// constant of src/main.cpp with a TUNED_ override macro, so a
+// configuration builds as tools/sim/corridor_sim.cpp with one -D per
+// entry. Entries that only act under one rate estimator are pinned to
+// their hand-set value under the other, so configurations that fly the
+// same code share one key (and one build).
+//
+// A configuration is scored over a fixed set of seeded flights: the share
+// that clear the corridor without touching anything, plus the margin they
+// kept (closest wingtip to a wall, or height), capped so that only near
+// misses count:
+//   score = 100 * cleared / flights + TUNE_MARGIN_WEIGHT * mean margin (cm)
+// A collision scores no margin. At the weight of 0.2 a 1% gain in
+// completion is worth 5cm more margin on every flight.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+const int TUNE_ANY_ESTIMATOR = -1;
+const int TUNE_MAX_VALUES    = 8;
+const double TUNE_MARGIN_CAP_CM = 25.0;
+const double TUNE_MARGIN_WEIGHT = 0.2;
+
+struct TuneParam {
+  const char *name;          // The constant in src/main.cpp
+  const char *macro;         // Its override
+  double hand;               // main.cpp's default
+  int count;
+  double values[TUNE_MAX_VALUES];
+  int onlyWithEstimator;     // RATE_ESTIMATOR value it acts under, or TUNE_ANY_ESTIMATOR
+  bool integer;
+};
+
+// README "Tunable Parameters". The README's fixed servo deadband is now the
+// budget's SERVO_STEP_MAX_US. The smoothing alpha is not swept: with the
+// servo lead on, how much of the smoothing reaches the servo is set by
+// SERVO_FF_GAIN, so that is swept in its place.
+// DIST_FILTER_ALPHA and RATE_AVG_WINDOW_SIZE only feed the difference
+// estimator; the tracker's gains stand in for them under the tracker.
+const int TUNE_ESTIMATOR = 7;   // RATE_ESTIMATOR's index below
+const TuneParam TUNE_PARAMS[] = {
+  { "PARAM_RATE_RIGHT_THRESHOLD",  "TUNED_RATE_RIGHT_THRESHOLD",  50, 6, { 30, 40, 50, 65, 80, 100 }, TUNE_ANY_ESTIMATOR, false },
+  { "PARAM_RATE_HEIGHT_THRESHOLD", "TUNED_RATE_HEIGHT_THRESHOLD", 50, 6, { 30, 40, 50, 65, 80, 100 }, TUNE_ANY_ESTIMATOR, false },
+  { "SERVO_HOLD_TIME_MS",          "TUNED_SERVO_HOLD_TIME_MS",   500, 7, { 50, 100, 200, 300, 400, 500, 700 }, TUNE_ANY_ESTIMATOR, true },
+  { "SERVO_FF_GAIN",               "TUNED_SERVO_FF_GAIN",       0.5, 5, { 0, 0.25, 0.5, 0.75, 1 }, TUNE_ANY_ESTIMATOR, false },
+  { "SERVO_STEP_MAX_US",           "TUNED_SERVO_STEP_MAX_US",    300, 5, { 50, 100, 200, 300, 400 }, TUNE_ANY_ESTIMATOR, true },
+  { "DIST_FILTER_ALPHA",           "TUNED_DIST_FILTER_ALPHA",   0.70, 4, { 0.4, 0.55, 0.7, 0.85 }, 0, false },
+  { "RATE_AVG_WINDOW_SIZE",        "TUNED_RATE_AVG_WINDOW_SIZE",   3, 5, { 1, 2, 3, 4, 6 }, 0, true },
+  { "RATE_ESTIMATOR",              "TUNED_RATE_ESTIMATOR",         1, 2, { 0, 1 }, TUNE_ANY_ESTIMATOR, true },
+  { "TRACKER_ALPHA",               "TUNED_TRACKER_ALPHA",       0.70, 4, { 0.5, 0.6, 0.7, 0.85 }, 1, false },
+  { "TRACKER_BETA",                "TUNED_TRACKER_BETA",        0.35, 4, { 0.2, 0.35, 0.5, 0.65 }, 1, false },
+};
+const int TUNE_PARAM_COUNT = sizeof(TUNE_PARAMS) / sizeof(TUNE_PARAMS[0]);
+
+struct TuneConfig {
+  double v[TUNE_PARAM_COUNT];
+};
+
+inline bool tuneActive(const TuneConfig &c, int p) {
+  int only = TUNE_PARAMS[p].onlyWithEstimator;
+  return only == TUNE_ANY_ESTIMATOR || (int)c.v[TUNE_ESTIMATOR] == only;
+}
+
+// Inactive entries back at their hand-set value
+inline TuneConfig tuneNormalize(TuneConfig c) {
+  for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+    if (!tuneActive(c, p)) c.v[p] = TUNE_PARAMS[p].hand;
+  }
+  return c;
+}
+
+inline TuneConfig tuneHandConfig() {
+  TuneConfig c;
+  for (int p = 0; p < TUNE_PARAM_COUNT; p++) c.v[p] = TUNE_PARAMS[p].hand;
+  return c;
+}
+
+inline std::string tuneValue(int p, double v) {
+  char buf[32];
+  if (TUNE_PARAMS[p].integer) snprintf(buf, sizeof(buf), "%d", (int)lround(v));
+  else snprintf(buf, sizeof(buf), "%.4g", v);
+  // Floating-point literal for the real_t constants (50, not the int 50)
+  if (!TUNE_PARAMS[p].integer && !strpbrk(buf, ".e")) strcat(buf, ".0");
+  return buf;
+}
+
+// One -D per active entry, e.g. "-DTUNED_SERVO_HOLD_TIME_MS=400"
+inline std::vector<std::string> tuneDefines(const TuneConfig &c) {
+  std::vector<std::string> out;
+  for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+    if (!tuneActive(c, p)) continue;
+    out.push_back(std::string("-D") + TUNE_PARAMS[p].macro + "=" + tuneValue(p, c.v[p]));
+  }
+  return out;
+}
+
+inline std::string tuneKey(const TuneConfig &c) {
+  std::string key;
+  for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+    if (p) key += ",";
+    key += tuneActive(c, p) ? tuneValue(p, c.v[p]) : "-";
+  }
+  return key;
+}
+
+// Every configuration one entry away from c, each entry through all of its
+// values; entries that do not act on c are left alone
+inline std::vector<TuneConfig> tuneNeighbours(const TuneConfig &c) {
+  std::vector<TuneConfig> out;
+  for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+    if (!tuneActive(c, p)) continue;
+    for (int i = 0; i < TUNE_PARAMS[p].count; i++) {
+      if (TUNE_PARAMS[p].values[i] == c.v[p]) continue;
+      TuneConfig n = c;
+      n.v[p] = TUNE_PARAMS[p].values[i];
+      out.push_back(tuneNormalize(n));
+    }
+  }
+  return out;
+}
+
+// ---------------------------------------------------------
+// Scoring
+// ---------------------------------------------------------
+struct TuneFlight {
+  unsigned seed;
+  bool cleared;
+  double minRightCm, minLeftCm, minGroundCm;
+};
+
+struct TuneScore {
+  int flights;
+  int cleared;
+  double marginCm;           // Sum over the flights (0 for a collision)
+};
+
+// One row of corridor_sim -r; false for the header or a malformed line
+inline bool parseTuneFlight(const char *line, TuneFlight &f) {
+  char outcome[32];
+  double timeSec, distanceCm;
+  if (sscanf(line, "%u,%31[^,],%lf,%lf,%lf,%lf,%lf", &f.seed, outcome, &timeSec, &distanceCm,
+             &f.minRightCm, &f.minLeftCm, &f.minGroundCm) != 7) return false;
+  f.cleared = !strcmp(outcome, "cleared");
+  return true;
+}
+
+inline double tuneMarginCm(const TuneFlight &f) {
+  if (!f.cleared) return 0;
+  double m = fmin(f.minGroundCm, fmin(f.minRightCm, f.minLeftCm));
+  return fmax(0.0, fmin(m, TUNE_MARGIN_CAP_CM));
+}
+
+inline void tuneAdd(TuneScore &s, const TuneFlight &f) {
+  s.flights++;
+  if (f.cleared) s.cleared++;
+  s.marginCm += tuneMarginCm(f);
+}
+
+inline void tuneMerge(TuneScore &into, const TuneScore &from) {
+  into.flights += from.flights;
+  into.cleared += from.cleared;
+  into.marginCm += from.marginCm;
+}
+
+inline double tuneScore(const TuneScore &s) {
+  if (s.flights == 0) return -1;
+  return 100.0 * s.cleared / s.flights + TUNE_MARGIN_WEIGHT * s.marginCm / s.flights;
+}
+
+// ---------------------------------------------------------
+// Generated header (built into main.cpp with -DTUNED_PARAMS)
+// ---------------------------------------------------------
+inline void writeTunedHeader(FILE *out, const TuneConfig &best, const TuneScore &bestScore,
+                             const TuneScore &handScore, const char *provenance) {
+  fprintf(out, "// Generated by tools/tune; do not edit. src/main.cpp uses these when built\n");
+  fprintf(out, "// with -DTUNED_PARAMS.\n");
+  fprintf(out, "// %s\n", provenance);
+  fprintf(out, "// Score %.2f: %.1f%% cleared, mean margin %.1fcm\n", tuneScore(bestScore),
+          100.0 * bestScore.cleared / bestScore.flights, bestScore.marginCm / bestScore.flights);
+  fprintf(out, "// Hand-set %.2f: %.1f%% cleared, mean margin %.1fcm\n", tuneScore(handScore),
+          100.0 * handScore.cleared / handScore.flights, handScore.marginCm / handScore.flights);
+  fprintf(out, "#ifndef TUNED_PARAMS_H\n#define TUNED_PARAMS_H\n\n");
+  for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+    if (!tuneActive(best, p)) continue;
+    std::string v = tuneValue(p, best.v[p]);
+    fprintf(out, "#define %-32s %-8s // %s, hand-set %s\n", TUNE_PARAMS[p].macro, v.c_str(),
+            TUNE_PARAMS[p].name, tuneValue(p, TUNE_PARAMS[p].hand).c_str());
+  }
+  fprintf(out, "\n#endif\n");
+}
+
+#endif
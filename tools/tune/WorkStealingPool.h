@@ -0,0 +1,166 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+// =========================================================
+// Work-stealing thread pool (tools/tune)
+// =========================================================
+// Each worker thread owns a deque. It runs its own newest task first
+// (LIFO: a task's follow-on work stays on the thread that made it), and
+// when its deque is empty it steals the oldest task from another worker
+// (FIFO: the biggest, least recently split work moves). A task gets the
+// index of the worker running it and can submit more tasks there.
+//
+//   WorkStealingPool pool(4);
+//   pool.submit([&](int w) { ... pool.submit(followOn, w); ... });
+//   pool.wait();              // every task, follow-ons included, has run
+//
+// The deques are mutex-guarded: the tasks here are compiles and whole
+// batches of flights, milliseconds to seconds each, so a lock per pop is
+// noise and a lock-free deque would buy nothing.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+struct PoolWorkerStats {
+  long executed;             // Tasks run on this worker
+  long stolen;               // ...of which taken from another worker's deque
+  double busySec;            // Time spent inside tasks
+};
+
+class WorkStealingPool {
+  public:
+    typedef std::function<void(int worker)> Task;
+
+  private:
+    struct Worker {
+      std::mutex lock;
+      std::deque<Task> tasks;
+      PoolWorkerStats stats;
+      uint32_t rng;          // Victim choice
+    };
+
+    std::vector<Worker *> workers;
+    std::vector<std::thread> threads;
+    std::mutex idleLock;
+    std::condition_variable wake;      // Work queued, or stopping
+    std::condition_variable drained;   // pending reached 0
+    std::atomic<long> queued;          // In deques, not yet taken
+    std::atomic<long> pending;         // Submitted, not yet finished
+    std::atomic<int> nextWorker;       // Round robin for outside submits
+    bool stopping;
+
+    bool popOwn(int w, Task &out) {
+      Worker &me = *workers[w];
+      std::lock_guard<std::mutex> g(me.lock);
+      if (me.tasks.empty()) return false;
+      out = std::move(me.tasks.back());
+      me.tasks.pop_back();
+      queued--;
+      return true;
+    }
+
+    bool steal(int w, Task &out) {
+      int n = (int)workers.size();
+      Worker &me = *workers[w];
+      me.rng ^= me.rng << 13;
+      me.rng ^= me.rng >> 17;
+      me.rng ^= me.rng << 5;
+      int start = (int)(me.rng % (uint32_t)n);
+      for (int i = 0; i < n; i++) {
+        int v = (start + i) % n;
+        if (v == w) continue;
+        Worker &victim = *workers[v];
+        std::lock_guard<std::mutex> g(victim.lock);
+        if (victim.tasks.empty()) continue;
+        out = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        queued--;
+        return true;
+      }
+      return false;
+    }
+
+    void run(int w) {
+      Worker &me = *workers[w];
+      for (;;) {
+        Task task;
+        bool stolen = false;
+        if (!popOwn(w, task)) {
+          stolen = steal(w, task);
+          if (!stolen) {
+            std::unique_lock<std::mutex> g(idleLock);
+            if (stopping) return;
+            if (queued.load() == 0) wake.wait(g);
+            continue;
+          }
+        }
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        task(w);
+        me.stats.busySec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        me.stats.executed++;
+        if (stolen) me.stats.stolen++;
+        if (--pending == 0) {
+          std::lock_guard<std::mutex> g(idleLock);
+          drained.notify_all();
+        }
+      }
+    }
+
+  public:
+    explicit WorkStealingPool(int n) : queued(0), pending(0), nextWorker(0), stopping(false) {
+      if (n < 1) n = 1;
+      for (int i = 0; i < n; i++) {
+        Worker *w = new Worker;
+        w->stats = PoolWorkerStats();
+        w->rng = 0x9E3779B9u * (uint32_t)(i + 1);
+        workers.push_back(w);
+      }
+      for (int i = 0; i < n; i++) threads.push_back(std::thread(&WorkStealingPool::run, this, i));
+    }
+
+    ~WorkStealingPool() {
+      {
+        std::lock_guard<std::mutex> g(idleLock);
+        stopping = true;
+        wake.notify_all();
+      }
+      for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+      for (size_t i = 0; i < workers.size(); i++) delete workers[i];
+    }
+
+    int size() const { return (int)workers.size(); }
+
+    // onto worker w's deque (from inside a task: its own w), or round robin
+    void submit(Task task, int w = -1) {
+      if (w < 0 || w >= size()) w = nextWorker++ % size();
+      pending++;
+      {
+        std::lock_guard<std::mutex> g(workers[w]->lock);
+        workers[w]->tasks.push_back(std::move(task));
+        queued++;
+      }
+      std::lock_guard<std::mutex> g(idleLock);
+      wake.notify_all();
+    }
+
+    void wait() {
+      std::unique_lock<std::mutex> g(idleLock);
+      while (pending.load() != 0) drained.wait(g);
+    }
+
+    // Read once wait() has returned
+    const PoolWorkerStats &workerStats(int w) const { return workers[w]->stats; }
+
+    void resetStats() {
+      for (int i = 0; i < size(); i++) workers[i]->stats = PoolWorkerStats();
+    }
+};
+
+#endif
@@ -0,0 +1,412 @@
+// Autotunes main.cpp's control constants (Tuner.h) against the corridor
+// simulator (tools/sim) and writes the best set as a header
+//   g++ -std=c++11 -O2 -pthread -Iinclude tools/tune/tune.cpp -o tune    # or build/tune
+//   ./tune [-j threads] [-n flights] [-b batch] [-s first_seed] [-r rounds]
+//          [-o header] [-S configs] [-d source_dir] [-C compiler] [-O level] [-k]
+//     -j  worker threads (default: every core)
+//     -n  flights per configuration, seeds first_seed... (default 200)
+//     -b  flights per evaluation task (default 50)
+//     -r  search rounds at most (default 6)
+//     -o  generated header (default <source_dir>/include/TunedParams.h)
+//     -S  only time the first N configurations at 1, 2, 4 ... -j threads,
+//         with the time spent compiling and flying apart
+//     -d  repository root (default: the one this was built from)
+//     -C  compiler for the simulator builds (default $CXX, else c++)
+//     -O  their optimisation flag (default -O1: build time dominates)
+//     -k  keep the builds and per-batch outputs
+//
+// Search: from the hand-set values, every configuration one constant away
+// is built and flown; the best becomes the next centre, until a round
+// improves nothing. A configuration is one build of corridor_sim.cpp with
+// its TUNED_ -Ds, then n / b evaluation tasks on the same seeds.
+//
+// main.cpp's state is a set of globals, one copy per process, so threads
+// can't fly it side by side. The pool's tasks are therefore compiles and
+// batches of flights in child processes; the work-stealing threads keep
+// every core busy with them. A compile queues its batches on its own
+// worker, so idle workers steal batches while the slow compiles go on.
+// Each round reports the two phases apart: the compiles are the price of
+// making every constant a compile-time one, the flights are the search.
+#include "Tuner.h"
+#include "WorkStealingPool.h"
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <map>
+
+extern char **environ;
+
+#ifndef TUNE_SOURCE_DIR
+#define TUNE_SOURCE_DIR "."
+#endif
+
+struct TuneOptions {
+  int threads;
+  int flights;
+  int batch;
+  unsigned firstSeed;
+  int rounds;
+  int scalingConfigs;        // -S, 0 = tune
+  std::string sourceDir;
+  std::string header;
+  std::string compiler;
+  std::string opt;
+  bool keep;
+};
+
+struct Candidate {
+  TuneConfig cfg;
+  std::string key;
+  std::string binary;
+  bool failed;
+  TuneScore score;
+  std::mutex lock;
+};
+
+// Runs argv with stdout and stderr into outPath; the exit status, or -1
+static int runCommand(const std::vector<std::string> &args, const std::string &outPath) {
+  std::vector<char *> argv;
+  for (size_t i = 0; i < args.size(); i++) argv.push_back(const_cast<char *>(args[i].c_str()));
+  argv.push_back(NULL);
+
+  posix_spawn_file_actions_t files;
+  posix_spawn_file_actions_init(&files);
+  posix_spawn_file_actions_addopen(&files, 1, outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&files, 1, 2);
+  pid_t pid;
+  int err = posix_spawnp(&pid, argv[0], &files, NULL, &argv[0], environ);
+  posix_spawn_file_actions_destroy(&files);
+  if (err != 0) return -1;
+
+  int status;
+  if (waitpid(pid, &status, 0) != pid) return -1;
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static std::mutex printLock;
+
+// Busy time of each phase, summed over the workers
+struct TunePhases {
+  int builds;
+  double buildSec;
+  long flights;
+  double flySec;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+class Evaluator {
+  private:
+    const TuneOptions &opts;
+    std::string workDir;
+    int builds;
+    TunePhases phases;
+    std::mutex phaseLock;
+
+    void build(WorkStealingPool &pool, Candidate *c, int w) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      std::vector<std::string> args;
+      args.push_back(opts.compiler);
+      args.push_back("-std=c++11");
+      args.push_back(opts.opt);
+      args.push_back("-I" + opts.sourceDir + "/include");
+      std::vector<std::string> defines = tuneDefines(c->cfg);
+      args.insert(args.end(), defines.begin(), defines.end());
+      args.push_back(opts.sourceDir + "/tools/sim/corridor_sim.cpp");
+      args.push_back("-o");
+      args.push_back(c->binary);
+      std::string log = c->binary + ".log";
+      int status = runCommand(args, log);
+      {
+        std::lock_guard<std::mutex> g(phaseLock);
+        phases.builds++;
+        phases.buildSec += secondsSince(start);
+      }
+      if (status != 0) {
+        c->failed = true;
+        std::lock_guard<std::mutex> g(printLock);
+        fprintf(stderr, "build failed for %s (see %s)\n", c->key.c_str(), log.c_str());
+        return;
+      }
+      // Batches onto this worker's deque: it runs the newest, idle workers
+      // steal the rest
+      for (int first = 0; first < opts.flights; first += opts.batch) {
+        int n = opts.flights - first < opts.batch ? opts.flights - first : opts.batch;
+        pool.submit([this, c, first, n](int) { fly(c, first, n); }, w);
+      }
+    }
+
+    void fly(Candidate *c, int first, int n) {
+      char seed[16], count[16], out[32];
+      snprintf(seed, sizeof(seed), "%u", opts.firstSeed + first);
+      snprintf(count, sizeof(count), "%d", n);
+      snprintf(out, sizeof(out), ".%d.csv", first);
+      std::vector<std::string> args;
+      args.push_back(c->binary);
+      args.push_back("-n");
+      args.push_back(count);
+      args.push_back("-s");
+      args.push_back(seed);
+      args.push_back("-r");
+      std::string path = c->binary + out;
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      int status = runCommand(args, path);
+      {
+        std::lock_guard<std::mutex> g(phaseLock);
+        phases.flights += n;
+        phases.flySec += secondsSince(start);
+      }
+      TuneScore s = TuneScore();
+      if (status == 0) {
+        FILE *f = fopen(path.c_str(), "r");
+        char line[256];
+        TuneFlight flight;
+        while (f && fgets(line, sizeof(line), f)) {
+          if (parseTuneFlight(line, flight)) tuneAdd(s, flight);
+        }
+        if (f) fclose(f);
+      }
+      std::lock_guard<std::mutex> g(c->lock);
+      if (s.flights != n) c->failed = true;
+      tuneMerge(c->score, s);
+    }
+
+  public:
+    Evaluator(const TuneOptions &o, const std::string &dir) : opts(o), workDir(dir), builds(0), phases() {}
+
+    // Builds and flies every candidate; returns the wall time. The phase
+    // totals cover this call only.
+    double run(WorkStealingPool &pool, const std::vector<Candidate *> &cands) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      phases = TunePhases();
+      for (size_t i = 0; i < cands.size(); i++) {
+        Candidate *c = cands[i];
+        char name[32];
+        snprintf(name, sizeof(name), "/sim%d", builds++);
+        c->binary = workDir + name;
+        pool.submit([this, &pool, c](int w) { build(pool, c, w); });
+      }
+      pool.wait();
+      return secondsSince(start);
+    }
+
+    const TunePhases &lastPhases() const { return phases; }
+};
+
+static Candidate *newCandidate(const TuneConfig &cfg) {
+  Candidate *c = new Candidate;
+  c->cfg = cfg;
+  c->key = tuneKey(cfg);
+  c->failed = false;
+  c->score = TuneScore();
+  return c;
+}
+
+static double candidateScore(const Candidate *c) {
+  return c->failed ? -1 : tuneScore(c->score);
+}
+
+static void printPoolStats(const WorkStealingPool &pool, double wall) {
+  long executed = 0, stolen = 0;
+  double busy = 0;
+  for (int w = 0; w < pool.size(); w++) {
+    executed += pool.workerStats(w).executed;
+    stolen += pool.workerStats(w).stolen;
+    busy += pool.workerStats(w).busySec;
+  }
+  printf("  %d threads: %ld tasks (%ld stolen), %.1fs busy in %.1fs wall: %.2f cores in use\n",
+         pool.size(), executed, stolen, busy, wall, wall > 0 ? busy / wall : 0);
+}
+
+static void printPhases(const TunePhases &p) {
+  printf("  compiles: %d in %.1fs busy (%.2fs each); flights: %ld in %.1fs busy (%.0f/s)\n", p.builds,
+         p.buildSec, p.builds ? p.buildSec / p.builds : 0, p.flights, p.flySec,
+         p.flySec > 0 ? p.flights / p.flySec : 0);
+}
+
+static std::string describeChanges(const TuneConfig &cfg) {
+  std::string out;
+  for (int p = 0; p < TUNE_PARAM_COUNT; p++) {
+    if (!tuneActive(cfg, p) || cfg.v[p] == TUNE_PARAMS[p].hand) continue;
+    out += out.empty() ? "" : ", ";
+    out += std::string(TUNE_PARAMS[p].name) + " " + tuneValue(p, TUNE_PARAMS[p].hand) + " -> " +
+           tuneValue(p, cfg.v[p]);
+  }
+  return out.empty() ? "hand-set values" : out;
+}
+
+static void printScore(const char *label, const Candidate *c) {
+  if (c->failed) {
+    printf("%s: failed\n", label);
+    return;
+  }
+  printf("%s: score %.2f, %.1f%% cleared, mean margin %.1fcm (%s)\n", label, candidateScore(c),
+         100.0 * c->score.cleared / c->score.flights, c->score.marginCm / c->score.flights,
+         describeChanges(c->cfg).c_str());
+}
+
+// -S: the same configurations at 1, 2, 4 ... threads, each from clean builds
+static int reportScaling(const TuneOptions &opts, const std::string &workDir) {
+  std::vector<TuneConfig> configs = tuneNeighbours(tuneHandConfig());
+  configs.insert(configs.begin(), tuneHandConfig());
+  if ((int)configs.size() > opts.scalingConfigs) configs.resize(opts.scalingConfigs);
+
+  std::vector<int> counts;
+  for (int t = 1; t < opts.threads; t *= 2) counts.push_back(t);
+  counts.push_back(opts.threads);
+
+  printf("%d configurations x %d flights, %u cores\n", (int)configs.size(), opts.flights,
+         std::thread::hardware_concurrency());
+  printf("threads,wall_s,speedup,efficiency,tasks_stolen,compile_busy_s,flight_busy_s\n");
+  double oneThread = 0;
+  for (size_t i = 0; i < counts.size(); i++) {
+    char dir[32];
+    snprintf(dir, sizeof(dir), "/t%d", counts[i]);
+    std::string runDir = workDir + dir;
+    mkdir(runDir.c_str(), 0755);
+
+    std::vector<Candidate *> cands;
+    for (size_t k = 0; k < configs.size(); k++) cands.push_back(newCandidate(configs[k]));
+    WorkStealingPool pool(counts[i]);
+    Evaluator eval(opts, runDir);
+    double wall = eval.run(pool, cands);
+    if (i == 0) oneThread = wall;
+    long stolen = 0;
+    for (int w = 0; w < pool.size(); w++) stolen += pool.workerStats(w).stolen;
+    const TunePhases &p = eval.lastPhases();
+    printf("%d,%.2f,%.2f,%.2f,%ld,%.2f,%.2f\n", counts[i], wall, oneThread / wall, oneThread / wall / counts[i],
+           stolen, p.buildSec, p.flySec);
+    fflush(stdout);
+    for (size_t k = 0; k < cands.size(); k++) delete cands[k];
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  TuneOptions opts;
+  opts.threads = (int)std::thread::hardware_concurrency();
+  if (opts.threads < 1) opts.threads = 1;
+  opts.flights = 200;
+  opts.batch = 50;
+  opts.firstSeed = 1;
+  opts.rounds = 6;
+  opts.scalingConfigs = 0;
+  opts.sourceDir = TUNE_SOURCE_DIR;
+  opts.compiler = getenv("CXX") ? getenv("CXX") : "c++";
+  opts.opt = "-O1";
+  opts.keep = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-j") && i + 1 < argc) opts.threads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc) opts.flights = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-b") && i + 1 < argc) opts.batch = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc) opts.firstSeed = (unsigned)strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc) opts.rounds = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc) opts.header = argv[++i];
+    else if (!strcmp(argv[i], "-S") && i + 1 < argc) opts.scalingConfigs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-d") && i + 1 < argc) opts.sourceDir = argv[++i];
+    else if (!strcmp(argv[i], "-C") && i + 1 < argc) opts.compiler = argv[++i];
+    else if (!strcmp(argv[i], "-O") && i + 1 < argc) opts.opt = std::string("-O") + argv[++i];
+    else if (!strcmp(argv[i], "-k")) opts.keep = true;
+    else {
+      fprintf(stderr, "usage: %s [-j threads] [-n flights] [-b batch] [-s first_seed] [-r rounds]\n"
+                      "       [-o header] [-S configs] [-d source_dir] [-C compiler] [-O level] [-k]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (opts.threads < 1 || opts.flights < 1 || opts.batch < 1) {
+    fprintf(stderr, "threads, flights and batch must be positive\n");
+    return 2;
+  }
+  if (opts.header.empty()) opts.header = opts.sourceDir + "/include/TunedParams.h";
+
+  char dirTemplate[] = "/tmp/tune.XXXXXX";
+  if (!mkdtemp(dirTemplate)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  std::string workDir = dirTemplate;
+
+  int status = 0;
+  if (opts.scalingConfigs > 0) {
+    status = reportScaling(opts, workDir);
+  } else {
+    WorkStealingPool pool(opts.threads);
+    Evaluator eval(opts, workDir);
+    std::map<std::string, Candidate *> seen;
+    std::vector<Candidate *> all;
+
+    Candidate *hand = newCandidate(tuneHandConfig());
+    seen[hand->key] = hand;
+    all.push_back(hand);
+    std::vector<Candidate *> round(1, hand);
+    Candidate *best = hand;
+    double totalWall = 0;
+
+    for (int r = 1; r <= opts.rounds; r++) {
+      std::vector<TuneConfig> next = tuneNeighbours(best->cfg);
+      for (size_t i = 0; i < next.size(); i++) {
+        std::string key = tuneKey(next[i]);
+        if (seen.count(key)) continue;
+        Candidate *c = newCandidate(next[i]);
+        seen[key] = c;
+        all.push_back(c);
+        round.push_back(c);
+      }
+      if (round.empty()) break;
+
+      pool.resetStats();
+      double wall = eval.run(pool, round);
+      totalWall += wall;
+      Candidate *roundBest = best;
+      for (size_t i = 0; i < round.size(); i++) {
+        if (candidateScore(round[i]) > candidateScore(roundBest)) roundBest = round[i];
+      }
+      printf("Round %d: %d configurations in %.1fs\n", r, (int)round.size(), wall);
+      printPoolStats(pool, wall);
+      printPhases(eval.lastPhases());
+      if (r == 1) printScore("  hand-set", hand);
+      printScore("  best", roundBest);
+      fflush(stdout);
+      round.clear();
+      if (roundBest == best) break;
+      best = roundBest;
+    }
+
+    if (hand->failed) {
+      fprintf(stderr, "the hand-set configuration did not build or fly; no header written\n");
+      status = 1;
+    } else {
+      char provenance[160];
+      snprintf(provenance, sizeof(provenance), "%d configurations, %d flights each (seeds %u-%u), corridor_sim defaults",
+               (int)all.size(), opts.flights, opts.firstSeed, opts.firstSeed + opts.flights - 1);
+      FILE *out = fopen(opts.header.c_str(), "w");
+      if (!out) {
+        perror(opts.header.c_str());
+        status = 1;
+      } else {
+        writeTunedHeader(out, best->cfg, best->score, hand->score, provenance);
+        fclose(out);
+        printf("%d configurations in %.1fs on %d threads; wrote %s\n", (int)all.size(), totalWall,
+               opts.threads, opts.header.c_str());
+      }
+    }
+    for (size_t i = 0; i < all.size(); i++) delete all[i];
+  }
+
+  if (!opts.keep) {
+    std::vector<std::string> rm;
+    rm.push_back("rm");
+    rm.push_back("-rf");
+    rm.push_back(workDir);
+    runCommand(rm, "/dev/null");
+  } else {
+    printf("builds kept in %s\n", workDir.c_str());
+  }
+  return status;
+}